@@ -2,18 +2,32 @@
 // Created by mfran on 25/12/2019.
 //
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <fstream>
 #include <MFranceschi_CppLibrary.hpp>
 #include <functional>
 #include <iostream>
 #include <string>
 #include <sys/stat.h>
+#if Threads_FOUND
+#include <thread>
+#include <unordered_map>
+#endif
 #include "TimingExperience.hpp"
+#if ZLIB_FOUND
+#include <zlib.h>
+#endif
 
 #if defined(_WIN32)
 #include <fcntl.h>
 #include <io.h>
 #include <Shlwapi.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
 using std::cout;
@@ -36,6 +50,22 @@ namespace TimingExperience {
         timingWchar_tConversion();
         timingFileReading();
         timingCtimeFunctions();
+        timingReadStrategies();
+        timingReadMany();
+        timingFileWriting();
+        timingStatMany();
+        timingLineIndex();
+        timingSearch();
+        timingInflate();
+        timingJournal();
+        timingPrefetch();
+        timingRecords();
+        timingSnapshot();
+        timingChunker();
+        timingDelta();
+        timingMappedContainers();
+        timingGlob();
+        timingPathCache();
     }
 
     void timingTimeThis() {
@@ -213,6 +243,736 @@ namespace TimingExperience {
             timet = mktime(&tmt);
         }) << endl;
     }
+
+    void timingReadStrategies() {
+        cout << "Timing File::Read strategies (open, scan every byte, close), in seconds per file!" << endl;
+        static constexpr File::Filename_t temp_name = MAKE_FILE_NAME "TimingExperience_ReadStrategies.tmp";
+        const std::pair<File::ReadStrategy, const char*> strategies[] = {
+                {File::ReadStrategy::READ, "READ"},
+                {File::ReadStrategy::MMAP, "MMAP"},
+                {File::ReadStrategy::MMAP_POPULATE, "MMAP_POPULATE"},
+                {File::ReadStrategy::MMAP_HUGE_PAGES, "MMAP_HUGE_PAGES"},
+        };
+
+        for (File::Filesize_t size = 4ul << 10; size <= 64ul << 20; size <<= 2) {
+            {
+                std::ofstream ofs(temp_name, std::ios_base::binary | std::ios_base::trunc);
+                const std::string block(4096, 'x');
+                for (File::Filesize_t written = 0; written < size; written += block.size()) {
+                    ofs.write(block.data(), block.size());
+                }
+            }
+
+            // Same amount of bytes scanned for every size, but at least a few iterations.
+            const size_t iterations = std::max<size_t>(5, (64ul << 20) / size);
+            cout << "Size " << (size >> 10) << " KiB:";
+            for (const auto& strategy : strategies) {
+                volatile unsigned long sum = 0;
+                const double duration = Toolbox::TimeThis(iterations, [&strategy, &sum]() {
+                    auto fileData = File::Read(temp_name, strategy.first);
+                    unsigned long localSum = 0;
+                    for (File::Filesize_t i = 0; i < fileData->size; ++i) {
+                        localSum += static_cast<unsigned char>(fileData->contents[i]);
+                    }
+                    sum = sum + localSum;
+                    File::Read_Close(fileData);
+                });
+                cout << " " << strategy.second << "=" << duration;
+            }
+            cout << endl;
+        }
+        File::Delete(temp_name);
+        cout << endl;
+    }
+
+    void timingReadMany() {
+        cout << "Timing the reading of many small files (warm cache), in seconds for all of them!" << endl;
+        static constexpr File::Filename_t temp_folder = MAKE_FILE_NAME "TimingExperience_ReadMany.tmp" FILE_SEPARATOR;
+        constexpr size_t number_of_files = 20 * 1000;
+        File::CreateFolder(temp_folder);
+        std::vector<File::SFilename_t> filenames;
+        const std::string contents(4096, 'x');
+        for (size_t i = 0; i < number_of_files; ++i) {
+            filenames.push_back(File::SFilename_t(temp_folder) + std::to_string(i));
+            std::ofstream(filenames.back(), std::ios_base::binary) << contents;
+        }
+
+        volatile size_t total = 0;
+        cout << "ReadToString, one after the other: " << Toolbox::TimeThis(3, [&filenames, &total]() {
+            std::string string;
+            for (const File::SFilename_t& filename : filenames) {
+                File::ReadToString(filename.c_str(), string);
+                total = total + string.size();
+            }
+        }) << endl;
+
+        File::ReadManyOptions options;
+        const auto readMany = [&filenames, &total, &options]() {
+            File::ReadMany(filenames, [&total](size_t, File::FileBuffer&& buffer, bool) { total = total + buffer.size; }, options);
+        };
+        cout << "ReadMany (io_uring, queue depth 64): " << Toolbox::TimeThis(3, readMany) << endl;
+        options.queueDepth = 256;
+        cout << "ReadMany (io_uring, queue depth 256): " << Toolbox::TimeThis(3, readMany) << endl;
+        options.useIoUring = false;
+        cout << "ReadMany (thread pool): " << Toolbox::TimeThis(3, readMany) << endl;
+
+        for (const File::SFilename_t& filename : filenames) {
+            File::Delete(filename.c_str());
+        }
+        File::Delete(temp_folder, false);
+        cout << endl;
+    }
+
+    void timingFileWriting() {
+        cout << "Timing the writing of 256 MiB in chunks of various sizes, in seconds!" << endl;
+        static constexpr File::Filename_t temp_name = MAKE_FILE_NAME "TimingExperience_FileWriting.tmp";
+        constexpr size_t total = 256ul << 20;
+        const std::string chunk(1ul << 20, 'x');
+
+        for (size_t chunkSize : {100ul, 4096ul, 65536ul, 1ul << 20}) {
+            cout << "Chunks of " << chunkSize << " bytes:";
+            cout << " ofstream=" << Toolbox::TimeThis(3, [&chunk, chunkSize]() {
+                std::ofstream ofs(temp_name, std::ios_base::binary | std::ios_base::trunc);
+                for (size_t written = 0; written < total; written += chunkSize) {
+                    ofs.write(chunk.data(), chunkSize);
+                }
+            });
+            cout << " Writer=" << Toolbox::TimeThis(3, [&chunk, chunkSize]() {
+                File::Writer writer(temp_name);
+                for (size_t written = 0; written < total; written += chunkSize) {
+                    writer.Write(chunk.data(), chunkSize);
+                }
+                writer.Commit();
+            }) << endl;
+        }
+        File::Delete(temp_name);
+        cout << endl;
+    }
+
+    void timingStatMany() {
+        cout << "Timing the metadata of many files (warm cache), in seconds for all of them!" << endl;
+        static constexpr File::Filename_t temp_folder = MAKE_FILE_NAME "TimingExperience_StatMany.tmp" FILE_SEPARATOR;
+        constexpr size_t number_of_folders = 20;
+        constexpr size_t files_per_folder = 1000;
+        // Paths of a realistic depth: the kernel walks every component of each path looked up.
+        File::SFilename_t deep_folder = temp_folder;
+        File::CreateFolder(temp_folder);
+        for (const char* component : {"project", "assets", "textures", "environment", "outdoor"}) {
+            deep_folder += File::SFilename_t(component) + FILE_SEPARATOR;
+            File::CreateFolder(deep_folder.c_str());
+        }
+        std::vector<File::SFilename_t> filenames;
+        for (size_t folder = 0; folder < number_of_folders; ++folder) {
+            const File::SFilename_t folder_name = deep_folder + "some_folder_" + std::to_string(folder);
+            File::CreateFolder(folder_name.c_str());
+            for (size_t i = 0; i < files_per_folder; ++i) {
+                filenames.push_back(folder_name + FILE_SEPARATOR + "file_" + std::to_string(i));
+                std::ofstream(filenames.back()) << i;
+            }
+        }
+
+        volatile File::Filesize_t total = 0;
+        cout << "Exists + IsDir + Size, one after the other: " << Toolbox::TimeThis(5, [&filenames, &total]() {
+            for (const File::SFilename_t& filename : filenames) {
+                if (File::Exists(filename.c_str()) && !File::IsDir(filename.c_str())) {
+                    total = total + File::Size(filename.c_str());
+                }
+            }
+        }) << endl;
+        cout << "Size, one after the other: " << Toolbox::TimeThis(5, [&filenames, &total]() {
+            for (const File::SFilename_t& filename : filenames) {
+                total = total + File::Size(filename.c_str());
+            }
+        }) << endl;
+        for (unsigned int threads : {1u, 0u}) {
+            cout << "StatMany (size, " << threads << " threads): " << Toolbox::TimeThis(5, [&filenames, &total, threads]() {
+                const File::StatResult result = File::StatMany(filenames, File::STAT_SIZE, threads);
+                for (size_t i = 0; i < result.Size(); ++i) {
+                    total = total + result.sizes[i];
+                }
+            }) << endl;
+        }
+
+        File::DeleteTree(temp_folder);
+        cout << endl;
+    }
+
+    void timingLineIndex() {
+        cout << "Timing the index of the lines of a big file (warm cache), in seconds!" << endl;
+        static constexpr File::Filename_t temp_name = MAKE_FILE_NAME "TimingExperience_LineIndex.tmp";
+        constexpr size_t number_of_lines = 4 * 1000 * 1000;
+        {
+            std::ofstream ofs(temp_name, std::ios_base::binary);
+            for (size_t i = 0; i < number_of_lines; ++i) {
+                ofs << "2026-10-19 12:00:00 INFO some message number " << i << " with payload\n";
+            }
+        }
+
+        File::MappedFile file(temp_name, File::AccessPattern::RANDOM);
+        volatile size_t total = 0;
+        cout << "LineRange, whole file: " << Toolbox::TimeThis(5, [&file, &total]() {
+            for (File::LineView line : File::LineRange(file.Get())) {
+                total = total + line.size;
+            }
+        }) << endl;
+        File::LineIndex index;
+        cout << "LineIndex::Build: " << Toolbox::TimeThis(5, [&file, &index]() {
+            index.Build(file.Data(), file.Size());
+        }) << " (" << index.MemoryUsage() << " bytes for " << index.LineCount() << " lines)" << endl;
+        cout << "1,000,000 random lines: " << Toolbox::TimeThis(5, [&file, &index, &total]() {
+            for (size_t i = 0; i < 1000 * 1000; ++i) {
+                total = total + index.Line(file.Get(), (i * 2654435761u) % index.LineCount()).size;
+            }
+        }) << endl;
+        index.Save(File::LineIndexFilename(temp_name).c_str(), file.GetIdentity());
+        cout << "LineIndex::Open from the sidecar: " << Toolbox::TimeThis(5, [&index]() {
+            index.Open(temp_name);
+        }) << endl;
+
+        file.Close();
+        File::Delete(File::LineIndexFilename(temp_name).c_str());
+        File::Delete(temp_name);
+        cout << endl;
+    }
+
+    void timingSearch() {
+        cout << "Timing the search of substrings in a big file (warm cache), in seconds!" << endl;
+        static constexpr File::Filename_t temp_name = MAKE_FILE_NAME "TimingExperience_Search.tmp";
+        {
+            std::ofstream ofs(temp_name, std::ios_base::binary);
+            for (size_t i = 0; i < 4 * 1000 * 1000; ++i) {
+                ofs << "2026-10-19 12:00:00 INFO some message number " << i << " with payload\n";
+            }
+        }
+        const std::vector<std::string> patterns = {"ERROR", "FATAL", "number 3999", "panic", "WARN"};
+        std::vector<std::string> identifiers;
+        for (int i = 0; i < 1000; ++i) {
+            identifiers.push_back("id" + std::to_string(i * 7919));
+        }
+
+        volatile size_t total = 0;
+        cout << "ReadToString then std::string::find, 1 pattern: " << Toolbox::TimeThis(5, [&total]() {
+            std::string contents;
+            File::ReadToString(temp_name, contents);
+            for (size_t offset = contents.find("number 3999"); offset != std::string::npos; offset = contents.find("number 3999", offset + 1)) {
+                total = total + 1;
+            }
+        }) << endl;
+        cout << "ReadToString then std::string::find, 5 patterns: " << Toolbox::TimeThis(5, [&total, &patterns]() {
+            std::string contents;
+            File::ReadToString(temp_name, contents);
+            for (const std::string& pattern : patterns) {
+                for (size_t offset = contents.find(pattern); offset != std::string::npos; offset = contents.find(pattern, offset + 1)) {
+                    total = total + 1;
+                }
+            }
+        }) << endl;
+
+        const File::ReadFileData* content = File::Read(temp_name, File::ReadStrategy::AUTO, File::AccessPattern::SEQUENTIAL);
+        std::string contents(content->contents, content->size);
+        for (unsigned int threads : {1u, 0u}) {
+            cout << (threads ? "1 thread" : "All threads") << endl;
+            cout << "std::string::find, 1 pattern (read excluded): " << Toolbox::TimeThis(5, [&contents, &total]() {
+                for (size_t offset = contents.find("number 3999"); offset != std::string::npos; offset = contents.find("number 3999", offset + 1)) {
+                    total = total + 1;
+                }
+            }) << endl;
+            cout << "File::Search, 1 pattern: " << Toolbox::TimeThis(5, [content, threads, &total]() {
+                total = total + File::Search(content, "number 3999", threads).size();
+            }) << endl;
+            const File::Searcher searcher(patterns);
+            cout << "File::Searcher, 5 patterns: " << Toolbox::TimeThis(5, [content, threads, &searcher, &total]() {
+                total = total + searcher.Find(content, threads).size();
+            }) << endl;
+            const File::Searcher identifiersSearcher(identifiers);
+            cout << "File::Searcher, 1000 patterns: " << Toolbox::TimeThis(5, [content, threads, &identifiersSearcher, &total]() {
+                total = total + identifiersSearcher.Find(content, threads).size();
+            }) << endl;
+        }
+        File::Read_Close(content);
+        File::Delete(temp_name);
+        cout << endl;
+    }
+
+    void timingInflate() {
+#if ZLIB_FOUND
+        cout << "Timing the decompression of a zlib stream of 107 MB (aom_v.scx, 64 times), in seconds!" << endl;
+        const File::ReadFileData* content = File::Read(MAKE_FILE_NAME ".." FILE_SEPARATOR "test" FILE_SEPARATOR "files" FILE_SEPARATOR "aom_v.scx");
+        if (!content) {
+            cout << "aom_v.scx not found: run from a directory next to \"test\"." << endl << endl;
+            return;
+        }
+        constexpr File::Filesize_t scx_header_size = 8; // "l33t" and the size of the contents.
+        std::string scenario;
+        File::Inflater(content, scx_header_size).ReadAll([&scenario](const char* data, size_t size) {
+            scenario.append(data, size);
+            return true;
+        });
+        File::Read_Close(content);
+        std::string contents;
+        for (int i = 0; i < 64; ++i) {
+            contents += scenario;
+        }
+        // One stream, compressed by zlib itself, so that both decompress the same input.
+        uLongf compressedSize = compressBound(static_cast<uLong>(contents.size()));
+        std::string compressed(compressedSize, '\0');
+        compress2(reinterpret_cast<Bytef*>(&compressed[0]), &compressedSize,
+                  reinterpret_cast<const Bytef*>(contents.data()), static_cast<uLong>(contents.size()), Z_DEFAULT_COMPRESSION);
+        compressed.resize(compressedSize);
+
+        volatile size_t total = 0;
+        cout << "File::Inflater::ReadAll: " << Toolbox::TimeThis(5, [&compressed, &total]() {
+            File::Inflater inflater(compressed.data(), compressed.size());
+            inflater.ReadAll([&total](const char*, size_t size) {
+                total = total + size;
+                return true;
+            });
+        }) << endl;
+        std::vector<char> buffer(64 << 10);
+        cout << "File::Inflater::Read, 64 KiB at a time: " << Toolbox::TimeThis(5, [&compressed, &buffer, &total]() {
+            File::Inflater inflater(compressed.data(), compressed.size());
+            while (size_t read = inflater.Read(buffer.data(), buffer.size())) {
+                total = total + read;
+            }
+        }) << endl;
+        std::string output(contents.size(), '\0');
+        cout << "zlib uncompress: " << Toolbox::TimeThis(5, [&compressed, &output, &total]() {
+            uLongf outputSize = static_cast<uLongf>(output.size());
+            uncompress(reinterpret_cast<Bytef*>(&output[0]), &outputSize,
+                       reinterpret_cast<const Bytef*>(compressed.data()), static_cast<uLong>(compressed.size()));
+            total = total + outputSize;
+        }) << endl;
+        cout << "zlib inflate, 64 KiB at a time: " << Toolbox::TimeThis(5, [&compressed, &buffer, &total]() {
+            z_stream stream{};
+            inflateInit(&stream);
+            stream.next_in = reinterpret_cast<Bytef*>(&compressed[0]);
+            stream.avail_in = static_cast<uInt>(compressed.size());
+            int status = Z_OK;
+            while (status == Z_OK) {
+                stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
+                stream.avail_out = static_cast<uInt>(buffer.size());
+                status = inflate(&stream, Z_NO_FLUSH);
+                total = total + (buffer.size() - stream.avail_out);
+            }
+            inflateEnd(&stream);
+        }) << endl;
+        cout << endl;
+#else
+        cout << "Timing the decompression of a zlib stream: zlib not found, nothing timed." << endl << endl;
+#endif
+    }
+
+    void timingJournal() {
+        cout << "Timing 16,000 durable appends of 100 bytes to a File::Journal, in seconds!" << endl;
+        static constexpr File::Filename_t temp_folder = MAKE_FILE_NAME "TimingExperience_Journal.tmp";
+        constexpr size_t number_of_appends = 16 * 1000;
+        const std::string record(100, 'r');
+#if Threads_FOUND
+        for (size_t threads : {1ul, 8ul, 64ul}) {
+#else
+        for (size_t threads : {1ul}) {
+#endif
+            File::DeleteTree(temp_folder);
+            File::Journal journal(temp_folder);
+            cout << threads << " thread(s): " << Toolbox::TimeThis(1, [&journal, &record, threads]() {
+#if Threads_FOUND
+                std::vector<std::thread> writers;
+                for (size_t t = 0; t < threads; ++t) {
+                    writers.emplace_back([&journal, &record, threads]() {
+                        for (size_t i = 0; i < number_of_appends / threads; ++i) {
+                            journal.Append(record);
+                        }
+                    });
+                }
+                for (std::thread& writer : writers) {
+                    writer.join();
+                }
+#else
+                for (size_t i = 0; i < number_of_appends; ++i) {
+                    journal.Append(record);
+                }
+#endif
+            }) << endl;
+        }
+        File::DeleteTree(temp_folder);
+        cout << endl;
+    }
+
+    void timingPrefetch() {
+        cout << "Timing the reading of 200 files of 1 MiB one after the other (cold cache), in seconds!" << endl;
+#if defined(_WIN32)
+        cout << "Nothing is prefetched on Windows." << endl << endl;
+#else
+        static constexpr File::Filename_t temp_folder = MAKE_FILE_NAME "TimingExperience_Prefetch.tmp" FILE_SEPARATOR;
+        File::CreateFolder(temp_folder);
+        std::vector<File::SFilename_t> filenames;
+        const std::string contents(1ul << 20, 'x');
+        for (size_t i = 0; i < 200; ++i) {
+            filenames.push_back(File::SFilename_t(temp_folder) + std::to_string(i));
+            std::ofstream(filenames.back(), std::ios_base::binary) << contents;
+        }
+        const auto evict = [&filenames]() {
+            for (const File::SFilename_t& filename : filenames) {
+                const int fd = open(filename.c_str(), O_RDONLY);
+                fdatasync(fd);
+                posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+                close(fd);
+            }
+        };
+
+        volatile size_t total = 0;
+        const auto readAll = [&filenames, &total](File::Prefetcher* prefetcher) {
+            for (size_t i = 0; i < filenames.size(); ++i) {
+                if (prefetcher) {
+                    prefetcher->Consume(i);
+                }
+                const File::ReadFileData* content = File::Read(filenames[i].c_str());
+                for (File::Filesize_t offset = 0; offset < content->size; offset += 4096) {
+                    total = total + content->contents[offset];
+                }
+                File::Read_Close(content);
+            }
+        };
+        for (int run = 0; run < 3; ++run) {
+            evict();
+            cout << "File::Read: " << Toolbox::TimeThis(1, [&readAll]() { readAll(nullptr); });
+            evict();
+            cout << ", with a File::Prefetcher: " << Toolbox::TimeThis(1, [&filenames, &readAll]() {
+                File::Prefetcher prefetcher(filenames);
+                readAll(&prefetcher);
+            }) << endl;
+        }
+
+        for (const File::SFilename_t& filename : filenames) {
+            File::Delete(filename.c_str());
+        }
+        File::Delete(temp_folder, false);
+        cout << endl;
+#endif
+    }
+
+    void timingRecords() {
+        cout << "Timing the loading of 4M records of 16 bytes (warm cache), then the sum of one field, in seconds!" << endl;
+        struct Record {
+            uint32_t id;
+            uint32_t quantity;
+            double price;
+        };
+        static constexpr File::Filename_t temp_name = MAKE_FILE_NAME "TimingExperience_Records.tmp";
+        constexpr size_t number_of_records = 4ul << 20;
+        {
+            std::vector<Record> records(number_of_records);
+            for (size_t i = 0; i < number_of_records; ++i) {
+                records[i] = {static_cast<uint32_t>(i), static_cast<uint32_t>(i % 100), i * 0.01};
+            }
+            std::ofstream(temp_name, std::ios_base::binary).write(reinterpret_cast<const char*>(records.data()),
+                                                                  records.size() * sizeof(Record));
+        }
+
+        volatile double total = 0;
+        cout << "ifstream::read into a vector: " << Toolbox::TimeThis(5, [&total]() {
+            std::ifstream ifs(temp_name, std::ios_base::binary);
+            std::vector<Record> records(number_of_records);
+            ifs.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(Record));
+            double sum = 0;
+            for (const Record& record : records) {
+                sum += record.price;
+            }
+            total = total + sum;
+        }) << endl;
+        cout << "File::RecordView: " << Toolbox::TimeThis(5, [&total]() {
+            const File::ReadFileData* content = File::Read(temp_name, File::ReadStrategy::AUTO, File::AccessPattern::SEQUENTIAL);
+            double sum = 0;
+            for (const Record& record : File::RecordView<Record>(content)) {
+                sum += record.price;
+            }
+            total = total + sum;
+            File::Read_Close(content);
+        }) << endl;
+        cout << "File::RecordView, only the price swapped on access: " << Toolbox::TimeThis(5, [&total]() {
+            const File::ReadFileData* content = File::Read(temp_name, File::ReadStrategy::AUTO, File::AccessPattern::SEQUENTIAL);
+            const File::RecordView<uint64_t, File::ByteOrder::BIG> words(content);
+            double sum = 0;
+            for (File::Filesize_t i = 1; i < words.Size(); i += 2) {
+                const uint64_t bits = words[i];
+                double price;
+                std::memcpy(&price, &bits, sizeof(price));
+                sum += price;
+            }
+            total = total + sum;
+            File::Read_Close(content);
+        }) << endl;
+        File::Delete(temp_name);
+        cout << endl;
+    }
+
+    void timingSnapshot() {
+        cout << "Timing the rescan of a tree of 20,000 files (warm cache), in seconds!" << endl;
+        static constexpr File::Filename_t temp_folder = MAKE_FILE_NAME "TimingExperience_Snapshot.tmp" FILE_SEPARATOR;
+        static constexpr File::Filename_t temp_snapshot = MAKE_FILE_NAME "TimingExperience_Snapshot.state";
+        constexpr size_t number_of_folders = 20;
+        constexpr size_t files_per_folder = 1000;
+        File::CreateFolder(temp_folder);
+        const std::string contents(4096, 'x');
+        for (size_t folder = 0; folder < number_of_folders; ++folder) {
+            const File::SFilename_t folder_name = temp_folder + File::SFilename_t("folder_") + std::to_string(folder) + FILE_SEPARATOR;
+            File::CreateFolder(folder_name.c_str());
+            for (size_t i = 0; i < files_per_folder; ++i) {
+                std::ofstream(folder_name + "file_" + std::to_string(i), std::ios_base::binary) << contents << i;
+            }
+        }
+
+        volatile size_t total = 0;
+        cout << "FilesInDirectory walk, then every file read and hashed: " << Toolbox::TimeThis(5, [&total]() {
+            std::vector<File::SFilename_t> folders = {temp_folder};
+            for (size_t i = 0; i < folders.size(); ++i) {
+                for (const File::SFilename_t& name : File::FilesInDirectory(folders[i].c_str())) {
+                    if (name.back() == FILE_SEPARATOR[0]) {
+                        folders.push_back(folders[i] + name);
+                    } else {
+                        std::string read;
+                        File::ReadToString((folders[i] + name).c_str(), read);
+                        total = total + std::hash<std::string>()(read);
+                    }
+                }
+            }
+        }) << endl;
+        File::SnapshotOptions options;
+        options.hashContents = true;
+        const File::TreeSnapshot first = File::SnapshotTree(temp_folder, options);
+        cout << "SnapshotTree, every file hashed: " << Toolbox::TimeThis(5, [&total, &options]() {
+            total = total + File::SnapshotTree(temp_folder, options).hashedFiles;
+        }) << endl;
+        cout << "SnapshotTree, unchanged since the previous snapshot: " << Toolbox::TimeThis(5, [&total, &options, &first]() {
+            total = total + File::SnapshotTree(temp_folder, options, &first).hashedFiles;
+        }) << endl;
+        const File::TreeSnapshot second = File::SnapshotTree(temp_folder, options, &first);
+        cout << "DiffSnapshots: " << Toolbox::TimeThis(5, [&total, &first, &second]() {
+            total = total + File::DiffSnapshots(first, second).size();
+        }) << endl;
+        cout << "SaveSnapshot + LoadSnapshot: " << Toolbox::TimeThis(5, [&total, &first]() {
+            File::TreeSnapshot loaded;
+            File::SaveSnapshot(first, temp_snapshot);
+            File::LoadSnapshot(temp_snapshot, loaded);
+            total = total + loaded.entries.size();
+        }) << endl;
+        cout << "Size of the snapshot file, in bytes: " << File::Size(temp_snapshot) << endl;
+        File::Delete(temp_snapshot);
+        File::DeleteTree(temp_folder);
+        cout << endl;
+    }
+
+    void timingChunker() {
+        cout << "Timing the content-defined chunking of 256 MiB in memory, in seconds!" << endl;
+        std::string data(256ul << 20, '\0');
+        uint64_t seed = 1;
+        for (char& byte : data) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            byte = static_cast<char>(seed >> 56);
+        }
+
+        volatile size_t total = 0;
+        File::ChunkOptions options;
+        options.threads = 1;
+        options.hashChunks = false;
+        cout << "FindChunks, 1 thread, without hashes: " << Toolbox::TimeThis(5, [&data, &total, &options]() {
+            total = total + File::FindChunks(data.data(), data.size(), options).size();
+        }) << endl;
+        options.hashChunks = true;
+        cout << "FindChunks, 1 thread, with hashes: " << Toolbox::TimeThis(5, [&data, &total, &options]() {
+            total = total + File::FindChunks(data.data(), data.size(), options).size();
+        }) << endl;
+        options.threads = 0;
+        cout << "FindChunks, all threads, with hashes: " << Toolbox::TimeThis(5, [&data, &total, &options]() {
+            total = total + File::FindChunks(data.data(), data.size(), options).size();
+        }) << endl;
+        cout << endl;
+    }
+
+    void timingDelta() {
+        cout << "Timing the delta between two versions of a file of 64 MiB, in seconds!" << endl;
+        static constexpr File::Filename_t temp_name = MAKE_FILE_NAME "TimingExperience_Delta.tmp";
+        std::string basis(64ul << 20, '\0');
+        uint64_t seed = 1;
+        for (char& byte : basis) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            byte = static_cast<char>(seed >> 56);
+        }
+        // 16 edits of 100 bytes, the size is unchanged so that the in-place delta can be applied again.
+        std::string edited = basis;
+        for (size_t i = 0; i < 16; ++i) {
+            edited.replace(i * (4ul << 20) + 12345, 100, std::string(100, 'x'));
+        }
+
+        volatile size_t total = 0;
+        File::DeltaSignature signature;
+        cout << "ComputeSignature: " << Toolbox::TimeThis(5, [&basis, &signature]() {
+            signature = File::ComputeSignature(basis.data(), basis.size());
+        }) << endl;
+        std::string delta;
+        cout << "ComputeDelta: " << Toolbox::TimeThis(5, [&edited, &signature, &delta]() {
+            delta = File::ComputeDelta(signature, edited.data(), edited.size(), true);
+        }) << endl;
+        cout << "Sizes of the signature and of the delta, in bytes: " << signature.Serialize().size() << " " << delta.size() << endl;
+        cout << "Writer, the whole new version: " << Toolbox::TimeThis(5, [&edited]() {
+            File::Writer writer(temp_name);
+            writer.Write(edited.data(), edited.size());
+            writer.Commit();
+        }) << endl;
+        cout << "ApplyDelta: " << Toolbox::TimeThis(5, [&basis, &delta]() {
+            File::ApplyDelta(basis.data(), basis.size(), delta.data(), delta.size(), temp_name);
+        }) << endl;
+        File::Filesize_t written = 0;
+        cout << "ApplyDeltaInPlace: " << Toolbox::TimeThis(5, [&delta, &written, &total]() {
+            total = total + File::ApplyDeltaInPlace(temp_name, delta.data(), delta.size(), &written);
+        }) << endl;
+        cout << "Bytes written in place: " << written << endl;
+        File::Delete(temp_name);
+        cout << endl;
+    }
+
+    void timingMappedContainers() {
+        cout << "Timing a lookup table of 1,000,000 entries kept in a file, in seconds!" << endl;
+        static constexpr File::Filename_t temp_name = MAKE_FILE_NAME "TimingExperience_Containers.tmp";
+        constexpr uint64_t count = 1000000;
+
+        volatile uint64_t total = 0;
+        cout << "std::unordered_map, built: " << Toolbox::TimeThis(5, [&total]() {
+            std::unordered_map<uint64_t, uint64_t> table;
+            table.reserve(count);
+            for (uint64_t i = 0; i < count; ++i) {
+                table[i * 0x9E3779B97F4A7C15ull] = i;
+            }
+            total = total + table.size();
+        }) << endl;
+        cout << "MappedHashMap, built into a new file: " << Toolbox::TimeThis(5, [&total]() {
+            File::Delete(temp_name);
+            File::MappedHashMap<uint64_t, uint64_t> table(temp_name);
+            table.Reserve(count);
+            for (uint64_t i = 0; i < count; ++i) {
+                table.Set(i * 0x9E3779B97F4A7C15ull, i);
+            }
+            total = total + table.Size();
+        }) << endl;
+        cout << "MappedHashMap, reopened: " << Toolbox::TimeThis(5, [&total]() {
+            File::MappedHashMap<uint64_t, uint64_t> table(temp_name, File::MappedMode::READ_ONLY);
+            total = total + table.Size();
+        }) << endl;
+
+        std::unordered_map<uint64_t, uint64_t> memoryTable;
+        for (uint64_t i = 0; i < count; ++i) {
+            memoryTable[i * 0x9E3779B97F4A7C15ull] = i;
+        }
+        File::MappedHashMap<uint64_t, uint64_t> fileTable(temp_name, File::MappedMode::READ_ONLY);
+        // The keys are looked up in another order than the one they were added in, as they would be.
+        cout << "1,000,000 lookups, std::unordered_map: " << Toolbox::TimeThis(5, [&total, &memoryTable]() {
+            for (uint64_t i = 0; i < count; ++i) {
+                total = total + memoryTable.find(i * 7919 % count * 0x9E3779B97F4A7C15ull)->second;
+            }
+        }) << endl;
+        cout << "1,000,000 lookups, MappedHashMap: " << Toolbox::TimeThis(5, [&total, &fileTable]() {
+            for (uint64_t i = 0; i < count; ++i) {
+                total = total + *fileTable.Find(i * 7919 % count * 0x9E3779B97F4A7C15ull);
+            }
+        }) << endl;
+        cout << "Size of the file, in bytes: " << fileTable.FileSize() << endl;
+        fileTable.Close();
+        File::Delete(temp_name);
+        cout << endl;
+    }
+
+    void timingGlob() {
+        cout << "Timing the selection of files in a tree of 20,000 files by glob patterns (warm cache), in seconds!" << endl;
+        static constexpr File::Filename_t temp_folder = MAKE_FILE_NAME "TimingExperience_Glob.tmp" FILE_SEPARATOR;
+        constexpr size_t number_of_folders = 20;
+        constexpr size_t subfolders_per_folder = 10;
+        constexpr size_t files_per_subfolder = 100;
+        File::CreateFolder(temp_folder);
+        for (size_t folder = 0; folder < number_of_folders; ++folder) {
+            const File::SFilename_t folder_name = temp_folder + File::SFilename_t("folder_") + std::to_string(folder) + FILE_SEPARATOR;
+            File::CreateFolder(folder_name.c_str());
+            for (size_t subfolder = 0; subfolder < subfolders_per_folder; ++subfolder) {
+                const File::SFilename_t subfolder_name = folder_name + "sub_" + std::to_string(subfolder) + FILE_SEPARATOR;
+                File::CreateFolder(subfolder_name.c_str());
+                for (size_t i = 0; i < files_per_subfolder; ++i) {
+                    std::ofstream(subfolder_name + "file_" + std::to_string(i) + (i % 10 ? ".cpp" : ".scx"), std::ios_base::binary);
+                }
+            }
+        }
+
+        volatile size_t total = 0;
+        for (const char* pattern : {"**/*.scx", "folder_3/**/*.scx", "folder_3/sub_7/file_50.scx"}) {
+            const File::GlobPattern compiled{File::SFilename_t(pattern, pattern + std::strlen(pattern))};
+            cout << pattern << ", FilesInDirectory walk, every path matched: " << Toolbox::TimeThis(5, [&total, &compiled]() {
+                std::vector<File::SFilename_t> folders = {File::SFilename_t()};
+                for (size_t i = 0; i < folders.size(); ++i) {
+                    for (const File::SFilename_t& name : File::FilesInDirectory((temp_folder + folders[i]).c_str())) {
+                        const File::SFilename_t path = folders[i] + name;
+                        total = total + compiled.Matches(path);
+                        if (name.back() == FILE_SEPARATOR[0]) {
+                            folders.push_back(path);
+                        }
+                    }
+                }
+            }) << endl;
+            cout << pattern << ", Glob, 1 thread: " << Toolbox::TimeThis(5, [&total, &compiled]() {
+                total = total + File::Glob(temp_folder, compiled, 1).size();
+            }) << endl;
+            cout << pattern << ", matches: " << File::Glob(temp_folder, compiled).size() << endl;
+        }
+        File::DeleteTree(temp_folder);
+        cout << endl;
+    }
+
+    void timingPathCache() {
+        cout << "Timing the canonicalisation of 100,000 paths of files in 100 directories, in seconds!" << endl;
+        static constexpr File::Filename_t temp_folder = MAKE_FILE_NAME "TimingExperience_Path.tmp" FILE_SEPARATOR;
+        constexpr size_t number_of_folders = 100;
+        constexpr size_t files_per_folder = 1000;
+        File::CreateFolder(temp_folder);
+        std::vector<File::SFilename_t> paths;
+        for (size_t folder = 0; folder < number_of_folders; ++folder) {
+            const File::SFilename_t folder_name = temp_folder + File::SFilename_t("folder_") + std::to_string(folder) + FILE_SEPARATOR;
+            File::CreateFolder(folder_name.c_str());
+            for (size_t i = 0; i < files_per_folder; ++i) {
+                paths.push_back(folder_name + "." + FILE_SEPARATOR + "file_" + std::to_string(i));
+                std::ofstream(paths.back(), std::ios_base::binary);
+            }
+        }
+
+        volatile size_t total = 0;
+        cout << "NormalizePath: " << Toolbox::TimeThis(5, [&total, &paths]() {
+            for (const File::SFilename_t& path : paths) {
+                total = total + File::NormalizePath(path).size();
+            }
+        }) << endl;
+#if !defined(_WIN32)
+        cout << "realpath: " << Toolbox::TimeThis(5, [&total, &paths]() {
+            for (const File::SFilename_t& path : paths) {
+                char* real = realpath(path.c_str(), nullptr);
+                total = total + std::strlen(real);
+                free(real);
+            }
+        }) << endl;
+#endif
+        File::PathCache cache;
+        File::SFilename_t canonical;
+        cout << "PathCache, first time: " << Toolbox::TimeThis(1, [&total, &paths, &cache, &canonical]() {
+            for (const File::SFilename_t& path : paths) {
+                cache.Canonicalize(path, canonical);
+                total = total + canonical.size();
+            }
+        }) << endl;
+        cout << "PathCache, directories known: " << Toolbox::TimeThis(5, [&total, &paths, &cache, &canonical]() {
+            for (const File::SFilename_t& path : paths) {
+                cache.Canonicalize(path, canonical);
+                total = total + canonical.size();
+            }
+        }) << endl;
+        cout << "Names read from the system by PathCache: " << cache.LookupCount() << endl;
+        File::DeleteTree(temp_folder);
+        cout << endl;
+    }
 }
 
 int main() {
@@ -13,6 +13,22 @@ namespace TimingExperience {
     void timingWchar_tConversion();
     void timingFileReading();
     void timingCtimeFunctions();
+    void timingReadStrategies();
+    void timingReadMany();
+    void timingFileWriting();
+    void timingStatMany();
+    void timingLineIndex();
+    void timingSearch();
+    void timingInflate();
+    void timingJournal();
+    void timingPrefetch();
+    void timingRecords();
+    void timingSnapshot();
+    void timingChunker();
+    void timingDelta();
+    void timingMappedContainers();
+    void timingGlob();
+    void timingPathCache();
 
     constexpr size_t NUMBER_OF_ITERATIONS = 10 * 1000;
 };
@@ -111,14 +111,14 @@ struct Array {
     // ----- ELEMENT ACCESS
     constexpr reference at(size_type pos) {
         if (pos >= size()) {
-            throw std::out_of_range;
+            throw std::out_of_range("Array::at: index out of range");
         }
         return _array[pos];
     }
 
     constexpr const_reference at(size_type pos) const {
         if (pos >= size()) {
-            throw std::out_of_range;
+            throw std::out_of_range("Array::at: index out of range");
         }
         return _array[pos];
     }
@@ -137,7 +137,7 @@ struct Array {
 
     // ----- CAPACITY
 
-    constexpr bool empty() const noexcept { return N != 0; }
+    constexpr bool empty() const noexcept { return N == 0; }
     constexpr size_type size() const noexcept { return N; }
     constexpr size_type max_size() const noexcept { return N; }
 
@@ -12,6 +12,7 @@
 #define FILE_H
 
 //--------------------------------------------------------------- Includes
+#include <cstdint>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -25,6 +26,9 @@ namespace File
 	enum class encoding_e {
 		ENC_UTF16LE, // Normal UTF-16LE
 		ENC_UTF8, // Normal UTF-8
+		ENC_UTF16BE, // Big-endian UTF-16 (only found by content-based detection)
+		ENC_UTF32LE, // Little-endian UTF-32 (only found by content-based detection)
+		ENC_UTF32BE, // Big-endian UTF-32 (only found by content-based detection)
 		ENC_DEFAULT, // If no encoding is false, we assume the default locale.
 		ENC_ERROR // A problem occurred while looking for the encoding.
 	};
@@ -107,11 +111,14 @@ namespace File
 	 * 2. If unknown, it calls "Encoding(filename)" to determine the encoding.
 	 * 3. If the coding could be processed, we call "ifs.open(filename)" with a specific policy (locale, starting offset, etc.).
 	 * In all cases, the function returns.
+	 * For UTF-16LE, the stream converts one character at a time through the locale:
+	 * prefer "DecodeUTF16LEFile" (FileEncoding.hpp) to read whole files.
 	 * @param ifs The stream to open with the given file and opening policy. It is closed before doing anything.
 	 * @param filename The path to the file to open.
 	 * @param encoding (optional) If you already know the encoding, you can set this parameter;
 	 *                            otherwise it will be determined inside the function.
-	 * @return False if and only if trying to determine the encoding failed --> file cannot be processed correctly.
+	 * @return False if trying to determine the encoding failed --> file cannot be processed correctly,
+	 *         or if the encoding has no stream policy (UTF-16BE, UTF-32).
 	 */
 	bool Open(std::ifstream& ifs, Filename_t filename,
               encoding_t encoding = encoding_t::ENC_ERROR);
@@ -119,6 +126,27 @@ namespace File
 	/// Returns the size of the file pointed by "filename" in bytes, or 0 if anything failed.
 	Filesize_t Size(Filename_t filename);
 
+	/// Identifies one version of a file: it changes when the file is replaced, modified or resized.
+	struct FileIdentity {
+		uint64_t device = 0; // Device (UNIX) or volume serial number (Windows)
+		uint64_t inode = 0; // Inode (UNIX) or file index (Windows)
+		int64_t mtimeNs = 0; // Last modification time, in nanoseconds since the epoch of the system
+		Filesize_t size = 0;
+
+		bool operator==(const FileIdentity& other) const {
+			return device == other.device && inode == other.inode && mtimeNs == other.mtimeNs && size == other.size;
+		}
+		bool operator!=(const FileIdentity& other) const { return !(*this == other); }
+	};
+
+	/**
+	 * Gets the identity of a file with a single system call (stat on UNIX), without opening it on UNIX.
+	 * @param filename Name of the file.
+	 * @param identity Filled with the identity of the file, not modified on failure.
+	 * @return True on success, false if the file does not exist or cannot be accessed.
+	 */
+	bool Identity(Filename_t filename, FileIdentity& identity);
+
 	/// Simple helper function, for use during debugging.
 	std::ostream& operator<< (std::ostream& os, const encoding_t& enc);
 
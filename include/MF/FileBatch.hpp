@@ -0,0 +1,53 @@
+//
+// File module: reading many files at once.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILEBATCH_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILEBATCH_HPP
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "MF/File.hpp"
+
+namespace File {
+    /// Contents of a whole file, owned by whoever holds the structure.
+    struct FileBuffer {
+        std::unique_ptr<char[]> contents; // Not null-terminated; nullptr for an empty file.
+        Filesize_t size = 0;
+    };
+
+    /// Settings of "ReadMany".
+    struct ReadManyOptions {
+        /// Number of files in flight at once with io_uring.
+        unsigned int queueDepth = 64;
+        /// Number of threads reading files when io_uring is not used, 0 for one per hardware thread.
+        unsigned int threads = 0;
+        /// If false, io_uring is never used, even where it is available.
+        bool useIoUring = true;
+    };
+
+    /**
+     * Called by "ReadMany" once per file.
+     * @param index Index of the file in the given list.
+     * @param buffer Contents of the file, to be moved away if needed. Empty on failure.
+     * @param success False if the file could not be opened or read.
+     */
+    using ReadManyCallback = std::function<void(size_t index, FileBuffer&& buffer, bool success)>;
+
+    /**
+     * Reads whole files and gives their contents to a callback, in no particular order.
+     * On Linux, open, read and close are submitted through io_uring, "queueDepth" files at a time,
+     * so that a single thread keeps the device busy without one system call per operation.
+     * Elsewhere, or when io_uring is not available (old kernel, forbidden by a sandbox), files are read by a pool of threads.
+     * The callback is never called concurrently, but it may be called from another thread than the caller's.
+     * @param filenames Names of the files to read.
+     * @param callback Called once for each file, as soon as it is read.
+     * @param options Settings.
+     * @return Number of files successfully read.
+     */
+    size_t ReadMany(const std::vector<SFilename_t>& filenames, const ReadManyCallback& callback,
+                    const ReadManyOptions& options = ReadManyOptions());
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILEBATCH_HPP
@@ -0,0 +1,62 @@
+//
+// File module: content-defined chunking of buffers, for deduplication and incremental backups.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILECHUNKER_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILECHUNKER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "MF/FileOpen.hpp"
+
+namespace File {
+    /// Settings of "FindChunks". The sizes are in bytes, with minSize <= avgSize <= maxSize (they are clamped otherwise).
+    struct ChunkOptions {
+        /// No cut is looked for in the first bytes of a chunk, which are skipped.
+        size_t minSize = 2u << 10;
+        /// Expected size of the chunks, rounded down to a power of two.
+        size_t avgSize = 8u << 10;
+        /// A chunk is cut there if no cut point was found before. Only the last chunk may be shorter than "minSize".
+        size_t maxSize = 64u << 10;
+        /// If true, each chunk gets the XXH64 of its bytes.
+        bool hashChunks = true;
+        /// Number of threads, 0 for one per hardware thread.
+        unsigned int threads = 0;
+    };
+
+    /// Part of a buffer found by "FindChunks".
+    struct Chunk {
+        Filesize_t offset;
+        Filesize_t size;
+        uint64_t hash; // XXH64 of the bytes, 0 if not asked for.
+
+        bool operator==(const Chunk& other) const {
+            return offset == other.offset && size == other.size && hash == other.hash;
+        }
+    };
+
+    /**
+     * Cuts a buffer into chunks whose boundaries depend on the contents only (FastCDC), so that inserting or removing
+     * bytes in a file only changes the chunks around the edit: the others are found again, at other offsets.
+     * > const File::ReadFileData* content = File::Read(filename, File::ReadStrategy::MMAP, File::AccessPattern::SEQUENTIAL);
+     * > for (const File::Chunk& chunk : File::FindChunks(content)) { store.PutIfMissing(chunk.hash, ...); }
+     * A chunk ends where a gear hash, rolled over its last 64 bytes, has its top bits at 0: more bits are required
+     * before "avgSize" and fewer after (normalised chunking), which gathers the sizes around "avgSize".
+     * The gear table is fixed, so the boundaries are the same on every run and machine.
+     * Big buffers are cut into segments chunked by several threads, each from its start; the chunks of a segment are
+     * kept from the first boundary also found by chunking from the end of the previous segment, where both agree
+     * since a boundary only depends on the bytes before it. The result is the same as with one thread.
+     * @param contents Buffer to cut.
+     * @param size Size of the buffer.
+     * @param options Settings.
+     * @return The chunks, in order, covering the whole buffer. Empty for an empty buffer.
+     */
+    std::vector<Chunk> FindChunks(const char* contents, Filesize_t size, const ChunkOptions& options = ChunkOptions());
+
+    /// Same as above, for something returned by "Read".
+    inline std::vector<Chunk> FindChunks(const ReadFileData* content, const ChunkOptions& options = ChunkOptions()) {
+        return FindChunks(content->contents, content->size, options);
+    }
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILECHUNKER_HPP
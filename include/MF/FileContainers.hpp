@@ -0,0 +1,460 @@
+//
+// File module: vector and hash map stored in a memory-mapped file, reopened without being rebuilt.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILECONTAINERS_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILECONTAINERS_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include "MF/FileOpen.hpp"
+
+namespace File {
+    /// How a persistent container opens its file.
+    enum class MappedMode {
+        READ_ONLY, // The file must exist. Any number of processes may read it at once, as long as none writes it
+        READ_WRITE // The file is created if needed. No other process may open it meanwhile
+    };
+
+    /**
+     * Base of the containers stored in a memory-mapped file: the file, its mapping, and the header at its start.
+     * The header gives the layout of the elements and where they are, as an offset from the start of the file;
+     * nothing in the file is an address, so it can be mapped anywhere, by any process.
+     * Opening a container only maps its file: the elements are read from the page cache when they are accessed.
+     * The elements are stored with the layout and byte order of this machine; a file written with another layout
+     * (other element sizes) is refused.
+     * Growing the file moves the mapping, which invalidates the pointers and references to the elements.
+     * Changes reach the file as the pages are written back by the system, or at once with "Flush"; a crash in the
+     * middle of a change may leave the container corrupted, so a file should be flushed once filled.
+     */
+    class MappedContainer {
+    public:
+        /// Alignment of the elements in the file: they may be aligned up to a cache line.
+        static constexpr size_t ELEMENT_ALIGNMENT = 64;
+
+        MappedContainer(MappedContainer&& other) noexcept;
+        MappedContainer& operator=(MappedContainer&& other) noexcept;
+        MappedContainer(const MappedContainer&) = delete;
+        MappedContainer& operator=(const MappedContainer&) = delete;
+        ~MappedContainer();
+
+        /// True if the file could be opened (and created or validated).
+        bool IsOpen() const { return data != nullptr; }
+        explicit operator bool() const { return IsOpen(); }
+
+        /// True if the container was opened in READ_WRITE mode. Otherwise, only its const members can be used.
+        bool IsWritable() const { return writable; }
+
+        /// Size of the file, in bytes.
+        Filesize_t FileSize() const { return size; }
+
+        /// Waits until the changes are on the device. Returns false if it failed, or if nothing is open.
+        bool Flush();
+
+        /// Unmaps and closes the file, which releases it for the other processes.
+        void Close();
+
+    protected:
+        /// First bytes of the file.
+        struct Header {
+            char magic[8]; // Kind of container.
+            uint32_t keySize; // Size of an element, or of a key.
+            uint32_t valueSize; // Size of a value, 0 without.
+            uint32_t alignment; // Alignment of an element, or of a key.
+            uint32_t valueAlignment;
+            uint64_t count; // Number of elements.
+            uint64_t capacity; // Number of elements the table can hold.
+            uint64_t tableOffset; // Offset of the table of elements, from the start of the file.
+        };
+
+        static constexpr Filesize_t HEADER_SIZE = ELEMENT_ALIGNMENT;
+
+        MappedContainer();
+
+        /**
+         * Opens the file, and initialises it if it is empty and writable, or validates its header.
+         * @param magic 8 characters telling the kind of container.
+         * @param tableSize Gives the size of the table for a capacity. It returns ~0 for a capacity which is not valid.
+         * @return False if the file could not be opened, or is another kind of container, or is truncated.
+         */
+        bool OpenContainer(Filename_t filename, MappedMode mode, const char* magic, uint32_t keySize, uint32_t valueSize,
+                           uint32_t alignment, uint32_t valueAlignment, uint64_t (*tableSize)(uint64_t capacity));
+
+        /// Sets the size of the file, which may move the mapping. On failure the mapping is unchanged (or closed).
+        bool ResizeFile(Filesize_t newSize);
+
+        Header& GetHeader() const { return *reinterpret_cast<Header*>(data); }
+        char* Table() const { return data + GetHeader().tableOffset; }
+
+        char* data = nullptr;
+        Filesize_t size = 0;
+        bool writable = false;
+
+        struct State;
+        std::unique_ptr<State> state;
+    };
+
+    /**
+     * Growable array of "T" stored in a file, as "std::vector" is in memory:
+     * > File::MappedVector<Point> points(filename); // Created if needed, or opened as it was left.
+     * > if (points.Empty()) { for (...) { points.PushBack(point); } points.Flush(); }
+     * > for (const Point& point : points) { ... }
+     * "T" must be trivially copyable. The capacity doubles when needed, which grows the file (and moves the mapping).
+     */
+    template <typename T>
+    class MappedVector : public MappedContainer {
+        static_assert(std::is_trivially_copyable<T>::value, "Elements must be trivially copyable");
+        static_assert(alignof(T) <= ELEMENT_ALIGNMENT, "Elements are aligned on 64 bytes at most");
+
+    public:
+        using value_type = T;
+        using iterator = T*;
+        using const_iterator = const T*;
+
+        /// Vector that owns nothing.
+        MappedVector() = default;
+
+        /// Opens (READ_WRITE: or creates) the vector stored in a file. Check "IsOpen".
+        explicit MappedVector(Filename_t filename, MappedMode mode = MappedMode::READ_WRITE) {
+            OpenContainer(filename, mode, "MFVECTOR", sizeof(T), 0, alignof(T), 0, &TableSize);
+        }
+
+        Filesize_t Size() const { return data ? GetHeader().count : 0; }
+        Filesize_t Capacity() const { return data ? GetHeader().capacity : 0; }
+        bool Empty() const { return !Size(); }
+
+        T& operator[](Filesize_t index) { return Elements()[index]; }
+        const T& operator[](Filesize_t index) const { return Elements()[index]; }
+        T& Back() { return Elements()[Size() - 1]; }
+        const T& Back() const { return Elements()[Size() - 1]; }
+        T* Data() { return Elements(); }
+        const T* Data() const { return Elements(); }
+
+        iterator begin() { return Elements(); }
+        iterator end() { return Elements() + Size(); }
+        const_iterator begin() const { return Elements(); }
+        const_iterator end() const { return Elements() + Size(); }
+
+        /// Makes room for "capacity" elements. Returns false if the file could not grow, or is not writable.
+        bool Reserve(Filesize_t capacity) {
+            if (!writable || !data) {
+                return false;
+            }
+            if (capacity <= GetHeader().capacity) {
+                return true;
+            }
+            if (TableSize(capacity) == ~0ull || !ResizeFile(GetHeader().tableOffset + TableSize(capacity))) {
+                return false;
+            }
+            GetHeader().capacity = capacity;
+            return true;
+        }
+
+        /// Appends an element; references to the elements are invalidated if the capacity grows.
+        bool PushBack(const T& value) {
+            const T copy = value; // "value" may be an element, moved by the growth.
+            const Filesize_t count = Size();
+            if (!writable || !data || (count == Capacity() && !Reserve(count < 16 ? 16 : count * 2))) {
+                return false;
+            }
+            Elements()[count] = copy;
+            GetHeader().count = count + 1;
+            return true;
+        }
+
+        /// Removes the last element. Returns false if there is none, or if the container is not writable.
+        bool PopBack() {
+            const Filesize_t count = Size();
+            if (!writable || !data || !count) {
+                return false;
+            }
+            GetHeader().count = count - 1;
+            return true;
+        }
+
+        /// Changes the number of elements; new ones are value-initialised.
+        bool Resize(Filesize_t count) {
+            const Filesize_t previous = Size();
+            if (!writable || !data || (count > previous && !Reserve(count))) {
+                return false;
+            }
+            for (Filesize_t i = previous; i < count; ++i) {
+                Elements()[i] = T();
+            }
+            GetHeader().count = count;
+            return true;
+        }
+
+        /// Removes every element, keeping the capacity.
+        bool Clear() {
+            return Resize(0);
+        }
+
+        /// Reduces the capacity (and the file) to the number of elements.
+        bool ShrinkToFit() {
+            if (!writable || !data) {
+                return false;
+            }
+            const Filesize_t count = Size();
+            if (!ResizeFile(GetHeader().tableOffset + TableSize(count))) {
+                return false;
+            }
+            GetHeader().capacity = count;
+            return true;
+        }
+
+    protected:
+        static uint64_t TableSize(uint64_t capacity) {
+            return capacity > ~0ull / sizeof(T) ? ~0ull : capacity * sizeof(T);
+        }
+
+        T* Elements() const { return data ? reinterpret_cast<T*>(Table()) : nullptr; }
+    };
+
+    /**
+     * Hash of the bytes of a key, the same in every process and on every run (unlike "std::hash", which only
+     * has to be stable during a run). Keys are compared by their bytes, so they must not have padding
+     * (or it must always be zeroed).
+     */
+    template <typename K>
+    struct MappedHash {
+        static_assert(std::is_trivially_copyable<K>::value, "Keys must be trivially copyable");
+
+        uint64_t operator()(const K& key) const {
+            const auto bytes = reinterpret_cast<const unsigned char*>(&key);
+            uint64_t hash = sizeof(K) * 0x9E3779B97F4A7C15ull;
+            size_t i = 0;
+            for (; i + 8 <= sizeof(K); i += 8) {
+                uint64_t word;
+                std::memcpy(&word, bytes + i, 8);
+                hash = Mix(hash ^ word);
+            }
+            if (i < sizeof(K)) {
+                uint64_t word = 0;
+                std::memcpy(&word, bytes + i, sizeof(K) - i);
+                hash = Mix(hash ^ word);
+            }
+            return hash;
+        }
+
+        /// Finaliser of MurmurHash3: every bit of the input changes about half the bits of the output.
+        static uint64_t Mix(uint64_t value) {
+            value = (value ^ (value >> 33)) * 0xFF51AFD7ED558CCDull;
+            value = (value ^ (value >> 33)) * 0xC4CEB9FE1A85EC53ull;
+            return value ^ (value >> 33);
+        }
+    };
+
+    /**
+     * Hash table from "K" to "V" stored in a file, with open addressing:
+     * > File::MappedHashMap<uint64_t, Offsets> index(filename, File::MappedMode::READ_ONLY);
+     * > if (const Offsets* offsets = index.Find(id)) { ... }
+     * Each slot has a control byte (empty, or 7 bits of the hash of its key), in a table of their own:
+     * a lookup reads the control bytes from the slot of the hash on, and only compares the keys whose bits match.
+     * Slots are taken by linear probing, at most 3/4 of them; an erased key moves back the keys after it,
+     * so there are no tombstones. When the table is full, a table twice as big is built after it in the file,
+     * then moved to its place. "K" and "V" must be trivially copyable, and "Hash" stable across processes.
+     */
+    template <typename K, typename V, typename Hash = MappedHash<K>>
+    class MappedHashMap : public MappedContainer {
+        static_assert(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value,
+                      "Keys and values must be trivially copyable");
+        static_assert(alignof(K) <= ELEMENT_ALIGNMENT && alignof(V) <= ELEMENT_ALIGNMENT, "Elements are aligned on 64 bytes at most");
+
+    public:
+        /// Map that owns nothing.
+        MappedHashMap() = default;
+
+        /// Opens (READ_WRITE: or creates) the map stored in a file. Check "IsOpen".
+        explicit MappedHashMap(Filename_t filename, MappedMode mode = MappedMode::READ_WRITE) {
+            OpenContainer(filename, mode, "MFHASHMP", sizeof(K), sizeof(V), alignof(K), alignof(V), &TableSize);
+        }
+
+        Filesize_t Size() const { return data ? GetHeader().count : 0; }
+        Filesize_t Capacity() const { return data ? GetHeader().capacity : 0; }
+        bool Empty() const { return !Size(); }
+
+        /// Value of a key, nullptr if absent. Valid until the map grows.
+        V* Find(const K& key) { return const_cast<V*>(static_cast<const MappedHashMap*>(this)->Find(key)); }
+        const V* Find(const K& key) const {
+            const uint64_t index = FindIndex(key);
+            return index < Capacity() ? &Slots()[index].value : nullptr;
+        }
+
+        bool Contains(const K& key) const { return Find(key) != nullptr; }
+
+        /// Sets the value of a key, added if absent. Returns false if the table could not grow, or is not writable.
+        bool Set(const K& key, const V& value) {
+            if (!writable || !data) {
+                return false;
+            }
+            if (V* found = Find(key)) {
+                *found = value;
+                return true;
+            }
+            const K keyCopy = key; // They may be in the table, moved by the growth.
+            const V valueCopy = value;
+            if (!Reserve(Size() + 1)) {
+                return false;
+            }
+            Place(Controls(), Slots(), Capacity(), Hash()(keyCopy), keyCopy, valueCopy);
+            ++GetHeader().count;
+            return true;
+        }
+
+        /// Removes a key. Returns false if it was absent, or if the map is not writable.
+        bool Erase(const K& key) {
+            if (!writable || !data) {
+                return false;
+            }
+            uint64_t hole = FindIndex(key);
+            if (hole >= Capacity()) {
+                return false;
+            }
+            unsigned char* controls = Controls();
+            Slot* slots = Slots();
+            const uint64_t mask = Capacity() - 1;
+            // The keys after the hole are moved back to it if the hole is between their slot of hash and them.
+            for (uint64_t i = (hole + 1) & mask; controls[i]; i = (i + 1) & mask) {
+                const uint64_t home = Hash()(slots[i].key) & mask;
+                if (((i - home) & mask) >= ((i - hole) & mask)) {
+                    controls[hole] = controls[i];
+                    slots[hole] = slots[i];
+                    hole = i;
+                }
+            }
+            controls[hole] = 0;
+            --GetHeader().count;
+            return true;
+        }
+
+        /// Removes every key, keeping the capacity.
+        bool Clear() {
+            if (!writable || !data) {
+                return false;
+            }
+            std::memset(Controls(), 0, static_cast<size_t>(Capacity()));
+            GetHeader().count = 0;
+            return true;
+        }
+
+        /// Makes room for "count" keys without growing again. Returns false if the file could not grow, or is not writable.
+        bool Reserve(Filesize_t count) {
+            if (!writable || !data) {
+                return false;
+            }
+            uint64_t capacity = Capacity() ? Capacity() : MIN_CAPACITY;
+            while (count > capacity / 4 * 3) {
+                capacity *= 2;
+            }
+            return capacity == Capacity() || Grow(capacity);
+        }
+
+        /// Calls "function(key, value)" for each key, in no particular order.
+        template <typename Function>
+        void ForEach(Function function) const {
+            const unsigned char* controls = Controls();
+            for (uint64_t i = 0; i < Capacity(); ++i) {
+                if (controls[i]) {
+                    function(static_cast<const K&>(Slots()[i].key), static_cast<const V&>(Slots()[i].value));
+                }
+            }
+        }
+
+    protected:
+        struct Slot {
+            K key;
+            V value;
+        };
+
+        static constexpr uint64_t MIN_CAPACITY = 16;
+
+        static uint64_t AlignUp(uint64_t value) {
+            return (value + ELEMENT_ALIGNMENT - 1) / ELEMENT_ALIGNMENT * ELEMENT_ALIGNMENT;
+        }
+
+        /// The control bytes, then the slots.
+        static uint64_t TableSize(uint64_t capacity) {
+            if (capacity & (capacity - 1) || capacity > ~0ull / 2 / (sizeof(Slot) + 1)) {
+                return ~0ull;
+            }
+            return AlignUp(capacity) + capacity * sizeof(Slot);
+        }
+
+        /// 7 bits of the hash other than the ones giving the slot, plus one so that it is never 0 (empty).
+        static unsigned char Control(uint64_t hash) {
+            return static_cast<unsigned char>(0x80 | hash >> 57);
+        }
+
+        static bool SameKey(const K& a, const K& b) {
+            return !std::memcmp(&a, &b, sizeof(K));
+        }
+
+        static void Place(unsigned char* controls, Slot* slots, uint64_t capacity, uint64_t hash, const K& key, const V& value) {
+            uint64_t i = hash & (capacity - 1);
+            while (controls[i]) {
+                i = (i + 1) & (capacity - 1);
+            }
+            controls[i] = Control(hash);
+            slots[i].key = key;
+            slots[i].value = value;
+        }
+
+        /// Slot of a key, or the capacity if it is absent.
+        uint64_t FindIndex(const K& key) const {
+            const uint64_t capacity = Capacity();
+            if (!capacity) {
+                return 0;
+            }
+            const uint64_t hash = Hash()(key);
+            const unsigned char control = Control(hash);
+            const unsigned char* controls = Controls();
+            const Slot* slots = Slots();
+            for (uint64_t i = hash & (capacity - 1);; i = (i + 1) & (capacity - 1)) {
+                if (!controls[i]) {
+                    return capacity;
+                }
+                if (controls[i] == control && SameKey(slots[i].key, key)) {
+                    return i;
+                }
+            }
+        }
+
+        unsigned char* Controls() const { return reinterpret_cast<unsigned char*>(Table()); }
+        Slot* Slots() const { return reinterpret_cast<Slot*>(Table() + AlignUp(GetHeader().capacity)); }
+
+        /// Builds the bigger table after the current one, then moves it to the place of the current one.
+        bool Grow(uint64_t capacity) {
+            const uint64_t previous = Capacity();
+            const Filesize_t offset = GetHeader().tableOffset;
+            const Filesize_t newOffset = AlignUp(offset + TableSize(previous));
+            const Filesize_t newSize = TableSize(capacity);
+            if (!ResizeFile(newOffset + newSize)) {
+                return false;
+            }
+            unsigned char* newControls = reinterpret_cast<unsigned char*>(data + newOffset);
+            Slot* newSlots = reinterpret_cast<Slot*>(data + newOffset + AlignUp(capacity));
+            std::memset(newControls, 0, static_cast<size_t>(capacity));
+            const unsigned char* controls = Controls();
+            const Slot* slots = Slots();
+            for (uint64_t i = 0; i < previous; ++i) {
+                if (controls[i]) {
+                    Place(newControls, newSlots, capacity, Hash()(slots[i].key), slots[i].key, slots[i].value);
+                }
+            }
+            std::memmove(data + offset, data + newOffset, static_cast<size_t>(newSize));
+            GetHeader().capacity = capacity;
+            // On Unix, a failed shrink leaves the file mapped and the table valid. On Windows the mapping is
+            // released first: if it cannot be mapped again, the container is closed.
+            ResizeFile(offset + newSize);
+            return data != nullptr;
+        }
+    };
+
+    template <typename K, typename V, typename Hash>
+    constexpr uint64_t MappedHashMap<K, V, Hash>::MIN_CAPACITY;
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILECONTAINERS_HPP
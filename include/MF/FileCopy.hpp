@@ -0,0 +1,56 @@
+//
+// File module: copy of files and directory trees, done by the kernel where possible.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILECOPY_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILECOPY_HPP
+
+#include "MF/File.hpp"
+
+namespace File {
+    /// How a file was copied, the first methods being the cheapest.
+    enum class CopyMethod {
+        FAILED, // Nothing could be copied
+        REFLINK, // The data is shared with the source until one of them is modified (FICLONE): nothing is copied
+        COPY_FILE_RANGE, // Copied inside the kernel, or by the file system itself (server-side copy on NFS...)
+        SENDFILE, // Copied inside the kernel through the page cache
+        BUFFERED, // Read and written through a buffer, as a last resort
+        SYSTEM // Copied by the system (CopyFileEx on Windows)
+    };
+
+    /**
+     * Copies a regular file with the cheapest method available: FICLONE reflink, copy_file_range, sendfile,
+     * then plain reads and writes. Holes of sparse files are preserved (SEEK_DATA / SEEK_HOLE),
+     * and the permissions are copied, those of an overwritten destination included.
+     * @param source Name of the file to copy.
+     * @param destination Name of the copy. Its directory must exist. The copy fails, leaving both untouched,
+     *                    if it is the source itself or a hard link to it.
+     * @param overwrite If false, the copy fails if "destination" exists.
+     * @return The method used, FAILED on failure (a partial destination is removed).
+     */
+    CopyMethod Copy(Filename_t source, Filename_t destination, bool overwrite = true);
+
+    /// Counters returned by "CopyTree".
+    struct CopyTreeResult {
+        size_t files = 0; // Regular files copied
+        size_t directories = 0; // Directories created, the root included
+        size_t links = 0; // Symbolic links copied as links
+        size_t failures = 0; // Entries which could not be copied
+        Filesize_t bytes = 0; // Size of the copied files
+        size_t reflinks = 0; // Files copied with REFLINK, so without using any space
+    };
+
+    /**
+     * Copies a directory and all its contents. Directories are created first, then the files are copied
+     * by several threads with "Copy". Symbolic links are copied as links and never followed;
+     * other special files (devices, sockets, pipes) are counted as failures.
+     * Existing files in "destination" are overwritten. "destination" must not be inside "source".
+     * @param source Directory to copy.
+     * @param destination Directory to create (or to fill if it exists).
+     * @param threads Number of threads copying files, 0 for one per hardware thread.
+     * @return What was copied. "failures" is 0 on full success.
+     */
+    CopyTreeResult CopyTree(Filename_t source, Filename_t destination, unsigned int threads = 0);
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILECOPY_HPP
@@ -0,0 +1,39 @@
+//
+// File module: removal of directory trees.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILEDELETE_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILEDELETE_HPP
+
+#include <functional>
+#include "MF/File.hpp"
+
+namespace File {
+    /// Counters returned by "DeleteTree", and given to its progress callback.
+    struct DeleteTreeResult {
+        size_t files = 0; // Entries other than directories removed: files, symbolic links, special files
+        size_t directories = 0; // Directories removed, the root included
+        size_t failures = 0; // Entries which could not be removed
+    };
+
+    /// Called by "DeleteTree" with the counters so far. Never called concurrently.
+    using DeleteTreeProgress = std::function<void(const DeleteTreeResult& progress)>;
+
+    /**
+     * Removes a directory and all its contents. Symbolic links are removed, never followed.
+     * On Unix, every directory is opened relative to its parent (openat with O_NOFOLLOW) and its entries are removed
+     * relative to it (unlinkat), so no path is ever built and the tree cannot be redirected by a concurrent rename.
+     * Subdirectories are processed by several threads; a directory is removed as soon as its last subdirectory is.
+     * @param directory Directory to remove.
+     * @param threads Number of threads, 0 for one per hardware thread.
+     * @param progress If set, called from any of the threads every "DELETE_TREE_PROGRESS_INTERVAL" removals.
+     * @return What was removed. "failures" is 0 on full success.
+     */
+    DeleteTreeResult DeleteTree(Filename_t directory, unsigned int threads = 0,
+                                const DeleteTreeProgress& progress = DeleteTreeProgress());
+
+    /// Number of removals between two calls to the progress callback of "DeleteTree".
+    constexpr size_t DELETE_TREE_PROGRESS_INTERVAL = 1024;
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILEDELETE_HPP
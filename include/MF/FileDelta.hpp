@@ -0,0 +1,96 @@
+//
+// File module: differences between two versions of a file, as blocks of the old one and new bytes (rsync algorithm).
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILEDELTA_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILEDELTA_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MF/FileOpen.hpp"
+
+namespace File {
+    /// Checksums of the blocks of a file (the "basis"), enough to encode a new version of it without having it.
+    struct DeltaSignature {
+        Filesize_t size = 0; // Size of the basis.
+        uint32_t blockSize = 0;
+        std::vector<uint32_t> weak; // Rolling checksum of each block. The last block may be shorter.
+        std::vector<uint64_t> strong; // XXH64 of each block.
+
+        /// Compact binary form, to be sent to the side having the new version.
+        std::string Serialize() const;
+
+        /// Reads what "Serialize" gave. Returns false (and leaves an empty signature) if it is not valid.
+        bool Parse(const char* data, size_t size);
+    };
+
+    /**
+     * Computes the signature of a basis: one weak and one strong checksum per block.
+     * @param contents Bytes of the basis.
+     * @param size Size of the basis.
+     * @param blockSize Size of the blocks, 0 to choose it from the size of the basis (its square root, within [1 KiB, 128 KiB]).
+     *                  Smaller blocks find smaller unchanged parts, but make a bigger signature.
+     */
+    DeltaSignature ComputeSignature(const char* contents, Filesize_t size, uint32_t blockSize = 0);
+
+    /// Same as above, for something returned by "Read".
+    inline DeltaSignature ComputeSignature(const ReadFileData* content, uint32_t blockSize = 0) {
+        return ComputeSignature(content->contents, content->size, blockSize);
+    }
+
+    /**
+     * Encodes a new version of a file against the signature of its basis. The new version is scanned with a checksum
+     * rolled one byte at a time, so blocks of the basis are found at any offset; a candidate block is confirmed
+     * by its strong checksum. The delta holds references to runs of blocks and the bytes found nowhere in the basis,
+     * so its size is about what changed (plus a few bytes per run of blocks).
+     * > File::DeltaSignature signature = File::ComputeSignature(oldContent); // Where the old version is.
+     * > std::string delta = File::ComputeDelta(signature, newContent); // Where the new version is.
+     * > File::ApplyDelta(oldContent, delta.data(), delta.size(), outputName); // Back where the old version is.
+     * @param signature Signature of the basis.
+     * @param contents Bytes of the new version.
+     * @param size Size of the new version.
+     * @param inPlace If true, blocks are only used where "ApplyDeltaInPlace" can copy them without overwriting one
+     *                needed later: at their offset in the basis or before it. Bytes moved further become new bytes.
+     * @return The delta, which embeds a checksum of itself.
+     */
+    std::string ComputeDelta(const DeltaSignature& signature, const char* contents, Filesize_t size, bool inPlace = false);
+
+    /// Same as above, for something returned by "Read".
+    inline std::string ComputeDelta(const DeltaSignature& signature, const ReadFileData* content, bool inPlace = false) {
+        return ComputeDelta(signature, content->contents, content->size, inPlace);
+    }
+
+    /**
+     * Writes the new version of a file from its basis and a delta. The output is written atomically, so it can be the
+     * basis file itself (whose contents must stay valid until the call returns, as a mapping does).
+     * @param basis Bytes of the basis the delta was computed against.
+     * @param basisSize Size of the basis, which must be the one of the signature.
+     * @param delta Delta from "ComputeDelta".
+     * @param deltaSize Size of the delta.
+     * @param output Name of the file to write.
+     * @return False if the delta is corrupted or does not match the basis, or if writing failed.
+     */
+    bool ApplyDelta(const char* basis, Filesize_t basisSize, const char* delta, size_t deltaSize, Filename_t output);
+
+    /// Same as above, for something returned by "Read".
+    inline bool ApplyDelta(const ReadFileData* basis, const char* delta, size_t deltaSize, Filename_t output) {
+        return ApplyDelta(basis->contents, basis->size, delta, deltaSize, output);
+    }
+
+    /**
+     * Turns the basis file into the new version by writing only what differs: blocks at their offset are left alone,
+     * moved blocks are copied inside the file, and new bytes are written; the file is then truncated to its new size.
+     * The delta must have been computed with "inPlace". Unlike "ApplyDelta", a failure or a crash in the middle leaves
+     * the file neither old nor new.
+     * @param filename Basis file, modified.
+     * @param delta Delta from "ComputeDelta(..., true)".
+     * @param deltaSize Size of the delta.
+     * @param written If not null, receives the number of bytes written to the file.
+     * @return False if the delta is corrupted, was not computed for in-place use or does not match the file,
+     *         in which case the file is unchanged, or if reading or writing failed.
+     */
+    bool ApplyDeltaInPlace(Filename_t filename, const char* delta, size_t deltaSize, Filesize_t* written = nullptr);
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILEDELTA_HPP
@@ -0,0 +1,58 @@
+//
+// File module: search of files with identical contents.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILEDUPLICATES_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILEDUPLICATES_HPP
+
+#include <vector>
+#include "MF/File.hpp"
+
+namespace File {
+    /// Files with the same contents.
+    struct DuplicateGroup {
+        Filesize_t size = 0; // Size of each file.
+        std::vector<SFilename_t> files; // Names of the files, sorted. Hard links to the same file are all listed.
+        size_t copies = 0; // Number of distinct files (inodes) among "files", at least 2.
+    };
+
+    /// Settings of "FindDuplicates".
+    struct DuplicatesOptions {
+        /// Number of threads reading and hashing files, 0 for one per hardware thread.
+        unsigned int threads = 0;
+        /// Files smaller than this are ignored. Empty files are always ignored.
+        Filesize_t minimumSize = 1;
+    };
+
+    /// Result of "FindDuplicates".
+    struct DuplicatesResult {
+        std::vector<DuplicateGroup> groups; // Sorted by decreasing reclaimable bytes.
+        Filesize_t reclaimableBytes = 0; // Space freed by keeping only one file of each group.
+        size_t files = 0; // Regular files found under the roots.
+        size_t sampled = 0; // Files of which the first and last 4 KiB were hashed.
+        size_t fullyHashed = 0; // Files read entirely.
+        size_t compared = 0; // Files compared byte by byte with the first of their group.
+        size_t failures = 0; // Directories or files which could not be read.
+    };
+
+    /**
+     * Finds the files with identical contents under some roots. Symbolic links are never followed.
+     * Files are compared in stages, each one only looking at the candidates left by the previous one:
+     *  - size: a file with a unique size has no duplicate;
+     *  - hash of the first and last 4 KiB ("DUPLICATES_SAMPLE_SIZE"), read through a mapping;
+     *  - hash of the whole contents, read with "File::Read";
+     *  - comparison of the contents with the first file of the group, read once for the whole group, so that a collision
+     *    of the 64-bit hashes (XXH64), even a deliberately crafted one, never makes a group.
+     * So most files are never entirely read, and the duplicates are read twice. Work is done by several threads,
+     * one file per job (one group per job for the comparison).
+     * @param roots Directories (or files) to search.
+     * @param options Settings.
+     * @return The duplicate groups, and counters.
+     */
+    DuplicatesResult FindDuplicates(const std::vector<SFilename_t>& roots, const DuplicatesOptions& options = DuplicatesOptions());
+
+    /// Number of bytes hashed at each end of a file before hashing it entirely.
+    constexpr Filesize_t DUPLICATES_SAMPLE_SIZE = 4096;
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILEDUPLICATES_HPP
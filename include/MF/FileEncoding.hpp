@@ -0,0 +1,130 @@
+//
+// File module: encoding detection and UTF-16LE transcoding based on the whole contents of a file.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILEENCODING_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILEENCODING_HPP
+
+#include <functional>
+#include <string>
+#include "MF/FileOpen.hpp"
+
+namespace File {
+    /// Outcome of a transcoding call.
+    enum class TranscodeStatus {
+        OK, // The whole source was transcoded
+        INVALID, // Stopped on an unpaired surrogate
+        TRUNCATED, // The source ends in the middle of a code unit or of a surrogate pair
+        DESTINATION_FULL // Stopped because the next character would not fit in the destination
+    };
+
+    /// Result of a transcoding call.
+    struct TranscodeResult {
+        TranscodeStatus status = TranscodeStatus::OK;
+        Filesize_t read = 0; // Number of bytes consumed from the source
+        Filesize_t written = 0; // Number of code units written in the destination (bytes for UTF-8)
+    };
+
+    /// Result of a content-based encoding detection.
+    struct EncodingDetection {
+        /// Detected encoding. ENC_DEFAULT if the contents is not valid in any supported Unicode encoding.
+        encoding_t encoding = encoding_t::ENC_ERROR;
+        /// Offset of the first byte of the first ill-formed sequence, or the size of the contents if all is valid.
+        /// With ENC_DEFAULT, it is the first offset where the contents stopped being valid UTF-8.
+        Filesize_t firstInvalid = 0;
+        /// Number of bytes taken by the Byte Order Mark, 0 if there is none.
+        unsigned int bomLength = 0;
+
+        /// True if the whole contents is valid in the detected encoding.
+        bool IsValid(Filesize_t size) const { return encoding != encoding_t::ENC_ERROR && firstInvalid == size; }
+    };
+
+    /**
+     * Checks that the given bytes are well-formed UTF-8 (no overlong form, no surrogate, nothing above U+10FFFF).
+     * Uses AVX2 when the CPU supports it, otherwise an SSE2 ASCII fast path or plain scalar code.
+     * @param contents Bytes to check, not necessarily null-terminated.
+     * @param size Number of bytes to check.
+     * @return Offset of the first byte of the first invalid sequence, or "size" if everything is valid.
+     */
+    Filesize_t ValidateUTF8(const char* contents, Filesize_t size);
+
+    /**
+     * Determines the encoding of a buffer from its contents, not only from its Byte Order Mark.
+     * Without a BOM, UTF-16LE/BE and UTF-32LE/BE are recognised by the distribution of their null bytes,
+     * and any other contents is validated as UTF-8.
+     * @param contents Bytes to analyse.
+     * @param size Number of bytes.
+     * @return The detected encoding, the first invalid offset and the BOM length.
+     */
+    EncodingDetection DetectEncoding(const char* contents, Filesize_t size);
+
+    /// Same as above, directly on something returned by "Read". Returns ENC_ERROR if "content" is null.
+    EncodingDetection DetectEncoding(const ReadFileData* content);
+
+    /// Same as above, internally using "Read". Returns ENC_ERROR if the file could not be read (or is empty).
+    EncodingDetection DetectEncoding(Filename_t filename);
+
+    /// Number of UTF-8 bytes sufficient to transcode "sourceSize" bytes of UTF-16LE, whatever they are.
+    constexpr Filesize_t UTF16LEToUTF8_MaxLength(Filesize_t sourceSize) { return sourceSize / 2 * 3; }
+
+    /**
+     * Transcodes UTF-16LE into UTF-8, in a buffer owned by the caller.
+     * Runs of ASCII are converted 16 (AVX2) or 8 (SSE2) code units at a time.
+     * No BOM is skipped nor written: give "contents + bomLength" if needed.
+     * @param source UTF-16LE bytes.
+     * @param sourceSize Number of bytes in "source".
+     * @param destination Buffer to fill, "UTF16LEToUTF8_MaxLength(sourceSize)" bytes is always enough.
+     * @param destinationSize Size of "destination" in bytes.
+     * @return How much was read and written; on failure "read" is the offset of the faulty code unit.
+     */
+    TranscodeResult UTF16LEToUTF8(const char* source, Filesize_t sourceSize, char* destination, Filesize_t destinationSize);
+
+    /// Same as "UTF16LEToUTF8", towards UTF-32. "sourceSize / 2" code points is always enough.
+    TranscodeResult UTF16LEToUTF32(const char* source, Filesize_t sourceSize, char32_t* destination, Filesize_t destinationSize);
+
+    /**
+     * Streaming UTF-16LE to UTF-8 decoder: chunks may be cut anywhere, even inside a code unit or a surrogate pair.
+     * The incomplete end of a chunk is kept until the next call to "Decode".
+     */
+    class UTF16LEDecoder {
+    public:
+        /**
+         * Decodes one more chunk and appends the UTF-8 result to "output".
+         * @return OK, or INVALID on an unpaired surrogate (the decoder then stays in error until "Reset").
+         */
+        TranscodeStatus Decode(const char* chunk, Filesize_t chunkSize, std::string& output);
+
+        /// Returns TRUNCATED if the stream ended in the middle of a character, OK otherwise.
+        TranscodeStatus Finish() const;
+
+        /// Forgets any pending bytes and error.
+        void Reset();
+
+    protected:
+        char pending[4] = {0, 0, 0, 0}; // Incomplete end of the previous chunk.
+        unsigned int pendingSize = 0;
+        bool failed = false;
+    };
+
+    /**
+     * Decodes a whole UTF-16LE file into UTF-8, through a "Read" mapping and without any locale.
+     * The BOM is skipped if present. The result is given chunk by chunk, to keep memory usage bounded.
+     * @param filename Name of the file to decode.
+     * @param callback Called with each decoded UTF-8 chunk.
+     * @param chunkSize Number of source bytes decoded per callback (rounded to an even number).
+     * @return OK on success, TRUNCATED if the file ends inside a character,
+     *         INVALID on an unpaired surrogate or if the file could not be read.
+     */
+    TranscodeStatus DecodeUTF16LEFile(Filename_t filename, const std::function<void(const char*, size_t)>& callback,
+                                      Filesize_t chunkSize = 1 << 20);
+
+    /**
+     * Wrapper function: fills a UTF-8 string with a whole UTF-16LE file, BOM skipped.
+     * @param filename Name of the file to read.
+     * @param string Decoded contents, not modified if an error occurred.
+     * @return True on success, false on error (unreadable file or invalid UTF-16LE).
+     */
+    bool ReadUTF16LEToString(Filename_t filename, std::string& string);
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILEENCODING_HPP
@@ -0,0 +1,123 @@
+//
+// File module: selection of files in directory trees by glob patterns ("src/**/*.cpp").
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILEGLOB_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILEGLOB_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "MF/File.hpp"
+
+namespace File {
+    /**
+     * Glob pattern compiled once, then matched against any number of relative paths.
+     * The pattern is cut into components by "/" (and FILE_SEPARATOR); each component matches one name:
+     * - "*" any characters (none included), "?" one character, "[abc]", "[a-z]" and "[!a-z]" one character of a set;
+     * - "**" alone as a component matches any number of directories (none included): "**" + "/" + "*.cpp" finds
+     *   the ".cpp" files at any depth, and "build/" + "**" everything under "build".
+     * A pattern ending with a separator only matches directories.
+     * Names starting with a dot are matched like the others, and characters are compared exactly (case-sensitive).
+     * Components are matched the cheapest way they allow: plain names are compared whole, and "prefix*suffix"
+     * by both ends; only the others go through the general matching.
+     *
+     * A path is matched one name at a time, with "States" (the set of how many components may have been matched yet),
+     * so that a walk knows after each directory whether anything below it can match ("CanDescend"), and
+     * which names it expects when they are all plain ("ExactNames"), to look them up without listing the directory.
+     */
+    class GlobPattern {
+    public:
+        /// Bit "i" is set if the first "i" components may have been matched by the names so far.
+        using States = uint64_t;
+
+        /// Maximum number of components of a pattern, as "States" has a bit per component plus one.
+        static constexpr size_t MAX_COMPONENTS = 63;
+
+        /// Compiles a pattern. It is invalid (and matches nothing) if a "[" is not closed or if it has too many components.
+        explicit GlobPattern(const SFilename_t& pattern);
+
+        bool IsValid() const { return valid; }
+
+        /// True if the pattern ends with a separator: it only matches directories.
+        bool DirectoriesOnly() const { return directoriesOnly; }
+
+        /// True if a path relative to the root of the walk matches the whole pattern; a trailing separator marks a directory.
+        bool Matches(const SFilename_t& path) const;
+
+        /// States before any name: at the root of the walk.
+        States Start() const;
+
+        /// States after one more name (a file or directory in the directory reached by "states").
+        States Step(States states, const SFilename_t& name) const;
+
+        /// True if the names so far match the whole pattern.
+        bool IsMatch(States states) const { return valid && (states >> components.size() & 1); }
+
+        /// True if a name below the directory reached by "states" may match: otherwise, it need not be walked.
+        bool CanDescend(States states) const { return valid && (states & ~(States(1) << components.size())); }
+
+        /**
+         * Gives the only names which may follow, when every component awaited by "states" is a plain name:
+         * they can then be looked up directly instead of listing the directory.
+         * @return False if any name may follow.
+         */
+        bool ExactNames(States states, std::vector<SFilename_t>& names) const;
+
+    protected:
+        using Char = SFilename_t::value_type;
+
+        struct Token {
+            enum class Kind : uint8_t { LITERAL, ANY, SET, STAR };
+            Kind kind;
+            SFilename_t text; // LITERAL.
+            std::vector<std::pair<Char, Char>> ranges; // SET: inclusive ranges of characters.
+            bool negated; // SET: matches the characters outside of the ranges.
+        };
+
+        struct Component {
+            enum class Kind : uint8_t {
+                EXACT, // Plain name, in "prefix"
+                STAR, // "prefix*suffix"
+                GLOBSTAR, // "**": any number of names
+                GENERAL // "tokens"
+            };
+            Kind kind;
+            SFilename_t prefix;
+            SFilename_t suffix;
+            std::vector<Token> tokens;
+        };
+
+        std::vector<Component> components;
+        bool valid = true;
+        bool directoriesOnly = false;
+
+        /// Adds the states reached by matching no name with "**".
+        States Closure(States states) const;
+
+        static bool MatchComponent(const Component& component, const SFilename_t& name);
+        static bool MatchTokens(const std::vector<Token>& tokens, const SFilename_t& name);
+        static bool MatchToken(const Token& token, const SFilename_t& name, size_t position, size_t& length);
+    };
+
+    /**
+     * Finds the files and directories of a tree matching a pattern:
+     * > for (const File::SFilename_t& path : File::Glob(root, File::GlobPattern(MAKE_FILE_NAME "**" "/" "*.scx"))) { ... }
+     * The tree is walked one level at a time, the directories of a level listed by several threads. Only the directories
+     * below which something may match are walked, and those where only plain names may match are not even listed:
+     * their names are looked up ("src/main/" + "**" + "/" + "*.cpp" starts at "src/main" directly).
+     * Symbolic links are never followed, but are matched as files.
+     * @param root Directory to search.
+     * @param pattern Pattern matched against the paths relative to "root".
+     * @param threads Number of threads, 0 for one per hardware thread.
+     * @return The paths relative to "root", sorted; those of directories end with a FILE_SEPARATOR.
+     */
+    std::vector<SFilename_t> Glob(Filename_t root, const GlobPattern& pattern, unsigned int threads = 0);
+
+    /// Same as above, compiling the pattern.
+    inline std::vector<SFilename_t> Glob(Filename_t root, const SFilename_t& pattern, unsigned int threads = 0) {
+        return Glob(root, GlobPattern(pattern), threads);
+    }
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILEGLOB_HPP
@@ -0,0 +1,106 @@
+//
+// File module: streaming decompression of DEFLATE and zlib data.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILEINFLATE_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILEINFLATE_HPP
+
+#include <functional>
+#include <memory>
+#include <string>
+#include "MF/FileOpen.hpp"
+
+namespace File {
+    /// Container of the compressed data.
+    enum class InflateFormat {
+        RAW, // DEFLATE blocks only (RFC 1951)
+        ZLIB // Two-byte header, DEFLATE blocks, then the Adler-32 checksum of the contents (RFC 1950)
+    };
+
+    /**
+     * Gives the next piece of compressed data to an "Inflater", without copy.
+     * @param data Set to the first byte of the piece, which must stay readable until the next call.
+     * @param size Set to the size of the piece.
+     * @return False when there is no more data.
+     */
+    using InflateSource = std::function<bool(const char*& data, size_t& size)>;
+
+    /**
+     * Decompresses a DEFLATE or zlib stream in constant memory, whatever the sizes of the input and the output:
+     * the input comes piece by piece from an "InflateSource" (for example the windows of a "WindowedReader"),
+     * and the output goes through a buffer of "BUFFER_SIZE" bytes which also holds the history the stream refers to.
+     * > const File::ReadFileData* content = File::Read(filename);
+     * > File::Inflater inflater(content, 8); // The zlib stream begins after an 8-byte header.
+     * > inflater.ReadAll([](const char* data, size_t size) { ...; return true; });
+     * > if (inflater.Failed()) { ... }
+     * Huffman codes are decoded with lookup tables (10 bits for literals and lengths, 8 for distances, with sub-tables
+     * for longer codes), which give one symbol per lookup; runs of literals are decoded without refilling the bits.
+     */
+    class Inflater {
+    public:
+        /// Size of the output buffer, history included: DEFLATE refers to at most the last 32 KiB.
+        static constexpr size_t BUFFER_SIZE = 256ul << 10;
+
+        /// Decompresses what "source" gives.
+        explicit Inflater(InflateSource source, InflateFormat format = InflateFormat::ZLIB);
+
+        /// Decompresses a buffer, which must stay readable as long as the inflater is used.
+        Inflater(const char* data, size_t size, InflateFormat format = InflateFormat::ZLIB);
+
+        /**
+         * Decompresses the contents of a file.
+         * @param content As returned by "Read". It must not be closed as long as the inflater is used.
+         * @param offset Offset of the compressed stream in the file, to skip the header of a container.
+         * @param format Container of the compressed stream.
+         */
+        explicit Inflater(const ReadFileData* content, Filesize_t offset = 0, InflateFormat format = InflateFormat::ZLIB);
+
+        ~Inflater();
+
+        Inflater(const Inflater&) = delete;
+        Inflater& operator=(const Inflater&) = delete;
+
+        /**
+         * Decompresses the next bytes.
+         * @param buffer Where to write them.
+         * @param capacity Maximal number of bytes to write.
+         * @return The number of bytes written, less than "capacity" only at the end of the stream or on error.
+         */
+        size_t Read(char* buffer, size_t capacity);
+
+        /**
+         * Decompresses the rest of the stream, giving it to "sink" by pieces of up to "BUFFER_SIZE" bytes, without copy.
+         * @param sink Called with each piece, valid during the call only. Returns false to stop.
+         * @return True if the whole stream was decompressed (and its checksum verified), false on error or if "sink" stopped.
+         */
+        bool ReadAll(const std::function<bool(const char* data, size_t size)>& sink);
+
+        /// True once the end of the stream was reached and checked.
+        bool IsDone() const;
+
+        /// True if the stream is corrupted or truncated. Nothing more can be read then.
+        bool Failed() const;
+
+        /// Number of compressed bytes used so far. Once done, the bytes which follow the stream (if any) are not counted.
+        Filesize_t TotalIn() const;
+
+        /// Number of bytes decompressed so far, read or not.
+        Filesize_t TotalOut() const;
+
+    protected:
+        struct State;
+        std::unique_ptr<State> state;
+    };
+
+    /**
+     * Decompresses a whole stream into a string.
+     * @param content As returned by "Read".
+     * @param output Filled with the decompressed bytes, even partially on failure.
+     * @param offset Offset of the compressed stream in the file.
+     * @param format Container of the compressed stream.
+     * @return True on success, false if the stream is corrupted or truncated.
+     */
+    bool Inflate(const ReadFileData* content, std::string& output, Filesize_t offset = 0, InflateFormat format = InflateFormat::ZLIB);
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILEINFLATE_HPP
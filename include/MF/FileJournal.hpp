@@ -0,0 +1,93 @@
+//
+// File module: durable append-only log of records, shared by threads.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILEJOURNAL_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILEJOURNAL_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include "MF/File.hpp"
+#include "MF/FileWriter.hpp"
+
+namespace File {
+    /// Settings of a "Journal".
+    struct JournalOptions {
+        /// Size of the segment files, allocated upfront, rounded down to a multiple of 8 (4096 at least).
+        /// A record must fit in one segment with its 8-byte header.
+        Filesize_t segmentSize = 64ul << 20;
+        /// NONE: "Append" returns once the record is in the page cache, and "Sync" makes the records durable.
+        /// SYNC_DATA or SYNC_DIRECTORY: "Append" returns once the record is on the device.
+        Durability durability = Durability::SYNC_DATA;
+    };
+
+    /**
+     * Log of records which survive a crash once appended, for example the state of jobs.
+     * The records go to segment files of a directory ("0000000000000001.journal", ...), which are written with zeros
+     * when created, so that making a record durable only writes data, never metadata (fdatasync). Appending a record
+     * writes it after the previous one with a single system call, preceded by its size and a checksum of it.
+     * Segments are never modified once full.
+     * > File::Journal journal(directory);
+     * > journal.ForEach([](const char* data, size_t size) { ...; return true; }); // State before the restart.
+     * > if (!journal.Append(record)) { ... } // From any thread.
+     * Waiting for the device is shared by the threads (group commit): while one thread synchronises the segment,
+     * the others append their records, which are then made durable together by a single synchronisation.
+     * On opening, the last segment is scanned up to the first record whose checksum does not match, which is where
+     * a crash stopped the writing; what follows is erased.
+     * Any error is sticky: every later "Append" fails.
+     */
+    class Journal {
+    public:
+        /**
+         * Opens the journal of a directory, which is created if needed, and recovers it.
+         * @param directory Directory of the segment files. It must not be used by another journal at the same time.
+         * @param options Settings. The size of the existing segments is kept.
+         */
+        explicit Journal(Filename_t directory, const JournalOptions& options = JournalOptions());
+
+        /// Closes the journal. With Durability::NONE, the records not synchronised yet are left to the system.
+        ~Journal();
+
+        Journal(const Journal&) = delete;
+        Journal& operator=(const Journal&) = delete;
+
+        /// True if the journal could be opened and no error occurred.
+        bool IsOpen() const;
+
+        /**
+         * Appends a record. Thread-safe.
+         * @param data Bytes of the record.
+         * @param size Size of the record, at most "MaxRecordSize()".
+         * @return False if the record is too big, or if writing or synchronising failed (or failed before).
+         */
+        bool Append(const char* data, size_t size);
+
+        /// Same as above, for a C++ string.
+        bool Append(const std::string& record) { return Append(record.data(), record.size()); }
+
+        /// Waits until every record appended so far is on the device. Thread-safe.
+        bool Sync();
+
+        /**
+         * Reads the records, in the order in which they were appended.
+         * @param reader Called with each record, valid during the call only. Returns false to stop.
+         *               Records appended during the call may be read or not.
+         * @return False if a segment could not be read.
+         */
+        bool ForEach(const std::function<bool(const char* data, size_t size)>& reader) const;
+
+        /// Number of records: recovered on opening, then appended.
+        uint64_t RecordCount() const;
+
+        /// Size of the biggest record a segment can hold.
+        size_t MaxRecordSize() const;
+
+    protected:
+        struct State;
+        std::unique_ptr<State> state;
+    };
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILEJOURNAL_HPP
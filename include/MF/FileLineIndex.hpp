@@ -0,0 +1,106 @@
+//
+// File module: index of the beginnings of lines, for random access to the lines of big files.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILELINEINDEX_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILELINEINDEX_HPP
+
+#include <cstdint>
+#include <vector>
+#include "MF/FileLines.hpp"
+
+namespace File {
+    /**
+     * Offsets of the beginnings of the lines of a buffer, with the same lines as "LineRange".
+     * The table is compact: lines are grouped by blocks of "BLOCK_LINES", each one storing the absolute offset
+     * of its first line, then the offsets of the other lines relative to it with just as many bits as needed
+     * (2 to 2.5 bytes per line for lines shorter than 200 bytes, instead of 8). Finding a line is a constant-time
+     * lookup, so reading line N of a mapped file costs the lookup plus reading the page holding the line:
+     * > File::MappedFile file(filename, File::AccessPattern::RANDOM);
+     * > File::LineIndex index;
+     * > if (file && index.Open(filename)) { File::LineView line = index.Line(file.Get(), n); }
+     */
+    class LineIndex {
+    public:
+        /// Number of lines sharing one absolute offset.
+        static constexpr size_t BLOCK_LINES = 64;
+
+        /// Empty index.
+        LineIndex() = default;
+
+        /**
+         * Indexes a buffer. Newlines are searched with SIMD instructions (AVX2 or SSE2 on x86-64),
+         * by several threads each taking a part of the buffer.
+         * @param contents Buffer to index.
+         * @param size Size of the buffer.
+         * @param threads Number of threads, 0 for one per hardware thread.
+         */
+        void Build(const char* contents, Filesize_t size, unsigned int threads = 0);
+
+        /**
+         * Gets the index of a file: loads its sidecar file (see "LineIndexFilename") if it matches the size
+         * and modification time of the file, otherwise reads and indexes the file, then writes the sidecar for
+         * the next time. Failing to write the sidecar (read-only directory...) does not make this fail.
+         * @param filename Name of the file to index.
+         * @param threads Number of threads used to index the file.
+         * @return False if the file could not be read. An empty file gives an empty index.
+         */
+        bool Open(Filename_t filename, unsigned int threads = 0);
+
+        /**
+         * Writes the index to a file (atomically).
+         * @param indexFilename Name of the index file.
+         * @param source Identity of the indexed file, whose size and modification time are stored.
+         * @return True on success, false on failure.
+         */
+        bool Save(Filename_t indexFilename, const FileIdentity& source) const;
+
+        /**
+         * Reads an index written by "Save".
+         * @param indexFilename Name of the index file.
+         * @param source Identity of the indexed file as it is now.
+         * @return False if the index could not be read, is corrupted, or was built for another size or modification time.
+         *         The index is then unchanged.
+         */
+        bool Load(Filename_t indexFilename, const FileIdentity& source);
+
+        /// Number of lines.
+        size_t LineCount() const { return lineCount; }
+
+        /// Size of the indexed buffer.
+        Filesize_t Size() const { return size; }
+
+        /// Offset of the beginning of line "line", which must be lower than "LineCount()".
+        Filesize_t Offset(size_t line) const;
+
+        /**
+         * View on a line of the indexed buffer, without its end of line ("\n" or "\r\n").
+         * @param contents The buffer (or the same contents mapped again).
+         * @param line Index of the line, lower than "LineCount()".
+         */
+        LineView Line(const char* contents, size_t line) const;
+
+        /// Same as above, for something returned by "Read", whose size must be the indexed one.
+        LineView Line(const ReadFileData* content, size_t line) const { return Line(content->contents, line); }
+
+        /// Bytes used by the table.
+        size_t MemoryUsage() const { return blocks.size() * sizeof(Block) + words.size() * sizeof(uint64_t); }
+
+    protected:
+        struct Block {
+            uint64_t base; // Offset of the first line of the block.
+            uint64_t firstWord; // Index in "words" of the packed relative offsets of the lines of the block.
+            uint64_t width; // Bits per relative offset.
+        };
+
+        std::vector<Block> blocks;
+        std::vector<uint64_t> words;
+        size_t lineCount = 0;
+        Filesize_t size = 0;
+    };
+
+    /// Name of the sidecar file of "filename" used by "LineIndex::Open": "filename" followed by ".lines".
+    SFilename_t LineIndexFilename(Filename_t filename);
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILELINEINDEX_HPP
@@ -0,0 +1,112 @@
+//
+// File module: iteration over the lines of a file without any copy.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILELINES_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILELINES_HPP
+
+#include <cstring>
+#include <iterator>
+#include <string>
+#include "MF/FileOpen.hpp"
+
+namespace File {
+    /// Read-only view on a line: it points inside the mapping, so it is valid as long as the mapping is.
+    struct LineView {
+        const char* data = nullptr;
+        size_t size = 0;
+
+        /// Copies the line into a C++ string.
+        std::string ToString() const { return std::string(data, size); }
+
+        bool operator==(const std::string& other) const {
+            return other.size() == size && (!size || !std::memcmp(other.data(), data, size));
+        }
+        bool operator!=(const std::string& other) const { return !(*this == other); }
+    };
+
+    /**
+     * Range of the lines of a buffer, usually the contents returned by "Read":
+     * > for (File::LineView line : File::LineRange(fileData)) { ... }
+     * Lines end with "\n" or "\r\n"; the end of line is not part of the view.
+     * As "std::getline", a last empty line (file ending with an end of line) is not produced.
+     * Newlines are found with "memchr", which the C library vectorises.
+     */
+    class LineRange {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = LineView;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const LineView*;
+            using reference = const LineView&;
+
+            iterator() = default;
+
+            reference operator*() const { return line; }
+            pointer operator->() const { return &line; }
+
+            iterator& operator++() {
+                position = next;
+                findLine();
+                return *this;
+            }
+
+            iterator operator++(int) {
+                iterator copy(*this);
+                ++(*this);
+                return copy;
+            }
+
+            bool operator==(const iterator& other) const { return position == other.position; }
+            bool operator!=(const iterator& other) const { return position != other.position; }
+
+        protected:
+            friend class LineRange;
+
+            iterator(const char* position, const char* end) :
+                    position(position), end(end) {
+                findLine();
+            }
+
+            void findLine() {
+                if (position == end) {
+                    return;
+                }
+                auto newline = static_cast<const char*>(std::memchr(position, '\n', end - position));
+                const char* lineEnd = newline ? newline : end;
+                next = newline ? newline + 1 : end;
+                if (lineEnd != position && lineEnd[-1] == '\r') {
+                    --lineEnd;
+                }
+                line.data = position;
+                line.size = lineEnd - position;
+            }
+
+            const char* position = nullptr; // Beginning of the current line, "end" once past the last line.
+            const char* end = nullptr;
+            const char* next = nullptr; // Beginning of the next line.
+            LineView line;
+        };
+
+        using const_iterator = iterator;
+
+        /// Lines of "size" bytes starting at "contents".
+        LineRange(const char* contents, Filesize_t size) :
+                contents(contents), size(contents ? size : 0) {}
+
+        /// Lines of something returned by "Read". A null pointer gives an empty range.
+        explicit LineRange(const ReadFileData* content) :
+                LineRange(content ? content->contents : nullptr, content ? content->size : 0) {}
+
+        iterator begin() const { return iterator(contents, contents + size); }
+        iterator end() const { return iterator(contents + size, contents + size); }
+
+    protected:
+        const char* contents;
+        Filesize_t size;
+    };
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILELINES_HPP
@@ -0,0 +1,85 @@
+//
+// File module: RAII handle over the contents of a file, shared between readers through a process-wide cache.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILEMAPPED_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILEMAPPED_HPP
+
+#include <memory>
+#include "MF/FileOpen.hpp"
+
+namespace File {
+    /**
+     * Owns the contents of a file as returned by "Read", and closes it on destruction.
+     * Opening goes through a process-wide cache keyed by the identity of the file (device, inode, mtime, size):
+     * as long as a file is not modified, every reader of it shares the same mapping, and reopening it
+     * only costs one "stat" instead of open + mmap + munmap + close.
+     * A modified or replaced file has a new identity, so it is mapped again, and the old mapping stays with its current
+     * holders; the cache drops its own reference to it when the file is opened again under the same name.
+     * A replaced file keeps its former contents there; but a file modified in place is not copied: the private
+     * mappings of its current holders may see the modification in the pages they have not written (and a file
+     * truncated in place makes the pages past its new end invalid). Replace files rather than modifying them in place.
+     * The cache is thread-safe; a handle must not be used by several threads without synchronisation.
+     * > File::MappedFile config(filename);
+     * > if (config) { for (File::LineView line : File::LineRange(config.Get())) { ... } }
+     */
+    class MappedFile {
+    public:
+        /// Default number of files kept mapped by the cache once no handle uses them anymore.
+        static constexpr size_t DEFAULT_CACHE_CAPACITY = 64;
+
+        /// Handle that owns nothing.
+        MappedFile() = default;
+
+        /**
+         * Gets the contents of a file, from the cache if it was already read and has not changed since.
+         * @param filename Name of the file to read.
+         * @param pattern Access pattern given to "Read" when the file is not cached yet.
+         *                The first reader of a file decides it for all others.
+         */
+        explicit MappedFile(Filename_t filename, AccessPattern pattern = AccessPattern::SEQUENTIAL);
+
+        MappedFile(MappedFile&& other) noexcept = default;
+        MappedFile& operator=(MappedFile&& other) noexcept = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /// True if the file could be read. False for an empty file, as "Read".
+        bool IsOpen() const { return static_cast<bool>(content); }
+        explicit operator bool() const { return IsOpen(); }
+
+        /// Contents of the file, nullptr if it is not open. Not null-terminated.
+        const char* Data() const { return content ? content->contents : nullptr; }
+
+        /// Size of the file in bytes, 0 if it is not open.
+        Filesize_t Size() const { return content ? content->size : 0; }
+
+        /// Underlying data, to give to functions taking something returned by "Read". Do not close it.
+        const ReadFileData* Get() const { return content.get(); }
+
+        /// Identity of the file when it was read.
+        const FileIdentity& GetIdentity() const { return identity; }
+
+        /// Releases the contents; the mapping is closed when neither another handle nor the cache uses it.
+        void Close();
+
+        /**
+         * Changes how many files the cache keeps once no handle uses them, the least recently used being released first.
+         * Files still used by a handle are kept besides them. The files no longer used are counted when a file is added
+         * to the cache, or when the capacity changes. 0 disables the cache: every handle then reads its file itself.
+         */
+        static void SetCacheCapacity(size_t capacity);
+
+        /// Number of files currently held by the cache, used by a handle or not.
+        static size_t CacheSize();
+
+        /// Releases every file held by the cache. Open handles are not affected.
+        static void ClearCache();
+
+    protected:
+        std::shared_ptr<const ReadFileData> content;
+        FileIdentity identity;
+    };
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILEMAPPED_HPP
@@ -8,24 +8,57 @@
 #include "MF/File.hpp"
 
 namespace File {
+    /// How "Read" brings the contents of a file into memory.
+    enum class ReadStrategy {
+        AUTO, // Chosen by "Read" from the file size and the access pattern (see "ChooseReadStrategy")
+        READ, // One "read" call into a buffer taken from a pool: fastest for small files
+        MMAP, // Memory mapping, pages are loaded when first accessed
+        MMAP_POPULATE, // Memory mapping with all pages loaded upfront (MAP_POPULATE): fastest for whole scans
+        MMAP_HUGE_PAGES // Memory mapping advised to use transparent huge pages, where the system supports it
+    };
+
+    /// How the contents returned by "Read" will be accessed. It is only a hint.
+    enum class AccessPattern {
+        SEQUENTIAL, // Whole contents read from the beginning to the end
+        RANDOM // Only a few places are read
+    };
+
     /// Data structure used to store information about files opened with Open.
     struct ReadFileData {
         const char* contents = nullptr;
         Filesize_t size = 0ul;
+        ReadStrategy strategy = ReadStrategy::MMAP; // Strategy actually used, never AUTO.
         virtual ~ReadFileData() = default; // For polymorphic reasons.
     };
 
+    /// Files up to this size are read with ReadStrategy::READ by AUTO (calibrated by TimingExperience).
+    constexpr Filesize_t READ_STRATEGY_MAX_SIZE = 128ul << 10;
+
+    /**
+     * Strategy used by "Read" when it is given ReadStrategy::AUTO.
+     * Small files are copied with one "read" call, which costs less than setting up and tearing down a mapping.
+     * Bigger files are mapped; for a sequential access all their pages are loaded at once,
+     * which avoids one page fault per page.
+     * @param size Size of the file in bytes.
+     * @param pattern How the contents will be accessed.
+     * @return A strategy which is not AUTO.
+     */
+    ReadStrategy ChooseReadStrategy(Filesize_t size, AccessPattern pattern);
+
     /**
      * Stores the entire contents of file "filename" in a read-only C-string.
      * Also, that C-string does not end with '\0'.
-     * It is advised to use an "InCharArrayStream".
+     * To iterate over its lines without copy, use a "LineRange" (FileLines.hpp); otherwise an "InCharArrayStream".
      * To clean up memory, please call "Read_Close" with the structure returned from there.
      * The structure must remain a pointer (in reality, it is an instance of a subclass of ReadFileData).
      * The purpose of this function is to offer the fastest way to read an entire file.
      * @param filename Name of the file to open.
+     * @param strategy How to bring the file into memory. The one actually used is stored in the returned structure.
+     * @param pattern How the contents will be accessed, used by AUTO and given as a hint to the system.
      * @return "nullptr" if anything failed or the file is empty, or a new structure.
      */
-    const ReadFileData* Read(Filename_t filename);
+    const ReadFileData* Read(Filename_t filename, ReadStrategy strategy = ReadStrategy::AUTO,
+                             AccessPattern pattern = AccessPattern::SEQUENTIAL);
 
     /// Please use this simple tool to clean up any memory associated with something returned by "Read".
     void Read_Close(const ReadFileData* content);
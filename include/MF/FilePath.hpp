@@ -0,0 +1,82 @@
+//
+// File module: normalisation of paths, and canonicalisation with a cache of the resolved directories.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILEPATH_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILEPATH_HPP
+
+#include <cstdint>
+#include <memory>
+#include "MF/File.hpp"
+
+namespace File {
+    /// True if the path starts at a root: "/", or "C:\" and "\\server\share\" on Windows ("\" depends on the current drive).
+    bool IsAbsolutePath(const SFilename_t& path);
+
+    /**
+     * Normalises a path lexically, without any system call: "a//./b/../c" -> "a/c".
+     * Separators are FILE_SEPARATOR ("/" is accepted on Windows too), "." and empty names are removed, and ".." removes
+     * the name before it. A ".." at the root stays at the root, and the leading ones of a relative path are kept.
+     * A trailing separator is kept; a path which becomes empty is ".".
+     * As symbolic links are ignored, "link/.." may be another directory than the normalised one: see "PathCache".
+     * @param path Path to normalise.
+     * @return The normalised path, empty if "path" is.
+     */
+    SFilename_t NormalizePath(const SFilename_t& path);
+
+    /**
+     * Canonicalisation of paths ("realpath"), the directories being resolved once then kept,
+     * so that the millions of files of a few directories cost one lookup per directory instead of one walk each.
+     * Directories are resolved one name at a time, with one "lstat" (and "readlink" for a symbolic link) per name
+     * not already known. Each name resolved is kept, as well as each directory path given, with its canonical path.
+     * The directories where names were resolved are watched with a File::Watcher: a name renamed, deleted or replaced
+     * forgets it (and what was resolved through it) before the next call.
+     * > File::PathCache cache;
+     * > File::SFilename_t canonical;
+     * > if (cache.Canonicalize(MAKE_FILE_NAME "src/../include/MF/File.hpp", canonical)) { ... }
+     * Changes are seen once the watcher has delivered them, so a call racing a change may still use the former path.
+     * Where directories cannot be watched (see File::Watcher), nothing is kept: every call resolves all its names.
+     * A PathCache is not thread-safe: use one per thread, or lock around it.
+     */
+    class PathCache {
+    public:
+        /// Maximum number of symbolic links followed by one resolution, as Linux does.
+        static constexpr unsigned int MAX_LINKS = 40;
+
+        /// Takes the current working directory, against which the relative paths are resolved from now on.
+        PathCache();
+
+        /// Stops watching the directories.
+        ~PathCache();
+
+        PathCache(const PathCache&) = delete;
+        PathCache& operator=(const PathCache&) = delete;
+
+        /// True if the resolved directories are kept.
+        bool IsCaching() const;
+
+        /**
+         * Gives the canonical path of an entry: absolute, without "." nor "..", its directories being real ones.
+         * The last name is not resolved, and need not exist, so that the files of a directory only cost a lookup of
+         * the directory: a final symbolic link stays as is. Unless it is "." or "..", or the path ends with a separator:
+         * it is then a directory, resolved like the others.
+         * @param path Absolute path, or relative to the working directory of the construction.
+         * @param canonical Filled with the canonical path. That of a directory ends with a FILE_SEPARATOR.
+         * @return False if a directory of the path does not exist or is not a directory, or if more than MAX_LINKS
+         *         symbolic links were followed.
+         */
+        bool Canonicalize(const SFilename_t& path, SFilename_t& canonical);
+
+        /// Forgets everything resolved, for example after the program changed something unwatched.
+        void Clear();
+
+        /// Number of names read from the system so far ("lstat" calls): one per name, while nothing changes.
+        uint64_t LookupCount() const;
+
+    protected:
+        struct State;
+        std::unique_ptr<State> state;
+    };
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILEPATH_HPP
@@ -0,0 +1,66 @@
+//
+// File module: reading of the next files of a batch into the page cache, ahead of their use.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILEPREFETCH_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILEPREFETCH_HPP
+
+#include <memory>
+#include <vector>
+#include "MF/File.hpp"
+
+namespace File {
+    /// Settings of a "Prefetcher".
+    struct PrefetchOptions {
+        /// At most this many bytes are prefetched and not consumed yet: the last file of the window may be prefetched partly.
+        Filesize_t windowBytes = 256ull << 20;
+        /// At most this many files are prefetched and not consumed yet.
+        size_t windowFiles = 64;
+        /// If true, the pages of the consumed files are dropped from the cache, so that a batch bigger than
+        /// the memory does not evict the pages of the files to come (nor those of other programs).
+        bool dropBehind = true;
+    };
+
+    /**
+     * Asks the system to read the next files of an ordered batch while the current one is processed,
+     * so that "Read" finds them in the page cache instead of waiting for the disk.
+     * The files between the consumer and the end of the window are opened and advised with posix_fadvise(WILLNEED)
+     * by a thread owned by the prefetcher; those before the consumer are closed (and dropped with DONTNEED).
+     * > File::Prefetcher prefetcher(filenames);
+     * > for (size_t i = 0; i < filenames.size(); ++i) {
+     * >     prefetcher.Consume(i);
+     * >     const File::ReadFileData* content = File::Read(filenames[i].c_str()); ...
+     * > }
+     * Without threads, the window is moved by "Consume" itself. Nothing is prefetched on Windows.
+     */
+    class Prefetcher {
+    public:
+        /// Starts prefetching the first files of "filenames". Missing or unreadable files are skipped.
+        explicit Prefetcher(std::vector<SFilename_t> filenames, const PrefetchOptions& options = PrefetchOptions());
+
+        /// Stops the thread. Files not consumed yet are closed, but their pages are kept.
+        ~Prefetcher();
+
+        Prefetcher(const Prefetcher&) = delete;
+        Prefetcher& operator=(const Prefetcher&) = delete;
+
+        /**
+         * Tells that the consumer is about to read a file: the files before it are done with, and the window moves on.
+         * @param index Index of the file in the batch; "FileCount()" once the whole batch is consumed.
+         *              Files may be skipped, but going back has no effect.
+         */
+        void Consume(size_t index);
+
+        /// Number of files in the batch.
+        size_t FileCount() const;
+
+        /// Number of files prefetched so far, consumed or not.
+        size_t PrefetchedCount() const;
+
+    protected:
+        struct State;
+        std::unique_ptr<State> state;
+    };
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILEPREFETCH_HPP
@@ -0,0 +1,209 @@
+//
+// File module: typed views over files of fixed-size binary records, without any copy.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILERECORDS_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILERECORDS_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include "MF/FileOpen.hpp"
+
+namespace File {
+    /// Order of the bytes of the numbers stored in a file.
+    enum class ByteOrder {
+        NATIVE, // The order of this machine: the file was written by it, or by a machine alike
+        LITTLE, // Least significant byte first (x86, most ARM)
+        BIG // Most significant byte first (network order)
+    };
+
+    /// Order of the bytes of the numbers of this machine, never NATIVE.
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    constexpr ByteOrder HOST_BYTE_ORDER = ByteOrder::BIG;
+#else
+    constexpr ByteOrder HOST_BYTE_ORDER = ByteOrder::LITTLE;
+#endif
+
+    /// Reverses the order of the bytes of an integer. Compilers turn these into one instruction.
+    inline uint8_t SwapBytes(uint8_t value) { return value; }
+    inline uint16_t SwapBytes(uint16_t value) { return static_cast<uint16_t>(value << 8 | value >> 8); }
+    inline uint32_t SwapBytes(uint32_t value) {
+        return value << 24 | (value & 0xFF00u) << 8 | (value >> 8 & 0xFF00u) | value >> 24;
+    }
+    inline uint64_t SwapBytes(uint64_t value) {
+        return static_cast<uint64_t>(SwapBytes(static_cast<uint32_t>(value))) << 32 | SwapBytes(static_cast<uint32_t>(value >> 32));
+    }
+
+    /**
+     * Reverses the order of the bytes of a record read from a file written with the other byte order.
+     * Numbers (and enumerations) are handled; for a structure, specialise it to swap each field:
+     * > namespace File { template <> struct RecordSwapper<Point> {
+     * >     static void Swap(Point& point) { RecordSwapper<int32_t>::Swap(point.x); RecordSwapper<int32_t>::Swap(point.y); }
+     * > }; }
+     */
+    template <typename T>
+    struct RecordSwapper {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+                      "Specialise File::RecordSwapper to swap the fields of this record");
+        static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8, "Unsupported size of number");
+
+        static void Swap(T& value) {
+            using Bits = typename std::conditional<sizeof(T) == 1, uint8_t,
+                         typename std::conditional<sizeof(T) == 2, uint16_t,
+                         typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type>::type>::type;
+            Bits bits;
+            std::memcpy(&bits, &value, sizeof(T));
+            bits = SwapBytes(bits);
+            std::memcpy(&value, &bits, sizeof(T));
+        }
+    };
+
+    /**
+     * Array of records of type "T" stored one after the other in a buffer, usually the contents of a mapped file:
+     * > const File::ReadFileData* content = File::Read(filename, File::ReadStrategy::MMAP, File::AccessPattern::RANDOM);
+     * > File::RecordView<Trade> trades(content);
+     * > if (trades.IsValid()) { for (const Trade& trade : trades) { ... } }
+     * Nothing is parsed nor copied: a record is read from the page cache when it is accessed, so opening
+     * a file of several GB costs no more than mapping it. The view is valid as long as the buffer is.
+     * "T" must be trivially copyable, and the file must have been written with its layout (padding included).
+     * With a byte order other than the one of this machine, each access returns a copy of the record,
+     * swapped by "RecordSwapper<T>"; otherwise it returns a reference into the buffer.
+     * The iterators are random-access, so sorted records can be searched with "std::lower_bound".
+     */
+    template <typename T, ByteOrder Order = ByteOrder::NATIVE>
+    class RecordView {
+        static_assert(std::is_trivially_copyable<T>::value, "Records must be trivially copyable");
+
+    public:
+        /// True if the records are swapped on access.
+        static constexpr bool SWAPPED = Order != ByteOrder::NATIVE && Order != HOST_BYTE_ORDER;
+
+        using value_type = T;
+        using reference = typename std::conditional<SWAPPED, T, const T&>::type;
+
+        /// Iterator over swapped records, which gives copies.
+        class SwappedIterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T*;
+            using reference = T;
+
+            SwappedIterator() = default;
+            explicit SwappedIterator(const char* position) : position(position) {}
+
+            T operator*() const { return Load(position); }
+            T operator[](difference_type n) const { return Load(position + n * static_cast<difference_type>(sizeof(T))); }
+
+            SwappedIterator& operator++() { position += sizeof(T); return *this; }
+            SwappedIterator& operator--() { position -= sizeof(T); return *this; }
+            SwappedIterator operator++(int) { SwappedIterator copy(*this); ++(*this); return copy; }
+            SwappedIterator operator--(int) { SwappedIterator copy(*this); --(*this); return copy; }
+            SwappedIterator& operator+=(difference_type n) { position += n * static_cast<difference_type>(sizeof(T)); return *this; }
+            SwappedIterator& operator-=(difference_type n) { position -= n * static_cast<difference_type>(sizeof(T)); return *this; }
+            SwappedIterator operator+(difference_type n) const { return SwappedIterator(*this) += n; }
+            SwappedIterator operator-(difference_type n) const { return SwappedIterator(*this) -= n; }
+            friend SwappedIterator operator+(difference_type n, const SwappedIterator& it) { return it + n; }
+            difference_type operator-(const SwappedIterator& other) const {
+                return (position - other.position) / static_cast<difference_type>(sizeof(T));
+            }
+
+            bool operator==(const SwappedIterator& other) const { return position == other.position; }
+            bool operator!=(const SwappedIterator& other) const { return position != other.position; }
+            bool operator<(const SwappedIterator& other) const { return position < other.position; }
+            bool operator>(const SwappedIterator& other) const { return position > other.position; }
+            bool operator<=(const SwappedIterator& other) const { return position <= other.position; }
+            bool operator>=(const SwappedIterator& other) const { return position >= other.position; }
+
+        protected:
+            const char* position = nullptr;
+        };
+
+        /// Plain pointers into the buffer in the native byte order.
+        using iterator = typename std::conditional<SWAPPED, SwappedIterator, const T*>::type;
+        using const_iterator = iterator;
+
+        /// Empty and invalid view.
+        RecordView() = default;
+
+        /**
+         * Views a buffer as records.
+         * @param data Buffer. In the native byte order, it must be aligned for "T".
+         * @param size Size of the buffer, which must be a multiple of the size of a record.
+         *             Otherwise the view is not valid, and empty.
+         */
+        RecordView(const char* data, Filesize_t size) {
+            if (data && size % sizeof(T) == 0 && (SWAPPED || reinterpret_cast<uintptr_t>(data) % alignof(T) == 0)) {
+                records = data;
+                count = size / sizeof(T);
+            }
+        }
+
+        /**
+         * Views the contents of a file as records. A mapping is aligned on a page, and a small file read into a buffer
+         * is aligned as anything allocated by "new".
+         * @param content As returned by "Read". Null gives an invalid view.
+         * @param offset Offset of the first record, to skip the header of the file.
+         */
+        explicit RecordView(const ReadFileData* content, Filesize_t offset = 0) :
+                RecordView(content && offset <= content->size ? content->contents + offset : nullptr,
+                           content && offset <= content->size ? content->size - offset : 0) {}
+
+        /// True if the buffer was a whole number of aligned records.
+        bool IsValid() const { return records != nullptr; }
+
+        /// Number of records.
+        Filesize_t Size() const { return count; }
+
+        /// Record at "index", which must be lower than "Size()": a reference into the buffer, or a swapped copy.
+        reference operator[](Filesize_t index) const { return Get(records + index * sizeof(T)); }
+
+        /// First record in the buffer, in the native byte order only.
+        const T* Data() const {
+            static_assert(!SWAPPED, "Swapped records cannot be accessed directly");
+            return reinterpret_cast<const T*>(records);
+        }
+
+        iterator begin() const { return IteratorAt(records); }
+        iterator end() const { return IteratorAt(records + count * sizeof(T)); }
+
+    protected:
+        /// Copy of the record at "position", swapped.
+        static T Load(const char* position) {
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+            std::memcpy(&storage, position, sizeof(T));
+            T& record = *reinterpret_cast<T*>(&storage);
+            RecordSwapper<T>::Swap(record);
+            return record;
+        }
+
+        template <bool Swapped = SWAPPED>
+        static typename std::enable_if<Swapped, T>::type Get(const char* position) { return Load(position); }
+
+        template <bool Swapped = SWAPPED>
+        static typename std::enable_if<!Swapped, const T&>::type Get(const char* position) {
+            return *reinterpret_cast<const T*>(position);
+        }
+
+        template <bool Swapped = SWAPPED>
+        static typename std::enable_if<Swapped, iterator>::type IteratorAt(const char* position) {
+            return SwappedIterator(position);
+        }
+
+        template <bool Swapped = SWAPPED>
+        static typename std::enable_if<!Swapped, iterator>::type IteratorAt(const char* position) {
+            return reinterpret_cast<const T*>(position);
+        }
+
+        const char* records = nullptr;
+        Filesize_t count = 0;
+    };
+
+    template <typename T, ByteOrder Order>
+    constexpr bool RecordView<T, Order>::SWAPPED;
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILERECORDS_HPP
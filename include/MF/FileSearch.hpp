@@ -0,0 +1,94 @@
+//
+// File module: search of substrings in big buffers, by several threads.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILESEARCH_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILESEARCH_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MF/FileOpen.hpp"
+
+namespace File {
+    /// One occurrence found by a "Searcher".
+    struct SearchMatch {
+        Filesize_t offset; // Offset of the first byte of the occurrence.
+        size_t pattern; // Index of the pattern found, in the list given to the "Searcher".
+
+        bool operator==(const SearchMatch& other) const { return offset == other.offset && pattern == other.pattern; }
+    };
+
+    /**
+     * Searches byte strings (not characters: the comparison is exact and case-sensitive) in buffers.
+     * The patterns are prepared once by the constructor, then any number of buffers can be searched:
+     * > const File::ReadFileData* content = File::Read(filename, File::ReadStrategy::AUTO, File::AccessPattern::SEQUENTIAL);
+     * > File::Searcher searcher({"ERROR", "FATAL"});
+     * > for (const File::SearchMatch& match : searcher.Find(content)) { ... }
+     * The buffer is cut into chunks searched by several threads, so a mapped file is read by all the cores.
+     * A single pattern is searched by comparing its first and last bytes to 32 (AVX2) or 16 (SSE2) positions at once,
+     * the pattern being compared only where both match; several patterns go through an Aho-Corasick automaton,
+     * whose cost does not depend on their number, which skips the positions where no pattern begins with their first two bytes.
+     * Every occurrence is reported, overlapping ones included ("aa" is found twice in "aaa").
+     */
+    class Searcher {
+    public:
+        /// Prepares the search of one pattern.
+        explicit Searcher(const std::string& pattern);
+
+        /// Prepares the search of several patterns. Empty patterns never match; duplicates are reported each.
+        explicit Searcher(const std::vector<std::string>& patterns);
+
+        /**
+         * Finds all the occurrences of the patterns in a buffer.
+         * @param contents Buffer to search.
+         * @param size Size of the buffer.
+         * @param threads Number of threads, 0 for one per hardware thread.
+         * @return The occurrences sorted by offset, then by pattern for patterns found at the same offset.
+         */
+        std::vector<SearchMatch> Find(const char* contents, Filesize_t size, unsigned int threads = 0) const;
+
+        /// Same as above, for something returned by "Read".
+        std::vector<SearchMatch> Find(const ReadFileData* content, unsigned int threads = 0) const {
+            return Find(content->contents, content->size, threads);
+        }
+
+        /// Number of patterns given to the constructor.
+        size_t PatternCount() const { return patterns.size(); }
+
+    protected:
+        std::vector<std::string> patterns;
+        size_t longest = 0; // Length of the longest pattern.
+
+        // Aho-Corasick automaton, when there are several patterns. Bytes are mapped to classes (all the bytes which
+        // appear in no pattern share one), and "transitions[state * classCount + class]" is the next state.
+        uint8_t classes[256] = {};
+        size_t classCount = 0;
+        std::vector<uint32_t> transitions;
+        std::vector<uint32_t> outputBegin; // Patterns ending at "state" are "outputs[outputBegin[state] .. outputBegin[state + 1]]".
+        std::vector<uint32_t> outputs;
+        // Bit "256 * first + second" is set if a pattern begins with these two bytes (or is the first byte alone):
+        // the automaton skips the other positions without stepping, as long as no pattern is partially matched.
+        std::vector<uint64_t> startPairs;
+        // Tables of nibbles giving the 8 buckets the first and second bytes of the patterns fall in, to check 32 positions
+        // at once against "startPairs" with AVX2 (a byte is in a bucket if both its low and high nibbles are).
+        // Positions passing both bytes are then checked against "startPairs".
+        uint8_t startNibbles[4][16] = {};
+
+        void FindMany(const char* contents, Filesize_t begin, Filesize_t end, Filesize_t size, std::vector<SearchMatch>& matches) const;
+    };
+
+    /**
+     * Finds all the occurrences of one pattern in the contents of a file, with several threads.
+     * @param content Contents of the file, as returned by "Read".
+     * @param pattern Bytes to find. An empty pattern is never found.
+     * @param threads Number of threads, 0 for one per hardware thread.
+     * @return The offsets of the occurrences, sorted.
+     */
+    std::vector<Filesize_t> Search(const ReadFileData* content, const std::string& pattern, unsigned int threads = 0);
+
+    /// Same as above for several patterns, see "Searcher".
+    std::vector<SearchMatch> Search(const ReadFileData* content, const std::vector<std::string>& patterns, unsigned int threads = 0);
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILESEARCH_HPP
@@ -0,0 +1,99 @@
+//
+// File module: snapshots of directory trees, and differences between two of them.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILESNAPSHOT_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILESNAPSHOT_HPP
+
+#include <cstdint>
+#include <vector>
+#include "MF/File.hpp"
+#include "MF/FileStat.hpp"
+
+namespace File {
+    /// State of an entry of a tree when the snapshot was taken. Symbolic links are not followed.
+    struct SnapshotEntry {
+        SFilename_t path; // Relative to the root of the tree, without ending separator for directories.
+        StatType type = StatType::NONE;
+        uint64_t inode = 0;
+        int64_t mtimeNs = 0;
+        Filesize_t size = 0;
+        uint64_t hash = 0; // XXH64 of the contents of a regular file, if "hashed".
+        bool hashed = false;
+    };
+
+    /// Entries of a tree, sorted by path (in the order of the code units).
+    struct TreeSnapshot {
+        std::vector<SnapshotEntry> entries;
+        size_t hashedFiles = 0; // Files read to take the snapshot: the others were unchanged since the previous one.
+        size_t failures = 0; // Directories or files which could not be read. Not saved.
+
+        /// Entry of a path, nullptr if there is none.
+        const SnapshotEntry* Find(const SFilename_t& path) const;
+    };
+
+    /// Settings of "SnapshotTree".
+    struct SnapshotOptions {
+        /// If true, the contents of the regular files are hashed, so that "DiffSnapshots" can tell modified files
+        /// from files only touched (same contents, new modification time or inode).
+        bool hashContents = false;
+        /// Number of threads getting the metadata and hashing the files, 0 for one per hardware thread.
+        unsigned int threads = 0;
+    };
+
+    /**
+     * Takes a snapshot of the entries below a directory: path, type, inode, size, modification time and optionally a hash.
+     * Given the snapshot of a previous run, a file whose inode, size and modification time did not change keeps its
+     * previous hash without being read, so an incremental run only reads the metadata of unchanged files.
+     * > File::TreeSnapshot previous;
+     * > File::LoadSnapshot(stateFile, previous);
+     * > const File::TreeSnapshot current = File::SnapshotTree(root, options, &previous);
+     * > for (const File::SnapshotChange& change : File::DiffSnapshots(previous, current)) { ... }
+     * > File::SaveSnapshot(current, stateFile);
+     * @param root Directory to walk.
+     * @param options Settings.
+     * @param previous Previous snapshot of the same tree, or nullptr.
+     * @return The snapshot; without entries if "root" could not be listed.
+     */
+    TreeSnapshot SnapshotTree(Filename_t root, const SnapshotOptions& options = SnapshotOptions(),
+                              const TreeSnapshot* previous = nullptr);
+
+    /**
+     * Saves a snapshot in a compact binary file: paths share their prefix with the previous one, and numbers are
+     * variable-length. The file is checksummed, and written atomically. It is meant to be read on the same system.
+     * @return True on success.
+     */
+    bool SaveSnapshot(const TreeSnapshot& snapshot, Filename_t filename);
+
+    /**
+     * Loads a snapshot saved by "SaveSnapshot".
+     * @param snapshot Filled with the entries; empty on failure.
+     * @return False if the file could not be read, or is not a valid snapshot.
+     */
+    bool LoadSnapshot(Filename_t filename, TreeSnapshot& snapshot);
+
+    /// How an entry differs between two snapshots.
+    enum class SnapshotChangeType {
+        ADDED,
+        REMOVED, // Removed, or replaced by an entry of another type (which is ADDED)
+        MODIFIED, // Size, modification time or inode changed, and the contents changed too or was not hashed
+        TOUCHED // Modification time or inode changed, but both snapshots have the same hash
+    };
+
+    /// Difference found by "DiffSnapshots". The entries point into the snapshots.
+    struct SnapshotChange {
+        SnapshotChangeType type;
+        const SnapshotEntry* before; // nullptr if ADDED
+        const SnapshotEntry* after; // nullptr if REMOVED
+
+        const SFilename_t& Path() const { return after ? after->path : before->path; }
+    };
+
+    /**
+     * Compares two snapshots of a tree in one pass over both. Directories are only added or removed.
+     * @return The changes, sorted by path.
+     */
+    std::vector<SnapshotChange> DiffSnapshots(const TreeSnapshot& before, const TreeSnapshot& after);
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILESNAPSHOT_HPP
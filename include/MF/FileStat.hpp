@@ -0,0 +1,62 @@
+//
+// File module: metadata of many files at once.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILESTAT_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILESTAT_HPP
+
+#include <cstdint>
+#include <vector>
+#include "MF/File.hpp"
+
+namespace File {
+    /// Fields asked to "StatMany", to be combined with |. The type is always given.
+    using StatMask = unsigned int;
+    constexpr StatMask STAT_TYPE = 0; // Only the type, which tells whether the file exists and whether it is a directory
+    constexpr StatMask STAT_SIZE = 1u << 0;
+    constexpr StatMask STAT_MTIME = 1u << 1; // Last modification time, in nanoseconds since the epoch of the system
+    constexpr StatMask STAT_INODE = 1u << 2; // Device and inode (file index and volume serial number on Windows)
+    constexpr StatMask STAT_MODE = 1u << 3; // Permission bits (UNIX only)
+    constexpr StatMask STAT_ALL = STAT_SIZE | STAT_MTIME | STAT_INODE | STAT_MODE;
+
+    /// Type of a file, as given by "StatMany".
+    enum class StatType : uint8_t {
+        NONE, // Does not exist, or could not be accessed
+        FILE,
+        DIRECTORY,
+        SYMLINK, // Only when links are not followed
+        OTHER // Device, socket, pipe...
+    };
+
+    /// Result of "StatMany": one column per field, each one only filled if it was asked for.
+    /// Row "i" is about the path of index "i". Fields of NONE rows are 0.
+    struct StatResult {
+        std::vector<StatType> types;
+        std::vector<Filesize_t> sizes;
+        std::vector<int64_t> mtimesNs;
+        std::vector<uint64_t> devices;
+        std::vector<uint64_t> inodes;
+        std::vector<uint32_t> modes;
+
+        /// Number of paths.
+        size_t Size() const { return types.size(); }
+        bool Exists(size_t index) const { return types[index] != StatType::NONE; }
+        bool IsDir(size_t index) const { return types[index] == StatType::DIRECTORY; }
+    };
+
+    /**
+     * Gets the metadata of many paths, with one system call per path for all the fields together.
+     * On Linux, "statx" is asked only for the wanted fields. Consecutive paths in the same directory
+     * are looked up relative to that directory, opened once, so the kernel does not walk its path again for each;
+     * lists sorted by name (manifests, directory listings) benefit the most.
+     * @param paths Paths to query.
+     * @param mask Wanted fields, STAT_TYPE for the type only.
+     * @param threads Number of threads, 0 for one per hardware thread.
+     * @param followLinks If false, symbolic links are described themselves (lstat) rather than their target.
+     * @return The wanted fields for every path.
+     */
+    StatResult StatMany(const std::vector<SFilename_t>& paths, StatMask mask = STAT_ALL, unsigned int threads = 1,
+                        bool followLinks = true);
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILESTAT_HPP
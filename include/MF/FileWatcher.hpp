@@ -0,0 +1,86 @@
+//
+// File module: notification of changes in directories.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILEWATCHER_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILEWATCHER_HPP
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "MF/File.hpp"
+
+namespace File {
+    /// What happened to an entry of a watched directory.
+    enum class ChangeType {
+        CREATED,
+        MODIFIED, // Contents written, or the entry was deleted then created again
+        DELETED, // Deleted, or moved out of the watched directories
+        MOVED, // Renamed inside the watched directories: see "Change::oldName"
+        LOST // Events were lost because the system queue was full: the watched directories should be rescanned
+    };
+
+    /// A change, after coalescing.
+    struct Change {
+        ChangeType type;
+        SFilename_t name; // Watched directory as given to "Watcher::Add", followed by the name of the entry.
+        SFilename_t oldName; // Previous name of a MOVED entry, empty otherwise.
+        bool isDirectory;
+    };
+
+    /// Called with each batch of changes, in the order in which they first happened.
+    using WatcherCallback = std::function<void(const std::vector<Change>& changes)>;
+
+    /// Settings of a "Watcher".
+    struct WatcherOptions {
+        /// Changes happening within this many milliseconds after the first one are delivered together,
+        /// and successive changes of the same entry are merged: created then modified is one CREATED,
+        /// created then deleted is nothing, deleted then created is one MODIFIED...
+        unsigned int coalesceMs = 50;
+    };
+
+    /**
+     * Watches directories with inotify, so that detecting changes costs nothing while nothing changes,
+     * instead of listing the directories again and again.
+     * A thread owned by the watcher waits for the events, coalesces them and calls the callback,
+     * which must therefore be thread-safe with respect to the rest of the program. It may call "Add" and "Remove".
+     * > File::Watcher watcher([](const std::vector<File::Change>& changes) { ... });
+     * > watcher.Add(directory, true);
+     * Linux only for now: elsewhere, or in a build without threads, "IsValid" is false.
+     */
+    class Watcher {
+    public:
+        /// Starts the thread of the watcher. No directory is watched yet.
+        explicit Watcher(WatcherCallback callback, const WatcherOptions& options = WatcherOptions());
+
+        /// Stops the thread, after delivering the pending changes.
+        ~Watcher();
+
+        Watcher(const Watcher&) = delete;
+        Watcher& operator=(const Watcher&) = delete;
+
+        /// True if directories can be watched.
+        bool IsValid() const;
+
+        /**
+         * Starts watching the entries of a directory. Symbolic links are not followed.
+         * @param directory Directory to watch.
+         * @param recursive If true, its subdirectories are watched too, as well as those created or moved in later.
+         *                  Entries created in a new subdirectory before its watch is set are reported as CREATED.
+         * @return False if "directory" could not be watched.
+         */
+        bool Add(Filename_t directory, bool recursive = false);
+
+        /// Stops watching a directory, and its subdirectories if it was added recursively.
+        void Remove(Filename_t directory);
+
+        /// Number of directories currently watched.
+        size_t WatchCount() const;
+
+    protected:
+        struct State;
+        std::unique_ptr<State> state;
+    };
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILEWATCHER_HPP
@@ -0,0 +1,87 @@
+//
+// File module: sequential reading of huge files through a sliding memory-mapped window.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILEWINDOW_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILEWINDOW_HPP
+
+#include "MF/File.hpp"
+
+namespace File {
+    /**
+     * Maps a file one fixed-size window at a time, instead of mapping it entirely as "Read" does.
+     * Only two windows are mapped at once: the current one, and the next one which is being prefetched.
+     * Pages behind the reader are released (and optionally dropped from the page cache),
+     * so the resident memory stays bounded whatever the size of the file.
+     * > File::WindowedReader reader(filename);
+     * > for (bool ok = reader.IsOpen(); ok; ok = reader.Next()) { use(reader.Data(), reader.Length()); }
+     * A record may be cut between two consecutive windows: the caller is in charge of joining it.
+     */
+    class WindowedReader {
+    public:
+        /// Default size of a window: 64 MiB.
+        static constexpr Filesize_t DEFAULT_WINDOW_SIZE = 64ul << 20;
+
+        /**
+         * Opens the file and maps its first window.
+         * @param filename Name of the file to read.
+         * @param windowSize Size of a window, rounded up to the mapping granularity of the system (page size on UNIX).
+         * @param dropBehind If true, the pages of a window are also dropped from the page cache when leaving it,
+         *                   so that reading a huge file once does not evict everything else.
+         */
+        explicit WindowedReader(Filename_t filename, Filesize_t windowSize = DEFAULT_WINDOW_SIZE, bool dropBehind = true);
+        ~WindowedReader();
+
+        WindowedReader(const WindowedReader&) = delete;
+        WindowedReader& operator=(const WindowedReader&) = delete;
+
+        /// True if the file could be opened and the current window is mapped. False for an empty file.
+        bool IsOpen() const { return current != nullptr; }
+
+        /// Total size of the file in bytes.
+        Filesize_t FileSize() const { return fileSize; }
+
+        /// Size of a window, after rounding.
+        Filesize_t WindowSize() const { return windowSize; }
+
+        /// Contents of the current window, nullptr if there is none. Not null-terminated.
+        const char* Data() const { return current; }
+
+        /// Number of bytes in the current window: "WindowSize()", or less for the last one.
+        Filesize_t Length() const { return currentLength; }
+
+        /// Offset in the file of the first byte of the current window.
+        Filesize_t Offset() const { return offset; }
+
+        /**
+         * Moves to the next window, and starts prefetching the one after it.
+         * @return False if the current window was the last one (or mapping failed); there is no current window then.
+         */
+        bool Next();
+
+        /**
+         * Moves to the window containing the given offset. Its data starts at "Offset()", which is <= "position".
+         * @return False if "position" is out of the file or mapping failed; there is no current window then.
+         */
+        bool Seek(Filesize_t position);
+
+    protected:
+        /// Unmaps everything, then maps the window at "newOffset" (reusing the prefetched one if possible).
+        bool MoveTo(Filesize_t newOffset);
+        void Release(const char*& window, Filesize_t windowOffset, Filesize_t& length);
+
+        void* osFile = nullptr; // "Unix_WindowedFile" or "Windows_WindowedFile", see the API helpers.
+        Filesize_t fileSize = 0;
+        Filesize_t windowSize = 0;
+        bool dropBehind = true;
+
+        const char* current = nullptr;
+        Filesize_t currentLength = 0;
+        Filesize_t offset = 0;
+
+        const char* next = nullptr; // Prefetched window, just after the current one.
+        Filesize_t nextLength = 0;
+    };
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILEWINDOW_HPP
@@ -0,0 +1,92 @@
+//
+// File module: buffered and atomic writing of files.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_FILEWRITER_HPP
+#define MFRANCESCHI_CPPLIBRARIES_FILEWRITER_HPP
+
+#include <memory>
+#include <string>
+#include "MF/File.hpp"
+
+namespace File {
+    /// What "Writer::Commit" waits for before returning.
+    enum class Durability {
+        NONE, // The data is left in the page cache: it may be lost on a power failure
+        SYNC_DATA, // The contents is on the device (fdatasync / FlushFileBuffers) before the file is published
+        SYNC_DIRECTORY // Same as SYNC_DATA, and the directory entry is on the device too (fsync of the directory)
+    };
+
+    /// Settings of a "Writer".
+    struct WriterOptions {
+        /// If true, the data goes to a temporary file which replaces the target only on "Commit":
+        /// readers see either the old file or the whole new one, never a partial one.
+        bool atomic = true;
+        /// Size of the buffer, rounded up to 4 KiB. Writes at least this big bypass it.
+        Filesize_t bufferSize = 1ul << 20;
+        /// If not 0, disk space is reserved upfront for this many bytes (fallocate), which limits fragmentation.
+        /// The file is truncated to what was actually written on "Commit".
+        Filesize_t expectedSize = 0;
+        Durability durability = Durability::NONE;
+    };
+
+    /**
+     * Writes a file through a big buffer aligned on pages, without any locale nor stream.
+     * > File::Writer writer(filename);
+     * > writer.Write(header); writer.Write(data, size);
+     * > if (!writer.Commit()) { ... }
+     * On Linux, an atomic writer uses an anonymous file (O_TMPFILE) which is linked then renamed over the target,
+     * so a crash never leaves a temporary file behind; elsewhere it writes to a temporary name next to the target.
+     * Any error is sticky: every later call fails, and "Commit" reports it.
+     */
+    class Writer {
+    public:
+        /// Opens the file (or the temporary file). Check "IsOpen" before writing.
+        explicit Writer(Filename_t filename, const WriterOptions& options = WriterOptions());
+
+        /// An atomic writer which was not committed is aborted; a non-atomic one is committed.
+        ~Writer();
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        /// True if the file is open and no error occurred.
+        bool IsOpen() const { return osFile != nullptr && !failed; }
+
+        /**
+         * Appends bytes to the file.
+         * @return False if writing failed (or failed before).
+         */
+        bool Write(const char* data, Filesize_t size);
+
+        /// Same as above, for a C++ string.
+        bool Write(const std::string& data) { return Write(data.data(), data.size()); }
+
+        /// Gives the buffered bytes to the system. They are not on the device yet: see "Durability".
+        bool Flush();
+
+        /**
+         * Flushes, waits for the durability level, publishes the file (for an atomic writer) and closes it.
+         * @return True if the whole file was written and published.
+         */
+        bool Commit();
+
+        /// Closes the file without publishing it. The target is unchanged for an atomic writer.
+        void Abort();
+
+        /// Number of bytes written so far, buffered ones included.
+        Filesize_t Size() const { return written + used; }
+
+    protected:
+        void* osFile = nullptr; // "Unix_WriteFile" or "Windows_WriteFile", see the API helpers.
+        WriterOptions options;
+        std::unique_ptr<char[]> storage; // Owns the buffer, which starts at the first page boundary in it.
+        char* buffer = nullptr;
+        Filesize_t capacity = 0;
+        Filesize_t used = 0;
+        Filesize_t written = 0;
+        bool failed = false;
+    };
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_FILEWRITER_HPP
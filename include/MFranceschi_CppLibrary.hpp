@@ -10,7 +10,30 @@
 #include "MF/Date.hpp"
 #include "MF/DynamicLibrary.hpp"
 #include "MF/File.hpp"
+#include "MF/FileBatch.hpp"
+#include "MF/FileChunker.hpp"
+#include "MF/FileContainers.hpp"
+#include "MF/FileCopy.hpp"
+#include "MF/FileDelete.hpp"
+#include "MF/FileDelta.hpp"
+#include "MF/FileDuplicates.hpp"
+#include "MF/FileEncoding.hpp"
+#include "MF/FileGlob.hpp"
+#include "MF/FileInflate.hpp"
+#include "MF/FileJournal.hpp"
+#include "MF/FileLineIndex.hpp"
+#include "MF/FileLines.hpp"
+#include "MF/FileMapped.hpp"
 #include "MF/FileOpen.hpp"
+#include "MF/FilePath.hpp"
+#include "MF/FilePrefetch.hpp"
+#include "MF/FileRecords.hpp"
+#include "MF/FileSearch.hpp"
+#include "MF/FileSnapshot.hpp"
+#include "MF/FileStat.hpp"
+#include "MF/FileWatcher.hpp"
+#include "MF/FileWindow.hpp"
+#include "MF/FileWriter.hpp"
 #include "MF/GeoCoord.hpp"
 #include "MF/Toolbox.hpp"
 
@@ -0,0 +1,60 @@
+//
+// Internal pool of buffers reused by File::Read (ReadStrategy::READ).
+//
+
+#include <mutex>
+#include <vector>
+#include "BufferPool.hpp"
+#include "MF/FileOpen.hpp"
+
+// Buffers are allocated by classes of power-of-two sizes, so that a released buffer fits any later request of its class.
+static constexpr std::size_t MIN_CLASS_SIZE = 4096;
+static constexpr std::size_t MAX_CLASS_SIZE = File::READ_STRATEGY_MAX_SIZE;
+static constexpr std::size_t MAX_BUFFERS_PER_CLASS = 8;
+
+static std::mutex poolMutex;
+static std::vector<std::vector<char*>> pool;
+
+static std::size_t ClassSize(std::size_t size, std::size_t& classIndex) {
+    std::size_t classSize = MIN_CLASS_SIZE;
+    classIndex = 0;
+    while (classSize < size) {
+        classSize <<= 1;
+        ++classIndex;
+    }
+    return classSize;
+}
+
+char* BufferPool_Acquire(std::size_t size) {
+    std::size_t classIndex;
+    const std::size_t classSize = ClassSize(size, classIndex);
+    if (classSize > MAX_CLASS_SIZE) {
+        return new char[size];
+    }
+
+    {
+        std::lock_guard<std::mutex> lockGuard(poolMutex);
+        if (classIndex < pool.size() && !pool[classIndex].empty()) {
+            char* buffer = pool[classIndex].back();
+            pool[classIndex].pop_back();
+            return buffer;
+        }
+    }
+    return new char[classSize];
+}
+
+void BufferPool_Release(char* buffer, std::size_t size) {
+    std::size_t classIndex;
+    const std::size_t classSize = ClassSize(size, classIndex);
+    if (classSize <= MAX_CLASS_SIZE) {
+        std::lock_guard<std::mutex> lockGuard(poolMutex);
+        if (pool.size() <= classIndex) {
+            pool.resize(classIndex + 1);
+        }
+        if (pool[classIndex].size() < MAX_BUFFERS_PER_CLASS) {
+            pool[classIndex].push_back(buffer);
+            return;
+        }
+    }
+    delete[] buffer;
+}
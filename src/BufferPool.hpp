@@ -0,0 +1,19 @@
+//
+// Internal pool of buffers reused by File::Read (ReadStrategy::READ).
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_BUFFERPOOL_HPP
+#define MFRANCESCHI_CPPLIBRARIES_BUFFERPOOL_HPP
+
+#include <cstddef>
+
+/**
+ * Returns a buffer of at least "size" bytes, reused from the pool when possible.
+ * Thread-safe. It must be given back with "BufferPool_Release".
+ */
+char* BufferPool_Acquire(std::size_t size);
+
+/// Gives back a buffer returned by "BufferPool_Acquire" with the same "size". Big buffers are freed, not pooled.
+void BufferPool_Release(char* buffer, std::size_t size);
+
+#endif //MFRANCESCHI_CPPLIBRARIES_BUFFERPOOL_HPP
@@ -10,6 +10,7 @@
 #include <sys/wait.h>
 #include <fcntl.h>
 #include <cassert>
+#include <cerrno>
 
 static constexpr unsigned int BUFFER_LENGTH = 4096;
 
@@ -123,24 +124,22 @@ void ProcessOutputStream_Retrieve::beforeStart() {
 void ProcessOutputStream_Retrieve::beforeStop() {}
 
 void ProcessOutputStream_Retrieve::afterStop() {
-    char chBuf[BUFFER_LENGTH] = {0};
-    bool bContinue = true;
+    char chBuf[BUFFER_LENGTH];
     ssize_t nbRead;
 
-    printf("Errno before read: %d\n", errno);
-
-    while (bContinue) {
-        nbRead = read(readStream, chBuf, BUFFER_LENGTH - 1);
-        printf("Errno of read: %d\n", errno);
+    // The parent must release its own write end, otherwise the read below never sees EOF.
+    // Reading until EOF (blocking) also keeps the pipe open while the child still writes into it.
+    close(writeStream);
+    fcntl(readStream, F_SETFL, fcntl(readStream, F_GETFL) & ~O_NONBLOCK);
 
+    while ((nbRead = read(readStream, chBuf, BUFFER_LENGTH)) != 0) {
         if (nbRead > 0) {
-            oss << chBuf;
-        } else { // TODO handle case -1
-            bContinue = false;
+            oss.write(chBuf, nbRead);
+        } else if (errno != EINTR) {
+            break;
         }
     }
     close(readStream);
-    close(writeStream);
 }
 
 std::string ProcessOutputStream_Retrieve::retrieveOutput() {
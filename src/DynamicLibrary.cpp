@@ -33,7 +33,7 @@ void* DynamicLibrary::GetFunction(const std::string& functionName) {
     }
 #else
     (void)dlerror(); // Clear any previous error.
-    functionAddress = dlsym(library, functionName.c_str());
+    functionAddress = dlsym(_library, functionName.c_str());
     if (dlerror()) {
         // We must run this check because the "functionAddress" value may be null but still valid.
         throw element_not_found_exception ("Unable to find given function: " + functionName);
@@ -71,7 +71,7 @@ DynamicLibrary::~DynamicLibrary() {
 #if defined(_WIN32)
     success = FreeLibrary(_GetLibraryPointer);
 #else
-    success = !dlclose(library);
+    success = !dlclose(_library);
 #endif
 
     if (success) {
@@ -91,7 +91,7 @@ DynamicLibrary::DynamicLibrary(const std::string &libName) {
     static constexpr DWORD dwFlags = LOAD_LIBRARY_SEARCH_DEFAULT_DIRS;
     _library = LoadLibraryExW(wLibName.get(), hFile, dwFlags);
 #else
-    library = dlopen(libName.c_str(), RTLD_LAZY | RTLD_GLOBAL);
+    _library = dlopen(libName.c_str(), RTLD_LAZY | RTLD_GLOBAL);
 #endif
 
     if (_library != nullptr) {
@@ -171,7 +171,7 @@ namespace File
 			ifs.open(filename, ios_base::binary);
 			return true;
 		}
-		else // Encoding is unknown
+		else // Encoding is unknown or has no stream policy
 			return false;
 	}
 
@@ -184,6 +184,15 @@ namespace File
 #endif
 	}
 
+	bool Identity(Filename_t filename, FileIdentity& identity)
+	{
+#if defined(_WIN32) // Win32
+		return Windows_GetFileIdentity(filename, identity);
+#else // POSIX
+		return Unix_GetFileIdentity(filename, identity);
+#endif
+	}
+
 	encoding_t Encoding(Filename_t filename)
     {
         char bits[NBR_BITS_TO_READ_ENCODING];
@@ -226,6 +235,15 @@ namespace File
 		case encoding_t::ENC_UTF8:
 			os << "UTF-8";
 			break;
+		case encoding_t::ENC_UTF16BE:
+			os << "UTF-16BE";
+			break;
+		case encoding_t::ENC_UTF32LE:
+			os << "UTF-32LE";
+			break;
+		case encoding_t::ENC_UTF32BE:
+			os << "UTF-32BE";
+			break;
 		case encoding_t::ENC_ERROR:
 			os << "<encoding-error>";
 			break;
@@ -0,0 +1,42 @@
+//
+// File module: reading many files at once.
+//
+
+#include <mutex>
+#include "MF/FileBatch.hpp"
+#include "ParallelHelper.hpp"
+
+#if defined(_WIN32)
+#   include "WindowsAPIHelper.hpp"
+#   define OS_ReadWholeFile Windows_ReadWholeFile
+#else
+#   include "UnixAPIHelper.hpp"
+#   define OS_ReadWholeFile Unix_ReadWholeFile
+#endif
+
+namespace File {
+    size_t ReadMany(const std::vector<SFilename_t>& filenames, const ReadManyCallback& callback,
+                    const ReadManyOptions& options) {
+        if (filenames.empty()) {
+            return 0;
+        }
+
+#if !defined(_WIN32)
+        size_t succeeded = 0;
+        if (options.useIoUring && Unix_ReadManyIoUring(filenames, callback, options.queueDepth, succeeded)) {
+            return succeeded;
+        }
+#endif
+
+        std::mutex callbackMutex;
+        size_t successes = 0;
+        Parallel_For(filenames.size(), Parallel_ThreadCount(options.threads), [&](size_t index) {
+            FileBuffer buffer;
+            const bool success = OS_ReadWholeFile(filenames[index].c_str(), buffer);
+            std::lock_guard<std::mutex> lock(callbackMutex);
+            successes += success;
+            callback(index, std::move(buffer), success);
+        });
+        return successes;
+    }
+}
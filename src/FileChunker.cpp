@@ -0,0 +1,197 @@
+//
+// File module: content-defined chunking of buffers, for deduplication and incremental backups.
+//
+
+#include <algorithm>
+#include "MF/FileChunker.hpp"
+#include "HashHelper.hpp"
+#include "ParallelHelper.hpp"
+
+namespace File {
+
+/////////////////////////////////////////////////////////////////  PRIVATE
+
+//-------------------------------------------------------------- Constants
+
+    // Parts of the buffer chunked by each job, at least this many chunks of the biggest size.
+    constexpr static Filesize_t CHUNK_SEGMENT_SIZE = 8ul << 20;
+    constexpr static Filesize_t CHUNK_SEGMENT_MAX_CHUNKS = 64;
+
+    // Seed of the gear table: changing it moves every boundary, so stored chunks would no longer be found.
+    constexpr static uint64_t CHUNK_GEAR_SEED = 0x4D46436863756E6Bull;
+
+    // Chunks hashed by a job once the boundaries are known.
+    constexpr static size_t CHUNK_HASH_BATCH = 256;
+
+//------------------------------------------------------ Private functions
+
+    /// Random value of each byte, rolled into the fingerprint, and the same shifted by one bit.
+    struct Chunk_GearTable {
+        uint64_t values[256];
+        uint64_t shifted[256];
+
+        Chunk_GearTable() {
+            // SplitMix64: deterministic, and good enough to spread the bits.
+            uint64_t state = CHUNK_GEAR_SEED;
+            for (size_t i = 0; i < 256; ++i) {
+                state += 0x9E3779B97F4A7C15ull;
+                uint64_t z = state;
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                values[i] = z ^ (z >> 31);
+                shifted[i] = values[i] << 1;
+            }
+        }
+    };
+
+    static const Chunk_GearTable CHUNK_GEAR;
+
+    /// Sizes and masks derived from "ChunkOptions".
+    struct Chunk_Parameters {
+        Filesize_t minSize;
+        Filesize_t avgSize;
+        Filesize_t maxSize;
+        uint64_t smallMask; // Used before "avgSize": more bits, so a cut is less likely.
+        uint64_t largeMask; // Used after.
+    };
+
+    /// The top bits are tested, as after the shifts they depend on the most bytes; all but the very top one,
+    /// so that the mask shifted by one bit tests the same bits of a fingerprint shifted by one bit.
+    static uint64_t Chunk_TopBits(unsigned int count) {
+        return count ? (~0ull << (64 - std::min(count, 62u))) >> 1 : 0;
+    }
+
+    static Chunk_Parameters Chunk_MakeParameters(const ChunkOptions& options) {
+        Chunk_Parameters parameters;
+        parameters.minSize = std::max<Filesize_t>(options.minSize, 1);
+        parameters.avgSize = std::max<Filesize_t>(options.avgSize, parameters.minSize);
+        parameters.maxSize = std::max<Filesize_t>(options.maxSize, parameters.avgSize);
+        unsigned int bits = 0;
+        while ((Filesize_t(2) << bits) <= parameters.avgSize) {
+            ++bits;
+        }
+        // Normalisation level 2: a cut is 4 times less likely before the average size, and 4 times more after.
+        parameters.smallMask = Chunk_TopBits(bits + 2);
+        parameters.largeMask = Chunk_TopBits(bits > 2 ? bits - 2 : 1);
+        return parameters;
+    }
+
+    /**
+     * Rolls the fingerprint over bytes [i, end) of a chunk, and returns the end of the chunk if a cut point is found
+     * (0 otherwise). Two bytes are rolled per step: after the first one, the fingerprint is kept shifted by one bit
+     * (the shifted table), which saves a shift, and tested with the shifted mask. The bound is checked every 4 bytes.
+     */
+    static Filesize_t Chunk_Roll(const unsigned char* bytes, Filesize_t i, Filesize_t end, uint64_t mask, uint64_t& fingerprint) {
+        const uint64_t shiftedMask = mask << 1;
+        uint64_t value = fingerprint;
+        for (; i + 4 <= end; i += 4) {
+            value = (value << 2) + CHUNK_GEAR.shifted[bytes[i]];
+            if (!(value & shiftedMask)) {
+                return i + 1;
+            }
+            value += CHUNK_GEAR.values[bytes[i + 1]];
+            if (!(value & mask)) {
+                return i + 2;
+            }
+            value = (value << 2) + CHUNK_GEAR.shifted[bytes[i + 2]];
+            if (!(value & shiftedMask)) {
+                return i + 3;
+            }
+            value += CHUNK_GEAR.values[bytes[i + 3]];
+            if (!(value & mask)) {
+                return i + 4;
+            }
+        }
+        for (; i < end; ++i) {
+            value = (value << 1) + CHUNK_GEAR.values[bytes[i]];
+            if (!(value & mask)) {
+                return i + 1;
+            }
+        }
+        fingerprint = value;
+        return 0;
+    }
+
+    /// Returns the end of the chunk starting at "begin".
+    static Filesize_t Chunk_Cut(const char* contents, Filesize_t begin, Filesize_t size, const Chunk_Parameters& parameters) {
+        const Filesize_t remaining = size - begin;
+        if (remaining <= parameters.minSize) {
+            return size;
+        }
+        const auto bytes = reinterpret_cast<const unsigned char*>(contents + begin);
+        const Filesize_t limit = std::min(remaining, parameters.maxSize);
+        const Filesize_t normal = std::min(limit, parameters.avgSize);
+        uint64_t fingerprint = 0;
+        Filesize_t end = Chunk_Roll(bytes, parameters.minSize, normal, parameters.smallMask, fingerprint);
+        if (!end) {
+            end = Chunk_Roll(bytes, std::max(normal, parameters.minSize), limit, parameters.largeMask, fingerprint);
+        }
+        return begin + (end ? end : limit);
+    }
+
+    /// Appends the ends of the chunks from "begin", until one reaches "end" (it may go beyond).
+    static void Chunk_Cuts(const char* contents, Filesize_t begin, Filesize_t end, Filesize_t size,
+                           const Chunk_Parameters& parameters, std::vector<Filesize_t>& cuts) {
+        while (begin < end) {
+            begin = Chunk_Cut(contents, begin, size, parameters);
+            cuts.push_back(begin);
+        }
+    }
+
+/////////////////////////////////////////////////////////////////  PUBLIC
+
+//------------------------------------------------------- Public functions
+
+    std::vector<Chunk> FindChunks(const char* contents, Filesize_t size, const ChunkOptions& options) {
+        const Chunk_Parameters parameters = Chunk_MakeParameters(options);
+        const unsigned int threads = Parallel_ThreadCount(options.threads);
+        const Filesize_t segmentSize = std::max(CHUNK_SEGMENT_SIZE, CHUNK_SEGMENT_MAX_CHUNKS * parameters.maxSize);
+        const size_t segmentCount = threads > 1 ? static_cast<size_t>((size + segmentSize - 1) / segmentSize) : 1;
+
+        std::vector<Filesize_t> cuts;
+        if (segmentCount <= 1) {
+            Chunk_Cuts(contents, 0, size, size, parameters, cuts);
+        } else {
+            // Each segment is chunked as if a chunk began at its start.
+            std::vector<std::vector<Filesize_t>> segmentCuts(segmentCount);
+            Parallel_For(segmentCount, threads, [contents, size, segmentSize, &parameters, &segmentCuts](size_t segment) {
+                const Filesize_t begin = segment * segmentSize;
+                Chunk_Cuts(contents, begin, std::min(begin + segmentSize, size), size, parameters, segmentCuts[segment]);
+            });
+            // The true chunks come from the end of the previous segment: once one of them ends where a chunk
+            // of the segment ends, both continue alike, and the rest of the segment is taken as is.
+            cuts.swap(segmentCuts.front());
+            for (size_t segment = 1; segment < segmentCount; ++segment) {
+                const Filesize_t begin = segment * segmentSize;
+                const Filesize_t end = std::min(begin + segmentSize, size);
+                const std::vector<Filesize_t>& candidates = segmentCuts[segment];
+                Filesize_t position = cuts.back();
+                while (position < end) {
+                    const auto found = std::lower_bound(candidates.begin(), candidates.end(), position);
+                    if (position == begin || (found != candidates.end() && *found == position)) {
+                        cuts.insert(cuts.end(), position == begin ? candidates.begin() : found + 1, candidates.end());
+                        break;
+                    }
+                    position = Chunk_Cut(contents, position, size, parameters);
+                    cuts.push_back(position);
+                }
+            }
+        }
+
+        std::vector<Chunk> chunks(cuts.size());
+        for (size_t i = 0; i < cuts.size(); ++i) {
+            chunks[i].offset = i ? cuts[i - 1] : 0;
+            chunks[i].size = cuts[i] - chunks[i].offset;
+            chunks[i].hash = 0;
+        }
+        if (options.hashChunks) {
+            Parallel_For((chunks.size() + CHUNK_HASH_BATCH - 1) / CHUNK_HASH_BATCH, threads, [contents, &chunks](size_t batch) {
+                const size_t last = std::min(chunks.size(), (batch + 1) * CHUNK_HASH_BATCH);
+                for (size_t i = batch * CHUNK_HASH_BATCH; i < last; ++i) {
+                    chunks[i].hash = Hash_XXH64(contents + chunks[i].offset, static_cast<size_t>(chunks[i].size));
+                }
+            });
+        }
+        return chunks;
+    }
+}
@@ -0,0 +1,145 @@
+//
+// File module: vector and hash map stored in a memory-mapped file, reopened without being rebuilt.
+//
+
+#include <cstring>
+#include "MF/FileContainers.hpp"
+
+#if defined(_WIN32)
+#   include "WindowsAPIHelper.hpp"
+using OSMappedRegion_t = Windows_MappedRegion;
+#   define OS_OpenMappedRegion Windows_OpenMappedRegion
+#   define OS_ResizeMappedRegion Windows_ResizeMappedRegion
+#   define OS_FlushMappedRegion Windows_FlushMappedRegion
+#   define OS_CloseMappedRegion Windows_CloseMappedRegion
+#else
+#   include "UnixAPIHelper.hpp"
+using OSMappedRegion_t = Unix_MappedRegion;
+#   define OS_OpenMappedRegion Unix_OpenMappedRegion
+#   define OS_ResizeMappedRegion Unix_ResizeMappedRegion
+#   define OS_FlushMappedRegion Unix_FlushMappedRegion
+#   define OS_CloseMappedRegion Unix_CloseMappedRegion
+#endif
+
+namespace File {
+
+/////////////////////////////////////////////////////////////////  PRIVATE
+
+//-------------------------------------------------------------- Constants
+
+    constexpr size_t MappedContainer::ELEMENT_ALIGNMENT;
+    constexpr Filesize_t MappedContainer::HEADER_SIZE;
+
+//------------------------------------------------------------------ State
+
+    struct MappedContainer::State {
+        OSMappedRegion_t* region = nullptr;
+    };
+
+/////////////////////////////////////////////////////////////////  PUBLIC
+
+//------------------------------------------------------- Public functions
+
+    MappedContainer::MappedContainer() : state(new State) {}
+
+    MappedContainer::MappedContainer(MappedContainer&& other) noexcept :
+            data(other.data), size(other.size), writable(other.writable), state(std::move(other.state))
+    {
+        other.data = nullptr;
+        other.size = 0;
+        other.writable = false;
+    }
+
+    MappedContainer& MappedContainer::operator=(MappedContainer&& other) noexcept {
+        if (this != &other) {
+            Close();
+            data = other.data;
+            size = other.size;
+            writable = other.writable;
+            state = std::move(other.state);
+            other.data = nullptr;
+            other.size = 0;
+            other.writable = false;
+        }
+        return *this;
+    }
+
+    MappedContainer::~MappedContainer() {
+        Close();
+    }
+
+    bool MappedContainer::Flush() {
+        return state && state->region && OS_FlushMappedRegion(state->region);
+    }
+
+    void MappedContainer::Close() {
+        if (state && state->region) {
+            OS_CloseMappedRegion(state->region);
+            state->region = nullptr;
+        }
+        data = nullptr;
+        size = 0;
+        writable = false;
+    }
+
+    bool MappedContainer::OpenContainer(Filename_t filename, MappedMode mode, const char* magic, uint32_t keySize,
+                                        uint32_t valueSize, uint32_t alignment, uint32_t valueAlignment,
+                                        uint64_t (*tableSize)(uint64_t capacity)) {
+        static_assert(sizeof(Header) <= HEADER_SIZE, "The header must fit before the table");
+        Close();
+        if (!state) {
+            state.reset(new State);
+        }
+        state->region = OS_OpenMappedRegion(filename, mode == MappedMode::READ_WRITE);
+        if (!state->region) {
+            return false;
+        }
+        data = state->region->data;
+        size = state->region->size;
+        writable = mode == MappedMode::READ_WRITE;
+
+        if (!size && writable) {
+            // New file: a header and an empty table.
+            if (!ResizeFile(HEADER_SIZE)) {
+                Close();
+                return false;
+            }
+            Header& header = GetHeader();
+            std::memcpy(header.magic, magic, sizeof(header.magic));
+            header.keySize = keySize;
+            header.valueSize = valueSize;
+            header.alignment = alignment;
+            header.valueAlignment = valueAlignment;
+            header.count = 0;
+            header.capacity = 0;
+            header.tableOffset = HEADER_SIZE;
+            return true;
+        }
+
+        // Same kind of container, same elements, and a table within the file.
+        if (size < HEADER_SIZE) {
+            Close();
+            return false;
+        }
+        const Header& header = GetHeader();
+        const uint64_t table = tableSize(header.capacity);
+        if (std::memcmp(header.magic, magic, sizeof(header.magic)) || header.keySize != keySize || header.valueSize != valueSize
+            || header.alignment != alignment || header.valueAlignment != valueAlignment || header.count > header.capacity
+            || header.tableOffset < HEADER_SIZE || header.tableOffset % ELEMENT_ALIGNMENT || header.tableOffset > size
+            || table > size - header.tableOffset) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    bool MappedContainer::ResizeFile(Filesize_t newSize) {
+        const bool success = OS_ResizeMappedRegion(state->region, newSize);
+        data = state->region->data;
+        size = state->region->size;
+        if (!data) {
+            Close(); // The file could not be mapped again.
+        }
+        return success && data;
+    }
+}
@@ -0,0 +1,91 @@
+//
+// File module: copy of files and directory trees, done by the kernel where possible.
+//
+
+#include <mutex>
+#include "MF/FileCopy.hpp"
+#include "ParallelHelper.hpp"
+#include "TreeHelper.hpp"
+
+#if defined(_WIN32)
+#   include "WindowsAPIHelper.hpp"
+#   define OS_CopyFile Windows_CopyFile
+#   define OS_CopySymlink Windows_CopySymlink
+#else
+#   include "UnixAPIHelper.hpp"
+#   define OS_CopyFile Unix_CopyFile
+#   define OS_CopySymlink Unix_CopySymlink
+#endif
+
+namespace File {
+    CopyMethod Copy(Filename_t source, Filename_t destination, bool overwrite) {
+        Filesize_t size = 0;
+        return OS_CopyFile(source, destination, overwrite, size);
+    }
+
+    CopyTreeResult CopyTree(Filename_t source, Filename_t destination, unsigned int threads) {
+        CopyTreeResult result;
+        std::vector<std::pair<SFilename_t, SFilename_t>> files; // Source and destination names.
+        std::vector<std::pair<SFilename_t, SFilename_t>> links;
+
+        // Directories are walked and created by the calling thread, in order, so that parents exist before children.
+        std::vector<std::pair<SFilename_t, SFilename_t>> directories;
+        directories.emplace_back(Tree_AsDirectory(source), Tree_AsDirectory(destination));
+        std::vector<Tree_Entry> entries;
+        for (size_t i = 0; i < directories.size(); ++i) {
+            const SFilename_t sourceDirectory = directories[i].first;
+            const SFilename_t destinationDirectory = directories[i].second;
+            if (!CreateFolder(destinationDirectory.c_str()) && !IsDir(destinationDirectory.c_str())) {
+                ++result.failures;
+                continue;
+            }
+            entries.clear();
+            if (!Tree_ListDirectory(sourceDirectory.c_str(), entries)) {
+                ++result.failures;
+                continue;
+            }
+            ++result.directories;
+
+            for (const Tree_Entry& entry : entries) {
+                switch (entry.type) {
+                    case Tree_EntryType::FILE:
+                        files.emplace_back(sourceDirectory + entry.name, destinationDirectory + entry.name);
+                        break;
+                    case Tree_EntryType::DIRECTORY:
+                        directories.emplace_back(sourceDirectory + entry.name + FILE_SEPARATOR,
+                                                 destinationDirectory + entry.name + FILE_SEPARATOR);
+                        break;
+                    case Tree_EntryType::SYMLINK:
+                        links.emplace_back(sourceDirectory + entry.name, destinationDirectory + entry.name);
+                        break;
+                    case Tree_EntryType::OTHER:
+                        ++result.failures;
+                        break;
+                }
+            }
+        }
+
+        for (const auto& link : links) {
+            if (OS_CopySymlink(link.first.c_str(), link.second.c_str())) {
+                ++result.links;
+            } else {
+                ++result.failures;
+            }
+        }
+
+        std::mutex resultMutex;
+        Parallel_For(files.size(), Parallel_ThreadCount(threads), [&files, &result, &resultMutex](size_t index) {
+            Filesize_t size = 0;
+            const CopyMethod method = OS_CopyFile(files[index].first.c_str(), files[index].second.c_str(), true, size);
+            std::lock_guard<std::mutex> lock(resultMutex);
+            if (method == CopyMethod::FAILED) {
+                ++result.failures;
+            } else {
+                ++result.files;
+                result.bytes += size;
+                result.reflinks += method == CopyMethod::REFLINK;
+            }
+        });
+        return result;
+    }
+}
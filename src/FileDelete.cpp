@@ -0,0 +1,160 @@
+//
+// File module: removal of directory trees.
+//
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "MF/FileDelete.hpp"
+#include "ParallelHelper.hpp"
+#include "TreeHelper.hpp"
+
+#if defined(_WIN32)
+#   include "WindowsAPIHelper.hpp"
+using OSDirectory_t = File::SFilename_t;
+static const OSDirectory_t OS_CURRENT_DIRECTORY;
+#   define OS_OpenDirectoryAt Windows_OpenDirectoryAt
+#   define OS_ListDirectoryAt Windows_ListDirectoryAt
+#   define OS_RemoveAt Windows_RemoveAt
+#   define OS_CloseDirectory Windows_CloseDirectory
+#else
+#   include <fcntl.h>
+#   include "UnixAPIHelper.hpp"
+using OSDirectory_t = int;
+static const OSDirectory_t OS_CURRENT_DIRECTORY = AT_FDCWD;
+#   define OS_OpenDirectoryAt Unix_OpenDirectoryAt
+#   define OS_ListDirectoryAt Unix_ListDirectoryAt
+#   define OS_RemoveAt Unix_RemoveAt
+#   define OS_CloseDirectory Unix_CloseDirectory
+#endif
+
+namespace {
+    /// A directory of the tree: it stays open until all its subdirectories are removed.
+    struct Delete_Directory {
+        Delete_Directory* parent; // nullptr for the root.
+        File::SFilename_t name; // Name in the parent only.
+        OSDirectory_t handle{};
+        bool opened = false;
+        std::atomic<size_t> pending{1}; // Subdirectories not removed yet, plus one until the listing is done.
+
+        Delete_Directory(Delete_Directory* parent, File::SFilename_t name) :
+                parent(parent), name(std::move(name)) {}
+    };
+
+    /// State shared by the threads of a "DeleteTree".
+    class Delete_Run {
+    public:
+        explicit Delete_Run(const File::DeleteTreeProgress& progress) : progress(progress) {}
+
+        void Push(Delete_Directory* directory) {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back(directory);
+            queueChanged.notify_one();
+        }
+
+        /// Body of each thread: takes the most recent directory first, so that the tree is walked depth first
+        /// and the number of open directories stays close to its depth.
+        void Work() {
+            std::vector<Tree_Entry> entries;
+            std::unique_lock<std::mutex> lock(queueMutex);
+            while (true) {
+                queueChanged.wait(lock, [this]() { return done || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                Delete_Directory* directory = queue.back();
+                queue.pop_back();
+                lock.unlock();
+                Process(directory, entries);
+                lock.lock();
+            }
+        }
+
+        File::DeleteTreeResult Result() const {
+            File::DeleteTreeResult result;
+            result.files = files;
+            result.directories = directories;
+            result.failures = failures;
+            return result;
+        }
+
+    protected:
+        void Process(Delete_Directory* directory, std::vector<Tree_Entry>& entries) {
+            const OSDirectory_t& parentHandle = directory->parent ? directory->parent->handle : OS_CURRENT_DIRECTORY;
+            directory->opened = OS_OpenDirectoryAt(parentHandle, directory->name.c_str(), directory->handle);
+            entries.clear();
+            if (!directory->opened || !OS_ListDirectoryAt(directory->handle, entries)) {
+                ++failures;
+                Finish(directory);
+                return;
+            }
+
+            std::vector<Delete_Directory*> subdirectories;
+            for (Tree_Entry& entry : entries) {
+                if (entry.type == Tree_EntryType::DIRECTORY) {
+                    ++directory->pending;
+                    subdirectories.push_back(new Delete_Directory(directory, std::move(entry.name)));
+                } else {
+                    Count(OS_RemoveAt(directory->handle, entry.name.c_str(), false), files);
+                }
+            }
+            if (!subdirectories.empty()) {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                queue.insert(queue.end(), subdirectories.begin(), subdirectories.end());
+                queueChanged.notify_all();
+            }
+            Finish(directory);
+        }
+
+        /// Drops one reference of "directory": the last one removes it, which drops one reference of its parent.
+        void Finish(Delete_Directory* directory) {
+            while (directory && !--directory->pending) {
+                Delete_Directory* parent = directory->parent;
+                if (directory->opened) {
+                    OS_CloseDirectory(directory->handle);
+                    Count(OS_RemoveAt(parent ? parent->handle : OS_CURRENT_DIRECTORY, directory->name.c_str(), true),
+                          directories);
+                }
+                if (!parent) {
+                    std::lock_guard<std::mutex> lock(queueMutex);
+                    done = true;
+                    queueChanged.notify_all();
+                }
+                delete directory;
+                directory = parent;
+            }
+        }
+
+        void Count(bool removed, std::atomic<size_t>& counter) {
+            if (!removed) {
+                ++failures;
+                return;
+            }
+            ++counter;
+            if (progress && ++removals % File::DELETE_TREE_PROGRESS_INTERVAL == 0) {
+                std::lock_guard<std::mutex> lock(progressMutex);
+                progress(Result());
+            }
+        }
+
+        const File::DeleteTreeProgress& progress;
+        std::mutex progressMutex;
+        std::atomic<size_t> files{0}, directories{0}, failures{0}, removals{0};
+
+        std::mutex queueMutex;
+        std::condition_variable queueChanged;
+        std::vector<Delete_Directory*> queue; // Directories to open and list.
+        bool done = false; // True once the root is finished.
+    };
+}
+
+namespace File {
+    DeleteTreeResult DeleteTree(Filename_t directory, unsigned int threads, const DeleteTreeProgress& progress) {
+        Delete_Run run(progress);
+        run.Push(new Delete_Directory(nullptr, directory));
+        Parallel_Run(Parallel_ThreadCount(threads), [&run]() { run.Work(); });
+        return run.Result();
+    }
+}
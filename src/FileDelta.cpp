@@ -0,0 +1,447 @@
+//
+// File module: differences between two versions of a file, as blocks of the old one and new bytes (rsync algorithm).
+//
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include "MF/FileDelta.hpp"
+#include "MF/FileWriter.hpp"
+#include "HashHelper.hpp"
+
+#if defined(_WIN32)
+#   include "WindowsAPIHelper.hpp"
+using OSPatchFile_t = Windows_PatchFile;
+#   define OS_OpenPatchFile Windows_OpenPatchFile
+#   define OS_ReadPatchFile Windows_ReadPatchFile
+#   define OS_WritePatchFile Windows_WritePatchFile
+#   define OS_ClosePatchFile Windows_ClosePatchFile
+#else
+#   include "UnixAPIHelper.hpp"
+using OSPatchFile_t = Unix_PatchFile;
+#   define OS_OpenPatchFile Unix_OpenPatchFile
+#   define OS_ReadPatchFile Unix_ReadPatchFile
+#   define OS_WritePatchFile Unix_WritePatchFile
+#   define OS_ClosePatchFile Unix_ClosePatchFile
+#endif
+
+namespace File {
+
+/////////////////////////////////////////////////////////////////  PRIVATE
+
+//-------------------------------------------------------------- Constants
+
+    // First bytes of a serialised signature and of a delta. Both end with the XXH64 of what precedes.
+    constexpr static char SIGNATURE_MAGIC[8] = {'M', 'F', 'S', 'I', 'G', 'N', '0', '1'};
+    constexpr static char DELTA_MAGIC[8] = {'M', 'F', 'D', 'E', 'L', 'T', 'A', '1'};
+    constexpr static size_t DELTA_CHECKSUM_SIZE = sizeof(uint64_t);
+
+    // Bounds of the automatic block size.
+    constexpr static uint32_t DELTA_MIN_BLOCK_SIZE = 1u << 10;
+    constexpr static uint32_t DELTA_MAX_BLOCK_SIZE = 128u << 10;
+
+    // Flag of a delta whose copies can be done in place.
+    constexpr static uint64_t DELTA_IN_PLACE = 1;
+
+    // Buffer of the copies done inside a file.
+    constexpr static size_t DELTA_COPY_BUFFER_SIZE = 1ul << 20;
+
+//------------------------------------------------------ Private functions
+
+    static void Delta_PutVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    static bool Delta_GetVarint(const char*& position, const char* end, uint64_t& value) {
+        value = 0;
+        for (unsigned int shift = 0; shift < 64 && position < end; shift += 7) {
+            const auto byte = static_cast<uint8_t>(*position++);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Appends the XXH64 of the whole string to it.
+    static void Delta_Seal(std::string& out) {
+        const uint64_t checksum = Hash_XXH64(out.data(), out.size());
+        out.append(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    }
+
+    /// Checks the magic and the checksum of a sealed string. On success, [position, end) is what lies between.
+    static bool Delta_Unseal(const char* data, size_t size, const char (&magic)[8], const char*& position, const char*& end) {
+        if (size < sizeof(magic) + DELTA_CHECKSUM_SIZE || std::memcmp(data, magic, sizeof(magic)) != 0) {
+            return false;
+        }
+        uint64_t checksum;
+        std::memcpy(&checksum, data + size - DELTA_CHECKSUM_SIZE, sizeof(checksum));
+        position = data + sizeof(magic);
+        end = data + size - DELTA_CHECKSUM_SIZE;
+        return Hash_XXH64(data, size - DELTA_CHECKSUM_SIZE) == checksum;
+    }
+
+    /// Rolling checksum of rsync: the sum of the bytes, and the sum of the bytes weighted by their distance to the end,
+    /// 16 bits each. Both are kept on 32 bits while rolling, only the low bits being used.
+    struct Delta_Weak {
+        uint32_t a = 0;
+        uint32_t b = 0;
+
+        Delta_Weak(const unsigned char* bytes, size_t size) {
+            for (size_t i = 0; i < size; ++i) {
+                a += bytes[i];
+                b += static_cast<uint32_t>(size - i) * bytes[i];
+            }
+        }
+
+        /// Moves the window of "size" bytes by one byte: "out" leaves it, "in" enters it.
+        void Roll(unsigned char out, unsigned char in, uint32_t size) {
+            a += static_cast<uint32_t>(in) - out;
+            b += a - size * out;
+        }
+
+        uint32_t Value() const { return (a & 0xFFFFu) | b << 16; }
+    };
+
+    /// Blocks of a signature (except a short last one) grouped by a hash of their weak checksum.
+    struct Delta_Index {
+        unsigned int shift = 32;
+        std::vector<uint32_t> starts; // Position in "blocks" of the first block of each bucket, and the end.
+        std::vector<uint32_t> blocks;
+
+        explicit Delta_Index(const DeltaSignature& signature, size_t fullBlocks) {
+            unsigned int bits = 1;
+            while (bits < 31 && (size_t(1) << bits) < 2 * fullBlocks) {
+                ++bits;
+            }
+            shift = 32 - bits;
+            starts.assign((size_t(1) << bits) + 1, 0);
+            for (size_t i = 0; i < fullBlocks; ++i) {
+                ++starts[Bucket(signature.weak[i]) + 1];
+            }
+            for (size_t i = 1; i < starts.size(); ++i) {
+                starts[i] += starts[i - 1];
+            }
+            blocks.resize(fullBlocks);
+            std::vector<uint32_t> next(starts.begin(), starts.end() - 1);
+            for (size_t i = 0; i < fullBlocks; ++i) {
+                blocks[next[Bucket(signature.weak[i])]++] = static_cast<uint32_t>(i);
+            }
+        }
+
+        uint32_t Bucket(uint32_t weak) const { return (weak * 0x9E3779B1u) >> shift; }
+    };
+
+    /// Writes the operations of a delta, merging consecutive blocks into one copy.
+    struct Delta_Encoder {
+        std::string out;
+        uint64_t runFirst = 0;
+        uint64_t runCount = 0;
+
+        void FlushRun() {
+            if (runCount) {
+                Delta_PutVarint(out, runCount << 1);
+                Delta_PutVarint(out, runFirst);
+                runCount = 0;
+            }
+        }
+
+        void Literal(const char* data, Filesize_t size) {
+            if (size) {
+                FlushRun();
+                Delta_PutVarint(out, size << 1 | 1);
+                out.append(data, static_cast<size_t>(size));
+            }
+        }
+
+        void Block(uint64_t index) {
+            if (Continues(index)) {
+                ++runCount;
+                return;
+            }
+            FlushRun();
+            runFirst = index;
+            runCount = 1;
+        }
+
+        /// True if "index" continues the current run of blocks.
+        bool Continues(uint64_t index) const { return runCount && index == runFirst + runCount; }
+    };
+
+    /// Header and operations of a delta, once checked.
+    struct Delta_Parsed {
+        uint64_t flags = 0;
+        uint64_t basisSize = 0;
+        uint64_t newSize = 0;
+
+        struct Operation {
+            bool copy; // Bytes of the basis, or new bytes of the delta.
+            uint64_t offset; // In the basis, or in the delta.
+            uint64_t length;
+        };
+        std::vector<Operation> operations;
+    };
+
+    static bool Delta_Parse(const char* delta, size_t deltaSize, Delta_Parsed& parsed) {
+        const char* position;
+        const char* end;
+        uint64_t blockSize;
+        if (!Delta_Unseal(delta, deltaSize, DELTA_MAGIC, position, end) || !Delta_GetVarint(position, end, parsed.flags)
+                || !Delta_GetVarint(position, end, parsed.basisSize) || !Delta_GetVarint(position, end, blockSize)
+                || !Delta_GetVarint(position, end, parsed.newSize) || !blockSize) {
+            return false;
+        }
+        const uint64_t blockCount = (parsed.basisSize + blockSize - 1) / blockSize;
+        uint64_t target = 0;
+        while (position < end) {
+            uint64_t tag, value;
+            if (!Delta_GetVarint(position, end, tag)) {
+                return false;
+            }
+            Delta_Parsed::Operation operation{};
+            if (tag & 1) {
+                value = tag >> 1;
+                if (value > static_cast<uint64_t>(end - position)) {
+                    return false;
+                }
+                operation = {false, static_cast<uint64_t>(position - delta), value};
+                position += value;
+            } else {
+                const uint64_t count = tag >> 1;
+                if (!Delta_GetVarint(position, end, value) || value >= blockCount || count > blockCount - value) {
+                    return false;
+                }
+                const uint64_t offset = value * blockSize;
+                operation = {true, offset, std::min(offset + count * blockSize, parsed.basisSize) - offset};
+                // In place, a copy must not read what an earlier operation overwrote (see "ApplyDeltaInPlace").
+                if ((parsed.flags & DELTA_IN_PLACE) && offset < target) {
+                    return false;
+                }
+            }
+            if (!operation.length || operation.length > parsed.newSize - target) {
+                return false;
+            }
+            target += operation.length;
+            parsed.operations.push_back(operation);
+        }
+        return target == parsed.newSize;
+    }
+
+/////////////////////////////////////////////////////////////////  PUBLIC
+
+//------------------------------------------------------- Public functions
+
+    std::string DeltaSignature::Serialize() const {
+        std::string out(SIGNATURE_MAGIC, sizeof(SIGNATURE_MAGIC));
+        Delta_PutVarint(out, size);
+        Delta_PutVarint(out, blockSize);
+        for (size_t i = 0; i < weak.size(); ++i) {
+            out.append(reinterpret_cast<const char*>(&weak[i]), sizeof(weak[i]));
+            out.append(reinterpret_cast<const char*>(&strong[i]), sizeof(strong[i]));
+        }
+        Delta_Seal(out);
+        return out;
+    }
+
+    bool DeltaSignature::Parse(const char* data, size_t dataSize) {
+        *this = DeltaSignature();
+        const char* position;
+        const char* end;
+        uint64_t readSize, readBlockSize;
+        if (!Delta_Unseal(data, dataSize, SIGNATURE_MAGIC, position, end) || !Delta_GetVarint(position, end, readSize)
+                || !Delta_GetVarint(position, end, readBlockSize) || !readBlockSize || readBlockSize > UINT32_MAX) {
+            return false;
+        }
+        constexpr size_t entrySize = sizeof(uint32_t) + sizeof(uint64_t);
+        const uint64_t count = (readSize + readBlockSize - 1) / readBlockSize;
+        if (static_cast<uint64_t>(end - position) != count * entrySize) {
+            return false;
+        }
+        size = readSize;
+        blockSize = static_cast<uint32_t>(readBlockSize);
+        weak.resize(static_cast<size_t>(count));
+        strong.resize(static_cast<size_t>(count));
+        for (size_t i = 0; i < weak.size(); ++i, position += entrySize) {
+            std::memcpy(&weak[i], position, sizeof(weak[i]));
+            std::memcpy(&strong[i], position + sizeof(weak[i]), sizeof(strong[i]));
+        }
+        return true;
+    }
+
+    DeltaSignature ComputeSignature(const char* contents, Filesize_t size, uint32_t blockSize) {
+        if (!blockSize) {
+            blockSize = DELTA_MIN_BLOCK_SIZE;
+            while (blockSize < DELTA_MAX_BLOCK_SIZE && static_cast<Filesize_t>(blockSize) * blockSize < size) {
+                blockSize <<= 1;
+            }
+        }
+        DeltaSignature signature;
+        signature.size = size;
+        signature.blockSize = blockSize;
+        const auto count = static_cast<size_t>((size + blockSize - 1) / blockSize);
+        signature.weak.resize(count);
+        signature.strong.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            const Filesize_t offset = static_cast<Filesize_t>(i) * blockSize;
+            const auto length = static_cast<size_t>(std::min<Filesize_t>(blockSize, size - offset));
+            signature.weak[i] = Delta_Weak(reinterpret_cast<const unsigned char*>(contents + offset), length).Value();
+            signature.strong[i] = Hash_XXH64(contents + offset, length);
+        }
+        return signature;
+    }
+
+    std::string ComputeDelta(const DeltaSignature& signature, const char* contents, Filesize_t size, bool inPlace) {
+        Delta_Encoder encoder;
+        encoder.out.assign(DELTA_MAGIC, sizeof(DELTA_MAGIC));
+        Delta_PutVarint(encoder.out, inPlace ? DELTA_IN_PLACE : 0);
+        Delta_PutVarint(encoder.out, signature.size);
+        Delta_PutVarint(encoder.out, std::max<uint32_t>(signature.blockSize, 1));
+        Delta_PutVarint(encoder.out, size);
+
+        const Filesize_t blockSize = signature.blockSize;
+        const size_t blockCount = signature.weak.size();
+        // A short last block cannot be found by the rolling checksum, whose window is one block: it is only
+        // looked for at the end of the new version.
+        const Filesize_t tailSize = blockSize ? signature.size % blockSize : 0;
+        const size_t fullBlocks = tailSize ? blockCount - 1 : blockCount;
+        const auto bytes = reinterpret_cast<const unsigned char*>(contents);
+
+        Filesize_t literalStart = 0;
+        if (fullBlocks && size >= blockSize) {
+            const Delta_Index index(signature, fullBlocks);
+            Filesize_t position = 0;
+            Delta_Weak weak(bytes, static_cast<size_t>(blockSize));
+            for (;;) {
+                const uint32_t value = weak.Value();
+                const uint32_t bucket = index.Bucket(value);
+                uint64_t found = UINT64_MAX;
+                uint64_t strong = 0;
+                bool hashed = false;
+                for (uint32_t k = index.starts[bucket]; k < index.starts[bucket + 1]; ++k) {
+                    const uint32_t block = index.blocks[k];
+                    if (signature.weak[block] != value || (inPlace && block * blockSize < position)) {
+                        continue;
+                    }
+                    if (!hashed) {
+                        strong = Hash_XXH64(contents + position, static_cast<size_t>(blockSize));
+                        hashed = true;
+                    }
+                    if (signature.strong[block] != strong) {
+                        continue;
+                    }
+                    // Preferred: a block left where it is (nothing to write in place), or continuing the run of blocks.
+                    if (inPlace ? block * blockSize == position : encoder.Continues(block)) {
+                        found = block;
+                        break;
+                    }
+                    found = std::min<uint64_t>(found, block);
+                }
+
+                if (found != UINT64_MAX) {
+                    encoder.Literal(contents + literalStart, position - literalStart);
+                    encoder.Block(found);
+                    position += blockSize;
+                    literalStart = position;
+                    if (position + blockSize > size) {
+                        break;
+                    }
+                    weak = Delta_Weak(bytes + position, static_cast<size_t>(blockSize));
+                } else {
+                    if (position + blockSize >= size) {
+                        break;
+                    }
+                    weak.Roll(bytes[position], bytes[position + blockSize], static_cast<uint32_t>(blockSize));
+                    ++position;
+                }
+            }
+        }
+
+        if (tailSize && size - literalStart >= tailSize) {
+            const Filesize_t position = size - tailSize;
+            const size_t tail = blockCount - 1;
+            if ((!inPlace || tail * blockSize >= position)
+                    && signature.weak[tail] == Delta_Weak(bytes + position, static_cast<size_t>(tailSize)).Value()
+                    && signature.strong[tail] == Hash_XXH64(contents + position, static_cast<size_t>(tailSize))) {
+                encoder.Literal(contents + literalStart, position - literalStart);
+                encoder.Block(tail);
+                literalStart = size;
+            }
+        }
+        encoder.Literal(contents + literalStart, size - literalStart);
+        encoder.FlushRun();
+        Delta_Seal(encoder.out);
+        return encoder.out;
+    }
+
+    bool ApplyDelta(const char* basis, Filesize_t basisSize, const char* delta, size_t deltaSize, Filename_t output) {
+        Delta_Parsed parsed;
+        if (!Delta_Parse(delta, deltaSize, parsed) || parsed.basisSize != basisSize) {
+            return false;
+        }
+        WriterOptions options;
+        options.expectedSize = parsed.newSize;
+        Writer writer(output, options);
+        for (const Delta_Parsed::Operation& operation : parsed.operations) {
+            if (!writer.Write((operation.copy ? basis : delta) + operation.offset, operation.length)) {
+                break;
+            }
+        }
+        return writer.Commit();
+    }
+
+    bool ApplyDeltaInPlace(Filename_t filename, const char* delta, size_t deltaSize, Filesize_t* written) {
+        if (written) {
+            *written = 0;
+        }
+        Delta_Parsed parsed;
+        if (!Delta_Parse(delta, deltaSize, parsed) || !(parsed.flags & DELTA_IN_PLACE)) {
+            return false;
+        }
+        Filesize_t size = 0;
+        OSPatchFile_t* file = OS_OpenPatchFile(filename, size);
+        if (!file) {
+            return false;
+        }
+        if (size != parsed.basisSize) {
+            OS_ClosePatchFile(file, size, false);
+            return false;
+        }
+
+        bool success = true;
+        Filesize_t target = 0;
+        Filesize_t writtenBytes = 0;
+        std::unique_ptr<char[]> buffer;
+        for (const Delta_Parsed::Operation& operation : parsed.operations) {
+            if (!operation.copy) {
+                success = OS_WritePatchFile(file, target, delta + operation.offset, static_cast<size_t>(operation.length));
+                writtenBytes += operation.length;
+            } else if (operation.offset != target) {
+                // The block moves towards the start: each step reads only bytes after those it writes.
+                if (!buffer) {
+                    buffer.reset(new char[DELTA_COPY_BUFFER_SIZE]);
+                }
+                const Filesize_t step = std::min<Filesize_t>(operation.offset - target, DELTA_COPY_BUFFER_SIZE);
+                for (Filesize_t done = 0; success && done < operation.length; done += step) {
+                    const auto length = static_cast<size_t>(std::min(step, operation.length - done));
+                    success = OS_ReadPatchFile(file, operation.offset + done, buffer.get(), length)
+                            && OS_WritePatchFile(file, target + done, buffer.get(), length);
+                }
+                writtenBytes += operation.length;
+            }
+            if (!success) {
+                break;
+            }
+            target += operation.length;
+        }
+        success = OS_ClosePatchFile(file, parsed.newSize, success) && success;
+        if (written) {
+            *written = writtenBytes;
+        }
+        return success;
+    }
+}
@@ -0,0 +1,298 @@
+//
+// File module: search of files with identical contents.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <unordered_map>
+#include "MF/FileDuplicates.hpp"
+#include "MF/FileOpen.hpp"
+#include "HashHelper.hpp"
+#include "ParallelHelper.hpp"
+#include "TreeHelper.hpp"
+
+namespace {
+    /// A distinct file (one inode), with all the names leading to it.
+    struct Duplicates_Candidate {
+        std::vector<const File::SFilename_t*> names; // The first one is read.
+        uint64_t hash = 0; // Of the last stage.
+        bool failed = false;
+        bool different = false; // From the first candidate of the set, once compared.
+    };
+
+    /// Candidates which may all have the same contents.
+    struct Duplicates_Set {
+        File::Filesize_t size = 0;
+        std::vector<Duplicates_Candidate> candidates;
+    };
+
+    /// Hashes a candidate for a stage. Returns false if the file could not be read, or changed since it was listed.
+    using Duplicates_Hasher = bool (*)(const File::SFilename_t& name, File::Filesize_t size, uint64_t& hash);
+
+    bool Duplicates_SampleHash(const File::SFilename_t& name, File::Filesize_t size, uint64_t& hash) {
+        // Only the pages at both ends of a mapping are touched, so the rest of the file is never read.
+        const bool whole = size <= 2 * File::DUPLICATES_SAMPLE_SIZE;
+        const File::ReadFileData* content = File::Read(name.c_str(),
+                whole ? File::ReadStrategy::READ : File::ReadStrategy::MMAP, File::AccessPattern::RANDOM);
+        if (!content) {
+            return false;
+        }
+        const bool success = content->size == size;
+        if (success && whole) {
+            hash = Hash_XXH64(content->contents, size);
+        } else if (success) {
+            hash = Hash_XXH64(content->contents, File::DUPLICATES_SAMPLE_SIZE);
+            hash = Hash_XXH64(content->contents + size - File::DUPLICATES_SAMPLE_SIZE, File::DUPLICATES_SAMPLE_SIZE, hash);
+        }
+        File::Read_Close(content);
+        return success;
+    }
+
+    bool Duplicates_FullHash(const File::SFilename_t& name, File::Filesize_t size, uint64_t& hash) {
+        const File::ReadFileData* content = File::Read(name.c_str());
+        if (!content) {
+            return false;
+        }
+        const bool success = content->size == size;
+        if (success) {
+            hash = Hash_XXH64(content->contents, size);
+        }
+        File::Read_Close(content);
+        return success;
+    }
+
+    /**
+     * Hashes every candidate of the sets in parallel, then splits each set by hash.
+     * Only the parts with at least two candidates are kept.
+     * @return Number of candidates hashed.
+     */
+    size_t Duplicates_Refine(std::vector<Duplicates_Set>& sets, Duplicates_Hasher hasher, unsigned int threads,
+                             size_t& failures) {
+        std::vector<std::pair<Duplicates_Set*, Duplicates_Candidate*>> jobs;
+        for (Duplicates_Set& set : sets) {
+            for (Duplicates_Candidate& candidate : set.candidates) {
+                jobs.emplace_back(&set, &candidate);
+            }
+        }
+        std::atomic<size_t> failed(0);
+        Parallel_For(jobs.size(), threads, [&jobs, hasher, &failed](size_t index) {
+            Duplicates_Candidate& candidate = *jobs[index].second;
+            candidate.failed = !hasher(*candidate.names.front(), jobs[index].first->size, candidate.hash);
+            failed += candidate.failed;
+        });
+        failures += failed;
+
+        std::vector<Duplicates_Set> refined;
+        for (Duplicates_Set& set : sets) {
+            std::vector<Duplicates_Candidate>& candidates = set.candidates;
+            candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                            [](const Duplicates_Candidate& candidate) { return candidate.failed; }),
+                             candidates.end());
+            std::sort(candidates.begin(), candidates.end(), [](const Duplicates_Candidate& a, const Duplicates_Candidate& b) {
+                return a.hash < b.hash;
+            });
+            for (size_t first = 0, last; first < candidates.size(); first = last) {
+                for (last = first + 1; last < candidates.size() && candidates[last].hash == candidates[first].hash; ++last) {}
+                if (last - first >= 2) {
+                    Duplicates_Set part;
+                    part.size = set.size;
+                    part.candidates.assign(std::make_move_iterator(candidates.begin() + first),
+                                           std::make_move_iterator(candidates.begin() + last));
+                    refined.push_back(std::move(part));
+                }
+            }
+        }
+        sets.swap(refined);
+        return jobs.size();
+    }
+
+    /**
+     * Compares every candidate of a set with the first one, byte by byte, the first one being read once.
+     * Sets "failed" on the candidates which could not be read (all of them if the first one could not),
+     * and "different" on the others.
+     * @return Number of candidates compared.
+     */
+    size_t Duplicates_CompareSet(Duplicates_Set& set) {
+        const File::ReadFileData* reference = File::Read(set.candidates.front().names.front()->c_str());
+        if (!reference || reference->size != set.size) {
+            if (reference) {
+                File::Read_Close(reference);
+            }
+            set.candidates.front().failed = true;
+            return 0;
+        }
+        size_t compared = 0;
+        for (size_t i = 1; i < set.candidates.size(); ++i) {
+            Duplicates_Candidate& candidate = set.candidates[i];
+            const File::ReadFileData* content = File::Read(candidate.names.front()->c_str());
+            candidate.failed = !content || content->size != set.size;
+            if (!candidate.failed) {
+                candidate.different = std::memcmp(reference->contents, content->contents, static_cast<size_t>(set.size)) != 0;
+                ++compared;
+            }
+            if (content) {
+                File::Read_Close(content);
+            }
+        }
+        File::Read_Close(reference);
+        return compared;
+    }
+
+    /**
+     * Compares the candidates of each set with the first one, one set per job, so that equal hashes never make a group
+     * alone. The candidates which differ (a hash collision) are compared again among themselves, as are the others of
+     * a set whose first candidate could not be read.
+     * @return Number of candidates compared.
+     */
+    size_t Duplicates_Confirm(std::vector<Duplicates_Set>& sets, unsigned int threads, size_t& failures) {
+        std::atomic<size_t> compared(0);
+        std::vector<Duplicates_Set> confirmed;
+        while (!sets.empty()) {
+            Parallel_For(sets.size(), threads, [&sets, &compared](size_t index) {
+                compared += Duplicates_CompareSet(sets[index]);
+            });
+
+            std::vector<Duplicates_Set> left;
+            for (Duplicates_Set& set : sets) {
+                Duplicates_Set same, different;
+                same.size = different.size = set.size;
+                if (set.candidates.front().failed) {
+                    ++failures;
+                    different.candidates.assign(std::make_move_iterator(set.candidates.begin() + 1),
+                                                std::make_move_iterator(set.candidates.end()));
+                } else {
+                    same.candidates.push_back(std::move(set.candidates.front()));
+                    for (size_t i = 1; i < set.candidates.size(); ++i) {
+                        Duplicates_Candidate& candidate = set.candidates[i];
+                        if (candidate.failed) {
+                            ++failures;
+                        } else {
+                            (candidate.different ? different : same).candidates.push_back(std::move(candidate));
+                        }
+                    }
+                }
+                if (same.candidates.size() >= 2) {
+                    confirmed.push_back(std::move(same));
+                }
+                if (different.candidates.size() >= 2) {
+                    left.push_back(std::move(different));
+                }
+            }
+            sets.swap(left);
+        }
+        sets.swap(confirmed);
+        return compared;
+    }
+}
+
+namespace File {
+    DuplicatesResult FindDuplicates(const std::vector<SFilename_t>& roots, const DuplicatesOptions& options) {
+        DuplicatesResult result;
+        const unsigned int threads = Parallel_ThreadCount(options.threads);
+
+        // Listing: the directories are walked in order by the calling thread.
+        std::vector<SFilename_t> files;
+        std::vector<SFilename_t> directories;
+        for (const SFilename_t& root : roots) {
+            if (IsDir(root.c_str())) {
+                directories.push_back(Tree_AsDirectory(root.c_str()));
+            } else {
+                files.push_back(root);
+            }
+        }
+        std::vector<Tree_Entry> entries;
+        for (size_t i = 0; i < directories.size(); ++i) {
+            const SFilename_t directory = directories[i];
+            entries.clear();
+            if (!Tree_ListDirectory(directory.c_str(), entries)) {
+                ++result.failures;
+                continue;
+            }
+            for (const Tree_Entry& entry : entries) {
+                if (entry.type == Tree_EntryType::FILE) {
+                    files.push_back(directory + entry.name);
+                } else if (entry.type == Tree_EntryType::DIRECTORY) {
+                    directories.push_back(directory + entry.name + FILE_SEPARATOR);
+                }
+            }
+        }
+        result.files = files.size();
+
+        // First stage: sizes and inodes, from one stat per file.
+        std::vector<FileIdentity> identities(files.size());
+        std::vector<char> known(files.size());
+        Parallel_For(files.size(), threads, [&files, &identities, &known](size_t index) {
+            known[index] = Identity(files[index].c_str(), identities[index]);
+        });
+        const Filesize_t minimumSize = std::max<Filesize_t>(options.minimumSize, 1);
+        std::unordered_map<Filesize_t, std::vector<size_t>> bySize;
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (!known[i]) {
+                ++result.failures;
+            } else if (identities[i].size >= minimumSize) {
+                bySize[identities[i].size].push_back(i);
+            }
+        }
+
+        std::vector<Duplicates_Set> sets;
+        for (auto& sameSize : bySize) {
+            std::vector<size_t>& indexes = sameSize.second;
+            if (indexes.size() < 2) {
+                continue;
+            }
+            // Hard links are one candidate: reading them twice would be a waste, and they free nothing.
+            std::sort(indexes.begin(), indexes.end(), [&identities](size_t a, size_t b) {
+                return identities[a].device != identities[b].device ? identities[a].device < identities[b].device
+                        : identities[a].inode < identities[b].inode;
+            });
+            Duplicates_Set set;
+            set.size = sameSize.first;
+            for (size_t i = 0; i < indexes.size(); ++i) {
+                const FileIdentity& identity = identities[indexes[i]];
+                if (!i || identity.device != identities[indexes[i - 1]].device || identity.inode != identities[indexes[i - 1]].inode) {
+                    set.candidates.emplace_back();
+                }
+                set.candidates.back().names.push_back(&files[indexes[i]]);
+            }
+            if (set.candidates.size() >= 2) {
+                sets.push_back(std::move(set));
+            }
+        }
+
+        // Second stage: both ends of the files. Small files are entirely hashed there, so they are done.
+        result.sampled = Duplicates_Refine(sets, Duplicates_SampleHash, threads, result.failures);
+        std::vector<Duplicates_Set> finished;
+        std::vector<Duplicates_Set> big;
+        for (Duplicates_Set& set : sets) {
+            (set.size <= 2 * DUPLICATES_SAMPLE_SIZE ? finished : big).push_back(std::move(set));
+        }
+
+        // Third stage: whole contents.
+        result.fullyHashed = Duplicates_Refine(big, Duplicates_FullHash, threads, result.failures);
+        finished.insert(finished.end(), std::make_move_iterator(big.begin()), std::make_move_iterator(big.end()));
+
+        // Last stage: the contents themselves.
+        result.compared = Duplicates_Confirm(finished, threads, result.failures);
+
+        for (const Duplicates_Set& set : finished) {
+            DuplicateGroup group;
+            group.size = set.size;
+            group.copies = set.candidates.size();
+            for (const Duplicates_Candidate& candidate : set.candidates) {
+                for (const SFilename_t* name : candidate.names) {
+                    group.files.push_back(*name);
+                }
+            }
+            std::sort(group.files.begin(), group.files.end());
+            result.reclaimableBytes += group.size * (group.copies - 1);
+            result.groups.push_back(std::move(group));
+        }
+        std::sort(result.groups.begin(), result.groups.end(), [](const DuplicateGroup& a, const DuplicateGroup& b) {
+            const Filesize_t reclaimableA = a.size * (a.copies - 1);
+            const Filesize_t reclaimableB = b.size * (b.copies - 1);
+            return reclaimableA != reclaimableB ? reclaimableA > reclaimableB : a.files.front() < b.files.front();
+        });
+        return result;
+    }
+}
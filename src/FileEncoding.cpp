@@ -0,0 +1,657 @@
+//
+// File module: encoding detection and UTF-16LE transcoding based on the whole contents of a file.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "MF/FileEncoding.hpp"
+#include "SimdHelper.hpp"
+
+namespace File {
+/////////////////////////////////////////////////////////////////  PRIVATE
+
+//-------------------------------------------------------------- Constants
+
+    // Number of bytes looked at to guess a BOM-less UTF-16 or UTF-32 encoding.
+    constexpr static size_t SNIFF_SAMPLE_SIZE = 64 * 1024;
+
+//------------------------------------------------------ Private functions
+
+    /// Returns the length of the well-formed UTF-8 sequence starting at "i", or 0 if it is ill-formed.
+    static inline size_t Utf8SequenceLength(const unsigned char* s, size_t i, size_t size) {
+        const unsigned char c = s[i];
+        if (c < 0x80) {
+            return 1;
+        } else if (c < 0xC2) { // Continuation byte or overlong 2-byte form.
+            return 0;
+        } else if (c < 0xE0) {
+            return (i + 1 < size && (s[i + 1] & 0xC0) == 0x80) ? 2 : 0;
+        } else if (c < 0xF0) {
+            if (i + 2 >= size) return 0;
+            const unsigned char b1 = s[i + 1];
+            if ((b1 & 0xC0) != 0x80 || (s[i + 2] & 0xC0) != 0x80) return 0;
+            if (c == 0xE0 && b1 < 0xA0) return 0; // Overlong
+            if (c == 0xED && b1 >= 0xA0) return 0; // Surrogate
+            return 3;
+        } else if (c < 0xF5) {
+            if (i + 3 >= size) return 0;
+            const unsigned char b1 = s[i + 1];
+            if ((b1 & 0xC0) != 0x80 || (s[i + 2] & 0xC0) != 0x80 || (s[i + 3] & 0xC0) != 0x80) return 0;
+            if (c == 0xF0 && b1 < 0x90) return 0; // Overlong
+            if (c == 0xF4 && b1 >= 0x90) return 0; // Above U+10FFFF
+            return 4;
+        } else {
+            return 0;
+        }
+    }
+
+    static size_t ValidateUTF8_Scalar(const unsigned char* s, size_t i, size_t size) {
+        while (i < size) {
+            // Skip 8 ASCII bytes at once.
+            if (i + 8 <= size) {
+                uint64_t block;
+                std::memcpy(&block, s + i, sizeof(block));
+                if (!(block & 0x8080808080808080ull)) {
+                    i += 8;
+                    continue;
+                }
+            }
+            const size_t length = Utf8SequenceLength(s, i, size);
+            if (!length) {
+                return i;
+            }
+            i += length;
+        }
+        return size;
+    }
+
+#if defined(MF_SIMD_X86)
+    static size_t ValidateUTF8_SSE2(const unsigned char* s, size_t size) {
+        size_t i = 0;
+        while (i + 16 <= size) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+            if (!_mm_movemask_epi8(block)) {
+                i += 16;
+                continue;
+            }
+            // Validate sequence by sequence until we go past the non-ASCII block.
+            const size_t blockEnd = i + 16;
+            while (i < blockEnd) {
+                const size_t length = Utf8SequenceLength(s, i, size);
+                if (!length) {
+                    return i;
+                }
+                i += length;
+            }
+        }
+        return ValidateUTF8_Scalar(s, i, size);
+    }
+
+    /*
+     * Lookup-table validation from "Validating UTF-8 In Less Than One Instruction Per Byte" (Keiser, Lemire).
+     * Each pair of consecutive bytes is classified with three 16-entry tables (high nibble of the previous byte,
+     * low nibble of the previous byte, high nibble of the current byte); the AND of the three is non-zero
+     * for every invalid pair. Lengths of 3 and 4-byte sequences are checked by looking 2 and 3 bytes back.
+     */
+    constexpr uint8_t TOO_SHORT = 1 << 0;
+    constexpr uint8_t TOO_LONG = 1 << 1;
+    constexpr uint8_t OVERLONG_3 = 1 << 2;
+    constexpr uint8_t TOO_LARGE = 1 << 3;
+    constexpr uint8_t SURROGATE = 1 << 4;
+    constexpr uint8_t OVERLONG_2 = 1 << 5;
+    constexpr uint8_t TOO_LARGE_1000 = 1 << 6;
+    constexpr uint8_t OVERLONG_4 = 1 << 6;
+    constexpr uint8_t TWO_CONTS = 1 << 7;
+    constexpr uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+    alignas(16) static const uint8_t BYTE_1_HIGH[16] = {
+            TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+            TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+            TOO_SHORT | OVERLONG_2,
+            TOO_SHORT,
+            TOO_SHORT | OVERLONG_3 | SURROGATE,
+            TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4
+    };
+    alignas(16) static const uint8_t BYTE_1_LOW[16] = {
+            CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+            CARRY | OVERLONG_2,
+            CARRY, CARRY,
+            CARRY | TOO_LARGE,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+            CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000
+    };
+    alignas(16) static const uint8_t BYTE_2_HIGH[16] = {
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+    };
+    // A lead byte in the last 3 positions of a block needs bytes from the next block.
+    alignas(32) static const uint8_t INCOMPLETE_MAX[32] = {
+            255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+            255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+            0xF0 - 1, 0xE0 - 1, 0xC0 - 1
+    };
+
+    MF_TARGET_AVX2 static inline __m256i HighNibbles_AVX2(__m256i v) {
+        return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+    }
+
+    MF_TARGET_AVX2 static inline __m256i CheckBlock_AVX2(__m256i input, __m256i previousInput,
+                                                          __m256i tableHigh1, __m256i tableLow1, __m256i tableHigh2) {
+        const __m256i shiftedPrevious = _mm256_permute2x128_si256(previousInput, input, 0x21);
+        const __m256i prev1 = _mm256_alignr_epi8(input, shiftedPrevious, 16 - 1);
+        const __m256i prev2 = _mm256_alignr_epi8(input, shiftedPrevious, 16 - 2);
+        const __m256i prev3 = _mm256_alignr_epi8(input, shiftedPrevious, 16 - 3);
+
+        const __m256i specialCases = _mm256_and_si256(
+                _mm256_and_si256(
+                        _mm256_shuffle_epi8(tableHigh1, HighNibbles_AVX2(prev1)),
+                        _mm256_shuffle_epi8(tableLow1, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)))),
+                _mm256_shuffle_epi8(tableHigh2, HighNibbles_AVX2(input)));
+
+        const __m256i isThirdByte = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+        const __m256i isFourthByte = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+        const __m256i mustBeContinuation = _mm256_and_si256(
+                _mm256_or_si256(isThirdByte, isFourthByte), _mm256_set1_epi8(static_cast<char>(0x80)));
+        return _mm256_xor_si256(mustBeContinuation, specialCases);
+    }
+
+    /// First offset from where the scalar validator can restart, given that everything before "i" has been validated.
+    static inline size_t RestartOffset(const unsigned char* s, size_t i) {
+        size_t p = i >= 3 ? i - 3 : 0;
+        while (p < i && (s[p] & 0xC0) == 0x80) {
+            ++p;
+        }
+        return p;
+    }
+
+    /// Checks one block of 32 bytes, and updates the state kept from one block to the next. Returns false on error.
+    MF_TARGET_AVX2 static inline bool Step_AVX2(__m256i input, __m256i& previousInput, __m256i& previousIncomplete,
+                                                 __m256i tableHigh1, __m256i tableLow1, __m256i tableHigh2,
+                                                 __m256i incompleteMax) {
+        __m256i error;
+        if (!_mm256_movemask_epi8(input)) {
+            error = previousIncomplete;
+            previousIncomplete = _mm256_setzero_si256();
+        } else {
+            error = CheckBlock_AVX2(input, previousInput, tableHigh1, tableLow1, tableHigh2);
+            previousIncomplete = _mm256_subs_epu8(input, incompleteMax);
+        }
+        previousInput = input;
+        return _mm256_testz_si256(error, error);
+    }
+
+    MF_TARGET_AVX2 static size_t ValidateUTF8_AVX2(const unsigned char* s, size_t size) {
+        const __m256i tableHigh1 = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(BYTE_1_HIGH)));
+        const __m256i tableLow1 = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(BYTE_1_LOW)));
+        const __m256i tableHigh2 = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(BYTE_2_HIGH)));
+        const __m256i incompleteMax = _mm256_load_si256(reinterpret_cast<const __m256i*>(INCOMPLETE_MAX));
+
+        __m256i previousInput = _mm256_setzero_si256();
+        __m256i previousIncomplete = _mm256_setzero_si256();
+        size_t i = 0;
+
+        for (; i + 32 <= size; i += 32) {
+            if (!Step_AVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i)), previousInput, previousIncomplete,
+                           tableHigh1, tableLow1, tableHigh2, incompleteMax)) {
+                return ValidateUTF8_Scalar(s, RestartOffset(s, i), size);
+            }
+        }
+
+        // The tail is padded with zeros: a truncated sequence is then followed by ASCII and reported.
+        alignas(32) unsigned char tail[32] = {0};
+        std::memcpy(tail, s + i, size - i);
+        if (!Step_AVX2(_mm256_load_si256(reinterpret_cast<const __m256i*>(tail)), previousInput, previousIncomplete,
+                       tableHigh1, tableLow1, tableHigh2, incompleteMax)) {
+            return ValidateUTF8_Scalar(s, RestartOffset(s, i), size);
+        }
+        return size;
+    }
+#endif
+
+    static size_t ValidateUTF16(const unsigned char* s, size_t i, size_t size, bool bigEndian) {
+        const int high = bigEndian ? 0 : 1;
+        const int low = 1 - high;
+        for (; i + 2 <= size; i += 2) {
+            const unsigned int unit = (s[i + high] << 8) | s[i + low];
+            if (unit < 0xD800 || unit > 0xDFFF) {
+                continue;
+            } else if (unit > 0xDBFF || i + 4 > size) { // Lone low surrogate, or truncated pair.
+                return i;
+            }
+            const unsigned int next = (s[i + 2 + high] << 8) | s[i + 2 + low];
+            if (next < 0xDC00 || next > 0xDFFF) {
+                return i;
+            }
+            i += 2;
+        }
+        return i; // Equal to "size" unless there is a trailing odd byte.
+    }
+
+    static size_t ValidateUTF32(const unsigned char* s, size_t i, size_t size, bool bigEndian) {
+        for (; i + 4 <= size; i += 4) {
+            const uint32_t codePoint = bigEndian ?
+                    (uint32_t(s[i]) << 24) | (uint32_t(s[i + 1]) << 16) | (uint32_t(s[i + 2]) << 8) | s[i + 3] :
+                    (uint32_t(s[i + 3]) << 24) | (uint32_t(s[i + 2]) << 16) | (uint32_t(s[i + 1]) << 8) | s[i];
+            if (codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+                return i;
+            }
+        }
+        return i;
+    }
+
+    /// Recognises a Byte Order Mark. Returns its length, 0 if there is none.
+    static unsigned int DetectBOM(const unsigned char* s, size_t size, encoding_t& encoding) {
+        // UTF-32LE must be checked before UTF-16LE, they share the first two bytes.
+        if (size >= 4 && s[0] == 0xFF && s[1] == 0xFE && s[2] == 0x00 && s[3] == 0x00) {
+            encoding = encoding_t::ENC_UTF32LE;
+            return 4;
+        } else if (size >= 4 && s[0] == 0x00 && s[1] == 0x00 && s[2] == 0xFE && s[3] == 0xFF) {
+            encoding = encoding_t::ENC_UTF32BE;
+            return 4;
+        } else if (size >= 3 && s[0] == 0xEF && s[1] == 0xBB && s[2] == 0xBF) {
+            encoding = encoding_t::ENC_UTF8;
+            return 3;
+        } else if (size >= 2 && s[0] == 0xFF && s[1] == 0xFE) {
+            encoding = encoding_t::ENC_UTF16LE;
+            return 2;
+        } else if (size >= 2 && s[0] == 0xFE && s[1] == 0xFF) {
+            encoding = encoding_t::ENC_UTF16BE;
+            return 2;
+        }
+        return 0;
+    }
+
+    /**
+     * Guesses a BOM-less UTF-16 or UTF-32 encoding from where the null bytes are.
+     * Text in these encodings has its high-order bytes almost always null, while UTF-8 text has no null bytes.
+     * Returns ENC_DEFAULT if the sample does not look like UTF-16 nor UTF-32.
+     */
+    static encoding_t GuessWideEncoding(const unsigned char* s, size_t size) {
+        const size_t sampleSize = std::min(size, SNIFF_SAMPLE_SIZE) & ~size_t(3);
+        if (!sampleSize || !std::memchr(s, 0, sampleSize)) {
+            return encoding_t::ENC_DEFAULT;
+        }
+
+        size_t zeros[4] = {0, 0, 0, 0};
+        for (size_t i = 0; i < sampleSize; i += 4) {
+            zeros[0] += !s[i];
+            zeros[1] += !s[i + 1];
+            zeros[2] += !s[i + 2];
+            zeros[3] += !s[i + 3];
+        }
+
+        const size_t units = sampleSize / 4;
+        if (size % 4 == 0) {
+            if (zeros[3] == units && zeros[2] * 2 >= units && zeros[0] < units) {
+                return encoding_t::ENC_UTF32LE;
+            } else if (zeros[0] == units && zeros[1] * 2 >= units && zeros[3] < units) {
+                return encoding_t::ENC_UTF32BE;
+            }
+        }
+
+        const size_t zerosEven = zeros[0] + zeros[2], zerosOdd = zeros[1] + zeros[3];
+        const size_t halfSample = sampleSize / 2;
+        if (zerosOdd > 2 * zerosEven && zerosOdd * 4 >= halfSample) {
+            return encoding_t::ENC_UTF16LE;
+        } else if (zerosEven > 2 * zerosOdd && zerosEven * 4 >= halfSample) {
+            return encoding_t::ENC_UTF16BE;
+        }
+        return encoding_t::ENC_DEFAULT;
+    }
+
+    static size_t ValidateAs(encoding_t encoding, const unsigned char* s, size_t begin, size_t size) {
+        switch (encoding) {
+            case encoding_t::ENC_UTF16LE:
+                return ValidateUTF16(s, begin, size, false);
+            case encoding_t::ENC_UTF16BE:
+                return ValidateUTF16(s, begin, size, true);
+            case encoding_t::ENC_UTF32LE:
+                return ValidateUTF32(s, begin, size, false);
+            case encoding_t::ENC_UTF32BE:
+                return ValidateUTF32(s, begin, size, true);
+            default:
+                return begin + ValidateUTF8(reinterpret_cast<const char*>(s + begin), size - begin);
+        }
+    }
+
+    /**
+     * Reads the character starting at "i" in UTF-16LE.
+     * @return Its length in bytes (2 or 4), or 0 with "status" set if it is invalid or truncated.
+     */
+    static inline size_t ReadUTF16LE(const unsigned char* s, size_t i, size_t size, char32_t& codePoint,
+                                     TranscodeStatus& status) {
+        if (i + 2 > size) {
+            status = TranscodeStatus::TRUNCATED;
+            return 0;
+        }
+        const char32_t unit = s[i] | (s[i + 1] << 8);
+        if (unit < 0xD800 || unit > 0xDFFF) {
+            codePoint = unit;
+            return 2;
+        } else if (unit > 0xDBFF) {
+            status = TranscodeStatus::INVALID;
+            return 0;
+        } else if (i + 4 > size) {
+            status = TranscodeStatus::TRUNCATED;
+            return 0;
+        }
+        const char32_t next = s[i + 2] | (s[i + 3] << 8);
+        if (next < 0xDC00 || next > 0xDFFF) {
+            status = TranscodeStatus::INVALID;
+            return 0;
+        }
+        codePoint = 0x10000 + ((unit - 0xD800) << 10) + (next - 0xDC00);
+        return 4;
+    }
+
+    /// Writes one code point in UTF-8. Returns the number of bytes written, 0 if it does not fit.
+    static inline size_t WriteUTF8(char32_t codePoint, unsigned char* d, size_t available) {
+        if (codePoint < 0x80) {
+            if (available < 1) return 0;
+            d[0] = static_cast<unsigned char>(codePoint);
+            return 1;
+        } else if (codePoint < 0x800) {
+            if (available < 2) return 0;
+            d[0] = static_cast<unsigned char>(0xC0 | (codePoint >> 6));
+            d[1] = static_cast<unsigned char>(0x80 | (codePoint & 0x3F));
+            return 2;
+        } else if (codePoint < 0x10000) {
+            if (available < 3) return 0;
+            d[0] = static_cast<unsigned char>(0xE0 | (codePoint >> 12));
+            d[1] = static_cast<unsigned char>(0x80 | ((codePoint >> 6) & 0x3F));
+            d[2] = static_cast<unsigned char>(0x80 | (codePoint & 0x3F));
+            return 3;
+        } else {
+            if (available < 4) return 0;
+            d[0] = static_cast<unsigned char>(0xF0 | (codePoint >> 18));
+            d[1] = static_cast<unsigned char>(0x80 | ((codePoint >> 12) & 0x3F));
+            d[2] = static_cast<unsigned char>(0x80 | ((codePoint >> 6) & 0x3F));
+            d[3] = static_cast<unsigned char>(0x80 | (codePoint & 0x3F));
+            return 4;
+        }
+    }
+
+    /// Transcodes one character. Returns false (and sets "result.status") if the conversion has to stop.
+    static inline bool StepUTF16LEToUTF8(const unsigned char* s, size_t size, unsigned char* d, size_t dSize,
+                                         TranscodeResult& result) {
+        char32_t codePoint = 0;
+        const size_t length = ReadUTF16LE(s, result.read, size, codePoint, result.status);
+        if (!length) {
+            return false;
+        }
+        const size_t written = WriteUTF8(codePoint, d + result.written, dSize - result.written);
+        if (!written) {
+            result.status = TranscodeStatus::DESTINATION_FULL;
+            return false;
+        }
+        result.read += length;
+        result.written += written;
+        return true;
+    }
+
+    static TranscodeResult UTF16LEToUTF8_Generic(const unsigned char* s, size_t size, unsigned char* d, size_t dSize) {
+        TranscodeResult result;
+        while (result.read < size) {
+#if defined(MF_SIMD_X86)
+            // 8 ASCII code units at once.
+            const __m128i asciiMask = _mm_set1_epi16(static_cast<short>(0xFF80));
+            while (result.read + 16 <= size && result.written + 8 <= dSize) {
+                const __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + result.read));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, asciiMask), _mm_setzero_si128())) != 0xFFFF) {
+                    break;
+                }
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(d + result.written), _mm_packus_epi16(units, units));
+                result.read += 16;
+                result.written += 8;
+            }
+            if (result.read >= size) {
+                break;
+            }
+#endif
+            if (!StepUTF16LEToUTF8(s, size, d, dSize, result)) {
+                return result;
+            }
+        }
+        return result;
+    }
+
+#if defined(MF_SIMD_X86)
+    MF_TARGET_AVX2 static TranscodeResult UTF16LEToUTF8_AVX2(const unsigned char* s, size_t size,
+                                                              unsigned char* d, size_t dSize) {
+        TranscodeResult result;
+        const __m256i asciiMask = _mm256_set1_epi16(static_cast<short>(0xFF80));
+        while (result.read < size) {
+            // 16 ASCII code units at once.
+            while (result.read + 32 <= size && result.written + 16 <= dSize) {
+                const __m256i units = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + result.read));
+                if (!_mm256_testz_si256(units, asciiMask)) {
+                    break;
+                }
+                // "packus" works per 128-bit lane, the permutation puts both halves together.
+                const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(units, units), 0xD8);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(d + result.written), _mm256_castsi256_si128(packed));
+                result.read += 32;
+                result.written += 16;
+            }
+            if (result.read >= size) {
+                break;
+            }
+            if (!StepUTF16LEToUTF8(s, size, d, dSize, result)) {
+                return result;
+            }
+        }
+        return result;
+    }
+#endif
+
+//////////////////////////////////////////////////////////////////  PUBLIC
+//------------------------------------------------------- Public functions
+
+    Filesize_t ValidateUTF8(const char* contents, Filesize_t size) {
+        const auto s = reinterpret_cast<const unsigned char*>(contents);
+#if defined(MF_SIMD_X86)
+        if (Simd_HasAVX2()) {
+            return ValidateUTF8_AVX2(s, size);
+        }
+        return ValidateUTF8_SSE2(s, size);
+#else
+        return ValidateUTF8_Scalar(s, 0, size);
+#endif
+    }
+
+    EncodingDetection DetectEncoding(const char* contents, Filesize_t size) {
+        EncodingDetection result;
+        if (!contents && size) {
+            return result;
+        }
+        const auto s = reinterpret_cast<const unsigned char*>(contents);
+
+        result.bomLength = DetectBOM(s, size, result.encoding);
+        if (!result.bomLength) {
+            result.encoding = GuessWideEncoding(s, size);
+        }
+
+        result.firstInvalid = ValidateAs(result.encoding, s, result.bomLength, size);
+        if (result.encoding == encoding_t::ENC_DEFAULT && result.firstInvalid == size) {
+            result.encoding = encoding_t::ENC_UTF8;
+        }
+        return result;
+    }
+
+    EncodingDetection DetectEncoding(const ReadFileData* content) {
+        if (!content) {
+            return EncodingDetection();
+        }
+        return DetectEncoding(content->contents, content->size);
+    }
+
+    EncodingDetection DetectEncoding(Filename_t filename) {
+        auto fileContents = File::Read(filename);
+        EncodingDetection result = DetectEncoding(fileContents);
+        if (fileContents) {
+            File::Read_Close(fileContents);
+        }
+        return result;
+    }
+
+    TranscodeResult UTF16LEToUTF8(const char* source, Filesize_t sourceSize, char* destination, Filesize_t destinationSize) {
+        const auto s = reinterpret_cast<const unsigned char*>(source);
+        const auto d = reinterpret_cast<unsigned char*>(destination);
+#if defined(MF_SIMD_X86)
+        if (Simd_HasAVX2()) {
+            return UTF16LEToUTF8_AVX2(s, sourceSize, d, destinationSize);
+        }
+#endif
+        return UTF16LEToUTF8_Generic(s, sourceSize, d, destinationSize);
+    }
+
+    TranscodeResult UTF16LEToUTF32(const char* source, Filesize_t sourceSize, char32_t* destination, Filesize_t destinationSize) {
+        const auto s = reinterpret_cast<const unsigned char*>(source);
+        TranscodeResult result;
+        while (result.read < sourceSize) {
+#if defined(MF_SIMD_X86)
+            // 8 code units without any surrogate are simply zero-extended.
+            const __m128i surrogateMask = _mm_set1_epi16(static_cast<short>(0xF800));
+            const __m128i surrogateValue = _mm_set1_epi16(static_cast<short>(0xD800));
+            while (result.read + 16 <= sourceSize && result.written + 8 <= destinationSize) {
+                const __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + result.read));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, surrogateMask), surrogateValue))) {
+                    break;
+                }
+                auto d = reinterpret_cast<__m128i*>(destination + result.written);
+                _mm_storeu_si128(d, _mm_unpacklo_epi16(units, _mm_setzero_si128()));
+                _mm_storeu_si128(d + 1, _mm_unpackhi_epi16(units, _mm_setzero_si128()));
+                result.read += 16;
+                result.written += 8;
+            }
+            if (result.read >= sourceSize) {
+                break;
+            }
+#endif
+            if (result.written >= destinationSize) {
+                result.status = TranscodeStatus::DESTINATION_FULL;
+                return result;
+            }
+            char32_t codePoint = 0;
+            const size_t length = ReadUTF16LE(s, result.read, sourceSize, codePoint, result.status);
+            if (!length) {
+                return result;
+            }
+            destination[result.written++] = codePoint;
+            result.read += length;
+        }
+        return result;
+    }
+
+    TranscodeStatus UTF16LEDecoder::Decode(const char* chunk, Filesize_t chunkSize, std::string& output) {
+        if (failed) {
+            return TranscodeStatus::INVALID;
+        }
+
+        const size_t base = output.size();
+        output.resize(base + UTF16LEToUTF8_MaxLength(pendingSize + chunkSize + 1));
+        size_t written = 0;
+        Filesize_t consumed = 0;
+
+        if (pendingSize) {
+            // Completes the character cut at the end of the previous chunk (at most 4 more bytes are needed).
+            char joined[8];
+            const unsigned int taken = static_cast<unsigned int>(std::min<Filesize_t>(chunkSize, 4));
+            std::memcpy(joined, pending, pendingSize);
+            std::memcpy(joined + pendingSize, chunk, taken);
+            const TranscodeResult result = UTF16LEToUTF8(joined, pendingSize + taken, &output[base], output.size() - base);
+            if (result.status == TranscodeStatus::INVALID) {
+                failed = true;
+                output.resize(base);
+                return TranscodeStatus::INVALID;
+            } else if (result.read < pendingSize) { // Still incomplete: the chunk was tiny.
+                std::memcpy(pending, joined, pendingSize + taken);
+                pendingSize += taken;
+                output.resize(base);
+                return TranscodeStatus::OK;
+            }
+            written = result.written;
+            consumed = result.read - pendingSize;
+            pendingSize = 0;
+        }
+
+        const TranscodeResult result = UTF16LEToUTF8(chunk + consumed, chunkSize - consumed,
+                                                     &output[base + written], output.size() - base - written);
+        written += result.written;
+        output.resize(base + written);
+        if (result.status == TranscodeStatus::INVALID) {
+            failed = true;
+            return TranscodeStatus::INVALID;
+        } else if (result.status == TranscodeStatus::TRUNCATED) {
+            pendingSize = static_cast<unsigned int>(chunkSize - consumed - result.read);
+            std::memcpy(pending, chunk + consumed + result.read, pendingSize);
+        }
+        return TranscodeStatus::OK;
+    }
+
+    TranscodeStatus UTF16LEDecoder::Finish() const {
+        if (failed) {
+            return TranscodeStatus::INVALID;
+        }
+        return pendingSize ? TranscodeStatus::TRUNCATED : TranscodeStatus::OK;
+    }
+
+    void UTF16LEDecoder::Reset() {
+        pendingSize = 0;
+        failed = false;
+    }
+
+    TranscodeStatus DecodeUTF16LEFile(Filename_t filename, const std::function<void(const char*, size_t)>& callback,
+                                      Filesize_t chunkSize) {
+        auto fileContents = File::Read(filename);
+        if (!fileContents) {
+            return TranscodeStatus::INVALID;
+        }
+
+        const char* contents = fileContents->contents;
+        const Filesize_t size = fileContents->size;
+        Filesize_t offset = (size >= 2 && contents[0] == '\xFF' && contents[1] == '\xFE') ? 2 : 0;
+        chunkSize = std::max<Filesize_t>(chunkSize & ~Filesize_t(1), 4);
+
+        std::string buffer(UTF16LEToUTF8_MaxLength(chunkSize), '\0');
+        TranscodeStatus status = TranscodeStatus::OK;
+        while (offset < size) {
+            // A chunk may end inside a surrogate pair: the conversion then stops before it, and the next chunk starts there.
+            const Filesize_t length = std::min(chunkSize, size - offset);
+            const TranscodeResult result = UTF16LEToUTF8(contents + offset, length, &buffer[0], buffer.size());
+            if (result.written) {
+                callback(buffer.data(), result.written);
+            }
+            offset += result.read;
+            if (result.status == TranscodeStatus::INVALID ||
+                (result.status == TranscodeStatus::TRUNCATED && offset + length - result.read >= size)) {
+                status = result.status;
+                break;
+            }
+        }
+
+        File::Read_Close(fileContents);
+        return status;
+    }
+
+    bool ReadUTF16LEToString(Filename_t filename, std::string& string) {
+        std::string decoded;
+        const TranscodeStatus status = DecodeUTF16LEFile(filename, [&decoded](const char* utf8, size_t length) {
+            decoded.append(utf8, length);
+        });
+        if (status != TranscodeStatus::OK) {
+            return false;
+        }
+        string.swap(decoded);
+        return true;
+    }
+}
@@ -0,0 +1,348 @@
+//
+// File module: selection of files in directory trees by glob patterns ("src/**/*.cpp").
+//
+
+#include <algorithm>
+#include "MF/FileGlob.hpp"
+#include "MF/FileStat.hpp"
+#include "ParallelHelper.hpp"
+#include "TreeHelper.hpp"
+
+namespace File {
+
+/////////////////////////////////////////////////////////////////  PRIVATE
+
+//-------------------------------------------------------------- Constants
+
+    constexpr size_t GlobPattern::MAX_COMPONENTS;
+
+//------------------------------------------------------ Private functions
+
+    static bool Glob_IsSeparator(SFilename_t::value_type character) {
+        return character == '/' || character == FILE_SEPARATOR[0];
+    }
+
+    /// Cuts a path into its names, skipping the empty ones and ".".
+    static std::vector<SFilename_t> Glob_Split(const SFilename_t& path) {
+        std::vector<SFilename_t> names;
+        size_t begin = 0;
+        while (begin <= path.size()) {
+            size_t end = begin;
+            while (end < path.size() && !Glob_IsSeparator(path[end])) {
+                ++end;
+            }
+            if (end > begin && !(end == begin + 1 && path[begin] == '.')) {
+                names.push_back(path.substr(begin, end - begin));
+            }
+            begin = end + 1;
+        }
+        return names;
+    }
+
+    static bool Glob_StartsWith(const SFilename_t& name, const SFilename_t& prefix) {
+        return name.size() >= prefix.size() && name.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    static bool Glob_EndsWith(const SFilename_t& name, const SFilename_t& suffix) {
+        return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    /// A directory of the walk, and the states of the pattern there.
+    struct Glob_Directory {
+        SFilename_t path; // Relative to the root, ending with a separator (empty for the root).
+        GlobPattern::States states;
+    };
+
+/////////////////////////////////////////////////////////////////  PUBLIC
+
+//------------------------------------------------------- Public functions
+
+    GlobPattern::GlobPattern(const SFilename_t& pattern) {
+        const std::vector<SFilename_t> names = Glob_Split(pattern);
+        directoriesOnly = !pattern.empty() && Glob_IsSeparator(pattern.back());
+        if (names.size() > MAX_COMPONENTS) {
+            valid = false;
+            return;
+        }
+        for (const SFilename_t& name : names) {
+            Component component;
+            if (name.size() == 2 && name[0] == '*' && name[1] == '*') {
+                component.kind = Component::Kind::GLOBSTAR;
+                components.push_back(std::move(component));
+                continue;
+            }
+
+            // Tokens, consecutive stars being one.
+            for (size_t i = 0; i < name.size(); ++i) {
+                Token token;
+                token.negated = false;
+                if (name[i] == '*') {
+                    token.kind = Token::Kind::STAR;
+                    if (!component.tokens.empty() && component.tokens.back().kind == Token::Kind::STAR) {
+                        continue;
+                    }
+                } else if (name[i] == '?') {
+                    token.kind = Token::Kind::ANY;
+                } else if (name[i] == '[') {
+                    token.kind = Token::Kind::SET;
+                    size_t j = i + 1;
+                    if (j < name.size() && name[j] == '!') {
+                        token.negated = true;
+                        ++j;
+                    }
+                    const size_t first = j;
+                    // A "]" right after the "[" is part of the set.
+                    while (j < name.size() && (name[j] != ']' || j == first)) {
+                        if (j + 2 < name.size() && name[j + 1] == '-' && name[j + 2] != ']') {
+                            token.ranges.emplace_back(name[j], name[j + 2]);
+                            j += 3;
+                        } else {
+                            token.ranges.emplace_back(name[j], name[j]);
+                            ++j;
+                        }
+                    }
+                    if (j >= name.size()) {
+                        valid = false;
+                        components.clear();
+                        return;
+                    }
+                    i = j;
+                } else {
+                    if (!component.tokens.empty() && component.tokens.back().kind == Token::Kind::LITERAL) {
+                        component.tokens.back().text.push_back(name[i]);
+                        continue;
+                    }
+                    token.kind = Token::Kind::LITERAL;
+                    token.text.push_back(name[i]);
+                }
+                component.tokens.push_back(std::move(token));
+            }
+
+            // Plain names, and literals around one star, are compared directly.
+            size_t stars = 0;
+            bool literalsOnly = true;
+            for (const Token& token : component.tokens) {
+                stars += token.kind == Token::Kind::STAR;
+                literalsOnly = literalsOnly && (token.kind == Token::Kind::LITERAL || token.kind == Token::Kind::STAR);
+            }
+            if (!stars && literalsOnly) {
+                component.kind = Component::Kind::EXACT;
+                component.prefix = name;
+                component.tokens.clear();
+            } else if (stars == 1 && literalsOnly) {
+                component.kind = Component::Kind::STAR;
+                bool beforeStar = true;
+                for (const Token& token : component.tokens) {
+                    if (token.kind == Token::Kind::STAR) {
+                        beforeStar = false;
+                    } else {
+                        (beforeStar ? component.prefix : component.suffix) = token.text;
+                    }
+                }
+                component.tokens.clear();
+            } else {
+                component.kind = Component::Kind::GENERAL;
+            }
+            components.push_back(std::move(component));
+        }
+    }
+
+    GlobPattern::States GlobPattern::Closure(States states) const {
+        for (size_t i = 0; i < components.size(); ++i) {
+            if (states >> i & 1 && components[i].kind == Component::Kind::GLOBSTAR) {
+                states |= States(1) << (i + 1);
+            }
+        }
+        return states;
+    }
+
+    GlobPattern::States GlobPattern::Start() const {
+        return valid ? Closure(1) : 0;
+    }
+
+    GlobPattern::States GlobPattern::Step(States states, const SFilename_t& name) const {
+        States next = 0;
+        for (size_t i = 0; i < components.size(); ++i) {
+            if (!(states >> i & 1)) {
+                continue;
+            }
+            const Component& component = components[i];
+            if (component.kind == Component::Kind::GLOBSTAR) {
+                next |= States(1) << i; // The name is one of the directories matched by "**".
+            } else if (MatchComponent(component, name)) {
+                next |= States(1) << (i + 1);
+            }
+        }
+        return Closure(next);
+    }
+
+    bool GlobPattern::Matches(const SFilename_t& path) const {
+        States states = Start();
+        for (const SFilename_t& name : Glob_Split(path)) {
+            states = Step(states, name);
+            if (!states) {
+                return false;
+            }
+        }
+        return IsMatch(states) && (!directoriesOnly || (!path.empty() && Glob_IsSeparator(path.back())));
+    }
+
+    bool GlobPattern::ExactNames(States states, std::vector<SFilename_t>& names) const {
+        names.clear();
+        for (size_t i = 0; i < components.size(); ++i) {
+            if (states >> i & 1) {
+                // ".." is in no listing, so it is not looked up either.
+                if (components[i].kind != Component::Kind::EXACT || components[i].prefix == MAKE_FILE_NAME "..") {
+                    names.clear();
+                    return false;
+                }
+                names.push_back(components[i].prefix);
+            }
+        }
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+        return true;
+    }
+
+    bool GlobPattern::MatchComponent(const Component& component, const SFilename_t& name) {
+        switch (component.kind) {
+            case Component::Kind::EXACT:
+                return name == component.prefix;
+            case Component::Kind::STAR:
+                return name.size() >= component.prefix.size() + component.suffix.size()
+                       && Glob_StartsWith(name, component.prefix) && Glob_EndsWith(name, component.suffix);
+            case Component::Kind::GLOBSTAR:
+                return true;
+            default:
+                return MatchTokens(component.tokens, name);
+        }
+    }
+
+    bool GlobPattern::MatchToken(const Token& token, const SFilename_t& name, size_t position, size_t& length) {
+        if (token.kind == Token::Kind::LITERAL) {
+            length = token.text.size();
+            return name.compare(position, length, token.text) == 0;
+        }
+        if (position >= name.size()) {
+            return false;
+        }
+        length = 1;
+        if (token.kind == Token::Kind::ANY) {
+            return true;
+        }
+        const Char character = name[position];
+        bool found = false;
+        for (const std::pair<Char, Char>& range : token.ranges) {
+            found = found || (range.first <= character && character <= range.second);
+        }
+        return found != token.negated;
+    }
+
+    bool GlobPattern::MatchTokens(const std::vector<Token>& tokens, const SFilename_t& name) {
+        // Greedy, going back to the last star on a mismatch: the star then takes one more character.
+        size_t token = 0;
+        size_t position = 0;
+        size_t starToken = tokens.size();
+        size_t starPosition = 0;
+        while (position < name.size()) {
+            size_t length = 0;
+            if (token < tokens.size() && tokens[token].kind == Token::Kind::STAR) {
+                starToken = token++;
+                starPosition = position;
+            } else if (token < tokens.size() && MatchToken(tokens[token], name, position, length)) {
+                ++token;
+                position += length;
+            } else if (starToken < tokens.size()) {
+                token = starToken + 1;
+                position = ++starPosition;
+            } else {
+                return false;
+            }
+        }
+        while (token < tokens.size() && tokens[token].kind == Token::Kind::STAR) {
+            ++token;
+        }
+        return token == tokens.size();
+    }
+
+    std::vector<SFilename_t> Glob(Filename_t root, const GlobPattern& pattern, unsigned int threads) {
+        std::vector<SFilename_t> matches;
+        if (!pattern.CanDescend(pattern.Start())) {
+            return matches;
+        }
+        threads = Parallel_ThreadCount(threads);
+        const SFilename_t prefix = Tree_AsDirectory(root);
+
+        std::vector<Glob_Directory> level(1, Glob_Directory{SFilename_t(), pattern.Start()});
+        std::vector<Glob_Directory> nextLevel;
+        std::vector<std::vector<Tree_Entry>> listings;
+        std::vector<SFilename_t> names;
+        std::vector<SFilename_t> lookups; // Paths of the expected names, in the directories not listed.
+        while (!level.empty()) {
+            // Directories where only plain names may match are not listed: the names are looked up.
+            listings.assign(level.size(), std::vector<Tree_Entry>());
+            std::vector<bool> listed(level.size(), true);
+            lookups.clear();
+            for (size_t i = 0; i < level.size(); ++i) {
+                if (pattern.ExactNames(level[i].states, names)) {
+                    listed[i] = false;
+                    for (SFilename_t& name : names) {
+                        lookups.push_back(prefix + level[i].path + name);
+                        listings[i].push_back(Tree_Entry{std::move(name), Tree_EntryType::OTHER});
+                    }
+                }
+            }
+            Parallel_For(level.size(), threads, [&level, &listed, &listings, &prefix](size_t i) {
+                if (listed[i]) {
+                    Tree_ListDirectory((prefix + level[i].path).c_str(), listings[i]);
+                }
+            });
+            if (!lookups.empty()) {
+                const StatResult result = StatMany(lookups, STAT_TYPE, threads, false);
+                size_t lookup = 0;
+                for (size_t i = 0; i < level.size(); ++i) {
+                    if (listed[i]) {
+                        continue;
+                    }
+                    std::vector<Tree_Entry>& entries = listings[i];
+                    for (Tree_Entry& entry : entries) {
+                        switch (result.types[lookup++]) {
+                            case StatType::FILE: entry.type = Tree_EntryType::FILE; break;
+                            case StatType::DIRECTORY: entry.type = Tree_EntryType::DIRECTORY; break;
+                            case StatType::SYMLINK: entry.type = Tree_EntryType::SYMLINK; break;
+                            case StatType::NONE: entry.name.clear(); break; // Dropped below.
+                            default: entry.type = Tree_EntryType::OTHER; break;
+                        }
+                    }
+                    entries.erase(std::remove_if(entries.begin(), entries.end(), [](const Tree_Entry& entry) {
+                        return entry.name.empty();
+                    }), entries.end());
+                }
+            }
+
+            nextLevel.clear();
+            for (size_t i = 0; i < level.size(); ++i) {
+                for (const Tree_Entry& entry : listings[i]) {
+                    const GlobPattern::States states = pattern.Step(level[i].states, entry.name);
+                    if (!states) {
+                        continue;
+                    }
+                    const bool directory = entry.type == Tree_EntryType::DIRECTORY;
+                    SFilename_t path = level[i].path + entry.name;
+                    if (directory) {
+                        path += FILE_SEPARATOR;
+                    }
+                    if (pattern.IsMatch(states) && (directory || !pattern.DirectoriesOnly())) {
+                        matches.push_back(path);
+                    }
+                    if (directory && pattern.CanDescend(states)) {
+                        nextLevel.push_back(Glob_Directory{std::move(path), states});
+                    }
+                }
+            }
+            level.swap(nextLevel);
+        }
+        std::sort(matches.begin(), matches.end());
+        return matches;
+    }
+}
@@ -0,0 +1,672 @@
+//
+// File module: streaming decompression of DEFLATE and zlib data.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "MF/FileInflate.hpp"
+#include "HashHelper.hpp"
+
+namespace File {
+    constexpr size_t Inflater::BUFFER_SIZE;
+
+/////////////////////////////////////////////////////////////////  PRIVATE
+
+//-------------------------------------------------------------- Constants
+
+    // Bytes of history a DEFLATE stream may refer to.
+    constexpr static size_t INFLATE_WINDOW_SIZE = 32ul << 10;
+
+    // Longest match, and the bytes a match copy may write past its end (it copies up to 16 bytes at a time).
+    constexpr static size_t INFLATE_MAX_MATCH = 258;
+    constexpr static size_t INFLATE_COPY_OVERRUN = 16;
+
+    // Bits looked up at once in the tables. Longer codes go through a sub-table.
+    constexpr static unsigned INFLATE_LITLEN_BITS = 10;
+    constexpr static unsigned INFLATE_DISTANCE_BITS = 8;
+    constexpr static unsigned INFLATE_CODELEN_BITS = 7;
+    constexpr static unsigned INFLATE_MAX_CODE_BITS = 15;
+
+    // An entry of a decoding table packs the number of bits of the code (bits 0 to 4), the kind of symbol (bits 5 to 7),
+    // the number of extra bits to read after it or of index bits of a sub-table (bits 8 to 11),
+    // and the literal, the base length or distance, or the first entry of a sub-table (bits 16 to 31).
+    enum InflateEntryKind : uint32_t {
+        ENTRY_LITERAL = 0,
+        ENTRY_LENGTH = 1,
+        ENTRY_END_OF_BLOCK = 2,
+        ENTRY_SUBTABLE = 3,
+        ENTRY_INVALID = 4
+    };
+
+    constexpr static uint32_t MakeEntry(uint32_t kind, uint32_t extraBits, uint32_t value) {
+        return kind << 5 | extraBits << 8 | value << 16;
+    }
+    static inline uint32_t EntryBits(uint32_t entry) { return entry & 31; }
+    static inline uint32_t EntryKind(uint32_t entry) { return entry >> 5 & 7; }
+    static inline uint32_t EntryExtraBits(uint32_t entry) { return entry >> 8 & 15; }
+    static inline uint32_t EntryValue(uint32_t entry) { return entry >> 16; }
+
+    constexpr static uint16_t LENGTH_BASES[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                                  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    constexpr static uint8_t LENGTH_EXTRA_BITS[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                                      3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    constexpr static uint16_t DISTANCE_BASES[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                                    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    constexpr static uint8_t DISTANCE_EXTRA_BITS[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                                        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    // Order in which the lengths of the code length code are stored in a dynamic block header.
+    constexpr static uint8_t CODELEN_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+//------------------------------------------------------ Private functions
+
+    /// Entry (without its number of bits) of each literal/length symbol.
+    static const uint32_t* LitLenSymbols() {
+        static const std::vector<uint32_t> symbols = []() {
+            std::vector<uint32_t> entries(288, MakeEntry(ENTRY_INVALID, 0, 0));
+            for (uint32_t literal = 0; literal < 256; ++literal) {
+                entries[literal] = MakeEntry(ENTRY_LITERAL, 0, literal);
+            }
+            entries[256] = MakeEntry(ENTRY_END_OF_BLOCK, 0, 0);
+            for (uint32_t length = 0; length < 29; ++length) {
+                entries[257 + length] = MakeEntry(ENTRY_LENGTH, LENGTH_EXTRA_BITS[length], LENGTH_BASES[length]);
+            }
+            return entries;
+        }();
+        return symbols.data();
+    }
+
+    /// Entry (without its number of bits) of each distance symbol.
+    static const uint32_t* DistanceSymbols() {
+        static const std::vector<uint32_t> symbols = []() {
+            std::vector<uint32_t> entries(32, MakeEntry(ENTRY_INVALID, 0, 0));
+            for (uint32_t distance = 0; distance < 30; ++distance) {
+                entries[distance] = MakeEntry(ENTRY_LENGTH, DISTANCE_EXTRA_BITS[distance], DISTANCE_BASES[distance]);
+            }
+            return entries;
+        }();
+        return symbols.data();
+    }
+
+    /// Entry (without its number of bits) of each code length symbol: the symbol itself.
+    static const uint32_t* CodeLengthSymbols() {
+        static const std::vector<uint32_t> symbols = []() {
+            std::vector<uint32_t> entries(19);
+            for (uint32_t symbol = 0; symbol < 19; ++symbol) {
+                entries[symbol] = MakeEntry(ENTRY_LITERAL, 0, symbol);
+            }
+            return entries;
+        }();
+        return symbols.data();
+    }
+
+    /// The "length" lowest bits of "code", in reverse order: DEFLATE stores Huffman codes from their highest bit.
+    static inline uint32_t ReverseBits(uint32_t code, unsigned int length) {
+        uint32_t reversed = 0;
+        for (unsigned int i = 0; i < length; ++i, code >>= 1) {
+            reversed = reversed << 1 | (code & 1);
+        }
+        return reversed;
+    }
+
+    /**
+     * Builds the decoding table of a canonical Huffman code.
+     * The first "1 << tableBits" entries are indexed by the next bits of the input; codes longer than that
+     * have an entry pointing to a sub-table, indexed by the following bits. Unused entries are ENTRY_INVALID.
+     * @param lengths Length of the code of each symbol, 0 for unused symbols.
+     * @param count Number of symbols.
+     * @param symbols Entry of each symbol, without its number of bits.
+     * @param tableBits Number of bits of the first-level table.
+     * @param table Filled with the table.
+     * @return False if the lengths do not make a prefix code (too many short codes).
+     */
+    static bool BuildTable(const uint8_t* lengths, size_t count, const uint32_t* symbols, unsigned int tableBits,
+                           std::vector<uint32_t>& table) {
+        unsigned int counts[INFLATE_MAX_CODE_BITS + 1] = {};
+        for (size_t symbol = 0; symbol < count; ++symbol) {
+            ++counts[lengths[symbol]];
+        }
+        counts[0] = 0;
+        int left = 1;
+        for (unsigned int length = 1; length <= INFLATE_MAX_CODE_BITS; ++length) {
+            left = (left << 1) - static_cast<int>(counts[length]);
+            if (left < 0) {
+                return false;
+            }
+        }
+
+        // Canonical codes: consecutive for a given length, ordered by symbol.
+        uint32_t nextCode[INFLATE_MAX_CODE_BITS + 1] = {};
+        uint32_t code = 0;
+        for (unsigned int length = 1; length <= INFLATE_MAX_CODE_BITS; ++length) {
+            code = (code + counts[length - 1]) << 1;
+            nextCode[length] = code;
+        }
+        std::vector<uint32_t> codes(count);
+        for (size_t symbol = 0; symbol < count; ++symbol) {
+            if (lengths[symbol]) {
+                codes[symbol] = nextCode[lengths[symbol]]++;
+            }
+        }
+
+        // Sub-tables: one per first "tableBits" bits shared by long codes, as big as the longest of them needs.
+        const uint32_t mainSize = 1u << tableBits;
+        table.assign(mainSize, MakeEntry(ENTRY_INVALID, 0, 0));
+        std::vector<uint8_t> longest(mainSize, 0);
+        for (size_t symbol = 0; symbol < count; ++symbol) {
+            if (lengths[symbol] > tableBits) {
+                const uint32_t prefix = ReverseBits(codes[symbol] >> (lengths[symbol] - tableBits), tableBits);
+                longest[prefix] = std::max(longest[prefix], lengths[symbol]);
+            }
+        }
+        for (uint32_t prefix = 0; prefix < mainSize; ++prefix) {
+            if (longest[prefix]) {
+                const uint32_t subBits = longest[prefix] - tableBits;
+                table[prefix] = tableBits | MakeEntry(ENTRY_SUBTABLE, subBits, static_cast<uint32_t>(table.size()));
+                table.resize(table.size() + (size_t(1) << subBits), MakeEntry(ENTRY_INVALID, 0, 0));
+            }
+        }
+
+        for (size_t symbol = 0; symbol < count; ++symbol) {
+            const unsigned int length = lengths[symbol];
+            if (!length) {
+                continue;
+            }
+            const uint32_t reversed = ReverseBits(codes[symbol], length);
+            if (length <= tableBits) {
+                for (uint32_t index = reversed; index < mainSize; index += 1u << length) {
+                    table[index] = length | symbols[symbol];
+                }
+            } else {
+                const uint32_t subtable = table[reversed & (mainSize - 1)];
+                const uint32_t subSize = 1u << EntryExtraBits(subtable);
+                for (uint32_t index = reversed >> tableBits; index < subSize; index += 1u << (length - tableBits)) {
+                    table[EntryValue(subtable) + index] = (length - tableBits) | symbols[symbol];
+                }
+            }
+        }
+        return true;
+    }
+
+    /// Next entry of "table" for the bits of "bits", following a sub-table if needed. "bits" must hold the whole code.
+    static inline uint32_t LookUp(const uint32_t* table, unsigned int tableBits, uint64_t& bits, unsigned int& bitCount) {
+        uint32_t entry = table[bits & ((1u << tableBits) - 1)];
+        if (EntryKind(entry) == ENTRY_SUBTABLE) {
+            bits >>= tableBits;
+            bitCount -= tableBits;
+            entry = table[EntryValue(entry) + (bits & ((1u << EntryExtraBits(entry)) - 1))];
+        }
+        bits >>= EntryBits(entry);
+        bitCount -= EntryBits(entry);
+        return entry;
+    }
+
+//////////////////////////////////////////////////////////////////  PUBLIC
+//------------------------------------------------------- Public functions
+
+    struct Inflater::State {
+        enum class Stage {
+            STREAM_HEADER, BLOCK_HEADER, STORED, HUFFMAN, TRAILER, DONE, FAILED
+        };
+
+        InflateSource source;
+        InflateFormat format;
+        Stage stage;
+        bool lastBlock = false;
+        size_t storedLeft = 0; // Bytes of the current stored block not copied yet.
+
+        // Input: the current piece, and the bits taken from it but not used yet (lowest first).
+        // Bits above "bitCount" may hold the next bytes of the piece, which are added again at the same place.
+        const unsigned char* in = nullptr;
+        const unsigned char* inEnd = nullptr;
+        const unsigned char* pieceBegin = nullptr;
+        Filesize_t previousPieces = 0; // Size of the pieces before the current one.
+        uint64_t bits = 0;
+        unsigned int bitCount = 0;
+        size_t padding = 0; // Zero bytes added after the end of the input, which must not be used.
+
+        // Output: "[readPosition, outPosition)" is decompressed and not read yet, and the bytes before are the history.
+        std::unique_ptr<unsigned char[]> buffer;
+        size_t outPosition = 0;
+        size_t readPosition = 0;
+        Filesize_t slid = 0; // Bytes dropped from the beginning of the buffer.
+        uint32_t adler = 1;
+
+        std::vector<uint32_t> litLenTable;
+        std::vector<uint32_t> distanceTable;
+
+        State(InflateSource source, InflateFormat format) :
+                source(std::move(source)), format(format),
+                stage(format == InflateFormat::ZLIB ? Stage::STREAM_HEADER : Stage::BLOCK_HEADER),
+                buffer(new unsigned char[BUFFER_SIZE + INFLATE_COPY_OVERRUN])
+        {}
+
+        /// Fills the bits with the input, at least 57 of them. Past the end of the input, zeros are added.
+        /// @return False if bits which are not in the input were used.
+        inline bool Refill() {
+            if (inEnd - in >= 8) {
+                uint64_t word;
+                std::memcpy(&word, in, sizeof(word));
+                bits |= word << bitCount;
+                in += (63 - bitCount) >> 3;
+                bitCount |= 56;
+                return true;
+            }
+            return RefillSlowly();
+        }
+
+        bool RefillSlowly() {
+            if (padding * 8 > bitCount) {
+                return false;
+            }
+            while (bitCount <= 56) {
+                if (in == inEnd && !NextPiece()) {
+                    ++padding;
+                    bits &= (uint64_t(1) << bitCount) - 1;
+                } else {
+                    bits = (bits & ((uint64_t(1) << bitCount) - 1)) | uint64_t(*in++) << bitCount;
+                }
+                bitCount += 8;
+            }
+            return true;
+        }
+
+        bool NextPiece() {
+            const char* data = nullptr;
+            size_t size = 0;
+            while (source && source(data, size)) {
+                if (size) {
+                    previousPieces += inEnd - pieceBegin;
+                    pieceBegin = in = reinterpret_cast<const unsigned char*>(data);
+                    inEnd = in + size;
+                    return true;
+                }
+            }
+            source = nullptr;
+            return false;
+        }
+
+        inline void Drop(unsigned int count) {
+            bits >>= count;
+            bitCount -= count;
+        }
+
+        inline uint32_t Take(unsigned int count) {
+            const auto value = static_cast<uint32_t>(bits & ((uint64_t(1) << count) - 1));
+            Drop(count);
+            return value;
+        }
+
+        /// True if the bits used so far were all in the input.
+        bool InInput() const { return padding * 8 <= bitCount; }
+
+        bool Fail() {
+            stage = Stage::FAILED;
+            return false;
+        }
+
+        bool ReadStreamHeader() {
+            if (!Refill()) {
+                return Fail();
+            }
+            const uint32_t method = Take(8);
+            const uint32_t flags = Take(8);
+            // Method 8 (DEFLATE) with a window of at most 32 KiB, no preset dictionary, and the header checksum.
+            if ((method & 15) != 8 || (method >> 4) > 7 || (flags & 0x20) || (method << 8 | flags) % 31 || !InInput()) {
+                return Fail();
+            }
+            stage = Stage::BLOCK_HEADER;
+            return true;
+        }
+
+        bool ReadBlockHeader() {
+            if (!Refill()) {
+                return Fail();
+            }
+            lastBlock = Take(1) != 0;
+            switch (Take(2)) {
+                case 0: {
+                    Drop(bitCount % 8);
+                    const uint32_t length = Take(16);
+                    const uint32_t complement = Take(16);
+                    if ((length ^ 0xFFFF) != complement || !InInput()) {
+                        return Fail();
+                    }
+                    storedLeft = length;
+                    stage = Stage::STORED;
+                    return true;
+                }
+                case 1:
+                    return BuildFixedTables();
+                case 2:
+                    return ReadDynamicTables();
+                default:
+                    return Fail();
+            }
+        }
+
+        bool BuildFixedTables() {
+            uint8_t lengths[288 + 32];
+            std::fill(lengths, lengths + 144, 8);
+            std::fill(lengths + 144, lengths + 256, 9);
+            std::fill(lengths + 256, lengths + 280, 7);
+            std::fill(lengths + 280, lengths + 288, 8);
+            std::fill(lengths + 288, lengths + 320, 5);
+            BuildTable(lengths, 288, LitLenSymbols(), INFLATE_LITLEN_BITS, litLenTable);
+            BuildTable(lengths + 288, 32, DistanceSymbols(), INFLATE_DISTANCE_BITS, distanceTable);
+            stage = Stage::HUFFMAN;
+            return true;
+        }
+
+        bool ReadDynamicTables() {
+            const uint32_t litLenCount = Take(5) + 257;
+            const uint32_t distanceCount = Take(5) + 1;
+            const uint32_t codeLengthCount = Take(4) + 4;
+            if (litLenCount > 286 || distanceCount > 30) {
+                return Fail();
+            }
+
+            uint8_t codeLengthLengths[19] = {};
+            for (uint32_t i = 0; i < codeLengthCount; ++i) {
+                if (!Refill()) {
+                    return Fail();
+                }
+                codeLengthLengths[CODELEN_ORDER[i]] = static_cast<uint8_t>(Take(3));
+            }
+            std::vector<uint32_t> codeLengthTable;
+            if (!BuildTable(codeLengthLengths, 19, CodeLengthSymbols(), INFLATE_CODELEN_BITS, codeLengthTable)) {
+                return Fail();
+            }
+
+            uint8_t lengths[286 + 30] = {};
+            for (uint32_t i = 0; i < litLenCount + distanceCount;) {
+                if (!Refill()) {
+                    return Fail();
+                }
+                const uint32_t entry = LookUp(codeLengthTable.data(), INFLATE_CODELEN_BITS, bits, bitCount);
+                if (EntryKind(entry) == ENTRY_INVALID) {
+                    return Fail();
+                }
+                const uint32_t symbol = EntryValue(entry);
+                uint32_t repeat = 1;
+                uint8_t length = 0;
+                if (symbol < 16) {
+                    length = static_cast<uint8_t>(symbol);
+                } else if (symbol == 16) {
+                    if (!i) {
+                        return Fail();
+                    }
+                    length = lengths[i - 1];
+                    repeat = 3 + Take(2);
+                } else if (symbol == 17) {
+                    repeat = 3 + Take(3);
+                } else {
+                    repeat = 11 + Take(7);
+                }
+                if (i + repeat > litLenCount + distanceCount) {
+                    return Fail();
+                }
+                std::fill(lengths + i, lengths + i + repeat, length);
+                i += repeat;
+            }
+
+            // The end of block must have a code, and codes are taken as they come: distances follow literals/lengths.
+            uint8_t litLenLengths[288] = {};
+            uint8_t distanceLengths[32] = {};
+            std::copy(lengths, lengths + litLenCount, litLenLengths);
+            std::copy(lengths + litLenCount, lengths + litLenCount + distanceCount, distanceLengths);
+            if (!litLenLengths[256] || !InInput()
+                || !BuildTable(litLenLengths, 288, LitLenSymbols(), INFLATE_LITLEN_BITS, litLenTable)
+                || !BuildTable(distanceLengths, 32, DistanceSymbols(), INFLATE_DISTANCE_BITS, distanceTable)) {
+                return Fail();
+            }
+            stage = Stage::HUFFMAN;
+            return true;
+        }
+
+        bool CopyStored() {
+            while (storedLeft && outPosition < BUFFER_SIZE) {
+                if (bitCount >= 8) {
+                    // Whole bytes already taken from the input.
+                    buffer[outPosition++] = static_cast<unsigned char>(Take(8));
+                    --storedLeft;
+                    continue;
+                }
+                bits = 0; // Drop the bytes which are read again below.
+                if (in == inEnd && !NextPiece()) {
+                    return Fail();
+                }
+                const size_t size = std::min({storedLeft, static_cast<size_t>(inEnd - in), BUFFER_SIZE - outPosition});
+                std::memcpy(buffer.get() + outPosition, in, size);
+                in += size;
+                outPosition += size;
+                storedLeft -= size;
+            }
+            if (!InInput()) {
+                return Fail();
+            }
+            if (!storedLeft) {
+                stage = lastBlock ? Stage::TRAILER : Stage::BLOCK_HEADER;
+            }
+            return true;
+        }
+
+        /// Decodes the symbols of a compressed block, until its end or until the buffer is full.
+        bool DecodeHuffman() {
+            const uint32_t* const litLen = litLenTable.data();
+            const uint32_t* const distances = distanceTable.data();
+            unsigned char* const begin = buffer.get();
+            unsigned char* out = begin + outPosition;
+            unsigned char* const outLimit = begin + BUFFER_SIZE - INFLATE_MAX_MATCH;
+
+            // Each iteration needs at most 15 + 5 bits for the length, then 15 + 13 bits for the distance: one refill is enough.
+            while (out <= outLimit) {
+                if (!Refill()) {
+                    outPosition = out - begin;
+                    return Fail();
+                }
+                uint32_t entry = LookUp(litLen, INFLATE_LITLEN_BITS, bits, bitCount);
+                if (EntryKind(entry) == ENTRY_LITERAL) {
+                    *out++ = static_cast<unsigned char>(EntryValue(entry));
+                    // Runs of literals: decode the following ones with the bits left, as long as they hold a whole code.
+                    while (bitCount >= INFLATE_MAX_CODE_BITS) {
+                        entry = litLen[bits & ((1u << INFLATE_LITLEN_BITS) - 1)];
+                        if (EntryKind(entry) != ENTRY_LITERAL) {
+                            break;
+                        }
+                        Drop(EntryBits(entry));
+                        *out++ = static_cast<unsigned char>(EntryValue(entry));
+                    }
+                    continue;
+                } else if (EntryKind(entry) == ENTRY_END_OF_BLOCK) {
+                    stage = lastBlock ? Stage::TRAILER : Stage::BLOCK_HEADER;
+                    break;
+                } else if (EntryKind(entry) != ENTRY_LENGTH) {
+                    outPosition = out - begin;
+                    return Fail();
+                }
+
+                const uint32_t length = EntryValue(entry) + Take(EntryExtraBits(entry));
+                entry = LookUp(distances, INFLATE_DISTANCE_BITS, bits, bitCount);
+                if (EntryKind(entry) != ENTRY_LENGTH) {
+                    outPosition = out - begin;
+                    return Fail();
+                }
+                const uint32_t distance = EntryValue(entry) + Take(EntryExtraBits(entry));
+                if (distance > static_cast<size_t>(out - begin)) {
+                    outPosition = out - begin;
+                    return Fail();
+                }
+
+                const unsigned char* from = out - distance;
+                unsigned char* const end = out + length;
+                if (distance >= 16) {
+                    // 16 bytes at a time, possibly past the end: the source is at least 16 bytes behind, so already written.
+                    for (; out < end; out += 16, from += 16) {
+                        std::memcpy(out, from, 16);
+                    }
+                } else if (distance >= 8) {
+                    for (; out < end; out += 8, from += 8) {
+                        std::memcpy(out, from, 8);
+                    }
+                } else if (distance == 1) {
+                    std::memset(out, *from, length);
+                } else {
+                    for (; out < end; ++out, ++from) {
+                        *out = *from;
+                    }
+                }
+                out = end;
+            }
+            outPosition = out - begin;
+            return true;
+        }
+
+        bool ReadTrailer() {
+            if (format == InflateFormat::ZLIB) {
+                Drop(bitCount % 8);
+                if (!Refill()) {
+                    return Fail();
+                }
+                uint32_t expected = 0;
+                for (int i = 0; i < 4; ++i) {
+                    expected = expected << 8 | Take(8);
+                }
+                if (expected != adler || !InInput()) {
+                    return Fail();
+                }
+            } else if (!InInput()) {
+                return Fail();
+            }
+            stage = Stage::DONE;
+            return true;
+        }
+
+        /**
+         * Decompresses the next bytes into the buffer: once all the decompressed bytes are read,
+         * the end of the buffer is moved to its beginning to keep the history, then the stream is decoded
+         * until the buffer is full, or the stream ends.
+         */
+        void Decompress() {
+            if (outPosition + INFLATE_MAX_MATCH > BUFFER_SIZE && readPosition == outPosition) {
+                const size_t keep = std::min(outPosition, INFLATE_WINDOW_SIZE);
+                std::memmove(buffer.get(), buffer.get() + outPosition - keep, keep);
+                slid += outPosition - keep;
+                outPosition = readPosition = keep;
+            }
+
+            const size_t start = outPosition;
+            bool going = true;
+            while (going && outPosition + INFLATE_MAX_MATCH <= BUFFER_SIZE) {
+                switch (stage) {
+                    case Stage::STREAM_HEADER:
+                        going = ReadStreamHeader();
+                        break;
+                    case Stage::BLOCK_HEADER:
+                        going = ReadBlockHeader();
+                        break;
+                    case Stage::STORED:
+                        going = CopyStored();
+                        break;
+                    case Stage::HUFFMAN:
+                        going = DecodeHuffman();
+                        break;
+                    case Stage::TRAILER:
+                        // The checksum covers all the bytes, so it is updated before the end.
+                        adler = Hash_Adler32(reinterpret_cast<const char*>(buffer.get() + start), outPosition - start, adler);
+                        ReadTrailer();
+                        return;
+                    case Stage::DONE:
+                    case Stage::FAILED:
+                        return;
+                }
+            }
+            if (format == InflateFormat::ZLIB && stage != Stage::FAILED) {
+                adler = Hash_Adler32(reinterpret_cast<const char*>(buffer.get() + start), outPosition - start, adler);
+            }
+        }
+    };
+
+    Inflater::Inflater(InflateSource source, InflateFormat format) :
+            state(new State(std::move(source), format))
+    {}
+
+    Inflater::Inflater(const char* data, size_t size, InflateFormat format) :
+            Inflater([data, size](const char*& piece, size_t& pieceSize) mutable {
+                piece = data;
+                pieceSize = size;
+                const bool given = data != nullptr;
+                data = nullptr;
+                return given;
+            }, format)
+    {}
+
+    Inflater::Inflater(const ReadFileData* content, Filesize_t offset, InflateFormat format) :
+            Inflater(content && offset < content->size ? content->contents + offset : nullptr,
+                     content && offset < content->size ? static_cast<size_t>(content->size - offset) : 0, format)
+    {}
+
+    Inflater::~Inflater() = default;
+
+    size_t Inflater::Read(char* buffer, size_t capacity) {
+        size_t read = 0;
+        while (read < capacity) {
+            if (state->readPosition == state->outPosition) {
+                if (state->stage == State::Stage::DONE || state->stage == State::Stage::FAILED) {
+                    break;
+                }
+                state->Decompress();
+                continue;
+            }
+            const size_t size = std::min(capacity - read, state->outPosition - state->readPosition);
+            std::memcpy(buffer + read, state->buffer.get() + state->readPosition, size);
+            state->readPosition += size;
+            read += size;
+        }
+        return read;
+    }
+
+    bool Inflater::ReadAll(const std::function<bool(const char*, size_t)>& sink) {
+        while (true) {
+            if (state->readPosition < state->outPosition) {
+                const size_t size = state->outPosition - state->readPosition;
+                const char* data = reinterpret_cast<const char*>(state->buffer.get() + state->readPosition);
+                state->readPosition = state->outPosition;
+                if (!sink(data, size)) {
+                    return false;
+                }
+            } else if (state->stage == State::Stage::DONE || state->stage == State::Stage::FAILED) {
+                return state->stage == State::Stage::DONE;
+            } else {
+                state->Decompress();
+            }
+        }
+    }
+
+    bool Inflater::IsDone() const {
+        return state->stage == State::Stage::DONE;
+    }
+
+    bool Inflater::Failed() const {
+        return state->stage == State::Stage::FAILED;
+    }
+
+    Filesize_t Inflater::TotalIn() const {
+        const size_t pending = state->bitCount / 8 > state->padding ? state->bitCount / 8 - state->padding : 0;
+        return state->previousPieces + (state->in - state->pieceBegin) - pending;
+    }
+
+    Filesize_t Inflater::TotalOut() const {
+        return state->slid + state->outPosition;
+    }
+
+    bool Inflate(const ReadFileData* content, std::string& output, Filesize_t offset, InflateFormat format) {
+        output.clear();
+        Inflater inflater(content, offset, format);
+        return inflater.ReadAll([&output](const char* data, size_t size) {
+            output.append(data, size);
+            return true;
+        });
+    }
+}
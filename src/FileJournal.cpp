@@ -0,0 +1,367 @@
+//
+// File module: durable append-only log of records, shared by threads.
+//
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include "MF/FileJournal.hpp"
+#include "MF/FileOpen.hpp"
+#include "HashHelper.hpp"
+#include "TreeHelper.hpp"
+
+#if defined(_WIN32)
+#   include "WindowsAPIHelper.hpp"
+using OSJournalSegment_t = Windows_JournalSegment;
+#   define OS_OpenJournalSegment Windows_OpenJournalSegment
+#   define OS_WriteJournalSegment Windows_WriteJournalSegment
+#   define OS_SyncJournalSegment Windows_SyncJournalSegment
+#   define OS_CloseJournalSegment Windows_CloseJournalSegment
+#else
+#   include "UnixAPIHelper.hpp"
+using OSJournalSegment_t = Unix_JournalSegment;
+#   define OS_OpenJournalSegment Unix_OpenJournalSegment
+#   define OS_WriteJournalSegment Unix_WriteJournalSegment
+#   define OS_SyncJournalSegment Unix_SyncJournalSegment
+#   define OS_CloseJournalSegment Unix_CloseJournalSegment
+#endif
+
+namespace File {
+
+/////////////////////////////////////////////////////////////////  PRIVATE
+
+//-------------------------------------------------------------- Constants
+
+    // First bytes of every segment.
+    constexpr static char JOURNAL_MAGIC[8] = {'M', 'F', 'J', 'O', 'U', 'R', 'N', '1'};
+
+    // Each record is preceded by its size and its checksum (32 bits each, in the byte order of the machine),
+    // and padded so that the next header is aligned on 8 bytes.
+    constexpr static size_t JOURNAL_HEADER_SIZE = 8;
+
+    // Digits of the number of a segment in its name, followed by the extension.
+    constexpr static size_t JOURNAL_NAME_DIGITS = 16;
+    constexpr static char JOURNAL_EXTENSION[] = ".journal";
+
+//------------------------------------------------------ Private functions
+
+    /// Name of a segment, without the directory.
+    static SFilename_t SegmentName(uint64_t number) {
+        SFilename_t name(JOURNAL_NAME_DIGITS, '0');
+        for (size_t i = JOURNAL_NAME_DIGITS; i-- > 0 && number; number /= 10) {
+            name[i] = static_cast<SFilename_t::value_type>('0' + number % 10);
+        }
+        for (const char* c = JOURNAL_EXTENSION; *c; ++c) {
+            name += static_cast<SFilename_t::value_type>(*c);
+        }
+        return name;
+    }
+
+    /// Number of the segment named "name", or 0 if it is not the name of a segment.
+    static uint64_t SegmentNumber(const SFilename_t& name) {
+        const size_t extensionSize = sizeof(JOURNAL_EXTENSION) - 1;
+        if (name.size() != JOURNAL_NAME_DIGITS + extensionSize) {
+            return 0;
+        }
+        for (size_t i = 0; i < extensionSize; ++i) {
+            if (name[JOURNAL_NAME_DIGITS + i] != static_cast<SFilename_t::value_type>(JOURNAL_EXTENSION[i])) {
+                return 0;
+            }
+        }
+        uint64_t number = 0;
+        for (size_t i = 0; i < JOURNAL_NAME_DIGITS; ++i) {
+            if (name[i] < '0' || name[i] > '9') {
+                return 0;
+            }
+            number = number * 10 + static_cast<uint64_t>(name[i] - '0');
+        }
+        return number;
+    }
+
+    /// Checksum of a record: it depends on where the record is, so that a record left by a previous use of the place is not valid.
+    static uint32_t RecordChecksum(uint64_t segment, Filesize_t offset, const char* data, size_t size) {
+        const uint64_t hash = Hash_XXH64(data, size, segment << 40 ^ offset);
+        return static_cast<uint32_t>(hash ^ hash >> 32) ^ static_cast<uint32_t>(size);
+    }
+
+    /// Space taken by a record of "size" bytes, header included.
+    static Filesize_t RecordSpace(size_t size) {
+        return (JOURNAL_HEADER_SIZE + size + 7) & ~static_cast<Filesize_t>(7);
+    }
+
+    /**
+     * Scans the records of a segment.
+     * @param reader Called with each valid record. Returns false to stop.
+     * @return The offset of the first invalid record (where the next one would be written), or of the record which stopped the scan.
+     */
+    template <typename Reader>
+    static Filesize_t ScanSegment(uint64_t number, const char* data, Filesize_t size, Reader&& reader) {
+        if (size < sizeof(JOURNAL_MAGIC) || std::memcmp(data, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0) {
+            return 0;
+        }
+        Filesize_t offset = sizeof(JOURNAL_MAGIC);
+        while (offset + JOURNAL_HEADER_SIZE <= size) {
+            uint32_t header[2];
+            std::memcpy(header, data + offset, sizeof(header));
+            if (header[0] > size - offset - JOURNAL_HEADER_SIZE ||
+                header[1] != RecordChecksum(number, offset, data + offset + JOURNAL_HEADER_SIZE, header[0]) ||
+                !reader(data + offset + JOURNAL_HEADER_SIZE, static_cast<size_t>(header[0]))) {
+                break;
+            }
+            offset += RecordSpace(header[0]);
+        }
+        return std::min(offset, size);
+    }
+
+/////////////////////////////////////////////////////////////////  PUBLIC
+
+//------------------------------------------------------- Public functions
+
+    struct Journal::State {
+        SFilename_t directory; // Ending with a separator.
+        JournalOptions options;
+
+        mutable std::mutex mutex;
+        std::condition_variable synced; // Notified when a synchronisation ends.
+        std::vector<uint64_t> segments; // Numbers of the segments, the last one being written.
+        OSJournalSegment_t* tail = nullptr; // Last segment.
+        Filesize_t end = 0; // Offset in "tail" where the next record goes.
+        uint64_t records = 0;
+        uint64_t appended = 0; // Number of records appended since the opening...
+        uint64_t durable = 0; // ...and how many of them are on the device.
+        bool syncing = false; // True while a thread synchronises "tail" without the mutex.
+        bool failed = false;
+
+        /// Creates the next segment, and makes it the tail. Call with the mutex held, no synchronisation running.
+        bool AddSegment() {
+            const uint64_t number = segments.empty() ? 1 : segments.back() + 1;
+            OSJournalSegment_t* segment = OS_OpenJournalSegment((directory + SegmentName(number)).c_str(), options.segmentSize, true);
+            if (!segment) {
+                return false;
+            }
+            if (tail) {
+                OS_CloseJournalSegment(tail);
+            }
+            tail = segment;
+            segments.push_back(number);
+            end = sizeof(JOURNAL_MAGIC);
+            return OS_WriteJournalSegment(tail, 0, nullptr, 0, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        }
+
+        /// What "RecoverTail" found.
+        enum class Recovery {
+            RECOVERED, // The tail is open, ready for the next record.
+            EMPTY, // The segment was created, but the crash happened before it held any record: it can be deleted.
+            FAILED
+        };
+
+        /// Opens the last segment, finds its end and erases what follows.
+        Recovery RecoverTail() {
+            const SFilename_t filename = directory + SegmentName(segments.back());
+            const ReadFileData* content = Read(filename.c_str(), ReadStrategy::MMAP, AccessPattern::SEQUENTIAL);
+            if (!content) {
+                return Size(filename.c_str()) == 0 ? Recovery::EMPTY : Recovery::FAILED;
+            }
+            end = ScanSegment(segments.back(), content->contents, content->size, [this](const char*, size_t) {
+                ++records;
+                return true;
+            });
+            // A crash may leave records (or parts of them) after the first invalid one, which a shorter record
+            // written at the same place could make look valid again.
+            const char* const last = content->contents + content->size;
+            const bool clean = std::find_if(content->contents + end, last, [](char c) { return c != 0; }) == last;
+            const Filesize_t size = content->size;
+            Read_Close(content);
+            if (end == 0) {
+                // The magic is synchronised with the first record: a segment without it must not hold anything else.
+                return clean ? Recovery::EMPTY : Recovery::FAILED;
+            }
+
+            tail = OS_OpenJournalSegment(filename.c_str(), 0, false);
+            if (!tail) {
+                return Recovery::FAILED;
+            }
+            if (!clean) {
+                std::unique_ptr<char[]> zeros(new char[1ul << 20]());
+                for (Filesize_t offset = end; offset < size; offset += 1ul << 20) {
+                    const auto length = static_cast<size_t>(std::min<Filesize_t>(size - offset, 1ul << 20));
+                    if (!OS_WriteJournalSegment(tail, offset, nullptr, 0, zeros.get(), length)) {
+                        return Recovery::FAILED;
+                    }
+                }
+                if (!OS_SyncJournalSegment(tail)) {
+                    return Recovery::FAILED;
+                }
+            }
+            return Recovery::RECOVERED;
+        }
+
+        /**
+         * Waits until the first "target" records appended are on the device, by synchronising the tail or by waiting for
+         * the thread which does. The records appended meanwhile are synchronised too.
+         */
+        bool WaitDurable(std::unique_lock<std::mutex>& lock, uint64_t target) {
+            while (durable < target && !failed) {
+                if (syncing) {
+                    synced.wait(lock);
+                    continue;
+                }
+                syncing = true;
+                const uint64_t batch = appended;
+                lock.unlock();
+                const bool success = OS_SyncJournalSegment(tail);
+                lock.lock();
+                syncing = false;
+                failed |= !success;
+                durable = std::max(durable, batch);
+                synced.notify_all();
+            }
+            return !failed;
+        }
+    };
+
+    Journal::Journal(Filename_t directory, const JournalOptions& options) :
+            state(new State)
+    {
+        state->directory = Tree_AsDirectory(directory);
+        state->options = options;
+        // Records take multiples of 8 bytes: a segment has no room for a partial one.
+        state->options.segmentSize = std::max<Filesize_t>(options.segmentSize, 4096) & ~static_cast<Filesize_t>(7);
+        CreateFolder(directory);
+
+        std::vector<Tree_Entry> entries;
+        if (!Tree_ListDirectory(state->directory.c_str(), entries)) {
+            state->failed = true;
+            return;
+        }
+        for (const Tree_Entry& entry : entries) {
+            const uint64_t number = SegmentNumber(entry.name);
+            if (number && entry.type == Tree_EntryType::FILE) {
+                state->segments.push_back(number);
+            }
+        }
+        std::sort(state->segments.begin(), state->segments.end());
+
+        const State::Recovery recovery = state->segments.empty() ? State::Recovery::EMPTY : state->RecoverTail();
+        if (recovery == State::Recovery::FAILED) {
+            state->failed = true;
+            return;
+        }
+        if (recovery == State::Recovery::EMPTY && !state->segments.empty()) {
+            if (!Delete((state->directory + SegmentName(state->segments.back())).c_str())) {
+                state->failed = true;
+                return;
+            }
+            state->segments.pop_back();
+        }
+        if (!state->tail && !state->AddSegment()) {
+            state->failed = true;
+        }
+
+        // Records of the full segments.
+        for (size_t i = 0; i + 1 < state->segments.size(); ++i) {
+            const ReadFileData* content = Read((state->directory + SegmentName(state->segments[i])).c_str(),
+                                               ReadStrategy::MMAP, AccessPattern::SEQUENTIAL);
+            if (content) {
+                ScanSegment(state->segments[i], content->contents, content->size, [this](const char*, size_t) {
+                    ++state->records;
+                    return true;
+                });
+                Read_Close(content);
+            }
+        }
+    }
+
+    Journal::~Journal() {
+        if (state->tail) {
+            if (state->options.durability != Durability::NONE) {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                state->WaitDurable(lock, state->appended);
+            }
+            OS_CloseJournalSegment(state->tail);
+        }
+    }
+
+    bool Journal::IsOpen() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->tail && !state->failed;
+    }
+
+    bool Journal::Append(const char* data, size_t size) {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        if (!state->tail || state->failed || size > MaxRecordSize()) {
+            return false;
+        }
+
+        const Filesize_t space = RecordSpace(size);
+        while (state->end + space > state->tail->size) {
+            // The tail is full: everything in it is made durable before it is closed, whatever the durability,
+            // so that "Sync" only has to synchronise the tail.
+            if (state->failed) {
+                return false;
+            }
+            if (state->syncing) {
+                state->synced.wait(lock);
+            } else if (state->durable < state->appended) {
+                state->WaitDurable(lock, state->appended);
+            } else if (!state->AddSegment()) {
+                state->failed = true;
+                return false;
+            }
+        }
+
+        const uint32_t header[2] = {static_cast<uint32_t>(size), RecordChecksum(state->segments.back(), state->end, data, size)};
+        if (!OS_WriteJournalSegment(state->tail, state->end, reinterpret_cast<const char*>(header), sizeof(header), data, size)) {
+            state->failed = true;
+            return false;
+        }
+        state->end += space;
+        ++state->records;
+        const uint64_t ticket = ++state->appended;
+
+        return state->options.durability == Durability::NONE || state->WaitDurable(lock, ticket);
+    }
+
+    bool Journal::Sync() {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        return state->tail && state->WaitDurable(lock, state->appended);
+    }
+
+    bool Journal::ForEach(const std::function<bool(const char* data, size_t size)>& reader) const {
+        std::vector<uint64_t> segments;
+        Filesize_t tailEnd;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            segments = state->segments;
+            tailEnd = state->end;
+        }
+
+        bool stopped = false;
+        for (size_t i = 0; i < segments.size() && !stopped; ++i) {
+            const ReadFileData* content = Read((state->directory + SegmentName(segments[i])).c_str(),
+                                               ReadStrategy::MMAP, AccessPattern::SEQUENTIAL);
+            if (!content) {
+                return false;
+            }
+            // Records appended after "tailEnd" may be partly copied.
+            const Filesize_t size = i + 1 == segments.size() ? std::min(tailEnd, content->size) : content->size;
+            ScanSegment(segments[i], content->contents, size, [&reader, &stopped](const char* data, size_t length) {
+                stopped = !reader(data, length);
+                return !stopped;
+            });
+            Read_Close(content);
+        }
+        return true;
+    }
+
+    uint64_t Journal::RecordCount() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->records;
+    }
+
+    size_t Journal::MaxRecordSize() const {
+        return static_cast<size_t>(std::min<Filesize_t>(state->options.segmentSize - sizeof(JOURNAL_MAGIC) - JOURNAL_HEADER_SIZE, UINT32_MAX));
+    }
+}
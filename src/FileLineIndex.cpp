@@ -0,0 +1,289 @@
+//
+// File module: index of the beginnings of lines, for random access to the lines of big files.
+//
+
+#include <algorithm>
+#include <cstring>
+#include "MF/FileLineIndex.hpp"
+#include "MF/FileWriter.hpp"
+#include "HashHelper.hpp"
+#include "ParallelHelper.hpp"
+#include "SimdHelper.hpp"
+
+namespace File {
+    constexpr size_t LineIndex::BLOCK_LINES;
+
+/////////////////////////////////////////////////////////////////  PRIVATE
+
+//-------------------------------------------------------------- Constants
+
+    // Parts of the buffer searched by each job: big enough that a job costs much more than handing it out.
+    constexpr static Filesize_t LINE_INDEX_CHUNK_SIZE = 4ul << 20;
+
+    // First bytes of an index file. The last character is the version of the format.
+    constexpr static char LINE_INDEX_MAGIC[8] = {'M', 'F', 'L', 'I', 'N', 'E', 'S', '1'};
+
+    /// Beginning of an index file, followed by the blocks then the words.
+    struct LineIndexHeader {
+        char magic[8];
+        uint64_t sourceSize;
+        int64_t sourceMtimeNs;
+        uint64_t lineCount;
+        uint64_t blockCount;
+        uint64_t wordCount;
+        uint64_t payloadHash; // XXH64 of the blocks and the words, to detect a corrupted file.
+    };
+
+//------------------------------------------------------ Private functions
+
+    /// Appends the offset following every newline of [begin, end) to "starts". Offsets are counted from "contents".
+    static void FindLineStarts_Scalar(const char* contents, Filesize_t begin, Filesize_t end, std::vector<uint64_t>& starts) {
+        const char* p = contents + begin;
+        const char* const last = contents + end;
+        while (auto newline = static_cast<const char*>(std::memchr(p, '\n', last - p))) {
+            starts.push_back(newline + 1 - contents);
+            p = newline + 1;
+        }
+    }
+
+#if defined(MF_SIMD_X86)
+    static void FindLineStarts_SSE2(const char* contents, Filesize_t begin, Filesize_t end, std::vector<uint64_t>& starts) {
+        const __m128i newline = _mm_set1_epi8('\n');
+        Filesize_t i = begin;
+        for (; i + 16 <= end; i += 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(contents + i));
+            for (auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline))); mask; mask &= mask - 1) {
+                starts.push_back(i + Simd_LowestBit(mask) + 1);
+            }
+        }
+        FindLineStarts_Scalar(contents, i, end, starts);
+    }
+
+    MF_TARGET_AVX2 static void FindLineStarts_AVX2(const char* contents, Filesize_t begin, Filesize_t end, std::vector<uint64_t>& starts) {
+        const __m256i newline = _mm256_set1_epi8('\n');
+        Filesize_t i = begin;
+        for (; i + 32 <= end; i += 32) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(contents + i));
+            for (auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline))); mask; mask &= mask - 1) {
+                starts.push_back(i + Simd_LowestBit(mask) + 1);
+            }
+        }
+        FindLineStarts_Scalar(contents, i, end, starts);
+    }
+#endif
+
+    static void FindLineStarts(const char* contents, Filesize_t begin, Filesize_t end, std::vector<uint64_t>& starts) {
+#if defined(MF_SIMD_X86)
+        if (Simd_HasAVX2()) {
+            FindLineStarts_AVX2(contents, begin, end, starts);
+        } else {
+            FindLineStarts_SSE2(contents, begin, end, starts);
+        }
+#else
+        FindLineStarts_Scalar(contents, begin, end, starts);
+#endif
+    }
+
+    /// Number of bits needed to store "value".
+    static inline uint64_t BitWidth(uint64_t value) {
+        uint64_t width = 0;
+        for (; value; value >>= 1) {
+            ++width;
+        }
+        return width;
+    }
+
+//////////////////////////////////////////////////////////////////  PUBLIC
+//------------------------------------------------------- Public functions
+
+    void LineIndex::Build(const char* contents, Filesize_t contentsSize, unsigned int threads) {
+        blocks.clear();
+        words.clear();
+        size = contents ? contentsSize : 0;
+        lineCount = 0;
+        if (!size) {
+            return;
+        }
+        threads = Parallel_ThreadCount(threads);
+
+        // Beginnings of lines of each chunk, searched in parallel. The first line begins the first chunk.
+        const size_t chunkCount = static_cast<size_t>((size + LINE_INDEX_CHUNK_SIZE - 1) / LINE_INDEX_CHUNK_SIZE);
+        std::vector<std::vector<uint64_t>> chunkStarts(chunkCount);
+        chunkStarts.front().push_back(0);
+        Parallel_For(chunkCount, threads, [this, contents, &chunkStarts](size_t chunk) {
+            const Filesize_t begin = chunk * LINE_INDEX_CHUNK_SIZE;
+            FindLineStarts(contents, begin, std::min(begin + LINE_INDEX_CHUNK_SIZE, size), chunkStarts[chunk]);
+        });
+        if (!chunkStarts.back().empty() && chunkStarts.back().back() == size) {
+            chunkStarts.back().pop_back(); // The last newline does not start a line, as with "LineRange".
+        }
+
+        // The chunks are not concatenated: blocks read their lines across them.
+        std::vector<size_t> chunkFirstLine(chunkCount + 1, 0);
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+            chunkFirstLine[chunk + 1] = chunkFirstLine[chunk] + chunkStarts[chunk].size();
+        }
+        lineCount = chunkFirstLine.back();
+        const auto gather = [this, &chunkStarts, &chunkFirstLine](size_t block, uint64_t* starts) {
+            const size_t first = block * BLOCK_LINES;
+            const size_t count = std::min(first + BLOCK_LINES, lineCount) - first;
+            size_t chunk = std::upper_bound(chunkFirstLine.begin(), chunkFirstLine.end(), first) - chunkFirstLine.begin() - 1;
+            size_t index = first - chunkFirstLine[chunk];
+            for (size_t i = 0; i < count; ++i, ++index) {
+                while (index == chunkStarts[chunk].size()) {
+                    ++chunk;
+                    index = 0;
+                }
+                starts[i] = chunkStarts[chunk][index];
+            }
+            return count;
+        };
+
+        // Each block takes "width" words exactly (BLOCK_LINES is 64), so blocks can be packed in parallel.
+        blocks.resize((lineCount + BLOCK_LINES - 1) / BLOCK_LINES);
+        Parallel_For(blocks.size(), threads, [this, &gather](size_t b) {
+            uint64_t starts[BLOCK_LINES];
+            const size_t count = gather(b, starts);
+            blocks[b].base = starts[0];
+            blocks[b].width = BitWidth(starts[count - 1] - starts[0]);
+        });
+        uint64_t wordCount = 0;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            blocks[b].firstWord = wordCount;
+            wordCount += (blocks[b].width * std::min(BLOCK_LINES, lineCount - b * BLOCK_LINES) + 63) / 64;
+        }
+        words.assign(wordCount, 0);
+        Parallel_For(blocks.size(), threads, [this, &gather](size_t b) {
+            const Block& block = blocks[b];
+            if (!block.width) {
+                return;
+            }
+            uint64_t starts[BLOCK_LINES];
+            const size_t count = gather(b, starts);
+            for (size_t i = 0; i < count; ++i) {
+                const uint64_t delta = starts[i] - block.base;
+                const uint64_t bit = i * block.width;
+                uint64_t* word = &words[block.firstWord + bit / 64];
+                word[0] |= delta << (bit % 64);
+                if (bit % 64 + block.width > 64) {
+                    word[1] |= delta >> (64 - bit % 64);
+                }
+            }
+        });
+    }
+
+    Filesize_t LineIndex::Offset(size_t line) const {
+        const Block& block = blocks[line / BLOCK_LINES];
+        if (!block.width) {
+            return block.base;
+        }
+        const uint64_t bit = (line % BLOCK_LINES) * block.width;
+        const uint64_t* word = &words[block.firstWord + bit / 64];
+        uint64_t delta = word[0] >> (bit % 64);
+        if (bit % 64 + block.width > 64) {
+            delta |= word[1] << (64 - bit % 64);
+        }
+        if (block.width < 64) {
+            delta &= (uint64_t(1) << block.width) - 1;
+        }
+        return block.base + delta;
+    }
+
+    LineView LineIndex::Line(const char* contents, size_t line) const {
+        LineView view;
+        const Filesize_t begin = Offset(line);
+        Filesize_t end = line + 1 < lineCount ? Offset(line + 1) - 1 : size;
+        if (line + 1 == lineCount && contents[end - 1] == '\n') {
+            --end;
+        }
+        if (end > begin && contents[end - 1] == '\r') {
+            --end;
+        }
+        view.data = contents + begin;
+        view.size = end - begin;
+        return view;
+    }
+
+    bool LineIndex::Save(Filename_t indexFilename, const FileIdentity& source) const {
+        LineIndexHeader header{};
+        std::memcpy(header.magic, LINE_INDEX_MAGIC, sizeof(header.magic));
+        header.sourceSize = source.size;
+        header.sourceMtimeNs = source.mtimeNs;
+        header.lineCount = lineCount;
+        header.blockCount = blocks.size();
+        header.wordCount = words.size();
+        header.payloadHash = Hash_XXH64(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t),
+                                        Hash_XXH64(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(Block)));
+
+        WriterOptions options;
+        options.expectedSize = sizeof(header) + MemoryUsage();
+        Writer writer(indexFilename, options);
+        return writer.Write(reinterpret_cast<const char*>(&header), sizeof(header))
+                && writer.Write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(Block))
+                && writer.Write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t))
+                && writer.Commit();
+    }
+
+    bool LineIndex::Load(Filename_t indexFilename, const FileIdentity& source) {
+        const ReadFileData* content = Read(indexFilename);
+        if (!content) {
+            return false;
+        }
+        LineIndexHeader header{};
+        bool valid = content->size >= sizeof(header);
+        if (valid) {
+            std::memcpy(&header, content->contents, sizeof(header));
+            valid = !std::memcmp(header.magic, LINE_INDEX_MAGIC, sizeof(header.magic))
+                    && header.sourceSize == source.size && header.sourceMtimeNs == source.mtimeNs
+                    && header.blockCount == (header.lineCount + BLOCK_LINES - 1) / BLOCK_LINES
+                    && header.wordCount <= header.blockCount * BLOCK_LINES
+                    && content->size == sizeof(header) + header.blockCount * sizeof(Block) + header.wordCount * sizeof(uint64_t);
+        }
+        if (valid) {
+            const char* payload = content->contents + sizeof(header);
+            const Filesize_t blocksSize = header.blockCount * sizeof(Block);
+            valid = header.payloadHash == Hash_XXH64(payload + blocksSize, header.wordCount * sizeof(uint64_t),
+                                                     Hash_XXH64(payload, blocksSize));
+            if (valid) {
+                blocks.resize(header.blockCount);
+                words.resize(header.wordCount);
+                std::memcpy(blocks.data(), payload, blocksSize);
+                std::memcpy(words.data(), payload + blocksSize, header.wordCount * sizeof(uint64_t));
+                lineCount = header.lineCount;
+                size = header.sourceSize;
+            }
+        }
+        Read_Close(content);
+        return valid;
+    }
+
+    bool LineIndex::Open(Filename_t filename, unsigned int threads) {
+        FileIdentity identity;
+        if (!Identity(filename, identity)) {
+            return false;
+        }
+        const SFilename_t indexFilename = LineIndexFilename(filename);
+        if (Load(indexFilename.c_str(), identity)) {
+            return true;
+        }
+
+        if (!identity.size) {
+            Build(nullptr, 0);
+        } else {
+            const ReadFileData* content = Read(filename);
+            if (!content) {
+                return false;
+            }
+            Build(content->contents, content->size, threads);
+            Read_Close(content);
+        }
+        if (size == identity.size) { // Otherwise the file changed while it was read: the sidecar would not match it.
+            Save(indexFilename.c_str(), identity);
+        }
+        return true;
+    }
+
+    SFilename_t LineIndexFilename(Filename_t filename) {
+        return SFilename_t(filename) + MAKE_FILE_NAME ".lines";
+    }
+}
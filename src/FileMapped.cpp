@@ -0,0 +1,162 @@
+//
+// File module: RAII handle over the contents of a file, shared between readers through a process-wide cache.
+//
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "MF/FileMapped.hpp"
+
+namespace File {
+    constexpr size_t MappedFile::DEFAULT_CACHE_CAPACITY;
+
+    namespace {
+        struct IdentityHash {
+            size_t operator()(const FileIdentity& identity) const {
+                uint64_t hash = identity.inode * 0x9E3779B97F4A7C15ull;
+                hash ^= identity.device + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+                hash ^= static_cast<uint64_t>(identity.mtimeNs) + (hash << 6) + (hash >> 2);
+                hash ^= identity.size + (hash << 6) + (hash >> 2);
+                return static_cast<size_t>(hash);
+            }
+        };
+
+        struct CacheEntry {
+            std::shared_ptr<const ReadFileData> content;
+            uint64_t lastUse = 0;
+            SFilename_t filename; // Name under which it was read.
+        };
+
+        struct MappingCache {
+            using Entries = std::unordered_map<FileIdentity, CacheEntry, IdentityHash>;
+
+            std::mutex mutex;
+            Entries entries;
+            std::unordered_map<SFilename_t, FileIdentity> names; // Identity of each cached name, to see it change.
+            size_t capacity = MappedFile::DEFAULT_CACHE_CAPACITY;
+            uint64_t clock = 0;
+
+            /// Drops an entry, and its name. Lock must be held.
+            void Erase(Entries::iterator entry) {
+                auto name = names.find(entry->second.filename);
+                if (name != names.end() && name->second == entry->first) {
+                    names.erase(name);
+                }
+                entries.erase(entry);
+            }
+
+            /// Drops the entry of an older version of a file, which no new handle can get anymore. Lock must be held.
+            void ForgetChanged(const SFilename_t& filename, const FileIdentity& identity) {
+                auto name = names.find(filename);
+                if (name != names.end() && name->second != identity) {
+                    auto entry = entries.find(name->second);
+                    if (entry != entries.end()) {
+                        Erase(entry);
+                    } else {
+                        names.erase(name);
+                    }
+                }
+            }
+
+            /// Drops the least recently used entries no handle uses until there are at most "capacity". Lock must be held.
+            void Shrink() {
+                std::vector<Entries::iterator> unused;
+                for (auto it = entries.begin(); it != entries.end(); ++it) {
+                    if (it->second.content.use_count() == 1) {
+                        unused.push_back(it);
+                    }
+                }
+                if (unused.size() <= capacity) {
+                    return;
+                }
+                std::sort(unused.begin(), unused.end(), [](Entries::iterator a, Entries::iterator b) {
+                    return a->second.lastUse < b->second.lastUse;
+                });
+                for (size_t i = 0; i < unused.size() - capacity; ++i) {
+                    Erase(unused[i]);
+                }
+            }
+        };
+
+        MappingCache& Cache() {
+            static MappingCache cache;
+            return cache;
+        }
+
+        std::shared_ptr<const ReadFileData> MakeShared(const ReadFileData* content) {
+            return std::shared_ptr<const ReadFileData>(content, [](const ReadFileData* data) { Read_Close(data); });
+        }
+    }
+
+    MappedFile::MappedFile(Filename_t filename, AccessPattern pattern) {
+        if (!File::Identity(filename, identity) || !identity.size) {
+            return;
+        }
+
+        MappingCache& cache = Cache();
+        {
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            cache.ForgetChanged(filename, identity);
+            auto it = cache.entries.find(identity);
+            if (it != cache.entries.end()) {
+                it->second.lastUse = ++cache.clock;
+                content = it->second.content;
+                return;
+            }
+        }
+
+        // Reading is done outside the lock: two threads may read the same file at once, only one is kept.
+        const ReadFileData* read = Read(filename, ReadStrategy::AUTO, pattern);
+        if (!read) {
+            return;
+        }
+        content = MakeShared(read);
+
+        // The file may have changed between "Identity" and "Read": then its contents must not be cached.
+        FileIdentity current;
+        if (!File::Identity(filename, current) || current != identity || read->size != identity.size) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        if (!cache.capacity) {
+            return;
+        }
+        CacheEntry& entry = cache.entries[identity];
+        if (entry.content) {
+            content = entry.content; // Another thread was faster.
+        } else {
+            entry.content = content;
+            entry.filename = filename;
+            cache.names[filename] = identity;
+        }
+        entry.lastUse = ++cache.clock;
+        cache.Shrink();
+    }
+
+    void MappedFile::Close() {
+        content.reset();
+        identity = FileIdentity();
+    }
+
+    void MappedFile::SetCacheCapacity(size_t capacity) {
+        MappingCache& cache = Cache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.capacity = capacity;
+        cache.Shrink();
+    }
+
+    size_t MappedFile::CacheSize() {
+        MappingCache& cache = Cache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        return cache.entries.size();
+    }
+
+    void MappedFile::ClearCache() {
+        MappingCache& cache = Cache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.entries.clear();
+        cache.names.clear();
+    }
+}
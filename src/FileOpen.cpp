@@ -11,12 +11,23 @@
 #endif
 
 namespace File {
-    const ReadFileData* Read(Filename_t filename)
+    ReadStrategy ChooseReadStrategy(Filesize_t size, AccessPattern pattern)
+    {
+        if (size <= READ_STRATEGY_MAX_SIZE) {
+            return ReadStrategy::READ;
+        } else if (pattern == AccessPattern::RANDOM) {
+            return ReadStrategy::MMAP;
+        } else {
+            return ReadStrategy::MMAP_POPULATE;
+        }
+    }
+
+    const ReadFileData* Read(Filename_t filename, ReadStrategy strategy, AccessPattern pattern)
     {
 #ifdef _WIN32
-        return Windows_OpenFile(filename);
+        return Windows_OpenFile(filename, strategy, pattern);
 #else
-        return Unix_OpenFile(filename);
+        return Unix_OpenFile(filename, strategy, pattern);
 #endif
     }
 
@@ -0,0 +1,397 @@
+//
+// File module: normalisation of paths, and canonicalisation with a cache of the resolved directories.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include "MF/FilePath.hpp"
+#include "MF/FileWatcher.hpp"
+#include "TreeHelper.hpp"
+
+#if defined(_WIN32)
+#   include "WindowsAPIHelper.hpp"
+#   define OS_ReadEntry Windows_ReadEntry
+#else
+#   include "UnixAPIHelper.hpp"
+#   define OS_ReadEntry Unix_ReadEntry
+#endif
+
+namespace File {
+
+/////////////////////////////////////////////////////////////////  PRIVATE
+
+//-------------------------------------------------------------- Constants
+
+    constexpr unsigned int PathCache::MAX_LINKS;
+
+//------------------------------------------------------ Private functions
+
+    static bool Path_IsSeparator(SFilename_t::value_type character) {
+        return character == '/' || character == FILE_SEPARATOR[0];
+    }
+
+    static bool Path_IsName(const SFilename_t& path, size_t begin, size_t end, const SFilename_t& name) {
+        return end - begin == name.size() && path.compare(begin, name.size(), name) == 0;
+    }
+
+    /// Length of the root of a path: "/", or "C:" and "C:\", "\\server\share\" and "\" on Windows. 0 if relative.
+    static size_t Path_RootLength(const SFilename_t& path) {
+#if defined(_WIN32)
+        if (path.size() >= 2 && path[1] == ':' && std::isalpha(static_cast<int>(path[0]))) {
+            return path.size() >= 3 && Path_IsSeparator(path[2]) ? 3 : 2;
+        }
+        if (path.size() >= 2 && Path_IsSeparator(path[0]) && Path_IsSeparator(path[1])) {
+            // The server and the share.
+            size_t end = 2;
+            for (int name = 0; name < 2; ++name) {
+                while (end < path.size() && !Path_IsSeparator(path[end])) {
+                    ++end;
+                }
+                end = std::min(end + 1, path.size());
+            }
+            return end;
+        }
+#endif
+        return !path.empty() && Path_IsSeparator(path[0]) ? 1 : 0;
+    }
+
+    /// Root of a path, with FILE_SEPARATOR as separator.
+    static SFilename_t Path_Root(const SFilename_t& path, size_t rootLength) {
+        SFilename_t root = path.substr(0, rootLength);
+        for (SFilename_t::value_type& character : root) {
+            if (Path_IsSeparator(character)) {
+                character = FILE_SEPARATOR[0];
+            }
+        }
+        return root;
+    }
+
+    /// A name resolved in a canonical directory.
+    struct Path_Entry {
+        bool link; // Symbolic link to a directory, rather than a directory.
+        SFilename_t target; // Canonical path of a link, ending with a separator.
+    };
+
+/////////////////////////////////////////////////////////////////  PUBLIC
+
+//------------------------------------------------------------------ State
+
+    struct PathCache::State {
+        SFilename_t base; // Working directory, ending with a separator.
+        std::map<SFilename_t, Path_Entry> names; // By canonical path of their directory followed by the name.
+        size_t linkCount = 0; // Links of "names".
+        std::unordered_map<SFilename_t, SFilename_t> directories; // Canonical path, by absolute path as given.
+        std::set<SFilename_t> watched; // Canonical directories, ending with a separator.
+        bool unwatched = false; // Set when a resolution used a name which could not be kept.
+        uint64_t lookups = 0;
+        SFilename_t path; // Reused by "Canonicalize".
+
+        // Changes from the thread of the watcher.
+        std::mutex changesMutex;
+        std::vector<SFilename_t> changed;
+        bool lost = false;
+        std::atomic<bool> pending{false};
+
+        std::unique_ptr<Watcher> watcher; // Last: stopped before the rest is destroyed.
+
+        /// Called by the thread of the watcher.
+        void Record(const std::vector<Change>& changes) {
+            std::lock_guard<std::mutex> lock(changesMutex);
+            for (const Change& change : changes) {
+                if (change.type == ChangeType::LOST) {
+                    lost = true;
+                    continue;
+                }
+                changed.push_back(change.name);
+                if (!change.oldName.empty()) {
+                    changed.push_back(change.oldName);
+                }
+            }
+            pending.store(true, std::memory_order_release);
+        }
+
+        /// Forgets a name, and the names resolved below it. @return True if anything was forgotten.
+        bool Forget(SFilename_t name) {
+            if (!name.empty() && Path_IsSeparator(name.back())) {
+                name.pop_back(); // A watched directory, deleted.
+            }
+            bool forgotten = false;
+            const auto exact = names.find(name);
+            if (exact != names.end()) {
+                linkCount -= exact->second.link;
+                names.erase(exact);
+                forgotten = true;
+            }
+            const SFilename_t prefix = name + FILE_SEPARATOR;
+            auto it = names.lower_bound(prefix);
+            while (it != names.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+                linkCount -= it->second.link;
+                it = names.erase(it);
+                forgotten = true;
+            }
+            // A directory created again under the same name is another one, to be watched again.
+            auto watch = watched.lower_bound(prefix);
+            while (watch != watched.end() && watch->compare(0, prefix.size(), prefix) == 0) {
+                watch = watched.erase(watch);
+            }
+            return forgotten;
+        }
+
+        /// Applies the changes recorded since the previous call.
+        void Update() {
+            std::vector<SFilename_t> changes;
+            bool wasLost;
+            {
+                std::lock_guard<std::mutex> lock(changesMutex);
+                changes.swap(changed);
+                wasLost = lost;
+                lost = false;
+                pending.store(false, std::memory_order_relaxed);
+            }
+            if (wasLost) {
+                Clear();
+                return;
+            }
+            bool forgotten = false;
+            for (const SFilename_t& name : changes) {
+                forgotten = Forget(name) || forgotten;
+            }
+            if (forgotten) {
+                // Anything may have been resolved through the names forgotten: links, and the paths given.
+                directories.clear();
+                for (auto it = names.begin(); linkCount && it != names.end(); ) {
+                    if (it->second.link) {
+                        --linkCount;
+                        it = names.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+        }
+
+        void Clear() {
+            names.clear();
+            linkCount = 0;
+            directories.clear();
+            watched.clear();
+        }
+
+        /// Watches a canonical directory, before resolving names in it. @return False if it cannot be watched.
+        bool Watch(const SFilename_t& directory) {
+            if (!watcher) {
+                return false;
+            }
+            if (watched.count(directory)) {
+                return true;
+            }
+            if (!watcher->Add(directory.c_str())) {
+                return false;
+            }
+            watched.insert(directory);
+            return true;
+        }
+
+        /**
+         * Resolves every name of an absolute path as a directory.
+         * @param canonical Filled with the canonical path, ending with a separator.
+         * @param links Number of links followed so far.
+         */
+        bool Resolve(const SFilename_t& absolute, SFilename_t& canonical, unsigned int& links) {
+            const size_t rootLength = Path_RootLength(absolute);
+            canonical = Path_Root(absolute, rootLength);
+            size_t begin = rootLength;
+            while (begin < absolute.size()) {
+                size_t end = begin;
+                while (end < absolute.size() && !Path_IsSeparator(absolute[end])) {
+                    ++end;
+                }
+                const size_t nameBegin = begin;
+                begin = end + 1;
+                if (end == nameBegin || Path_IsName(absolute, nameBegin, end, MAKE_FILE_NAME ".")) {
+                    continue;
+                }
+                if (Path_IsName(absolute, nameBegin, end, MAKE_FILE_NAME "..")) {
+                    // The directory is canonical: its parent is lexical.
+                    if (canonical.size() > rootLength) {
+                        canonical.erase(canonical.find_last_of(FILE_SEPARATOR[0], canonical.size() - 2) + 1);
+                    }
+                    continue;
+                }
+
+                SFilename_t name = canonical;
+                name.append(absolute, nameBegin, end - nameBegin);
+                const auto known = names.find(name);
+                if (known != names.end()) {
+                    canonical = known->second.link ? known->second.target : name + FILE_SEPARATOR;
+                    continue;
+                }
+
+                const bool keep = Watch(canonical);
+                unwatched = unwatched || !keep;
+                ++lookups;
+                Tree_EntryType type;
+                Path_Entry entry{false, SFilename_t()};
+                if (!OS_ReadEntry(name.c_str(), type, entry.target)) {
+                    return false;
+                }
+                if (type == Tree_EntryType::SYMLINK) {
+                    if (++links > MAX_LINKS) {
+                        return false;
+                    }
+                    // A relative target starts from the directory of the link.
+                    const SFilename_t target = Path_RootLength(entry.target) ? entry.target : canonical + entry.target;
+                    if (!Resolve(target, entry.target, links)) {
+                        return false;
+                    }
+                    entry.link = true;
+                    canonical = entry.target;
+                } else if (type == Tree_EntryType::DIRECTORY) {
+                    entry.target.clear();
+                    canonical = name + FILE_SEPARATOR;
+                } else {
+                    return false;
+                }
+                if (keep) {
+                    linkCount += entry.link;
+                    names.emplace(std::move(name), std::move(entry));
+                }
+            }
+            return true;
+        }
+    };
+
+//------------------------------------------------------- Public functions
+
+    bool IsAbsolutePath(const SFilename_t& path) {
+        const size_t rootLength = Path_RootLength(path);
+#if defined(_WIN32)
+        // "\" and "C:" depend on the current drive or directory.
+        return rootLength > 1 && Path_IsSeparator(path[rootLength - 1]);
+#else
+        return rootLength != 0;
+#endif
+    }
+
+    SFilename_t NormalizePath(const SFilename_t& path) {
+        if (path.empty()) {
+            return path;
+        }
+        const size_t rootLength = Path_RootLength(path);
+        const bool rooted = rootLength && Path_IsSeparator(path[rootLength - 1]);
+
+        // Names as [begin, end) in "path".
+        std::vector<std::pair<size_t, size_t>> kept;
+        size_t begin = rootLength;
+        while (begin < path.size()) {
+            size_t end = begin;
+            while (end < path.size() && !Path_IsSeparator(path[end])) {
+                ++end;
+            }
+            if (end == begin || Path_IsName(path, begin, end, MAKE_FILE_NAME ".")) {
+                // Nothing.
+            } else if (Path_IsName(path, begin, end, MAKE_FILE_NAME "..")) {
+                if (!kept.empty() && !Path_IsName(path, kept.back().first, kept.back().second, MAKE_FILE_NAME "..")) {
+                    kept.pop_back();
+                } else if (!rooted) {
+                    kept.emplace_back(begin, end);
+                }
+            } else {
+                kept.emplace_back(begin, end);
+            }
+            begin = end + 1;
+        }
+
+        SFilename_t normalized = Path_Root(path, rootLength);
+        for (size_t i = 0; i < kept.size(); ++i) {
+            if (i) {
+                normalized += FILE_SEPARATOR;
+            }
+            normalized.append(path, kept[i].first, kept[i].second - kept[i].first);
+        }
+        if (normalized.empty()) {
+            normalized = MAKE_FILE_NAME ".";
+        }
+        if (Path_IsSeparator(path.back()) && !Path_IsSeparator(normalized.back())) {
+            normalized += FILE_SEPARATOR;
+        }
+        return normalized;
+    }
+
+    PathCache::PathCache() : state(new State) {
+        state->base = Tree_AsDirectory(GetCWD().c_str());
+        WatcherOptions options;
+        options.coalesceMs = 0; // Forgotten as soon as possible, nothing to batch.
+        State* const cacheState = state.get();
+        state->watcher.reset(new Watcher([cacheState](const std::vector<Change>& changes) {
+            cacheState->Record(changes);
+        }, options));
+        if (!state->watcher->IsValid()) {
+            state->watcher.reset();
+        }
+    }
+
+    PathCache::~PathCache() = default;
+
+    bool PathCache::IsCaching() const {
+        return state->watcher != nullptr;
+    }
+
+    bool PathCache::Canonicalize(const SFilename_t& path, SFilename_t& canonical) {
+        if (state->pending.load(std::memory_order_acquire)) {
+            state->Update();
+        }
+        if (path.empty()) {
+            return false;
+        }
+        SFilename_t& absolute = state->path;
+        if (IsAbsolutePath(path)) {
+            absolute = path;
+        } else {
+            absolute = state->base;
+            absolute += path;
+        }
+
+        // The directory, and the last name unless it is a directory too.
+        size_t nameBegin = absolute.size();
+        while (nameBegin > 0 && !Path_IsSeparator(absolute[nameBegin - 1])) {
+            --nameBegin;
+        }
+        if (Path_IsName(absolute, nameBegin, absolute.size(), MAKE_FILE_NAME ".")
+            || Path_IsName(absolute, nameBegin, absolute.size(), MAKE_FILE_NAME "..")) {
+            nameBegin = absolute.size();
+        }
+        canonical.assign(absolute, nameBegin, SFilename_t::npos);
+        absolute.resize(nameBegin);
+
+        const auto known = state->directories.find(absolute);
+        if (known != state->directories.end()) {
+            canonical.insert(0, known->second);
+            return true;
+        }
+        SFilename_t directory;
+        unsigned int links = 0;
+        state->unwatched = false;
+        if (!state->Resolve(absolute, directory, links)) {
+            return false;
+        }
+        canonical.insert(0, directory);
+        if (!state->unwatched) {
+            state->directories.emplace(absolute, std::move(directory));
+        }
+        return true;
+    }
+
+    void PathCache::Clear() {
+        state->Clear();
+    }
+
+    uint64_t PathCache::LookupCount() const {
+        return state->lookups;
+    }
+}
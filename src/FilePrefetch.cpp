@@ -0,0 +1,150 @@
+//
+// File module: reading of the next files of a batch into the page cache, ahead of their use.
+//
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#if Threads_FOUND
+#   include <thread>
+#endif
+#include "MF/FilePrefetch.hpp"
+
+#if defined(_WIN32)
+#   include "WindowsAPIHelper.hpp"
+using OSPrefetchedFile_t = Windows_PrefetchedFile;
+#   define OS_PrefetchFile Windows_PrefetchFile
+#   define OS_ReleasePrefetchedFile Windows_ReleasePrefetchedFile
+#else
+#   include "UnixAPIHelper.hpp"
+using OSPrefetchedFile_t = Unix_PrefetchedFile;
+#   define OS_PrefetchFile Unix_PrefetchFile
+#   define OS_ReleasePrefetchedFile Unix_ReleasePrefetchedFile
+#endif
+
+namespace File {
+    struct Prefetcher::State {
+        /// A file of the window.
+        struct InFlight {
+            size_t index;
+            OSPrefetchedFile_t* file;
+            Filesize_t length; // Number of bytes asked for.
+        };
+
+        std::vector<SFilename_t> filenames;
+        PrefetchOptions options;
+#if Threads_FOUND
+        std::thread thread;
+#endif
+
+        mutable std::mutex mutex;
+        std::condition_variable moved; // Notified when the consumer moves or the prefetcher stops.
+        size_t consumer = 0; // Index of the file being consumed.
+        size_t next = 0; // Index of the next file to prefetch.
+        std::deque<InFlight> inFlight; // Prefetched files not released yet, by index.
+        Filesize_t bytesInFlight = 0; // Bytes asked for the files of "inFlight".
+        size_t prefetched = 0;
+        bool stopping = false;
+
+        /**
+         * Releases the files before the consumer, then prefetches the next ones until the window is full.
+         * The system calls are made without the mutex, so that "Consume" never waits for them.
+         */
+        void Advance(std::unique_lock<std::mutex>& lock) {
+            while (!stopping) {
+                if (!inFlight.empty() && inFlight.front().index < consumer) {
+                    const InFlight done = inFlight.front();
+                    inFlight.pop_front();
+                    bytesInFlight -= done.length;
+                    lock.unlock();
+                    OS_ReleasePrefetchedFile(done.file, options.dropBehind);
+                    lock.lock();
+                    continue;
+                }
+
+                next = std::max(next, consumer);
+                if (next >= filenames.size() || inFlight.size() >= options.windowFiles ||
+                    bytesInFlight >= options.windowBytes) {
+                    return;
+                }
+                const size_t index = next++;
+                Filesize_t length = options.windowBytes - bytesInFlight;
+                lock.unlock();
+                OSPrefetchedFile_t* file = OS_PrefetchFile(filenames[index].c_str(), length);
+                lock.lock();
+                if (file) {
+                    inFlight.push_back({index, file, length});
+                    bytesInFlight += length;
+                    ++prefetched;
+                }
+            }
+        }
+
+#if Threads_FOUND
+        void Run() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopping) {
+                Advance(lock);
+                moved.wait(lock, [this]() {
+                    return stopping || (!inFlight.empty() && inFlight.front().index < consumer) ||
+                           (std::max(next, consumer) < filenames.size() && inFlight.size() < options.windowFiles &&
+                            bytesInFlight < options.windowBytes);
+                });
+            }
+        }
+#endif
+    };
+
+    Prefetcher::Prefetcher(std::vector<SFilename_t> filenames, const PrefetchOptions& options) :
+            state(new State)
+    {
+        state->filenames = std::move(filenames);
+        state->options = options;
+        state->options.windowFiles = std::max<size_t>(state->options.windowFiles, 1);
+        state->options.windowBytes = std::max<Filesize_t>(state->options.windowBytes, 1);
+#if Threads_FOUND
+        state->thread = std::thread(&State::Run, state.get());
+#else
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->Advance(lock);
+#endif
+    }
+
+    Prefetcher::~Prefetcher() {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->stopping = true;
+        }
+        state->moved.notify_one();
+#if Threads_FOUND
+        state->thread.join();
+#endif
+        for (const State::InFlight& file : state->inFlight) {
+            OS_ReleasePrefetchedFile(file.file, state->options.dropBehind && file.index < state->consumer);
+        }
+    }
+
+    void Prefetcher::Consume(size_t index) {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        if (index <= state->consumer) {
+            return;
+        }
+        state->consumer = std::min(index, state->filenames.size());
+#if Threads_FOUND
+        lock.unlock();
+        state->moved.notify_one();
+#else
+        state->Advance(lock);
+#endif
+    }
+
+    size_t Prefetcher::FileCount() const {
+        return state->filenames.size();
+    }
+
+    size_t Prefetcher::PrefetchedCount() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->prefetched;
+    }
+}
@@ -0,0 +1,379 @@
+//
+// File module: search of substrings in big buffers, by several threads.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include "MF/FileSearch.hpp"
+#include "ParallelHelper.hpp"
+#include "SimdHelper.hpp"
+
+namespace File {
+
+/////////////////////////////////////////////////////////////////  PRIVATE
+
+//-------------------------------------------------------------- Constants
+
+    // Parts of the buffer searched by each job: big enough that a job costs much more than handing it out.
+    constexpr static Filesize_t SEARCH_CHUNK_SIZE = 4ul << 20;
+
+    // Set in a transition of the automaton when the next state ends at least one pattern.
+    constexpr static uint32_t SEARCH_OUTPUT_FLAG = 1u << 31;
+
+    // Marks a missing transition while the trie is built.
+    constexpr static uint32_t SEARCH_NO_STATE = UINT32_MAX;
+
+//------------------------------------------------------ Private functions
+
+    /// Appends the offsets in [begin, end) where "pattern" starts to "offsets". The pattern must fit after "end - 1".
+    static void FindOne_Scalar(const char* contents, Filesize_t begin, Filesize_t end, const std::string& pattern,
+                               std::vector<Filesize_t>& offsets) {
+        const char* p = contents + begin;
+        const char* const last = contents + end;
+        while (p < last) {
+            auto found = static_cast<const char*>(std::memchr(p, pattern.front(), last - p));
+            if (!found) {
+                break;
+            }
+            if (std::memcmp(found + 1, pattern.data() + 1, pattern.size() - 1) == 0) {
+                offsets.push_back(found - contents);
+            }
+            p = found + 1;
+        }
+    }
+
+#if defined(MF_SIMD_X86)
+    // Compares the first byte of the pattern to 16 positions, and its last byte to the 16 positions "length - 1" further:
+    // the pattern is compared only where both match, which is rare unless the text is made of the pattern's bytes.
+    static void FindOne_SSE2(const char* contents, Filesize_t begin, Filesize_t end, const std::string& pattern,
+                             std::vector<Filesize_t>& offsets) {
+        const size_t length = pattern.size();
+        const __m128i first = _mm_set1_epi8(pattern.front());
+        const __m128i last = _mm_set1_epi8(pattern.back());
+        Filesize_t i = begin;
+        for (; i + 16 <= end; i += 16) {
+            const __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(contents + i));
+            const __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(contents + i + length - 1));
+            const __m128i both = _mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last));
+            for (auto mask = static_cast<uint32_t>(_mm_movemask_epi8(both)); mask; mask &= mask - 1) {
+                const Filesize_t offset = i + Simd_LowestBit(mask);
+                if (length <= 2 || std::memcmp(contents + offset + 1, pattern.data() + 1, length - 2) == 0) {
+                    offsets.push_back(offset);
+                }
+            }
+        }
+        FindOne_Scalar(contents, i, end, pattern, offsets);
+    }
+
+    MF_TARGET_AVX2 static void FindOne_AVX2(const char* contents, Filesize_t begin, Filesize_t end, const std::string& pattern,
+                                            std::vector<Filesize_t>& offsets) {
+        const size_t length = pattern.size();
+        const __m256i first = _mm256_set1_epi8(pattern.front());
+        const __m256i last = _mm256_set1_epi8(pattern.back());
+        Filesize_t i = begin;
+        for (; i + 32 <= end; i += 32) {
+            const __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(contents + i));
+            const __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(contents + i + length - 1));
+            const __m256i both = _mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last));
+            for (auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(both)); mask; mask &= mask - 1) {
+                const Filesize_t offset = i + Simd_LowestBit(mask);
+                if (length <= 2 || std::memcmp(contents + offset + 1, pattern.data() + 1, length - 2) == 0) {
+                    offsets.push_back(offset);
+                }
+            }
+        }
+        FindOne_Scalar(contents, i, end, pattern, offsets);
+    }
+#endif
+
+    /// True if a pattern may begin at "text": see "Searcher::startPairs".
+    static inline bool StartsPattern(const uint64_t* startPairs, const uint8_t* text) {
+        return startPairs[text[0] * 4 + text[1] / 64] >> (text[1] % 64) & 1;
+    }
+
+    /// First position in [i, last) where a pattern may begin, or "last". The byte at "last" must be readable.
+    static Filesize_t SkipToStart_Scalar(const uint8_t* text, Filesize_t i, Filesize_t last, const uint64_t* startPairs) {
+        while (i < last && !StartsPattern(startPairs, text + i)) {
+            ++i;
+        }
+        return i;
+    }
+
+#if defined(MF_SIMD_X86)
+    // Looks up the buckets of 32 first bytes and of the 32 following bytes with shuffles of the nibble tables:
+    // a position is checked against "startPairs" only if its two bytes share a bucket, which is rare in usual text.
+    MF_TARGET_AVX2 static Filesize_t SkipToStart_AVX2(const uint8_t* text, Filesize_t i, Filesize_t last, const uint64_t* startPairs,
+                                                      const uint8_t (*startNibbles)[16]) {
+        const __m256i firstLow = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(startNibbles[0])));
+        const __m256i firstHigh = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(startNibbles[1])));
+        const __m256i secondLow = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(startNibbles[2])));
+        const __m256i secondHigh = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(startNibbles[3])));
+        const __m256i lowNibble = _mm256_set1_epi8(0x0F);
+        for (; i + 32 <= last; i += 32) {
+            const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+            const __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + 1));
+            const __m256i firstBuckets = _mm256_and_si256(_mm256_shuffle_epi8(firstLow, _mm256_and_si256(first, lowNibble)),
+                    _mm256_shuffle_epi8(firstHigh, _mm256_and_si256(_mm256_srli_epi16(first, 4), lowNibble)));
+            const __m256i secondBuckets = _mm256_and_si256(_mm256_shuffle_epi8(secondLow, _mm256_and_si256(second, lowNibble)),
+                    _mm256_shuffle_epi8(secondHigh, _mm256_and_si256(_mm256_srli_epi16(second, 4), lowNibble)));
+            const __m256i both = _mm256_and_si256(firstBuckets, secondBuckets);
+            auto mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(both, _mm256_setzero_si256())));
+            for (; mask; mask &= mask - 1) {
+                const Filesize_t position = i + Simd_LowestBit(mask);
+                if (StartsPattern(startPairs, text + position)) {
+                    return position;
+                }
+            }
+        }
+        return SkipToStart_Scalar(text, i, last, startPairs);
+    }
+#endif
+
+    /// Appends the offsets of the occurrences of "pattern" (not empty) which begin in [begin, end) to "offsets".
+    static void FindOne(const char* contents, Filesize_t begin, Filesize_t end, Filesize_t size, const std::string& pattern,
+                        std::vector<Filesize_t>& offsets) {
+        end = std::min(end, size - pattern.size() + 1);
+#if defined(MF_SIMD_X86)
+        if (Simd_HasAVX2()) {
+            FindOne_AVX2(contents, begin, end, pattern, offsets);
+        } else {
+            FindOne_SSE2(contents, begin, end, pattern, offsets);
+        }
+#else
+        FindOne_Scalar(contents, begin, end, pattern, offsets);
+#endif
+    }
+
+    /**
+     * Cuts [0, size) into chunks searched in parallel by "search(begin, end, matches)", which appends the matches
+     * beginning in [begin, end) in order.
+     * @return The matches of all the chunks, in order.
+     */
+    template <typename Match>
+    static std::vector<Match> FindInChunks(Filesize_t size, unsigned int threads,
+                                           const std::function<void(Filesize_t, Filesize_t, std::vector<Match>&)>& search) {
+        const size_t chunkCount = static_cast<size_t>((size + SEARCH_CHUNK_SIZE - 1) / SEARCH_CHUNK_SIZE);
+        std::vector<std::vector<Match>> chunkMatches(chunkCount);
+        Parallel_For(chunkCount, Parallel_ThreadCount(threads), [size, &search, &chunkMatches](size_t chunk) {
+            const Filesize_t begin = chunk * SEARCH_CHUNK_SIZE;
+            search(begin, std::min(begin + SEARCH_CHUNK_SIZE, size), chunkMatches[chunk]);
+        });
+        if (chunkCount == 1) {
+            return std::move(chunkMatches.front());
+        }
+
+        size_t total = 0;
+        for (const std::vector<Match>& chunk : chunkMatches) {
+            total += chunk.size();
+        }
+        std::vector<Match> matches;
+        matches.reserve(total);
+        for (const std::vector<Match>& chunk : chunkMatches) {
+            matches.insert(matches.end(), chunk.begin(), chunk.end());
+        }
+        return matches;
+    }
+
+//////////////////////////////////////////////////////////////////  PUBLIC
+//------------------------------------------------------- Public functions
+
+    Searcher::Searcher(const std::string& pattern) :
+            Searcher(std::vector<std::string>(1, pattern))
+    {}
+
+    Searcher::Searcher(const std::vector<std::string>& patterns) :
+            patterns(patterns)
+    {
+        for (const std::string& pattern : patterns) {
+            longest = std::max(longest, pattern.size());
+        }
+        if (patterns.size() < 2 || !longest) {
+            return; // One pattern is searched directly.
+        }
+
+        // Bytes which appear in the patterns get their own class, all the others share class 0
+        // (unless all the 256 bytes appear in the patterns).
+        bool used[256] = {};
+        size_t usedCount = 0;
+        for (const std::string& pattern : patterns) {
+            for (char c : pattern) {
+                usedCount += !used[static_cast<uint8_t>(c)];
+                used[static_cast<uint8_t>(c)] = true;
+            }
+        }
+        classCount = usedCount < 256 ? 1 : 0;
+        for (size_t byte = 0; byte < 256; ++byte) {
+            if (used[byte]) {
+                classes[byte] = static_cast<uint8_t>(classCount++);
+            }
+        }
+
+        // Filters of the first two bytes. The patterns are spread in buckets by their first byte, so that the bytes
+        // of different patterns mix as little as possible; a pattern of one byte accepts any second byte.
+        startPairs.assign(256 * 256 / 64, 0);
+        for (const std::string& pattern : patterns) {
+            if (pattern.empty()) {
+                continue;
+            }
+            const auto first = static_cast<uint8_t>(pattern[0]);
+            const uint8_t bucket = 1u << (first % 8);
+            startNibbles[0][first % 16] |= bucket;
+            startNibbles[1][first / 16] |= bucket;
+            for (size_t second = 0; second < 256; ++second) {
+                if (pattern.size() == 1 || static_cast<uint8_t>(pattern[1]) == second) {
+                    startPairs[first * 4 + second / 64] |= uint64_t(1) << (second % 64);
+                    startNibbles[2][second % 16] |= bucket;
+                    startNibbles[3][second / 16] |= bucket;
+                }
+            }
+        }
+
+        // Trie of the patterns.
+        std::vector<std::vector<uint32_t>> stateOutputs(1);
+        transitions.assign(classCount, SEARCH_NO_STATE);
+        for (size_t index = 0; index < patterns.size(); ++index) {
+            if (patterns[index].empty()) {
+                continue;
+            }
+            uint32_t state = 0;
+            for (char c : patterns[index]) {
+                uint32_t& next = transitions[state * classCount + classes[static_cast<uint8_t>(c)]];
+                if (next == SEARCH_NO_STATE) {
+                    next = static_cast<uint32_t>(stateOutputs.size());
+                    stateOutputs.emplace_back();
+                    transitions.resize(transitions.size() + classCount, SEARCH_NO_STATE);
+                }
+                state = transitions[state * classCount + classes[static_cast<uint8_t>(c)]];
+            }
+            stateOutputs[state].push_back(static_cast<uint32_t>(index));
+        }
+
+        // Failure links, in breadth-first order so that the link of a state is complete before the state is visited.
+        // Missing transitions are replaced by those of the failure state, which turns the trie into a deterministic automaton,
+        // and each state inherits the patterns of its failure state (they are suffixes of its own string).
+        std::vector<uint32_t> failure(stateOutputs.size(), 0);
+        std::deque<uint32_t> queue;
+        for (size_t c = 0; c < classCount; ++c) {
+            uint32_t& next = transitions[c];
+            if (next == SEARCH_NO_STATE) {
+                next = 0;
+            } else {
+                queue.push_back(next);
+            }
+        }
+        while (!queue.empty()) {
+            const uint32_t state = queue.front();
+            queue.pop_front();
+            const std::vector<uint32_t>& inherited = stateOutputs[failure[state]];
+            stateOutputs[state].insert(stateOutputs[state].end(), inherited.begin(), inherited.end());
+            for (size_t c = 0; c < classCount; ++c) {
+                uint32_t& next = transitions[state * classCount + c];
+                const uint32_t fallback = transitions[failure[state] * classCount + c];
+                if (next == SEARCH_NO_STATE) {
+                    next = fallback;
+                } else {
+                    failure[next] = fallback;
+                    queue.push_back(next);
+                }
+            }
+        }
+
+        outputBegin.reserve(stateOutputs.size() + 1);
+        for (const std::vector<uint32_t>& stateOutput : stateOutputs) {
+            outputBegin.push_back(static_cast<uint32_t>(outputs.size()));
+            outputs.insert(outputs.end(), stateOutput.begin(), stateOutput.end());
+        }
+        outputBegin.push_back(static_cast<uint32_t>(outputs.size()));
+
+        // Transitions hold the index of the row of the next state, which saves a multiplication per byte,
+        // and are flagged when the next state ends a pattern.
+        for (uint32_t& next : transitions) {
+            const bool output = outputBegin[next] != outputBegin[next + 1];
+            next = static_cast<uint32_t>(next * classCount) | (output ? SEARCH_OUTPUT_FLAG : 0);
+        }
+    }
+
+    void Searcher::FindMany(const char* contents, Filesize_t begin, Filesize_t end, Filesize_t size,
+                            std::vector<SearchMatch>& matches) const {
+        // The automaton starts early enough to see the whole of the patterns beginning at "begin",
+        // and goes on until the patterns beginning just before "end" are complete.
+        const Filesize_t from = begin < longest - 1 ? 0 : begin - (longest - 1);
+        const Filesize_t to = std::min<Filesize_t>(end + longest - 1, size);
+        const size_t firstMatch = matches.size();
+        const uint32_t* const table = transitions.data();
+        const uint8_t* const text = reinterpret_cast<const uint8_t*>(contents);
+        const Filesize_t lastPair = std::min<Filesize_t>(to, size - 1); // The last byte has no second byte to check.
+#if defined(MF_SIMD_X86)
+        const bool avx2 = Simd_HasAVX2();
+#endif
+        uint32_t state = 0;
+        for (Filesize_t i = from; i < to; ++i) {
+            if (!state) {
+                // No pattern is partially matched: the positions where none begins can be skipped.
+#if defined(MF_SIMD_X86)
+                i = avx2 ? SkipToStart_AVX2(text, i, lastPair, startPairs.data(), startNibbles)
+                         : SkipToStart_Scalar(text, i, lastPair, startPairs.data());
+#else
+                i = SkipToStart_Scalar(text, i, lastPair, startPairs.data());
+#endif
+                if (i == to) {
+                    break;
+                }
+            }
+            state = table[state + classes[text[i]]];
+            if (state & SEARCH_OUTPUT_FLAG) {
+                state &= ~SEARCH_OUTPUT_FLAG;
+                const size_t index = state / classCount;
+                for (uint32_t k = outputBegin[index]; k < outputBegin[index + 1]; ++k) {
+                    const Filesize_t offset = i + 1 - patterns[outputs[k]].size();
+                    if (offset >= begin && offset < end) {
+                        matches.push_back({offset, outputs[k]});
+                    }
+                }
+            }
+        }
+
+        // Patterns are found by their end: short ones may be found after longer ones which begin earlier.
+        std::sort(matches.begin() + firstMatch, matches.end(), [](const SearchMatch& a, const SearchMatch& b) {
+            return a.offset < b.offset || (a.offset == b.offset && a.pattern < b.pattern);
+        });
+    }
+
+    std::vector<SearchMatch> Searcher::Find(const char* contents, Filesize_t size, unsigned int threads) const {
+        if (!contents || !longest || size < (patterns.size() > 1 ? 1 : longest)) {
+            return std::vector<SearchMatch>();
+        } else if (patterns.size() > 1) {
+            return FindInChunks<SearchMatch>(size, threads, [this, contents, size](Filesize_t begin, Filesize_t end, std::vector<SearchMatch>& matches) {
+                FindMany(contents, begin, end, size, matches);
+            });
+        }
+
+        const std::string& pattern = patterns.front();
+        const std::vector<Filesize_t> offsets = FindInChunks<Filesize_t>(size, threads, [contents, size, &pattern](Filesize_t begin, Filesize_t end, std::vector<Filesize_t>& chunkOffsets) {
+            FindOne(contents, begin, end, size, pattern, chunkOffsets);
+        });
+        std::vector<SearchMatch> matches;
+        matches.reserve(offsets.size());
+        for (Filesize_t offset : offsets) {
+            matches.push_back({offset, 0});
+        }
+        return matches;
+    }
+
+    std::vector<Filesize_t> Search(const ReadFileData* content, const std::string& pattern, unsigned int threads) {
+        if (!content || !content->contents || pattern.empty() || content->size < pattern.size()) {
+            return std::vector<Filesize_t>();
+        }
+        const char* const contents = content->contents;
+        const Filesize_t size = content->size;
+        return FindInChunks<Filesize_t>(size, threads, [contents, size, &pattern](Filesize_t begin, Filesize_t end, std::vector<Filesize_t>& offsets) {
+            FindOne(contents, begin, end, size, pattern, offsets);
+        });
+    }
+
+    std::vector<SearchMatch> Search(const ReadFileData* content, const std::vector<std::string>& patterns, unsigned int threads) {
+        return content ? Searcher(patterns).Find(content, threads) : std::vector<SearchMatch>();
+    }
+}
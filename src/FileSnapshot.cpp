@@ -0,0 +1,315 @@
+//
+// File module: snapshots of directory trees, and differences between two of them.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include "MF/FileSnapshot.hpp"
+#include "MF/FileOpen.hpp"
+#include "MF/FileWriter.hpp"
+#include "HashHelper.hpp"
+#include "ParallelHelper.hpp"
+#include "TreeHelper.hpp"
+
+namespace File {
+
+/////////////////////////////////////////////////////////////////  PRIVATE
+
+//-------------------------------------------------------------- Constants
+
+    /// First bytes of a snapshot file. The count of entries follows, then the entries, then the XXH64 of all that.
+    constexpr static char SNAPSHOT_MAGIC[8] = {'M', 'F', 'S', 'N', 'A', 'P', '0', '1'};
+    constexpr static size_t SNAPSHOT_CHECKSUM_SIZE = sizeof(uint64_t);
+    /// Bit of the type byte of an entry telling that a hash follows.
+    constexpr static uint8_t SNAPSHOT_HASHED = 0x80;
+    constexpr static size_t SNAPSHOT_UNIT_SIZE = sizeof(SFilename_t::value_type);
+
+//------------------------------------------------------ Private functions
+
+    static bool Snapshot_PathLess(const SnapshotEntry& entry, const SFilename_t& path) {
+        return entry.path < path;
+    }
+
+    static bool Snapshot_SameMetadata(const SnapshotEntry& a, const SnapshotEntry& b) {
+        return a.type == b.type && a.inode == b.inode && a.size == b.size && a.mtimeNs == b.mtimeNs;
+    }
+
+    static StatType Snapshot_Type(Tree_EntryType type) {
+        switch (type) {
+            case Tree_EntryType::FILE: return StatType::FILE;
+            case Tree_EntryType::DIRECTORY: return StatType::DIRECTORY;
+            case Tree_EntryType::SYMLINK: return StatType::SYMLINK;
+            default: return StatType::OTHER;
+        }
+    }
+
+    static void Snapshot_PutVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    static bool Snapshot_GetVarint(const char*& position, const char* end, uint64_t& value) {
+        value = 0;
+        for (unsigned int shift = 0; shift < 64 && position < end; shift += 7) {
+            const uint8_t byte = static_cast<uint8_t>(*position++);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Modification times are signed: zigzag keeps the small negative ones short.
+    static uint64_t Snapshot_ZigZag(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    static int64_t Snapshot_UnZigZag(uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    static bool Snapshot_HashFile(const SFilename_t& name, Filesize_t size, uint64_t& hash) {
+        const ReadFileData* content = Read(name.c_str());
+        if (!content) {
+            return false;
+        }
+        const bool success = content->size == size;
+        if (success) {
+            hash = Hash_XXH64(content->contents, size);
+        }
+        Read_Close(content);
+        return success;
+    }
+
+/////////////////////////////////////////////////////////////////  PUBLIC
+
+//------------------------------------------------------- Public functions
+
+    const SnapshotEntry* TreeSnapshot::Find(const SFilename_t& path) const {
+        const auto found = std::lower_bound(entries.begin(), entries.end(), path, Snapshot_PathLess);
+        return found != entries.end() && found->path == path ? &*found : nullptr;
+    }
+
+    TreeSnapshot SnapshotTree(Filename_t root, const SnapshotOptions& options, const TreeSnapshot* previous) {
+        TreeSnapshot snapshot;
+        const unsigned int threads = Parallel_ThreadCount(options.threads);
+        const SFilename_t prefix = Tree_AsDirectory(root);
+
+        // Listing: the directories are walked in order by the calling thread, with paths relative to the root.
+        std::vector<SnapshotEntry>& entries = snapshot.entries;
+        std::vector<SFilename_t> directories(1);
+        std::vector<Tree_Entry> listed;
+        for (size_t i = 0; i < directories.size(); ++i) {
+            const SFilename_t directory = directories[i];
+            listed.clear();
+            if (!Tree_ListDirectory((prefix + directory).c_str(), listed)) {
+                ++snapshot.failures;
+                continue;
+            }
+            for (Tree_Entry& entry : listed) {
+                SnapshotEntry added;
+                added.path = directory + entry.name;
+                added.type = Snapshot_Type(entry.type);
+                if (entry.type == Tree_EntryType::DIRECTORY) {
+                    directories.push_back(added.path + FILE_SEPARATOR);
+                }
+                entries.push_back(std::move(added));
+            }
+        }
+        std::sort(entries.begin(), entries.end(), [](const SnapshotEntry& a, const SnapshotEntry& b) {
+            return a.path < b.path;
+        });
+
+        // Metadata: one stat per entry, in parallel. Entries removed since they were listed are dropped.
+        std::vector<SFilename_t> paths;
+        paths.reserve(entries.size());
+        for (const SnapshotEntry& entry : entries) {
+            paths.push_back(prefix + entry.path);
+        }
+        const StatResult stats = StatMany(paths, STAT_SIZE | STAT_MTIME | STAT_INODE, threads, false);
+        size_t kept = 0;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (!stats.Exists(i)) {
+                continue;
+            }
+            SnapshotEntry& entry = entries[kept];
+            if (kept != i) {
+                entry = std::move(entries[i]);
+                paths[kept] = std::move(paths[i]);
+            }
+            entry.type = stats.types[i];
+            entry.inode = stats.inodes[i];
+            entry.size = stats.sizes[i];
+            entry.mtimeNs = stats.mtimesNs[i];
+            ++kept;
+        }
+        entries.resize(kept);
+        paths.resize(kept);
+
+        if (!options.hashContents) {
+            return snapshot;
+        }
+
+        // Hashes: those of the files unchanged since the previous snapshot are reused, both lists being sorted.
+        std::vector<size_t> toHash;
+        const std::vector<SnapshotEntry> none;
+        const std::vector<SnapshotEntry>& previousEntries = previous ? previous->entries : none;
+        auto before = previousEntries.begin();
+        const auto beforeEnd = previousEntries.end();
+        for (size_t i = 0; i < entries.size(); ++i) {
+            SnapshotEntry& entry = entries[i];
+            if (entry.type != StatType::FILE) {
+                continue;
+            }
+            before = std::lower_bound(before, beforeEnd, entry.path, Snapshot_PathLess);
+            if (before != beforeEnd && before->path == entry.path && before->hashed && Snapshot_SameMetadata(*before, entry)) {
+                entry.hash = before->hash;
+                entry.hashed = true;
+            } else {
+                toHash.push_back(i);
+            }
+        }
+        std::atomic<size_t> failed(0);
+        Parallel_For(toHash.size(), threads, [&toHash, &entries, &paths, &failed](size_t index) {
+            SnapshotEntry& entry = entries[toHash[index]];
+            entry.hashed = Snapshot_HashFile(paths[toHash[index]], entry.size, entry.hash);
+            failed += !entry.hashed;
+        });
+        snapshot.hashedFiles = toHash.size();
+        snapshot.failures += failed;
+        return snapshot;
+    }
+
+    bool SaveSnapshot(const TreeSnapshot& snapshot, Filename_t filename) {
+        // Each entry: length of the prefix shared with the previous path, rest of the path, type (and hashed bit),
+        // then size, inode and modification time as varints, and the hash if any.
+        std::string data(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        Snapshot_PutVarint(data, snapshot.entries.size());
+        const SFilename_t* last = nullptr;
+        for (const SnapshotEntry& entry : snapshot.entries) {
+            size_t shared = 0;
+            if (last) {
+                const size_t limit = std::min(last->size(), entry.path.size());
+                while (shared < limit && (*last)[shared] == entry.path[shared]) {
+                    ++shared;
+                }
+            }
+            Snapshot_PutVarint(data, shared);
+            Snapshot_PutVarint(data, entry.path.size() - shared);
+            data.append(reinterpret_cast<const char*>(entry.path.data() + shared), (entry.path.size() - shared) * SNAPSHOT_UNIT_SIZE);
+            data.push_back(static_cast<char>(static_cast<uint8_t>(entry.type) | (entry.hashed ? SNAPSHOT_HASHED : 0)));
+            Snapshot_PutVarint(data, entry.size);
+            Snapshot_PutVarint(data, entry.inode);
+            Snapshot_PutVarint(data, Snapshot_ZigZag(entry.mtimeNs));
+            if (entry.hashed) {
+                data.append(reinterpret_cast<const char*>(&entry.hash), sizeof(entry.hash));
+            }
+            last = &entry.path;
+        }
+        const uint64_t checksum = Hash_XXH64(data.data(), data.size());
+        data.append(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+
+        Writer writer(filename);
+        return writer.Write(data) && writer.Commit();
+    }
+
+    bool LoadSnapshot(Filename_t filename, TreeSnapshot& snapshot) {
+        snapshot = TreeSnapshot();
+        const ReadFileData* content = Read(filename);
+        if (!content) {
+            return false;
+        }
+        const char* position = content->contents;
+        const char* end = content->contents + content->size;
+        bool success = content->size >= sizeof(SNAPSHOT_MAGIC) + SNAPSHOT_CHECKSUM_SIZE
+                && !std::memcmp(position, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        if (success) {
+            end -= SNAPSHOT_CHECKSUM_SIZE;
+            uint64_t checksum;
+            std::memcpy(&checksum, end, sizeof(checksum));
+            success = Hash_XXH64(position, static_cast<size_t>(end - position)) == checksum;
+            position += sizeof(SNAPSHOT_MAGIC);
+        }
+        uint64_t count = 0;
+        success = success && Snapshot_GetVarint(position, end, count) && count <= static_cast<uint64_t>(end - position);
+        if (success) {
+            snapshot.entries.reserve(static_cast<size_t>(count));
+        }
+        for (uint64_t i = 0; success && i < count; ++i) {
+            uint64_t shared, length, size, inode, mtime;
+            success = Snapshot_GetVarint(position, end, shared) && Snapshot_GetVarint(position, end, length)
+                    && (i ? shared <= snapshot.entries.back().path.size() : !shared)
+                    && length <= static_cast<uint64_t>(end - position) / SNAPSHOT_UNIT_SIZE
+                    && static_cast<uint64_t>(end - position) > length * SNAPSHOT_UNIT_SIZE;
+            if (!success) {
+                break;
+            }
+            SnapshotEntry entry;
+            if (shared) {
+                entry.path.assign(snapshot.entries.back().path, 0, static_cast<size_t>(shared));
+            }
+            entry.path.resize(static_cast<size_t>(shared + length));
+            std::memcpy(&entry.path[static_cast<size_t>(shared)], position, static_cast<size_t>(length) * SNAPSHOT_UNIT_SIZE);
+            position += length * SNAPSHOT_UNIT_SIZE;
+            const uint8_t type = static_cast<uint8_t>(*position++);
+            entry.type = static_cast<StatType>(type & ~SNAPSHOT_HASHED);
+            entry.hashed = (type & SNAPSHOT_HASHED) != 0;
+            success = entry.type > StatType::NONE && entry.type <= StatType::OTHER
+                    && Snapshot_GetVarint(position, end, size) && Snapshot_GetVarint(position, end, inode)
+                    && Snapshot_GetVarint(position, end, mtime)
+                    && (!entry.hashed || static_cast<size_t>(end - position) >= sizeof(entry.hash))
+                    && (snapshot.entries.empty() || snapshot.entries.back().path < entry.path);
+            if (!success) {
+                break;
+            }
+            entry.size = size;
+            entry.inode = inode;
+            entry.mtimeNs = Snapshot_UnZigZag(mtime);
+            if (entry.hashed) {
+                std::memcpy(&entry.hash, position, sizeof(entry.hash));
+                position += sizeof(entry.hash);
+            }
+            snapshot.entries.push_back(std::move(entry));
+        }
+        success = success && position == end;
+        Read_Close(content);
+        if (!success) {
+            snapshot.entries.clear();
+        }
+        return success;
+    }
+
+    std::vector<SnapshotChange> DiffSnapshots(const TreeSnapshot& before, const TreeSnapshot& after) {
+        std::vector<SnapshotChange> changes;
+        auto old = before.entries.begin();
+        auto current = after.entries.begin();
+        while (old != before.entries.end() || current != after.entries.end()) {
+            if (current == after.entries.end() || (old != before.entries.end() && old->path < current->path)) {
+                changes.push_back({SnapshotChangeType::REMOVED, &*old++, nullptr});
+            } else if (old == before.entries.end() || current->path < old->path) {
+                changes.push_back({SnapshotChangeType::ADDED, nullptr, &*current++});
+            } else if (old->type != current->type) {
+                changes.push_back({SnapshotChangeType::REMOVED, &*old, nullptr});
+                changes.push_back({SnapshotChangeType::ADDED, nullptr, &*current});
+                ++old, ++current;
+            } else {
+                const bool bothHashed = old->hashed && current->hashed;
+                if (old->type == StatType::DIRECTORY || (Snapshot_SameMetadata(*old, *current) && !(bothHashed && old->hash != current->hash))) {
+                    // Unchanged; the modification time of a directory only tells that its entries changed.
+                } else if (bothHashed && old->hash == current->hash && old->size == current->size) {
+                    changes.push_back({SnapshotChangeType::TOUCHED, &*old, &*current});
+                } else {
+                    changes.push_back({SnapshotChangeType::MODIFIED, &*old, &*current});
+                }
+                ++old, ++current;
+            }
+        }
+        return changes;
+    }
+}
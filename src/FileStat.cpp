@@ -0,0 +1,76 @@
+//
+// File module: metadata of many files at once.
+//
+
+#include <algorithm>
+#include "MF/FileStat.hpp"
+#include "ParallelHelper.hpp"
+
+#if defined(_WIN32)
+#   include "WindowsAPIHelper.hpp"
+#   define OS_StatGroup Windows_StatGroup
+#else
+#   include "UnixAPIHelper.hpp"
+#   define OS_StatGroup Unix_StatGroup
+#endif
+
+// Maximum number of paths looked up by one job: big directories are split so that threads share them.
+static constexpr size_t STAT_JOB_SIZE = 4096;
+
+namespace {
+    /// Paths [begin, end) all start with the same directory, of "directoryLength" characters.
+    struct Stat_Group {
+        size_t begin;
+        size_t end;
+        size_t directoryLength;
+    };
+
+    /// Length of the directory part of a path, last separator included.
+    size_t Stat_DirectoryLength(const File::SFilename_t& path) {
+#if defined(_WIN32)
+        const size_t separator = path.find_last_of(MAKE_FILE_NAME "\\/");
+#else
+        const size_t separator = path.rfind('/');
+#endif
+        return separator == File::SFilename_t::npos ? 0 : separator + 1;
+    }
+}
+
+namespace File {
+    StatResult StatMany(const std::vector<SFilename_t>& paths, StatMask mask, unsigned int threads, bool followLinks) {
+        StatResult result;
+        result.types.assign(paths.size(), StatType::NONE);
+        if (mask & STAT_SIZE) {
+            result.sizes.assign(paths.size(), 0);
+        }
+        if (mask & STAT_MTIME) {
+            result.mtimesNs.assign(paths.size(), 0);
+        }
+        if (mask & STAT_INODE) {
+            result.devices.assign(paths.size(), 0);
+            result.inodes.assign(paths.size(), 0);
+        }
+        if (mask & STAT_MODE) {
+            result.modes.assign(paths.size(), 0);
+        }
+
+        // Runs of consecutive paths in the same directory; the list is not sorted, which would cost more than it saves.
+        std::vector<Stat_Group> groups;
+        for (size_t i = 0; i < paths.size(); ) {
+            const size_t directoryLength = Stat_DirectoryLength(paths[i]);
+            size_t end = i + 1;
+            while (end < paths.size() && end - i < STAT_JOB_SIZE && Stat_DirectoryLength(paths[end]) == directoryLength
+                    && paths[end].compare(0, directoryLength, paths[i], 0, directoryLength) == 0) {
+                ++end;
+            }
+            groups.push_back({i, end, directoryLength});
+            i = end;
+        }
+
+        Parallel_For(groups.size(), Parallel_ThreadCount(threads), [&paths, &groups, mask, followLinks, &result](size_t index) {
+            const Stat_Group& group = groups[index];
+            OS_StatGroup(paths, group.begin, group.end, group.directoryLength, mask, followLinks, result);
+        });
+        return result;
+    }
+}
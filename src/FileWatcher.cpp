@@ -0,0 +1,322 @@
+//
+// File module: notification of changes in directories.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#if Threads_FOUND
+#   include <thread>
+#endif
+#include "MF/FileWatcher.hpp"
+#include "TreeHelper.hpp"
+
+#if defined(_WIN32)
+#   include "WindowsAPIHelper.hpp"
+using OSWatcher_t = Windows_Watcher;
+#   define OS_OpenWatcher Windows_OpenWatcher
+#   define OS_AddWatch Windows_AddWatch
+#   define OS_RemoveWatch Windows_RemoveWatch
+#   define OS_ReadWatchEvents Windows_ReadWatchEvents
+#   define OS_WakeWatcher Windows_WakeWatcher
+#   define OS_CloseWatcher Windows_CloseWatcher
+#else
+#   include "UnixAPIHelper.hpp"
+using OSWatcher_t = Unix_Watcher;
+#   define OS_OpenWatcher Unix_OpenWatcher
+#   define OS_AddWatch Unix_AddWatch
+#   define OS_RemoveWatch Unix_RemoveWatch
+#   define OS_ReadWatchEvents Unix_ReadWatchEvents
+#   define OS_WakeWatcher Unix_WakeWatcher
+#   define OS_CloseWatcher Unix_CloseWatcher
+#endif
+
+namespace File {
+    struct Watcher::State {
+        /// A watched directory.
+        struct Watch {
+            SFilename_t directory; // Ending with a separator.
+            bool recursive;
+            bool root; // Given to "Add", rather than found below a recursive one.
+        };
+
+        WatcherCallback callback;
+        WatcherOptions options;
+        OSWatcher_t* os = nullptr;
+#if Threads_FOUND
+        std::thread thread;
+#endif
+
+        mutable std::mutex watchesMutex; // Watches are changed by "Add" and "Remove" too.
+        std::unordered_map<int, Watch> watches;
+
+        // Batch being coalesced, only used by the thread.
+        std::vector<Change> pending;
+        std::vector<char> alive; // False for changes cancelled by a later one.
+        std::unordered_map<SFilename_t, size_t> pendingByName;
+        std::unordered_map<uint32_t, std::pair<SFilename_t, bool>> movedFrom; // Name and type, by rename cookie.
+
+        /**
+         * Watches a directory, and its subdirectories if recursive. Call with the mutex held.
+         * @param found If not null, filled with the entries found in the subdirectories, to be reported as created.
+         */
+        bool AddTree(const SFilename_t& directory, bool recursive, bool root, std::vector<std::pair<SFilename_t, bool>>* found) {
+            const int watch = OS_AddWatch(os, directory.c_str());
+            if (watch == -1) {
+                return false;
+            }
+            watches[watch] = {directory, recursive, root};
+            if (recursive) {
+                std::vector<Tree_Entry> entries;
+                Tree_ListDirectory(directory.c_str(), entries);
+                for (const Tree_Entry& entry : entries) {
+                    const bool isDirectory = entry.type == Tree_EntryType::DIRECTORY;
+                    if (found) {
+                        found->emplace_back(directory + entry.name, isDirectory);
+                    }
+                    if (isDirectory) {
+                        AddTree(directory + entry.name + FILE_SEPARATOR, true, false, found);
+                    }
+                }
+            }
+            return true;
+        }
+
+        /// Stops watching the directories starting with "prefix". Call with the mutex held.
+        void RemoveTree(const SFilename_t& prefix, bool roots) {
+            for (auto it = watches.begin(); it != watches.end(); ) {
+                const Watch& watch = it->second;
+                if (watch.directory.compare(0, prefix.size(), prefix) == 0 && (roots || !watch.root || watch.directory == prefix)) {
+                    OS_RemoveWatch(os, it->first);
+                    it = watches.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        /// Adds a change to the batch, merging it with an earlier one of the same entry.
+        void Record(ChangeType type, const SFilename_t& name, bool isDirectory, const SFilename_t& oldName = SFilename_t()) {
+            const auto found = pendingByName.find(name);
+            if (type == ChangeType::LOST || found == pendingByName.end()) {
+                if (type != ChangeType::LOST) {
+                    pendingByName[name] = pending.size();
+                }
+                pending.push_back({type, name, oldName, isDirectory});
+                alive.push_back(true);
+                return;
+            }
+
+            Change& change = pending[found->second];
+            if (type == ChangeType::MODIFIED && change.type != ChangeType::DELETED) {
+                return; // Already created, moved or modified in this batch.
+            } else if (type == ChangeType::DELETED && change.type == ChangeType::CREATED) {
+                alive[found->second] = false;
+                pendingByName.erase(found);
+            } else if (type == ChangeType::DELETED && change.type == ChangeType::MOVED) {
+                const SFilename_t movedName = change.oldName;
+                alive[found->second] = false;
+                pendingByName.erase(found);
+                Record(ChangeType::DELETED, movedName, isDirectory);
+            } else if (type == ChangeType::CREATED && change.type == ChangeType::DELETED) {
+                change.type = ChangeType::MODIFIED;
+                change.isDirectory = isDirectory;
+            } else {
+                change.type = type;
+                change.oldName = oldName;
+                change.isDirectory = isDirectory;
+            }
+        }
+
+        void Process(const Watch_Event& event) {
+            if (event.kind == Watch_EventKind::OVERFLOWED) {
+                Record(ChangeType::LOST, SFilename_t(), false);
+                return;
+            }
+
+            std::vector<std::pair<SFilename_t, bool>> found;
+            {
+                std::lock_guard<std::mutex> lock(watchesMutex);
+                const auto watchIt = watches.find(event.watch);
+                if (watchIt == watches.end()) {
+                    return; // Removed in the meantime.
+                }
+                const Watch watch = watchIt->second;
+                const SFilename_t name = watch.directory + event.name;
+
+                switch (event.kind) {
+                    case Watch_EventKind::WATCH_REMOVED:
+                        watches.erase(watchIt);
+                        return;
+                    case Watch_EventKind::SELF_DELETED:
+                        // Subdirectories are reported by their parent.
+                        if (watch.root) {
+                            Record(ChangeType::DELETED, watch.directory.substr(0, watch.directory.size() - 1), true);
+                        }
+                        return;
+                    case Watch_EventKind::CREATED:
+                        Record(ChangeType::CREATED, name, event.isDirectory);
+                        if (event.isDirectory && watch.recursive) {
+                            AddTree(name + FILE_SEPARATOR, true, false, &found);
+                        }
+                        break;
+                    case Watch_EventKind::MODIFIED:
+                        Record(ChangeType::MODIFIED, name, event.isDirectory);
+                        break;
+                    case Watch_EventKind::DELETED:
+                        Record(ChangeType::DELETED, name, event.isDirectory);
+                        break;
+                    case Watch_EventKind::MOVED_FROM:
+                        Record(ChangeType::DELETED, name, event.isDirectory);
+                        movedFrom[event.cookie] = {name, event.isDirectory};
+                        break;
+                    case Watch_EventKind::MOVED_TO: {
+                        const auto from = movedFrom.find(event.cookie);
+                        if (from == movedFrom.end()) {
+                            // Moved in from an unwatched place: new to the watcher, its contents included.
+                            Record(ChangeType::CREATED, name, event.isDirectory);
+                            if (event.isDirectory && watch.recursive) {
+                                AddTree(name + FILE_SEPARATOR, true, false, &found);
+                            }
+                            break;
+                        }
+
+                        const SFilename_t oldName = from->second.first;
+                        movedFrom.erase(from);
+                        const auto oldChange = pendingByName.find(oldName);
+                        if (oldChange != pendingByName.end()) {
+                            // The DELETED recorded by MOVED_FROM.
+                            alive[oldChange->second] = false;
+                            pendingByName.erase(oldChange);
+                            Record(ChangeType::MOVED, name, event.isDirectory, oldName);
+                        } else {
+                            Record(ChangeType::CREATED, name, event.isDirectory); // Created earlier in the batch.
+                        }
+                        if (event.isDirectory) {
+                            // The watches follow the directory: only their names change.
+                            const SFilename_t oldPrefix = oldName + FILE_SEPARATOR;
+                            const SFilename_t newPrefix = name + FILE_SEPARATOR;
+                            for (auto& moved : watches) {
+                                if (moved.second.directory.compare(0, oldPrefix.size(), oldPrefix) == 0) {
+                                    moved.second.directory.replace(0, oldPrefix.size(), newPrefix);
+                                }
+                            }
+                        }
+                        break;
+                    }
+                    default:
+                        break;
+                }
+            }
+            for (const auto& entry : found) {
+                Record(ChangeType::CREATED, entry.first, entry.second);
+            }
+        }
+
+        void Deliver() {
+            {
+                // Directories moved out of the watched ones are not watched anymore.
+                std::lock_guard<std::mutex> lock(watchesMutex);
+                for (const auto& from : movedFrom) {
+                    if (from.second.second) {
+                        RemoveTree(from.second.first + FILE_SEPARATOR, false);
+                    }
+                }
+            }
+            movedFrom.clear();
+
+            std::vector<Change> changes;
+            for (size_t i = 0; i < pending.size(); ++i) {
+                if (alive[i]) {
+                    changes.push_back(std::move(pending[i]));
+                }
+            }
+            pending.clear();
+            alive.clear();
+            pendingByName.clear();
+            if (!changes.empty()) {
+                callback(changes);
+            }
+        }
+
+        /// Body of the thread: waits without any timeout while nothing happens.
+        void Run() {
+            using Clock = std::chrono::steady_clock;
+            std::vector<Watch_Event> events;
+            bool collecting = false;
+            Clock::time_point deadline;
+            while (true) {
+                int timeoutMs = -1;
+                if (collecting) {
+                    const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+                    timeoutMs = static_cast<int>(std::max<decltype(remaining)>(remaining + 1, 0));
+                }
+                events.clear();
+                const bool running = OS_ReadWatchEvents(os, timeoutMs, events);
+                if (!events.empty() && !collecting) {
+                    collecting = true;
+                    deadline = Clock::now() + std::chrono::milliseconds(options.coalesceMs);
+                }
+                for (const Watch_Event& event : events) {
+                    Process(event);
+                }
+                if (!running) {
+                    Deliver();
+                    return;
+                }
+                if (collecting && Clock::now() >= deadline) {
+                    collecting = false;
+                    Deliver();
+                }
+            }
+        }
+    };
+
+    Watcher::Watcher(WatcherCallback callback, const WatcherOptions& options) :
+            state(new State)
+    {
+        state->callback = std::move(callback);
+        state->options = options;
+#if Threads_FOUND
+        state->os = OS_OpenWatcher();
+        if (state->os) {
+            state->thread = std::thread(&State::Run, state.get());
+        }
+#endif
+    }
+
+    Watcher::~Watcher() {
+        if (state->os) {
+            OS_WakeWatcher(state->os);
+#if Threads_FOUND
+            state->thread.join();
+#endif
+            OS_CloseWatcher(state->os);
+        }
+    }
+
+    bool Watcher::IsValid() const {
+        return state->os != nullptr;
+    }
+
+    bool Watcher::Add(Filename_t directory, bool recursive) {
+        if (!IsValid()) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(state->watchesMutex);
+        return state->AddTree(Tree_AsDirectory(directory), recursive, true, nullptr);
+    }
+
+    void Watcher::Remove(Filename_t directory) {
+        if (IsValid()) {
+            std::lock_guard<std::mutex> lock(state->watchesMutex);
+            state->RemoveTree(Tree_AsDirectory(directory), false);
+        }
+    }
+
+    size_t Watcher::WatchCount() const {
+        std::lock_guard<std::mutex> lock(state->watchesMutex);
+        return state->watches.size();
+    }
+}
@@ -0,0 +1,111 @@
+//
+// File module: sequential reading of huge files through a sliding memory-mapped window.
+//
+
+#include <algorithm>
+#include "MF/FileWindow.hpp"
+
+#if defined(_WIN32)
+#   include "WindowsAPIHelper.hpp"
+using OSWindowedFile_t = Windows_WindowedFile;
+#   define OS_GetMappingGranularity Windows_GetMappingGranularity
+#   define OS_OpenWindowedFile Windows_OpenWindowedFile
+#   define OS_MapWindow Windows_MapWindow
+#   define OS_UnmapWindow Windows_UnmapWindow
+#   define OS_CloseWindowedFile Windows_CloseWindowedFile
+#else
+#   include "UnixAPIHelper.hpp"
+using OSWindowedFile_t = Unix_WindowedFile;
+#   define OS_GetMappingGranularity Unix_GetMappingGranularity
+#   define OS_OpenWindowedFile Unix_OpenWindowedFile
+#   define OS_MapWindow Unix_MapWindow
+#   define OS_UnmapWindow Unix_UnmapWindow
+#   define OS_CloseWindowedFile Unix_CloseWindowedFile
+#endif
+
+namespace File {
+    constexpr Filesize_t WindowedReader::DEFAULT_WINDOW_SIZE;
+
+    WindowedReader::WindowedReader(Filename_t filename, Filesize_t windowSize, bool dropBehind) :
+            dropBehind(dropBehind)
+    {
+        const Filesize_t granularity = OS_GetMappingGranularity();
+        this->windowSize = std::max<Filesize_t>((windowSize + granularity - 1) / granularity, 1) * granularity;
+
+        osFile = OS_OpenWindowedFile(filename, fileSize);
+        if (osFile && fileSize) {
+            MoveTo(0);
+        }
+    }
+
+    WindowedReader::~WindowedReader() {
+        if (osFile) {
+            Release(current, offset, currentLength);
+            Release(next, offset + windowSize, nextLength);
+            OS_CloseWindowedFile(static_cast<OSWindowedFile_t*>(osFile));
+        }
+    }
+
+    bool WindowedReader::Next() {
+        if (!current) {
+            return false;
+        }
+        return MoveTo(offset + windowSize);
+    }
+
+    bool WindowedReader::Seek(Filesize_t position) {
+        if (!osFile) {
+            return false;
+        } else if (position >= fileSize) {
+            return MoveTo(fileSize); // Only releases the windows.
+        }
+        return MoveTo(position / windowSize * windowSize);
+    }
+
+    void WindowedReader::Release(const char*& window, Filesize_t windowOffset, Filesize_t& length) {
+        if (window) {
+            OS_UnmapWindow(static_cast<OSWindowedFile_t*>(osFile), window, windowOffset, length, dropBehind);
+            window = nullptr;
+            length = 0;
+        }
+    }
+
+    bool WindowedReader::MoveTo(Filesize_t newOffset) {
+        auto file = static_cast<OSWindowedFile_t*>(osFile);
+        const bool sequential = current && newOffset == offset + windowSize;
+
+        Release(current, offset, currentLength);
+        if (sequential) {
+            // The prefetched window becomes the current one.
+            current = next;
+            currentLength = nextLength;
+            next = nullptr;
+            nextLength = 0;
+        } else {
+            Release(next, offset + windowSize, nextLength);
+        }
+        offset = newOffset;
+
+        if (newOffset >= fileSize) {
+            return false;
+        }
+        if (!current) {
+            currentLength = std::min(windowSize, fileSize - newOffset);
+            current = OS_MapWindow(file, newOffset, currentLength, true);
+            if (!current) {
+                currentLength = 0;
+                return false;
+            }
+        }
+
+        const Filesize_t nextOffset = newOffset + windowSize;
+        if (nextOffset < fileSize) {
+            nextLength = std::min(windowSize, fileSize - nextOffset);
+            next = OS_MapWindow(file, nextOffset, nextLength, true);
+            if (!next) {
+                nextLength = 0; // Not fatal: it will be mapped when needed.
+            }
+        }
+        return true;
+    }
+}
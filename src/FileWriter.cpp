@@ -0,0 +1,124 @@
+//
+// File module: buffered and atomic writing of files.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "MF/FileWriter.hpp"
+
+#if defined(_WIN32)
+#   include "WindowsAPIHelper.hpp"
+using OSWriteFile_t = Windows_WriteFile;
+#   define OS_OpenWriteFile Windows_OpenWriteFile
+#   define OS_WriteToFile Windows_WriteToFile
+#   define OS_CommitWriteFile Windows_CommitWriteFile
+#   define OS_AbortWriteFile Windows_AbortWriteFile
+#else
+#   include "UnixAPIHelper.hpp"
+using OSWriteFile_t = Unix_WriteFile;
+#   define OS_OpenWriteFile Unix_OpenWriteFile
+#   define OS_WriteToFile Unix_WriteToFile
+#   define OS_CommitWriteFile Unix_CommitWriteFile
+#   define OS_AbortWriteFile Unix_AbortWriteFile
+#endif
+
+// Alignment of the buffer: writes of whole pages from page-aligned memory are the cheapest for the kernel.
+static constexpr File::Filesize_t BUFFER_ALIGNMENT = 4096;
+
+namespace File {
+    Writer::Writer(Filename_t filename, const WriterOptions& options) :
+            options(options)
+    {
+        capacity = std::max<Filesize_t>((options.bufferSize + BUFFER_ALIGNMENT - 1) / BUFFER_ALIGNMENT, 1) * BUFFER_ALIGNMENT;
+        osFile = OS_OpenWriteFile(filename, options.atomic, options.expectedSize);
+        if (osFile) {
+            storage.reset(new char[capacity + BUFFER_ALIGNMENT]);
+            const auto address = reinterpret_cast<uintptr_t>(storage.get());
+            buffer = storage.get() + (BUFFER_ALIGNMENT - address % BUFFER_ALIGNMENT) % BUFFER_ALIGNMENT;
+        }
+    }
+
+    Writer::~Writer() {
+        if (osFile) {
+            if (options.atomic) {
+                Abort();
+            } else {
+                Commit();
+            }
+        }
+    }
+
+    bool Writer::Write(const char* data, Filesize_t size) {
+        if (!IsOpen()) {
+            return false;
+        }
+
+        if (used + size <= capacity) {
+            std::memcpy(buffer + used, data, size);
+            used += size;
+            return true;
+        }
+
+        // Fill the buffer up, so that every write to the system is a whole number of pages.
+        if (used) {
+            const Filesize_t part = capacity - used;
+            std::memcpy(buffer + used, data, part);
+            used = capacity;
+            data += part;
+            size -= part;
+            if (!Flush()) {
+                return false;
+            }
+        }
+        if (size >= capacity) {
+            // Big writes go straight to the system.
+            const Filesize_t direct = size / BUFFER_ALIGNMENT * BUFFER_ALIGNMENT;
+            if (!OS_WriteToFile(static_cast<OSWriteFile_t*>(osFile), data, direct)) {
+                failed = true;
+                return false;
+            }
+            written += direct;
+            data += direct;
+            size -= direct;
+        }
+        std::memcpy(buffer, data, size);
+        used = size;
+        return true;
+    }
+
+    bool Writer::Flush() {
+        if (!IsOpen()) {
+            return false;
+        }
+        if (used) {
+            if (!OS_WriteToFile(static_cast<OSWriteFile_t*>(osFile), buffer, used)) {
+                failed = true;
+                return false;
+            }
+            written += used;
+            used = 0;
+        }
+        return true;
+    }
+
+    bool Writer::Commit() {
+        if (!osFile) {
+            return false;
+        } else if (!Flush()) {
+            Abort();
+            return false;
+        }
+        const bool success = OS_CommitWriteFile(static_cast<OSWriteFile_t*>(osFile), written, options.durability);
+        osFile = nullptr;
+        return success;
+    }
+
+    void Writer::Abort() {
+        if (osFile) {
+            OS_AbortWriteFile(static_cast<OSWriteFile_t*>(osFile));
+            osFile = nullptr;
+        }
+        used = 0;
+    }
+}
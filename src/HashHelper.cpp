@@ -0,0 +1,161 @@
+//
+// Internal fast non-cryptographic hashes of byte ranges.
+//
+
+#include <cstring>
+#include "HashHelper.hpp"
+#include "SimdHelper.hpp"
+
+static constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ull;
+static constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ull;
+static constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+static constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t RotateLeft(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t Read64(const char* data) {
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline uint32_t Read32(const char* data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline uint64_t Round(uint64_t accumulator, uint64_t input) {
+    return RotateLeft(accumulator + input * PRIME64_2, 31) * PRIME64_1;
+}
+
+static inline uint64_t MergeRound(uint64_t hash, uint64_t accumulator) {
+    return (hash ^ Round(0, accumulator)) * PRIME64_1 + PRIME64_4;
+}
+
+uint64_t Hash_XXH64(const char* data, std::size_t size, uint64_t seed) {
+    const char* const end = data + size;
+    uint64_t hash;
+
+    if (size >= 32) {
+        // Four independent lanes, so that the multiplications of one stripe run in parallel.
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        const char* const lastStripe = end - 32;
+        do {
+            v1 = Round(v1, Read64(data));
+            v2 = Round(v2, Read64(data + 8));
+            v3 = Round(v3, Read64(data + 16));
+            v4 = Round(v4, Read64(data + 24));
+            data += 32;
+        } while (data <= lastStripe);
+
+        hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+        hash = MergeRound(hash, v1);
+        hash = MergeRound(hash, v2);
+        hash = MergeRound(hash, v3);
+        hash = MergeRound(hash, v4);
+    } else {
+        hash = seed + PRIME64_5;
+    }
+    hash += size;
+
+    for (; data + 8 <= end; data += 8) {
+        hash = RotateLeft(hash ^ Round(0, Read64(data)), 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (data + 4 <= end) {
+        hash = RotateLeft(hash ^ (Read32(data) * PRIME64_1), 23) * PRIME64_2 + PRIME64_3;
+        data += 4;
+    }
+    for (; data < end; ++data) {
+        hash = RotateLeft(hash ^ (static_cast<unsigned char>(*data) * PRIME64_5), 11) * PRIME64_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// Largest number of bytes whose Adler-32 sums cannot overflow 32 bits before being reduced modulo 65521.
+static constexpr std::size_t ADLER_MAX_RUN = 5552;
+static constexpr uint32_t ADLER_MODULO = 65521;
+
+static uint32_t Adler32_Scalar(const unsigned char* bytes, std::size_t size, uint32_t adler) {
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (size) {
+        std::size_t run = size < ADLER_MAX_RUN ? size : ADLER_MAX_RUN;
+        size -= run;
+        for (; run >= 8; run -= 8, bytes += 8) {
+            a += bytes[0]; b += a;
+            a += bytes[1]; b += a;
+            a += bytes[2]; b += a;
+            a += bytes[3]; b += a;
+            a += bytes[4]; b += a;
+            a += bytes[5]; b += a;
+            a += bytes[6]; b += a;
+            a += bytes[7]; b += a;
+        }
+        for (; run; --run) {
+            a += *bytes++;
+            b += a;
+        }
+        a %= ADLER_MODULO;
+        b %= ADLER_MODULO;
+    }
+    return b << 16 | a;
+}
+
+#if defined(MF_SIMD_X86)
+MF_TARGET_AVX2 static uint32_t SumLanes_AVX2(__m256i lanes) {
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(lanes), _mm256_extracti128_si256(lanes, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+}
+
+// 32 bytes at a time: "a" grows by their sum, and "b" by 32 times the previous "a" plus the bytes weighted from 32 down to 1.
+MF_TARGET_AVX2 static uint32_t Adler32_AVX2(const unsigned char* bytes, std::size_t size, uint32_t adler) {
+    const __m256i weights = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+                                             16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i ones = _mm256_set1_epi16(1);
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    std::size_t blocks = size / 32;
+    while (blocks) {
+        std::size_t run = blocks < ADLER_MAX_RUN / 32 ? blocks : ADLER_MAX_RUN / 32;
+        blocks -= run;
+        __m256i previousSums = _mm256_setr_epi32(static_cast<int>(a * run), 0, 0, 0, 0, 0, 0, 0);
+        __m256i sums = _mm256_setzero_si256();
+        __m256i weighted = _mm256_setr_epi32(static_cast<int>(b), 0, 0, 0, 0, 0, 0, 0);
+        for (; run; --run, bytes += 32) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes));
+            previousSums = _mm256_add_epi32(previousSums, sums);
+            sums = _mm256_add_epi32(sums, _mm256_sad_epu8(block, _mm256_setzero_si256()));
+            weighted = _mm256_add_epi32(weighted, _mm256_madd_epi16(_mm256_maddubs_epi16(block, weights), ones));
+        }
+        weighted = _mm256_add_epi32(weighted, _mm256_slli_epi32(previousSums, 5));
+        a = (a + SumLanes_AVX2(sums)) % ADLER_MODULO;
+        b = SumLanes_AVX2(weighted) % ADLER_MODULO;
+    }
+    return Adler32_Scalar(bytes, size % 32, b << 16 | a);
+}
+#endif
+
+uint32_t Hash_Adler32(const char* data, std::size_t size, uint32_t adler) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+#if defined(MF_SIMD_X86)
+    if (Simd_HasAVX2()) {
+        return Adler32_AVX2(bytes, size, adler);
+    }
+#endif
+    return Adler32_Scalar(bytes, size, adler);
+}
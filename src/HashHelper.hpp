@@ -0,0 +1,30 @@
+//
+// Internal fast non-cryptographic hashes of byte ranges.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_HASHHELPER_HPP
+#define MFRANCESCHI_CPPLIBRARIES_HASHHELPER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * XXH64 hash of a byte range: about as fast as memory can be read, and good enough to tell contents apart
+ * outside of an adversarial setting. It is not a cryptographic hash.
+ * @param data Bytes to hash.
+ * @param size Number of bytes.
+ * @param seed Start value, to chain hashes or to get independent ones.
+ * @return The same value as the reference implementation on a little-endian host.
+ */
+uint64_t Hash_XXH64(const char* data, std::size_t size, uint64_t seed = 0);
+
+/**
+ * Adler-32 checksum of a byte range, as stored at the end of zlib streams (RFC 1950).
+ * @param data Bytes to add to the checksum.
+ * @param size Number of bytes.
+ * @param adler Checksum of the previous bytes, 1 for the first ones.
+ * @return The checksum of the previous bytes followed by these ones.
+ */
+uint32_t Hash_Adler32(const char* data, std::size_t size, uint32_t adler = 1);
+
+#endif //MFRANCESCHI_CPPLIBRARIES_HASHHELPER_HPP
@@ -0,0 +1,48 @@
+//
+// Internal helpers to spread independent jobs on several threads.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#if Threads_FOUND
+#   include <thread>
+#endif
+#include "ParallelHelper.hpp"
+
+unsigned int Parallel_ThreadCount(unsigned int requested) {
+#if Threads_FOUND
+    if (!requested) {
+        requested = std::thread::hardware_concurrency();
+    }
+    return std::max(requested, 1u);
+#else
+    (void)requested;
+    return 1;
+#endif
+}
+
+void Parallel_For(std::size_t count, unsigned int threads, const std::function<void(std::size_t)>& job) {
+    std::atomic<std::size_t> next(0);
+    Parallel_Run(static_cast<unsigned int>(std::min<std::size_t>(threads, count)), [&next, count, &job]() {
+        for (std::size_t i = next++; i < count; i = next++) {
+            job(i);
+        }
+    });
+}
+
+void Parallel_Run(unsigned int threads, const std::function<void()>& worker) {
+#if Threads_FOUND
+    std::vector<std::thread> pool;
+    for (unsigned int i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+#else
+    (void)threads;
+    worker();
+#endif
+}
@@ -0,0 +1,33 @@
+//
+// Internal helpers to spread independent jobs on several threads.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_PARALLELHELPER_HPP
+#define MFRANCESCHI_CPPLIBRARIES_PARALLELHELPER_HPP
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * Number of threads to use for a job.
+ * @param requested Wanted number of threads, 0 for one per hardware thread.
+ * @return At least 1. Always 1 when the library is built without thread support.
+ */
+unsigned int Parallel_ThreadCount(unsigned int requested);
+
+/**
+ * Calls "job(i)" for every i in [0, count). Indexes are handed out one at a time to "threads" threads
+ * (the calling one included), so that long jobs do not hold the others back. Returns when all jobs are done.
+ * @param count Number of jobs.
+ * @param threads Number of threads, as returned by "Parallel_ThreadCount".
+ * @param job Job to run, called concurrently from several threads.
+ */
+void Parallel_For(std::size_t count, unsigned int threads, const std::function<void(std::size_t)>& job);
+
+/**
+ * Runs "worker" on "threads" threads (the calling one included) and returns when all of them returned.
+ * The workers share their jobs themselves, for example through a queue.
+ */
+void Parallel_Run(unsigned int threads, const std::function<void()>& worker);
+
+#endif //MFRANCESCHI_CPPLIBRARIES_PARALLELHELPER_HPP
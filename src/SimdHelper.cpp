@@ -0,0 +1,37 @@
+//
+// Internal helpers to select SIMD kernels at runtime.
+//
+
+#include "SimdHelper.hpp"
+
+#if defined(MF_SIMD_X86) && defined(_MSC_VER) && !defined(__clang__)
+#   include <intrin.h>
+#endif
+
+static bool DetectAVX2() {
+#if !defined(MF_SIMD_X86)
+    return false;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+bool Simd_HasAVX2() {
+    static const bool hasAVX2 = DetectAVX2();
+    return hasAVX2;
+}
@@ -0,0 +1,40 @@
+//
+// Internal helpers to select SIMD kernels at runtime.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_SIMDHELPER_HPP
+#define MFRANCESCHI_CPPLIBRARIES_SIMDHELPER_HPP
+
+#include <cstdint>
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+// "MF_SIMD_X86" is defined when SSE2 is always available (baseline of x86-64) and intrinsics can be used.
+// Wider kernels (AVX2) are compiled with a per-function target and chosen at runtime,
+// so the library does not need to be compiled with "-mavx2".
+#if defined(__x86_64__) || defined(_M_X64) || defined(_M_AMD64)
+#   define MF_SIMD_X86 1
+#   include <immintrin.h>
+#   if defined(_MSC_VER) && !defined(__clang__)
+#       define MF_TARGET_AVX2
+#   else
+#       define MF_TARGET_AVX2 __attribute__((target("avx2")))
+#   endif
+#endif
+
+/// Returns true if the running CPU supports AVX2 (and the OS saves the YMM registers).
+bool Simd_HasAVX2();
+
+/// Index of the lowest set bit of a comparison mask, which must not be 0.
+static inline unsigned int Simd_LowestBit(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned int>(index);
+#else
+    return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+#endif //MFRANCESCHI_CPPLIBRARIES_SIMDHELPER_HPP
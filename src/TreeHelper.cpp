@@ -0,0 +1,29 @@
+//
+// Internal helpers to walk directory trees.
+//
+
+#include "TreeHelper.hpp"
+
+#if defined(_WIN32)
+#   include "WindowsAPIHelper.hpp"
+#else
+#   include "UnixAPIHelper.hpp"
+#endif
+
+bool Tree_ListDirectory(File::Filename_t directory, std::vector<Tree_Entry>& entries) {
+#if defined(_WIN32)
+    return Windows_ListDirectory(directory, entries);
+#else
+    return Unix_ListDirectory(directory, entries);
+#endif
+}
+
+File::SFilename_t Tree_AsDirectory(File::Filename_t path) {
+    static const File::SFilename_t separator = FILE_SEPARATOR;
+    File::SFilename_t directory(path);
+    if (directory.size() < separator.size()
+            || directory.compare(directory.size() - separator.size(), separator.size(), separator) != 0) {
+        directory += separator;
+    }
+    return directory;
+}
@@ -0,0 +1,37 @@
+//
+// Internal helpers to walk directory trees.
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_TREEHELPER_HPP
+#define MFRANCESCHI_CPPLIBRARIES_TREEHELPER_HPP
+
+#include <vector>
+#include "MF/File.hpp"
+
+/// Kind of a directory entry. Symbolic links are never followed.
+enum class Tree_EntryType {
+    FILE,
+    DIRECTORY,
+    SYMLINK,
+    OTHER // Device, socket, pipe...
+};
+
+/// Entry of a directory, as listed by "Tree_ListDirectory".
+struct Tree_Entry {
+    File::SFilename_t name; // Name relative to the directory, without ending separator.
+    Tree_EntryType type;
+};
+
+/**
+ * Lists the entries of a directory, "." and ".." excluded.
+ * The type comes from the directory itself where possible (d_type, find data), without one stat per entry.
+ * @param directory Name of the directory, ending with a FILE_SEPARATOR.
+ * @param entries Vector to fill.
+ * @return False if the directory could not be opened.
+ */
+bool Tree_ListDirectory(File::Filename_t directory, std::vector<Tree_Entry>& entries);
+
+/// Returns "path" with an ending FILE_SEPARATOR, added if missing.
+File::SFilename_t Tree_AsDirectory(File::Filename_t path);
+
+#endif //MFRANCESCHI_CPPLIBRARIES_TREEHELPER_HPP
@@ -7,10 +7,25 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include "UnixAPIHelper.hpp"
+#include "BufferPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <climits>
 #include <dirent.h>
 #include <fcntl.h>
+#include <sys/file.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
+#if defined(__linux__)
+#   include <linux/fs.h>
+#   include <poll.h>
+#   include <sys/eventfd.h>
+#   include <sys/inotify.h>
+#   include <sys/ioctl.h>
+#   include <sys/sendfile.h>
+#   include <sys/sysmacros.h>
+#endif
 
 bool Unix_DeleteFile(File::Filename_t filename) {
     return !unlink(filename);
@@ -36,6 +51,95 @@ File::Filesize_t Unix_GetFileSize(File::Filename_t filename) {
     return static_cast<File::Filesize_t>(t.st_size);
 }
 
+bool Unix_GetFileIdentity(File::Filename_t filename, File::FileIdentity& identity) {
+    struct stat t{};
+    if (stat(filename, &t)) return false;
+    identity.device = static_cast<uint64_t>(t.st_dev);
+    identity.inode = static_cast<uint64_t>(t.st_ino);
+#if defined(__APPLE__)
+    identity.mtimeNs = static_cast<int64_t>(t.st_mtimespec.tv_sec) * 1000000000 + t.st_mtimespec.tv_nsec;
+#else
+    identity.mtimeNs = static_cast<int64_t>(t.st_mtim.tv_sec) * 1000000000 + t.st_mtim.tv_nsec;
+#endif
+    identity.size = static_cast<File::Filesize_t>(t.st_size);
+    return true;
+}
+
+// Fills one row of a File::StatResult.
+static void SetStatRow(File::StatResult& result, size_t row, File::StatMask mask, mode_t mode, off_t size,
+                       int64_t mtimeNs, uint64_t device, uint64_t inode) {
+    result.types[row] = S_ISREG(mode) ? File::StatType::FILE : S_ISDIR(mode) ? File::StatType::DIRECTORY
+            : S_ISLNK(mode) ? File::StatType::SYMLINK : File::StatType::OTHER;
+    if (mask & File::STAT_SIZE) {
+        result.sizes[row] = static_cast<File::Filesize_t>(size);
+    }
+    if (mask & File::STAT_MTIME) {
+        result.mtimesNs[row] = mtimeNs;
+    }
+    if (mask & File::STAT_INODE) {
+        result.devices[row] = device;
+        result.inodes[row] = inode;
+    }
+    if (mask & File::STAT_MODE) {
+        result.modes[row] = static_cast<uint32_t>(mode & 07777);
+    }
+}
+
+void Unix_StatGroup(const std::vector<File::SFilename_t>& paths, size_t begin, size_t end, size_t directoryLength,
+                    File::StatMask mask, bool followLinks, File::StatResult& result) {
+    int directoryFd = AT_FDCWD;
+    if (directoryLength) {
+#if defined(O_PATH)
+        // Only a handle for lookups: no read permission needed, nothing loaded.
+        constexpr int flags = O_PATH | O_DIRECTORY | O_CLOEXEC;
+#else
+        constexpr int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+#endif
+        directoryFd = open(paths[begin].substr(0, directoryLength).c_str(), flags);
+        if (directoryFd == -1) {
+            return; // Nothing in a missing directory exists.
+        }
+    }
+
+    const int flags = followLinks ? 0 : AT_SYMLINK_NOFOLLOW;
+#if defined(__linux__) && defined(STATX_TYPE)
+    // Only the wanted fields: some file systems (network ones) then skip fetching the others.
+    const unsigned int statxMask = STATX_TYPE | (mask & File::STAT_SIZE ? STATX_SIZE : 0u)
+            | (mask & File::STAT_MTIME ? STATX_MTIME : 0u) | (mask & File::STAT_INODE ? STATX_INO : 0u)
+            | (mask & File::STAT_MODE ? STATX_MODE : 0u);
+#endif
+    for (size_t row = begin; row < end; ++row) {
+        int at = directoryFd;
+        const char* name = paths[row].c_str() + directoryLength;
+        if (!*name) {
+            at = AT_FDCWD; // A path ending with a separator: the directory itself.
+            name = paths[row].c_str();
+        }
+#if defined(__linux__) && defined(STATX_TYPE)
+        struct statx stx{};
+        if (!statx(at, name, flags, statxMask, &stx)) {
+            SetStatRow(result, row, mask, stx.stx_mode, static_cast<off_t>(stx.stx_size),
+                       static_cast<int64_t>(stx.stx_mtime.tv_sec) * 1000000000 + stx.stx_mtime.tv_nsec,
+                       static_cast<uint64_t>(makedev(stx.stx_dev_major, stx.stx_dev_minor)), stx.stx_ino);
+        }
+#else
+        struct stat st{};
+        if (!fstatat(at, name, &st, flags)) {
+#   if defined(__APPLE__)
+            const int64_t mtimeNs = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#   else
+            const int64_t mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#   endif
+            SetStatRow(result, row, mask, st.st_mode, st.st_size, mtimeNs, static_cast<uint64_t>(st.st_dev),
+                       static_cast<uint64_t>(st.st_ino));
+        }
+#endif
+    }
+    if (directoryFd != AT_FDCWD) {
+        close(directoryFd);
+    }
+}
+
 bool Unix_CreateDirectory(File::Filename_t directoryName) {
     return !mkdir(directoryName, S_IRWXU | S_IRWXG | S_IRWXO);
 }
@@ -74,38 +178,178 @@ void Unix_GetDirectoryContents(File::Filename_t directoryName, std::vector<File:
     }
 }
 
-const Unix_ReadFileData* Unix_OpenFile(File::Filename_t filename) {
+// Lists an open directory stream, and closes it.
+static void ListDirectoryStream(DIR* d, std::vector<Tree_Entry>& entries) {
+    while (dirent* entry = readdir(d)) {
+        const char* name = entry->d_name;
+        if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2]))) {
+            continue;
+        }
+
+        unsigned char type = entry->d_type;
+        if (type == DT_UNKNOWN) {
+            struct stat st{};
+            if (fstatat(dirfd(d), name, &st, AT_SYMLINK_NOFOLLOW)) {
+                continue; // Removed in the meantime.
+            }
+            type = S_ISREG(st.st_mode) ? DT_REG : S_ISDIR(st.st_mode) ? DT_DIR : S_ISLNK(st.st_mode) ? DT_LNK : DT_FIFO;
+        }
+        const Tree_EntryType entryType = type == DT_REG ? Tree_EntryType::FILE : type == DT_DIR ? Tree_EntryType::DIRECTORY
+                : type == DT_LNK ? Tree_EntryType::SYMLINK : Tree_EntryType::OTHER;
+        entries.push_back({name, entryType});
+    }
+    closedir(d);
+}
+
+bool Unix_ListDirectory(File::Filename_t directoryName, std::vector<Tree_Entry>& entries) {
+    DIR* d = opendir(directoryName);
+    if (!d) {
+        return false;
+    }
+    ListDirectoryStream(d, entries);
+    return true;
+}
+
+bool Unix_ReadEntry(File::Filename_t name, Tree_EntryType& type, File::SFilename_t& target) {
+    struct stat st{};
+    if (lstat(name, &st)) {
+        return false;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        type = Tree_EntryType::DIRECTORY;
+    } else if (S_ISREG(st.st_mode)) {
+        type = Tree_EntryType::FILE;
+    } else if (S_ISLNK(st.st_mode)) {
+        type = Tree_EntryType::SYMLINK;
+        // "st_size" is the length of the target, except on some pseudo file systems where it is 0.
+        target.assign(st.st_size > 0 ? static_cast<size_t>(st.st_size) + 1 : PATH_MAX, '\0');
+        const ssize_t length = readlink(name, &target[0], target.size());
+        if (length <= 0 || static_cast<size_t>(length) >= target.size()) {
+            return false;
+        }
+        target.resize(static_cast<size_t>(length));
+    } else {
+        type = Tree_EntryType::OTHER;
+    }
+    return true;
+}
+
+bool Unix_OpenDirectoryAt(int parentFd, File::Filename_t name, int& fd) {
+    fd = openat(parentFd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    return fd != -1;
+}
+
+bool Unix_ListDirectoryAt(int fd, std::vector<Tree_Entry>& entries) {
+    // The stream owns its descriptor, so it gets a duplicate: "fd" is still needed to remove the entries.
+    const int streamFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (streamFd == -1) {
+        return false;
+    }
+    DIR* d = fdopendir(streamFd);
+    if (!d) {
+        close(streamFd);
+        return false;
+    }
+    ListDirectoryStream(d, entries);
+    return true;
+}
+
+bool Unix_RemoveAt(int parentFd, File::Filename_t name, bool directory) {
+    return !unlinkat(parentFd, name, directory ? AT_REMOVEDIR : 0);
+}
+
+void Unix_CloseDirectory(int fd) {
+    close(fd);
+}
+
+const Unix_ReadFileData* Unix_OpenFile(File::Filename_t filename, File::ReadStrategy strategy, File::AccessPattern pattern) {
     auto rfd = new Unix_ReadFileData;
 
-    if ((rfd->fd = open(filename, O_RDONLY)) == -1) {
+    if ((rfd->fd = open(filename, O_RDONLY | O_CLOEXEC)) == -1) {
         delete rfd;
         return nullptr;
     }
 
-    struct stat st;
-    if (fstat(rfd->fd, &st) == 0) {
+    struct stat st{};
+    if (fstat(rfd->fd, &st) == 0 && st.st_size > 0) {
         rfd->size = st.st_size;
     } else {
-        delete rfd;
+        Unix_CloseReadFileData(rfd);
         return nullptr;
     }
 
-    rfd->contents = (const char*)mmap(nullptr, rfd->size, PROT_READ, MAP_PRIVATE, rfd->fd, 0);
-    if (rfd->contents == MAP_FAILED) {
-        delete rfd;
+    if (strategy == File::ReadStrategy::AUTO) {
+        strategy = File::ChooseReadStrategy(rfd->size, pattern);
+    }
+    rfd->strategy = strategy;
+
+    if (strategy == File::ReadStrategy::READ) {
+        // The whole file is copied at once, the descriptor is not needed anymore.
+        char* buffer = BufferPool_Acquire(rfd->size);
+        rfd->contents = buffer;
+        File::Filesize_t done = 0;
+        while (done < rfd->size) {
+            ssize_t nbRead = read(rfd->fd, buffer + done, rfd->size - done);
+            if (nbRead <= 0) {
+                if (nbRead == -1 && errno == EINTR) continue;
+                break;
+            }
+            done += static_cast<File::Filesize_t>(nbRead);
+        }
+        close(rfd->fd);
+        rfd->fd = -1;
+        if (done != rfd->size) {
+            Unix_CloseReadFileData(rfd);
+            return nullptr;
+        }
+        return rfd;
+    }
+
+    int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+    if (strategy == File::ReadStrategy::MMAP_POPULATE) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+    void* mapping = mmap(nullptr, rfd->size, PROT_READ, flags, rfd->fd, 0);
+    if (mapping == MAP_FAILED) {
+        Unix_CloseReadFileData(rfd);
         return nullptr;
     }
+    rfd->contents = static_cast<const char*>(mapping);
+
+    madvise(mapping, rfd->size, pattern == File::AccessPattern::RANDOM ? MADV_RANDOM : MADV_SEQUENTIAL);
+#if !defined(MAP_POPULATE)
+    if (strategy == File::ReadStrategy::MMAP_POPULATE) {
+        madvise(mapping, rfd->size, MADV_WILLNEED);
+    }
+#endif
+#if defined(MADV_HUGEPAGE)
+    if (strategy == File::ReadStrategy::MMAP_HUGE_PAGES) {
+        madvise(mapping, rfd->size, MADV_HUGEPAGE);
+    }
+#endif
 
     return rfd;
 }
 
 void Unix_CloseReadFileData(const Unix_ReadFileData* readFileData)  {
-    close(readFileData->fd);
+    if (readFileData->contents) {
+        if (readFileData->strategy == File::ReadStrategy::READ) {
+            BufferPool_Release(const_cast<char*>(readFileData->contents), readFileData->size);
+        } else {
+            munmap(const_cast<char*>(readFileData->contents), readFileData->size);
+        }
+    }
+    if (readFileData->fd != -1) {
+        close(readFileData->fd);
+    }
     delete readFileData;
 }
 
 void Unix_CloseReadFileData(const File::ReadFileData* readFileData) {
-    (void)(readFileData); // to avoid "unused parameter warning
+    // Everything returned by "Unix_OpenFile" is an Unix_ReadFileData.
+    Unix_CloseReadFileData(static_cast<const Unix_ReadFileData*>(readFileData));
 }
 
 int Unix_ReadFileToBuffer(File::Filename_t filename, char* buffer, File::Filesize_t bufferSize) {
@@ -119,4 +363,676 @@ int Unix_ReadFileToBuffer(File::Filename_t filename, char* buffer, File::Filesiz
     return bytesRead;
 }
 
+bool Unix_ReadWholeFile(File::Filename_t filename, File::FileBuffer& buffer) {
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st)) {
+        close(fd);
+        return false;
+    }
+    const auto size = static_cast<File::Filesize_t>(st.st_size);
+    std::unique_ptr<char[]> contents(size ? new char[size] : nullptr);
+
+    File::Filesize_t done = 0;
+    while (done < size) {
+        ssize_t nbRead = read(fd, contents.get() + done, size - done);
+        if (nbRead == -1 && errno == EINTR) {
+            continue;
+        } else if (nbRead == -1) {
+            close(fd);
+            return false;
+        } else if (nbRead == 0) {
+            break; // The file got shorter.
+        }
+        done += static_cast<File::Filesize_t>(nbRead);
+    }
+    close(fd);
+
+    buffer.contents = std::move(contents);
+    buffer.size = done;
+    return true;
+}
+
+File::Filesize_t Unix_GetMappingGranularity() {
+    static const File::Filesize_t pageSize = static_cast<File::Filesize_t>(sysconf(_SC_PAGESIZE));
+    return pageSize;
+}
+
+Unix_WindowedFile* Unix_OpenWindowedFile(File::Filename_t filename, File::Filesize_t& fileSize) {
+    auto file = new Unix_WindowedFile;
+    if ((file->fd = open(filename, O_RDONLY | O_CLOEXEC)) == -1) {
+        delete file;
+        return nullptr;
+    }
+
+    struct stat st{};
+    if (fstat(file->fd, &st) != 0) {
+        Unix_CloseWindowedFile(file);
+        return nullptr;
+    }
+    fileSize = static_cast<File::Filesize_t>(st.st_size);
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+    posix_fadvise(file->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    return file;
+}
+
+const char* Unix_MapWindow(const Unix_WindowedFile* file, File::Filesize_t offset, File::Filesize_t length, bool prefetch) {
+    void* window = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file->fd, static_cast<off_t>(offset));
+    if (window == MAP_FAILED) {
+        return nullptr;
+    }
+    madvise(window, length, MADV_SEQUENTIAL);
+    if (prefetch) {
+        madvise(window, length, MADV_WILLNEED);
+    }
+    return static_cast<const char*>(window);
+}
+
+void Unix_UnmapWindow(const Unix_WindowedFile* file, const char* window, File::Filesize_t offset,
+                      File::Filesize_t length, bool dropPages) {
+    void* address = const_cast<char*>(window);
+    madvise(address, length, MADV_DONTNEED);
+    munmap(address, length);
+#if defined(POSIX_FADV_DONTNEED)
+    if (dropPages) {
+        posix_fadvise(file->fd, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_DONTNEED);
+    }
+#else
+    (void)file;
+    (void)offset;
+    (void)dropPages;
+#endif
+}
+
+void Unix_CloseWindowedFile(Unix_WindowedFile* file) {
+    close(file->fd);
+    delete file;
+}
+
+Unix_PrefetchedFile* Unix_PrefetchFile(File::Filename_t filename, File::Filesize_t& length) {
+    auto file = new Unix_PrefetchedFile;
+    if ((file->fd = open(filename, O_RDONLY | O_CLOEXEC)) == -1) {
+        delete file;
+        return nullptr;
+    }
+
+    struct stat st{};
+    if (fstat(file->fd, &st) != 0) {
+        Unix_ReleasePrefetchedFile(file, false);
+        return nullptr;
+    }
+    length = std::min(length, static_cast<File::Filesize_t>(st.st_size));
+
+#if defined(POSIX_FADV_WILLNEED)
+    // Only queues the reads (by pieces of the readahead size): they are done while the caller goes on.
+    if (length != 0) {
+        posix_fadvise(file->fd, 0, static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+    }
+#endif
+    return file;
+}
+
+void Unix_ReleasePrefetchedFile(Unix_PrefetchedFile* file, bool dropPages) {
+#if defined(POSIX_FADV_DONTNEED)
+    if (dropPages) {
+        posix_fadvise(file->fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+#else
+    (void)dropPages;
+#endif
+    close(file->fd);
+    delete file;
+}
+
+/// Directory containing "filename", with its ending separator; "./" for a relative name without directory.
+static std::string DirectoryOf(const std::string& filename) {
+    const size_t separator = filename.rfind('/');
+    return separator == std::string::npos ? std::string("./") : filename.substr(0, separator + 1);
+}
+
+/// Puts the entries of the directory containing "filename" on the device.
+static bool SyncDirectoryOf(const std::string& filename) {
+    int directory = open(DirectoryOf(filename).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    const bool success = directory != -1 && !fsync(directory);
+    if (directory != -1) {
+        close(directory);
+    }
+    return success;
+}
+
+/// Name of a temporary file next to "target", unique in the process.
+static std::string TemporaryNameFor(const std::string& target) {
+    static std::atomic<unsigned int> counter(0);
+    return target + ".tmp." + std::to_string(getpid()) + "." + std::to_string(counter++);
+}
+
+Unix_WriteFile* Unix_OpenWriteFile(File::Filename_t filename, bool atomic, File::Filesize_t expectedSize) {
+    auto file = new Unix_WriteFile;
+    file->target = filename;
+    file->atomic = atomic;
+
+    if (!atomic) {
+        file->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    } else {
+#if defined(O_TMPFILE)
+        file->fd = open(DirectoryOf(file->target).c_str(), O_TMPFILE | O_WRONLY | O_CLOEXEC, 0666);
+#endif
+        if (file->fd == -1) {
+            // No O_TMPFILE support (old kernel, or file system such as NFS).
+            file->tempName = TemporaryNameFor(file->target);
+            file->fd = open(file->tempName.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+        }
+    }
+    if (file->fd == -1) {
+        delete file;
+        return nullptr;
+    }
+
+#if defined(__linux__)
+    if (expectedSize && !fallocate(file->fd, 0, 0, static_cast<off_t>(expectedSize))) {
+        file->preallocated = expectedSize;
+    }
+#else
+    (void)expectedSize;
+#endif
+    return file;
+}
+
+bool Unix_WriteToFile(const Unix_WriteFile* file, const char* data, File::Filesize_t size) {
+    while (size) {
+        ssize_t nbWritten = write(file->fd, data, size);
+        if (nbWritten == -1) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += nbWritten;
+        size -= static_cast<File::Filesize_t>(nbWritten);
+    }
+    return true;
+}
+
+bool Unix_CommitWriteFile(Unix_WriteFile* file, File::Filesize_t size, File::Durability durability) {
+    bool success = true;
+    if (file->preallocated > size) {
+        success = !ftruncate(file->fd, static_cast<off_t>(size));
+    }
+    if (success && durability != File::Durability::NONE) {
+#if defined(__APPLE__)
+        success = !fsync(file->fd);
+#else
+        success = !fdatasync(file->fd);
+#endif
+    }
+
+    if (success && file->atomic) {
+        if (file->tempName.empty()) {
+            // An anonymous file gets a name first: "linkat" cannot replace an existing file, "rename" can.
+            const std::string procPath = "/proc/self/fd/" + std::to_string(file->fd);
+            file->tempName = TemporaryNameFor(file->target);
+            if (linkat(AT_FDCWD, procPath.c_str(), AT_FDCWD, file->tempName.c_str(), AT_SYMLINK_FOLLOW)) {
+                file->tempName.clear();
+                success = false;
+            }
+        }
+        if (success && rename(file->tempName.c_str(), file->target.c_str())) {
+            success = false;
+        }
+        if (!success && !file->tempName.empty()) {
+            unlink(file->tempName.c_str());
+        }
+    }
+    success &= !close(file->fd);
+
+    if (success && durability == File::Durability::SYNC_DIRECTORY) {
+        success = SyncDirectoryOf(file->target);
+    }
+    delete file;
+    return success;
+}
+
+void Unix_AbortWriteFile(Unix_WriteFile* file) {
+    close(file->fd);
+    if (file->atomic && !file->tempName.empty()) {
+        unlink(file->tempName.c_str());
+    }
+    delete file;
+}
+
+Unix_JournalSegment* Unix_OpenJournalSegment(File::Filename_t filename, File::Filesize_t size, bool create) {
+    auto segment = new Unix_JournalSegment;
+    segment->fd = open(filename, O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_EXCL : 0), 0666);
+    if (segment->fd == -1) {
+        delete segment;
+        return nullptr;
+    }
+
+    bool success = true;
+    if (create) {
+        // The blocks are written with zeros rather than only reserved (fallocate): on ext4 and XFS, the first write
+        // to a reserved block changes the metadata, so each synchronisation would also commit the journal of the file system.
+        std::unique_ptr<char[]> zeros(new char[1ul << 20]());
+        for (File::Filesize_t offset = 0; success && offset < size; offset += 1ul << 20) {
+            const auto length = static_cast<size_t>(std::min<File::Filesize_t>(size - offset, 1ul << 20));
+            success = Unix_WriteJournalSegment(segment, offset, nullptr, 0, zeros.get(), length);
+        }
+        success = success && !fsync(segment->fd) && SyncDirectoryOf(filename);
+    } else {
+        struct stat st{};
+        success = !fstat(segment->fd, &st);
+        size = static_cast<File::Filesize_t>(st.st_size);
+    }
+
+    if (!success) {
+        close(segment->fd);
+        delete segment;
+        if (create) {
+            unlink(filename);
+        }
+        return nullptr;
+    }
+    segment->size = size;
+    return segment;
+}
+
+bool Unix_WriteJournalSegment(const Unix_JournalSegment* segment, File::Filesize_t offset, const char* header, size_t headerSize,
+                              const char* data, size_t size) {
+    size_t done = 0;
+    while (done < headerSize + size) {
+        struct iovec parts[2];
+        int count = 0;
+        if (done < headerSize) {
+            parts[count++] = {const_cast<char*>(header + done), headerSize - done};
+        }
+        const size_t dataDone = done > headerSize ? done - headerSize : 0;
+        parts[count++] = {const_cast<char*>(data + dataDone), size - dataDone};
+        const ssize_t written = pwritev(segment->fd, parts, count, static_cast<off_t>(offset + done));
+        if (written == -1) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool Unix_SyncJournalSegment(const Unix_JournalSegment* segment) {
+#if defined(__APPLE__)
+    return !fsync(segment->fd);
+#else
+    return !fdatasync(segment->fd);
+#endif
+}
+
+void Unix_CloseJournalSegment(Unix_JournalSegment* segment) {
+    close(segment->fd);
+    delete segment;
+}
+
+Unix_PatchFile* Unix_OpenPatchFile(File::Filename_t filename, File::Filesize_t& size) {
+    const int fd = open(filename, O_RDWR | O_CLOEXEC);
+    struct stat st{};
+    if (fd == -1 || fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+        if (fd != -1) {
+            close(fd);
+        }
+        return nullptr;
+    }
+    size = static_cast<File::Filesize_t>(st.st_size);
+    auto file = new Unix_PatchFile;
+    file->fd = fd;
+    return file;
+}
+
+bool Unix_ReadPatchFile(const Unix_PatchFile* file, File::Filesize_t offset, char* buffer, size_t size) {
+    while (size) {
+        const ssize_t done = pread(file->fd, buffer, size, static_cast<off_t>(offset));
+        if (done == -1 && errno == EINTR) continue;
+        if (done <= 0) {
+            return false;
+        }
+        buffer += done;
+        size -= static_cast<size_t>(done);
+        offset += static_cast<File::Filesize_t>(done);
+    }
+    return true;
+}
+
+bool Unix_WritePatchFile(const Unix_PatchFile* file, File::Filesize_t offset, const char* data, size_t size) {
+    while (size) {
+        const ssize_t done = pwrite(file->fd, data, size, static_cast<off_t>(offset));
+        if (done == -1) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += done;
+        size -= static_cast<size_t>(done);
+        offset += static_cast<File::Filesize_t>(done);
+    }
+    return true;
+}
+
+bool Unix_ClosePatchFile(Unix_PatchFile* file, File::Filesize_t size, bool resize) {
+    const bool success = !resize || !ftruncate(file->fd, static_cast<off_t>(size));
+    close(file->fd);
+    delete file;
+    return success;
+}
+
+Unix_MappedRegion* Unix_OpenMappedRegion(File::Filename_t filename, bool writable) {
+    const int fd = writable ? open(filename, O_RDWR | O_CREAT | O_CLOEXEC, 0644) : open(filename, O_RDONLY | O_CLOEXEC);
+    struct stat st{};
+    if (fd == -1 || fstat(fd, &st) || !S_ISREG(st.st_mode) || flock(fd, (writable ? LOCK_EX : LOCK_SH) | LOCK_NB)) {
+        if (fd != -1) {
+            close(fd);
+        }
+        return nullptr;
+    }
+    void* data = nullptr;
+    if (st.st_size) {
+        data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | (writable ? PROT_WRITE : 0), MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return nullptr;
+        }
+    }
+    auto region = new Unix_MappedRegion;
+    region->fd = fd;
+    region->data = static_cast<char*>(data);
+    region->size = static_cast<File::Filesize_t>(st.st_size);
+    return region;
+}
+
+bool Unix_ResizeMappedRegion(Unix_MappedRegion* region, File::Filesize_t size) {
+    const File::Filesize_t previous = region->size;
+    if (size > previous && ftruncate(region->fd, static_cast<off_t>(size))) {
+        return false;
+    }
+    void* data = nullptr;
+#if defined(__linux__)
+    if (region->data && size) {
+        // Same pages, moved if they do not fit where they are: nothing is read again.
+        data = mremap(region->data, static_cast<size_t>(region->size), static_cast<size_t>(size), MREMAP_MAYMOVE);
+    } else
+#endif
+    if (size) {
+        data = mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, region->fd, 0);
+        if (data != MAP_FAILED && region->data) {
+            munmap(region->data, static_cast<size_t>(region->size));
+        }
+    } else if (region->data) {
+        munmap(region->data, static_cast<size_t>(region->size));
+    }
+    if (data == MAP_FAILED) {
+        return false; // The old mapping is kept; a file grown keeps zeros at its end, which nothing reads.
+    }
+    region->data = static_cast<char*>(data);
+    region->size = size;
+    return size >= previous || !ftruncate(region->fd, static_cast<off_t>(size));
+}
+
+bool Unix_FlushMappedRegion(const Unix_MappedRegion* region) {
+    if (region->data && msync(region->data, static_cast<size_t>(region->size), MS_SYNC)) {
+        return false;
+    }
+#if defined(__APPLE__)
+    return !fsync(region->fd);
+#else
+    return !fdatasync(region->fd);
+#endif
+}
+
+void Unix_CloseMappedRegion(Unix_MappedRegion* region) {
+    if (region->data) {
+        munmap(region->data, static_cast<size_t>(region->size));
+    }
+    close(region->fd);
+    delete region;
+}
+
+/// Copies [offset, end) of "in" into "out" at the same offset, with the best "method" that works; it is downgraded as needed.
+static bool CopySegment(int in, int out, off_t offset, off_t end, File::CopyMethod& method, std::unique_ptr<char[]>& buffer) {
+    static constexpr size_t BUFFER_SIZE = 1ul << 20;
+    while (offset < end) {
+        const auto length = static_cast<size_t>(std::min<off_t>(end - offset, 1l << 30));
+        ssize_t done = -1;
+#if defined(__linux__)
+        if (method == File::CopyMethod::COPY_FILE_RANGE) {
+            off_t inOffset = offset, outOffset = offset;
+            done = copy_file_range(in, &inOffset, out, &outOffset, length, 0);
+            if (done == -1 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP || errno == EPERM)) {
+                method = File::CopyMethod::SENDFILE; // Not supported between these files, or by this kernel.
+                continue;
+            }
+        } else if (method == File::CopyMethod::SENDFILE) {
+            off_t inOffset = offset;
+            if (lseek(out, offset, SEEK_SET) == offset) {
+                done = sendfile(out, in, &inOffset, length);
+            }
+            if (done == -1 && (errno == EINVAL || errno == ENOSYS)) {
+                method = File::CopyMethod::BUFFERED;
+                continue;
+            }
+        } else
+#endif
+        {
+            method = File::CopyMethod::BUFFERED;
+            if (!buffer) {
+                buffer.reset(new char[BUFFER_SIZE]);
+            }
+            done = pread(in, buffer.get(), std::min(length, BUFFER_SIZE), offset);
+            for (ssize_t written = 0; done > 0 && written < done; ) {
+                const ssize_t nbWritten = pwrite(out, buffer.get() + written, done - written, offset + written);
+                if (nbWritten == -1 && errno != EINTR) {
+                    return false;
+                }
+                written += std::max<ssize_t>(nbWritten, 0);
+            }
+        }
+
+        if (done == -1 && errno == EINTR) {
+            continue;
+        } else if (done <= 0) {
+            return done == 0; // 0: the source got shorter.
+        }
+        offset += done;
+    }
+    return true;
+}
+
+File::CopyMethod Unix_CopyFile(File::Filename_t source, File::Filename_t destination, bool overwrite, File::Filesize_t& size) {
+    const int in = open(source, O_RDONLY | O_CLOEXEC);
+    if (in == -1) {
+        return File::CopyMethod::FAILED;
+    }
+    struct stat st{};
+    if (fstat(in, &st) || !S_ISREG(st.st_mode)) {
+        close(in);
+        return File::CopyMethod::FAILED;
+    }
+    // Truncated only once known to be another file than the source: not the source itself, nor a hard link to it.
+    // Created apart from being opened, so that a failure only deletes a file this call created.
+    int out = open(destination, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 0777);
+    const bool created = out != -1;
+    if (!created && overwrite && errno == EEXIST) {
+        out = open(destination, O_WRONLY | O_CLOEXEC);
+    }
+    if (out == -1) {
+        close(in);
+        return File::CopyMethod::FAILED;
+    }
+    struct stat outSt{};
+    if (fstat(out, &outSt) || (outSt.st_dev == st.st_dev && outSt.st_ino == st.st_ino)
+        || ftruncate(out, 0) || fchmod(out, st.st_mode & 0777)) {
+        close(in);
+        close(out);
+        if (created) {
+            unlink(destination);
+        }
+        return File::CopyMethod::FAILED;
+    }
+    size = static_cast<File::Filesize_t>(st.st_size);
+
+    File::CopyMethod method = File::CopyMethod::COPY_FILE_RANGE;
+#if defined(__linux__) && defined(FICLONE)
+    if (!ioctl(out, FICLONE, in)) {
+        method = File::CopyMethod::REFLINK;
+    }
+#endif
+
+    bool success = true;
+    if (method != File::CopyMethod::REFLINK) {
+        std::unique_ptr<char[]> buffer;
+        const off_t end = st.st_size;
+        off_t offset = 0;
+        while (success && offset < end) {
+            off_t dataStart = offset, dataEnd = end;
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+            dataStart = lseek(in, offset, SEEK_DATA);
+            if (dataStart == -1) {
+                // ENXIO: only a hole until the end; otherwise SEEK_DATA is not supported, and all is data.
+                dataStart = errno == ENXIO ? end : offset;
+            } else {
+                dataEnd = std::min(lseek(in, dataStart, SEEK_HOLE), end);
+                if (dataEnd <= dataStart) {
+                    dataEnd = end;
+                }
+            }
+#endif
+            success = CopySegment(in, out, dataStart, dataEnd, method, buffer);
+            offset = dataEnd;
+        }
+        // Extends the file if it ends with a hole.
+        success = success && !ftruncate(out, end);
+    }
+
+    close(in);
+    success &= !close(out);
+    if (!success) {
+        unlink(destination);
+        return File::CopyMethod::FAILED;
+    }
+    return method;
+}
+
+bool Unix_CopySymlink(File::Filename_t source, File::Filename_t destination) {
+    std::string target(PATH_MAX, '\0');
+    const ssize_t length = readlink(source, &target[0], target.size());
+    if (length <= 0 || static_cast<size_t>(length) >= target.size()) {
+        return false;
+    }
+    target.resize(static_cast<size_t>(length));
+    unlink(destination);
+    return !symlink(target.c_str(), destination);
+}
+
+Unix_Watcher* Unix_OpenWatcher() {
+#if defined(__linux__)
+    auto watcher = new Unix_Watcher;
+    watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    watcher->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (watcher->fd == -1 || watcher->wakeFd == -1) {
+        Unix_CloseWatcher(watcher);
+        return nullptr;
+    }
+    return watcher;
+#else
+    return nullptr;
+#endif
+}
+
+int Unix_AddWatch(Unix_Watcher* watcher, File::Filename_t directoryName) {
+#if defined(__linux__)
+    return inotify_add_watch(watcher->fd, directoryName, IN_CREATE | IN_MODIFY | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+            | IN_DELETE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK);
+#else
+    (void)watcher;
+    (void)directoryName;
+    return -1;
+#endif
+}
+
+void Unix_RemoveWatch(Unix_Watcher* watcher, int watch) {
+#if defined(__linux__)
+    inotify_rm_watch(watcher->fd, watch);
+#else
+    (void)watcher;
+    (void)watch;
+#endif
+}
+
+bool Unix_ReadWatchEvents(Unix_Watcher* watcher, int timeoutMs, std::vector<Watch_Event>& events) {
+#if defined(__linux__)
+    pollfd fds[2] = {{watcher->fd, POLLIN, 0}, {watcher->wakeFd, POLLIN, 0}};
+    if (poll(fds, 2, timeoutMs) <= 0) {
+        return true; // Timeout, or interrupted by a signal.
+    } else if (fds[1].revents) {
+        return false;
+    }
+
+    alignas(inotify_event) char buffer[64 << 10];
+    ssize_t length;
+    while ((length = read(watcher->fd, buffer, sizeof(buffer))) > 0) {
+        for (const char* p = buffer; p < buffer + length; ) {
+            const auto* event = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            Watch_EventKind kind;
+            if (event->mask & IN_Q_OVERFLOW) {
+                kind = Watch_EventKind::OVERFLOWED;
+            } else if (event->mask & IN_IGNORED) {
+                kind = Watch_EventKind::WATCH_REMOVED;
+            } else if (event->mask & IN_DELETE_SELF) {
+                kind = Watch_EventKind::SELF_DELETED;
+            } else if (event->mask & IN_CREATE) {
+                kind = Watch_EventKind::CREATED;
+            } else if (event->mask & IN_DELETE) {
+                kind = Watch_EventKind::DELETED;
+            } else if (event->mask & IN_MOVED_FROM) {
+                kind = Watch_EventKind::MOVED_FROM;
+            } else if (event->mask & IN_MOVED_TO) {
+                kind = Watch_EventKind::MOVED_TO;
+            } else if (event->mask & IN_MODIFY) {
+                kind = Watch_EventKind::MODIFIED;
+            } else {
+                continue;
+            }
+            // The name is padded with null characters up to "len".
+            events.push_back({event->wd, kind, event->cookie, (event->mask & IN_ISDIR) != 0,
+                              event->len ? File::SFilename_t(event->name) : File::SFilename_t()});
+        }
+    }
+    return true;
+#else
+    (void)watcher;
+    (void)timeoutMs;
+    (void)events;
+    return false;
+#endif
+}
+
+void Unix_WakeWatcher(Unix_Watcher* watcher) {
+#if defined(__linux__)
+    const uint64_t one = 1;
+    (void)!write(watcher->wakeFd, &one, sizeof(one));
+#else
+    (void)watcher;
+#endif
+}
+
+void Unix_CloseWatcher(Unix_Watcher* watcher) {
+    if (watcher->fd != -1) {
+        close(watcher->fd);
+    }
+    if (watcher->wakeFd != -1) {
+        close(watcher->wakeFd);
+    }
+    delete watcher;
+}
+
 #endif // no _WIN32
\ No newline at end of file
@@ -5,8 +5,14 @@
 #if !defined( MFRANCESCHI_CPPLIBRARIES_UNIXAPIHELPER_HPP) && !defined(_WIN32)
 #define MFRANCESCHI_CPPLIBRARIES_UNIXAPIHELPER_HPP
 
-#include "File.hpp"
-#include "FileOpen.hpp"
+#include "MF/File.hpp"
+#include "MF/FileBatch.hpp"
+#include "MF/FileCopy.hpp"
+#include "MF/FileOpen.hpp"
+#include "MF/FileStat.hpp"
+#include "MF/FileWriter.hpp"
+#include "TreeHelper.hpp"
+#include "WatchHelper.hpp"
 
 // ///////////////////////////////////////////////////////////////
 // //////////////// COMMAND HANDLING API /////////////////////////
@@ -20,6 +26,49 @@ struct Unix_ReadFileData : public File::ReadFileData {
     int fd = -1;
 };
 
+/// File read by windows (see File::WindowedReader).
+struct Unix_WindowedFile {
+    int fd = -1;
+};
+
+/// File read into the page cache ahead of its use (see File::Prefetcher).
+struct Unix_PrefetchedFile {
+    int fd = -1;
+};
+
+/// File being written (see File::Writer).
+struct Unix_WriteFile {
+    int fd = -1;
+    std::string target; // Name of the file to write.
+    std::string tempName; // Name of the temporary file; empty if it is anonymous (O_TMPFILE) or if not atomic.
+    bool atomic = false;
+    File::Filesize_t preallocated = 0;
+};
+
+/// Segment of a journal (see File::Journal).
+struct Unix_JournalSegment {
+    int fd = -1;
+    File::Filesize_t size = 0;
+};
+
+/// File modified in place (see File::ApplyDeltaInPlace).
+struct Unix_PatchFile {
+    int fd = -1;
+};
+
+/// File mapped to be read, and written in place if opened so (see File::MappedContainer).
+struct Unix_MappedRegion {
+    int fd = -1;
+    char* data = nullptr; // Null if the file is empty.
+    File::Filesize_t size = 0;
+};
+
+/// Set of watched directories (see File::Watcher).
+struct Unix_Watcher {
+    int fd = -1; // inotify instance.
+    int wakeFd = -1; // eventfd which interrupts a wait.
+};
+
 /**
  * Deletes a file.
  * @param filename Name of the file to delete.
@@ -55,6 +104,28 @@ bool Unix_DirectoryExists(File::Filename_t directoryName);
  */
 File::Filesize_t Unix_GetFileSize(File::Filename_t filename);
 
+/**
+ * Gets the identity (device, inode, modification time, size) of a file with "stat".
+ * @param filename Name of the file.
+ * @param identity Identity to fill.
+ * @return True on success, false on failure.
+ */
+bool Unix_GetFileIdentity(File::Filename_t filename, File::FileIdentity& identity);
+
+/**
+ * Fills rows [begin, end) of "result" (see File::StatMany). All the paths start with the same directory,
+ * which is opened once: every path is then looked up relative to it, with "statx" on Linux and "fstatat" elsewhere.
+ * @param paths All the paths.
+ * @param begin First row to fill.
+ * @param end Row after the last one to fill.
+ * @param directoryLength Length of the common directory, separator included; 0 for the current directory.
+ * @param mask Wanted fields. Their columns must already have their final size.
+ * @param followLinks If false, symbolic links are described themselves.
+ * @param result Columns to fill. Rows which cannot be accessed are left as they are.
+ */
+void Unix_StatGroup(const std::vector<File::SFilename_t>& paths, size_t begin, size_t end, size_t directoryLength,
+                    File::StatMask mask, bool followLinks, File::StatResult& result);
+
 /**
  * Creates a directory.
  * @param directoryName Name of the new directory.
@@ -75,12 +146,55 @@ File::SFilename_t Unix_GetCurrentWorkingDirectory();
  */
 void Unix_GetDirectoryContents(File::Filename_t directoryName, std::vector<File::SFilename_t>& result);
 
+/**
+ * Lists a directory with "readdir", using "lstat" only when the file system does not give the type (DT_UNKNOWN).
+ * @param directoryName Name of the directory, ending with a separator.
+ * @param entries Vector to fill.
+ * @return False if the directory could not be opened.
+ */
+bool Unix_ListDirectory(File::Filename_t directoryName, std::vector<Tree_Entry>& entries);
+
+/**
+ * Gives the type of an entry with "lstat", and reads the target of a symbolic link (see File::PathCache).
+ * @param name Name of the entry.
+ * @param type Type of the entry, symbolic links not being followed.
+ * @param target Filled with the contents of the link for a SYMLINK, as written in it.
+ * @return False if the entry does not exist or cannot be read.
+ */
+bool Unix_ReadEntry(File::Filename_t name, Tree_EntryType& type, File::SFilename_t& target);
+
+/**
+ * Opens a directory relative to another one, without following a symbolic link (see File::DeleteTree).
+ * @param parentFd Descriptor of the parent directory, or AT_FDCWD.
+ * @param name Name of the directory in its parent.
+ * @param fd Filled with the descriptor of the directory.
+ * @return True on success, false on failure.
+ */
+bool Unix_OpenDirectoryAt(int parentFd, File::Filename_t name, int& fd);
+
+/// Same as "Unix_ListDirectory", for a directory opened with "Unix_OpenDirectoryAt".
+bool Unix_ListDirectoryAt(int fd, std::vector<Tree_Entry>& entries);
+
+/**
+ * Removes an entry of a directory with "unlinkat".
+ * @param parentFd Descriptor of the directory holding the entry, or AT_FDCWD.
+ * @param name Name of the entry.
+ * @param directory If true, the entry is an empty directory (AT_REMOVEDIR).
+ * @return True on success, false on failure.
+ */
+bool Unix_RemoveAt(int parentFd, File::Filename_t name, bool directory);
+
+/// Closes a directory opened with "Unix_OpenDirectoryAt".
+void Unix_CloseDirectory(int fd);
+
 /**
  * Opens the given file and returns a pointer to a ReadFileData structure.
  * @param filename Name of the file to open.
- * @return A new structure, or nullptr if anything failed.
+ * @param strategy How to bring the file into memory; AUTO is resolved with "File::ChooseReadStrategy".
+ * @param pattern Access pattern, given to the kernel with "madvise".
+ * @return A new structure, or nullptr if anything failed (including an empty file).
  */
-const Unix_ReadFileData* Unix_OpenFile(File::Filename_t filename);
+const Unix_ReadFileData* Unix_OpenFile(File::Filename_t filename, File::ReadStrategy strategy, File::AccessPattern pattern);
 
 /**
  * Releases the memory associated with the file opened there.
@@ -88,7 +202,7 @@ const Unix_ReadFileData* Unix_OpenFile(File::Filename_t filename);
  */
 void Unix_CloseReadFileData(const Unix_ReadFileData* readFileData);
 
-/// For polymorphic reasons; actually this is a dummy function.
+/// Closes something returned by "Unix_OpenFile" but known through its base class.
 void Unix_CloseReadFileData(const File::ReadFileData* readFileData);
 
 /**
@@ -100,4 +214,192 @@ void Unix_CloseReadFileData(const File::ReadFileData* readFileData);
  */
 int Unix_ReadFileToBuffer(File::Filename_t filename, char* buffer, File::Filesize_t bufferSize);
 
+/**
+ * Reads a whole file into a new buffer: open, fstat, read, close.
+ * @param filename Name of the file to read.
+ * @param buffer Buffer to fill, left empty on failure.
+ * @return True on success, false on failure.
+ */
+bool Unix_ReadWholeFile(File::Filename_t filename, File::FileBuffer& buffer);
+
+/**
+ * Reads whole files through io_uring (see File::ReadMany). Linux only.
+ * @param filenames Names of the files to read.
+ * @param callback Called once per file, from the calling thread.
+ * @param queueDepth Maximum number of files in flight.
+ * @param succeeded Filled with the number of files successfully read.
+ * @return False if io_uring is not available: nothing was read then. If the ring fails later, the files left
+ *         are read with plain system calls: each file is always given to the callback once.
+ */
+bool Unix_ReadManyIoUring(const std::vector<File::SFilename_t>& filenames, const File::ReadManyCallback& callback,
+                          unsigned int queueDepth, size_t& succeeded);
+
+/// Returns the granularity of file mappings: offsets of mapped windows must be multiples of it.
+File::Filesize_t Unix_GetMappingGranularity();
+
+/**
+ * Opens a file to be mapped window by window, and advises the kernel that it will be read sequentially.
+ * @param filename Name of the file to open.
+ * @param fileSize Filled with the size of the file.
+ * @return A new structure, or nullptr if anything failed.
+ */
+Unix_WindowedFile* Unix_OpenWindowedFile(File::Filename_t filename, File::Filesize_t& fileSize);
+
+/**
+ * Maps a window of a file opened with "Unix_OpenWindowedFile".
+ * @param file The file.
+ * @param offset Offset of the window, multiple of "Unix_GetMappingGranularity()".
+ * @param length Length of the window.
+ * @param prefetch If true, the kernel is asked to start reading the window now (MADV_WILLNEED).
+ * @return The address of the window, or nullptr on failure.
+ */
+const char* Unix_MapWindow(const Unix_WindowedFile* file, File::Filesize_t offset, File::Filesize_t length, bool prefetch);
+
+/**
+ * Unmaps a window mapped by "Unix_MapWindow".
+ * @param dropPages If true, the pages are also dropped from the page cache (POSIX_FADV_DONTNEED).
+ */
+void Unix_UnmapWindow(const Unix_WindowedFile* file, const char* window, File::Filesize_t offset,
+                      File::Filesize_t length, bool dropPages);
+
+/// Closes a file opened with "Unix_OpenWindowedFile", and frees the structure.
+void Unix_CloseWindowedFile(Unix_WindowedFile* file);
+
+/**
+ * Opens a file and asks the system to read it into the page cache, without waiting for the reads.
+ * @param filename Name of the file.
+ * @param length Maximal number of bytes to read, from the beginning. Set to the number of bytes asked for.
+ * @return A new structure, or nullptr if the file could not be opened.
+ */
+Unix_PrefetchedFile* Unix_PrefetchFile(File::Filename_t filename, File::Filesize_t& length);
+
+/**
+ * Closes a file opened with "Unix_PrefetchFile", and frees the structure.
+ * @param dropPages If true, its pages are dropped from the cache first.
+ */
+void Unix_ReleasePrefetchedFile(Unix_PrefetchedFile* file, bool dropPages);
+
+/**
+ * Opens a file to write.
+ * @param filename Name of the file to write.
+ * @param atomic If true, an anonymous file (O_TMPFILE) is opened in the same directory,
+ *               or a temporary file next to the target if the file system does not support it.
+ * @param expectedSize If not 0, space is reserved with "fallocate" (Linux only).
+ * @return A new structure, or nullptr if anything failed.
+ */
+Unix_WriteFile* Unix_OpenWriteFile(File::Filename_t filename, bool atomic, File::Filesize_t expectedSize);
+
+/// Writes all the given bytes, retrying after partial writes. Returns false on failure.
+bool Unix_WriteToFile(const Unix_WriteFile* file, const char* data, File::Filesize_t size);
+
+/**
+ * Truncates the preallocated space, syncs according to "durability", publishes the file if atomic,
+ * closes it and frees the structure.
+ * @param size Number of bytes written.
+ * @return True on success, false on failure (an atomic target is then unchanged).
+ */
+bool Unix_CommitWriteFile(Unix_WriteFile* file, File::Filesize_t size, File::Durability durability);
+
+/// Closes the file, removes the temporary file if any, and frees the structure.
+void Unix_AbortWriteFile(Unix_WriteFile* file);
+
+/**
+ * Opens a segment of a journal to be read and written.
+ * @param filename Name of the segment.
+ * @param size Size of a new segment, whose blocks are allocated and zeroed. Ignored for an existing segment.
+ * @param create If true, the segment must not exist yet: it is created, and it is on the device (with its
+ *               directory entry) on return.
+ * @return A new structure, or nullptr if anything failed.
+ */
+Unix_JournalSegment* Unix_OpenJournalSegment(File::Filename_t filename, File::Filesize_t size, bool create);
+
+/// Writes a header then data at an offset of a segment, with one system call (pwritev).
+bool Unix_WriteJournalSegment(const Unix_JournalSegment* segment, File::Filesize_t offset, const char* header, size_t headerSize,
+                              const char* data, size_t size);
+
+/// Waits until what was written to a segment is on the device (fdatasync).
+bool Unix_SyncJournalSegment(const Unix_JournalSegment* segment);
+
+/// Closes a segment opened with "Unix_OpenJournalSegment", and frees the structure.
+void Unix_CloseJournalSegment(Unix_JournalSegment* segment);
+
+/**
+ * Opens an existing file to be read and written at any offset.
+ * @param filename Name of the file.
+ * @param size Filled with the size of the file.
+ * @return A new structure, or nullptr if the file could not be opened.
+ */
+Unix_PatchFile* Unix_OpenPatchFile(File::Filename_t filename, File::Filesize_t& size);
+
+/// Reads exactly "size" bytes at an offset of the file (pread).
+bool Unix_ReadPatchFile(const Unix_PatchFile* file, File::Filesize_t offset, char* buffer, size_t size);
+
+/// Writes data at an offset of the file (pwrite).
+bool Unix_WritePatchFile(const Unix_PatchFile* file, File::Filesize_t offset, const char* data, size_t size);
+
+/// If "resize", sets the size of the file (ftruncate), closes it, and frees the structure. Returns false if the size could not be set.
+bool Unix_ClosePatchFile(Unix_PatchFile* file, File::Filesize_t size, bool resize);
+
+/**
+ * Maps a whole file, shared with the other processes mapping it. The file is locked (flock): shared for a reader,
+ * exclusive for a writer, so that a writer never changes it under a reader.
+ * @param filename Name of the file.
+ * @param writable If true, the file is created if needed and mapped to be written; otherwise it must exist.
+ * @return A new structure, or nullptr if the file could not be opened or mapped, or is locked.
+ */
+Unix_MappedRegion* Unix_OpenMappedRegion(File::Filename_t filename, bool writable);
+
+/// Sets the size of a writable file (ftruncate) and maps it again (mremap on Linux). Its data may move.
+bool Unix_ResizeMappedRegion(Unix_MappedRegion* region, File::Filesize_t size);
+
+/// Waits until what was written through the mapping is on the device (msync, then fdatasync for the size).
+bool Unix_FlushMappedRegion(const Unix_MappedRegion* region);
+
+/// Unmaps and closes a region opened with "Unix_OpenMappedRegion", and frees the structure.
+void Unix_CloseMappedRegion(Unix_MappedRegion* region);
+
+/**
+ * Copies a regular file: FICLONE, then copy_file_range, then sendfile, then pread / pwrite (see File::Copy).
+ * Only data segments are copied (SEEK_DATA / SEEK_HOLE), so holes are preserved.
+ * @param source Name of the file to copy.
+ * @param destination Name of the copy.
+ * @param overwrite If false, fails when "destination" exists.
+ * @param size Filled with the size of the file.
+ * @return The method used, or FAILED.
+ */
+File::CopyMethod Unix_CopyFile(File::Filename_t source, File::Filename_t destination, bool overwrite, File::Filesize_t& size);
+
+/// Creates "destination" as a symbolic link with the same target as "source". Replaces an existing file.
+bool Unix_CopySymlink(File::Filename_t source, File::Filename_t destination);
+
+/**
+ * Creates an inotify instance. Linux only.
+ * @return A new structure, or nullptr if inotify is not available.
+ */
+Unix_Watcher* Unix_OpenWatcher();
+
+/**
+ * Starts watching the entries of a directory: creations, modifications, deletions and renames.
+ * Symbolic links are not followed. Adding the same directory twice returns the same watch.
+ * @return The watch descriptor, or -1 on failure.
+ */
+int Unix_AddWatch(Unix_Watcher* watcher, File::Filename_t directoryName);
+
+/// Stops a watch. A WATCH_REMOVED event follows.
+void Unix_RemoveWatch(Unix_Watcher* watcher, int watch);
+
+/**
+ * Waits for events, then reads all the queued ones without blocking.
+ * @param timeoutMs Maximum waiting time in milliseconds, -1 to wait until something happens.
+ * @param events Vector to which the events are appended.
+ * @return False if the wait was interrupted by "Unix_WakeWatcher".
+ */
+bool Unix_ReadWatchEvents(Unix_Watcher* watcher, int timeoutMs, std::vector<Watch_Event>& events);
+
+/// Interrupts the current and all later "Unix_ReadWatchEvents". Thread-safe.
+void Unix_WakeWatcher(Unix_Watcher* watcher);
+
+/// Closes the instance, removing all its watches, and frees the structure.
+void Unix_CloseWatcher(Unix_Watcher* watcher);
+
 #endif //MFRANCESCHI_CPPLIBRARIES_UNIXAPIHELPER_HPP
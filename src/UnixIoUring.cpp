@@ -0,0 +1,436 @@
+//
+// Batch reading of files through io_uring, used by File::ReadMany on Linux.
+// The ring is driven with the raw system calls, so liburing is not needed.
+//
+
+#if !defined(_WIN32)
+
+#include "UnixAPIHelper.hpp"
+
+#if defined(__linux__) && defined(__has_include)
+#   if __has_include(<linux/io_uring.h>)
+#       define MF_HAS_IO_URING 1
+#   endif
+#endif
+
+#if defined(MF_HAS_IO_URING)
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <ctime>
+#include <unistd.h>
+
+// IO_URING_OP_SUPPORTED comes with the probing of operations (Linux 5.6), like OPENAT and CLOSE.
+#if !defined(IO_URING_OP_SUPPORTED) || !defined(__NR_io_uring_setup)
+#   undef MF_HAS_IO_URING
+#endif
+
+#endif // MF_HAS_IO_URING
+
+#if defined(MF_HAS_IO_URING)
+
+namespace {
+    // Biggest read submitted at once: longer files are read in several steps.
+    constexpr File::Filesize_t MAX_READ_SIZE = 1ul << 30;
+
+    /// Submission and completion queues shared with the kernel.
+    class Ring {
+    public:
+        ~Ring() {
+            if (sqes) munmap(sqes, sqesSize);
+            if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+            if (sqRing) munmap(sqRing, sqRingSize);
+            if (fd != -1) close(fd);
+        }
+
+        /// Creates the ring; false if io_uring is not available or lacks the needed operations.
+        bool Setup(unsigned int entries) {
+            io_uring_params params{};
+            fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if (fd < 0) {
+                fd = -1;
+                return false;
+            }
+
+            sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            const bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (singleMap) {
+                sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+            }
+            sqRing = Map(sqRingSize, IORING_OFF_SQ_RING);
+            cqRing = singleMap ? sqRing : Map(cqRingSize, IORING_OFF_CQ_RING);
+            sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+            sqes = static_cast<io_uring_sqe*>(Map(sqesSize, IORING_OFF_SQES));
+            if (!sqRing || !cqRing || !sqes) {
+                return false;
+            }
+
+            auto sq = static_cast<char*>(sqRing);
+            sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+            sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            sqEntries = params.sq_entries;
+            localTail = *sqTail;
+
+            auto cq = static_cast<char*>(cqRing);
+            cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+            return Supports({IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE});
+        }
+
+        /// Next free submission entry, cleared. Null if the queue is full and its entries could not be submitted.
+        io_uring_sqe* NextSqe() {
+            if (localTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries
+                    && (!Enter(0) || localTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)) {
+                return nullptr;
+            }
+            const unsigned index = localTail & sqMask;
+            sqArray[index] = index;
+            ++localTail;
+            io_uring_sqe* sqe = &sqes[index];
+            std::memset(sqe, 0, sizeof(*sqe));
+            return sqe;
+        }
+
+        /// Submits the pending entries and waits for at least "waitFor" completions.
+        bool Enter(unsigned int waitFor) {
+            __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+            const unsigned toSubmit = localTail - submitted;
+            long result;
+            do {
+                result = syscall(__NR_io_uring_enter, fd, toSubmit, waitFor, waitFor ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            } while (result == -1 && errno == EINTR);
+            if (result >= 0) {
+                submitted += static_cast<unsigned>(result);
+            }
+            return result >= 0;
+        }
+
+        /// Position of the next submission entry, to know later whether the kernel took it.
+        unsigned Position() const {
+            return localTail;
+        }
+
+        /// True if the kernel took the entry at "position": it may then be in flight.
+        bool IsSubmitted(unsigned position) const {
+            return static_cast<int>(submitted - position) > 0;
+        }
+
+        /// Withdraws the entries the kernel has not taken yet: they will never run.
+        void DropPending() {
+            localTail = submitted;
+            __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+        }
+
+        /// Calls "handler" with every available completion, then frees them.
+        template <typename Handler>
+        void Reap(Handler handler) {
+            unsigned head = *cqHead;
+            const unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = cqes[head & cqMask];
+                handler(cqe.user_data, cqe.res);
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        }
+
+    protected:
+        void* Map(size_t size, off_t offset) const {
+            void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+            return address == MAP_FAILED ? nullptr : address;
+        }
+
+        bool Supports(std::initializer_list<unsigned int> operations) const {
+            const size_t probeSize = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+            std::unique_ptr<char[]> buffer(new char[probeSize]());
+            auto probe = reinterpret_cast<io_uring_probe*>(buffer.get());
+            if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+                return false;
+            }
+            for (unsigned int operation : operations) {
+                if (operation > probe->last_op || !(probe->ops[operation].flags & IO_URING_OP_SUPPORTED)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        int fd = -1;
+        void* sqRing = nullptr;
+        void* cqRing = nullptr;
+        io_uring_sqe* sqes = nullptr;
+        size_t sqRingSize = 0, cqRingSize = 0, sqesSize = 0;
+
+        unsigned* sqHead = nullptr;
+        unsigned* sqTail = nullptr;
+        unsigned* sqArray = nullptr;
+        unsigned sqMask = 0, sqEntries = 0;
+        unsigned localTail = 0; // Tail including the entries not published to the kernel yet.
+        unsigned submitted = 0; // Tail of what the kernel already consumed.
+
+        unsigned* cqHead = nullptr;
+        unsigned* cqTail = nullptr;
+        unsigned cqMask = 0;
+        io_uring_cqe* cqes = nullptr;
+    };
+
+    /// Kind of operation, stored in the low bits of the "user_data" of each entry.
+    enum Operation : uint64_t { OPEN = 0, READ = 1, CLOSE = 2 };
+
+    /// One file in flight: opened, then read (in several steps if it is huge), then closed.
+    struct Slot {
+        size_t index = 0; // Index of the file in the list.
+        int fd = -1; // Kept until the CLOSE completes.
+        File::FileBuffer buffer;
+        File::Filesize_t done = 0;
+        bool busy = false;
+        bool reported = false; // Given to the callback, only the CLOSE is left.
+        Operation operation = OPEN; // Operation in flight.
+        unsigned position = 0; // Its submission entry.
+    };
+
+    class Batch {
+    public:
+        Batch(Ring& ring, const std::vector<File::SFilename_t>& filenames, const File::ReadManyCallback& callback) :
+                ring(ring), filenames(filenames), callback(callback) {}
+
+        size_t Run(unsigned int queueDepth) {
+            slots.resize(std::min<size_t>(queueDepth, filenames.size()));
+            for (size_t i = 0; i < slots.size(); ++i) {
+                Start(i);
+            }
+            while (busySlots) {
+                if (ringFailed || !ring.Enter(1)) {
+                    FinishSynchronously();
+                    break;
+                }
+                ring.Reap([this](uint64_t userData, int result) { Complete(userData, result); });
+            }
+            return succeeded;
+        }
+
+    protected:
+        /// Queues an operation of a slot. Null if the ring failed: the operation is then never run.
+        io_uring_sqe* Submit(size_t slotIndex, Operation operation) {
+            slots[slotIndex].operation = operation;
+            slots[slotIndex].position = ring.Position();
+            io_uring_sqe* sqe = ringFailed ? nullptr : ring.NextSqe();
+            if (!sqe) {
+                ringFailed = true;
+                return nullptr;
+            }
+            sqe->opcode = operation == OPEN ? IORING_OP_OPENAT : operation == READ ? IORING_OP_READ : IORING_OP_CLOSE;
+            sqe->user_data = (static_cast<uint64_t>(slotIndex) << 2) | operation;
+            return sqe;
+        }
+
+        /// Starts reading the next file in the given slot, if any is left.
+        void Start(size_t slotIndex) {
+            if (next >= filenames.size() || ringFailed) {
+                return;
+            }
+            Slot& slot = slots[slotIndex];
+            slot = Slot();
+            slot.index = next++;
+            slot.busy = true;
+            ++busySlots;
+
+            if (io_uring_sqe* sqe = Submit(slotIndex, OPEN)) {
+                sqe->fd = AT_FDCWD;
+                sqe->addr = reinterpret_cast<uint64_t>(filenames[slot.index].c_str());
+                sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            }
+        }
+
+        /// Sizes the buffer once the file is open. A plain "fstat" is used: a STATX operation would be
+        /// handed to a kernel worker thread, which costs more than the system call on an inode already loaded by open.
+        void StartReading(size_t slotIndex) {
+            Slot& slot = slots[slotIndex];
+            struct stat st{};
+            if (fstat(slot.fd, &st)) {
+                Finish(slotIndex, false);
+            } else if (!st.st_size) {
+                Finish(slotIndex, true);
+            } else {
+                slot.buffer.size = static_cast<File::Filesize_t>(st.st_size);
+                slot.buffer.contents.reset(new char[slot.buffer.size]);
+                SubmitRead(slotIndex);
+            }
+        }
+
+        void SubmitRead(size_t slotIndex) {
+            Slot& slot = slots[slotIndex];
+            if (io_uring_sqe* sqe = Submit(slotIndex, READ)) {
+                sqe->fd = slot.fd;
+                sqe->addr = reinterpret_cast<uint64_t>(slot.buffer.contents.get() + slot.done);
+                sqe->len = static_cast<uint32_t>(std::min(slot.buffer.size - slot.done, MAX_READ_SIZE));
+                sqe->off = slot.done;
+            }
+        }
+
+        /// Gives the file to the callback, then closes it; the slot is reused once closed.
+        void Finish(size_t slotIndex, bool success) {
+            Slot& slot = slots[slotIndex];
+            slot.reported = true;
+            if (success) {
+                slot.buffer.size = slot.done;
+                ++succeeded;
+                callback(slot.index, std::move(slot.buffer), true);
+            } else {
+                callback(slot.index, File::FileBuffer(), false);
+            }
+
+            if (slot.fd != -1) {
+                if (io_uring_sqe* sqe = Submit(slotIndex, CLOSE)) {
+                    sqe->fd = slot.fd;
+                }
+            } else {
+                Release(slotIndex);
+            }
+        }
+
+        void Release(size_t slotIndex) {
+            slots[slotIndex].busy = false;
+            slots[slotIndex].fd = -1;
+            --busySlots;
+            Start(slotIndex);
+        }
+
+        /**
+         * The ring failed: the operations the kernel took are waited for, then the files in flight and those not
+         * started are read with plain system calls, so that every file is still given to the callback once.
+         */
+        void FinishSynchronously() {
+            ring.DropPending();
+            std::vector<char> inFlight(slots.size());
+            size_t waiting = 0;
+            for (size_t i = 0; i < slots.size(); ++i) {
+                inFlight[i] = slots[i].busy && ring.IsSubmitted(slots[i].position);
+                waiting += inFlight[i];
+            }
+            // Until they complete, they may still write the buffers, and an OPEN still gives an fd to close.
+            while (waiting) {
+                if (!ring.Enter(1)) {
+                    // Returning to user space also runs the completions queued as task work.
+                    const timespec pause{0, 1000 * 1000};
+                    nanosleep(&pause, nullptr);
+                }
+                ring.Reap([this, &inFlight, &waiting](uint64_t userData, int result) {
+                    const size_t slotIndex = userData >> 2;
+                    Slot& slot = slots[slotIndex];
+                    const auto operation = static_cast<Operation>(userData & 3);
+                    if (operation == OPEN && result >= 0) {
+                        slot.fd = result;
+                    } else if (operation == CLOSE) {
+                        slot.fd = -1;
+                    }
+                    waiting -= inFlight[slotIndex];
+                    inFlight[slotIndex] = false;
+                });
+            }
+
+            for (Slot& slot : slots) {
+                if (!slot.busy) {
+                    continue;
+                }
+                if (slot.fd != -1) {
+                    close(slot.fd);
+                }
+                if (!slot.reported) {
+                    Report(slot.index);
+                }
+                slot.busy = false;
+            }
+            busySlots = 0;
+            while (next < filenames.size()) {
+                Report(next++);
+            }
+        }
+
+        void Report(size_t index) {
+            File::FileBuffer buffer;
+            const bool success = Unix_ReadWholeFile(filenames[index].c_str(), buffer);
+            succeeded += success;
+            callback(index, std::move(buffer), success);
+        }
+
+        void Complete(uint64_t userData, int result) {
+            const size_t slotIndex = userData >> 2;
+            Slot& slot = slots[slotIndex];
+
+            switch (static_cast<Operation>(userData & 3)) {
+                case OPEN:
+                    if (result < 0) {
+                        Finish(slotIndex, false);
+                    } else {
+                        slot.fd = result;
+                        StartReading(slotIndex);
+                    }
+                    break;
+
+                case READ:
+                    if (result == -EINTR || result == -EAGAIN) {
+                        SubmitRead(slotIndex);
+                    } else if (result < 0) {
+                        Finish(slotIndex, false);
+                    } else {
+                        slot.done += static_cast<File::Filesize_t>(result);
+                        if (result && slot.done < slot.buffer.size) {
+                            SubmitRead(slotIndex);
+                        } else {
+                            Finish(slotIndex, true); // Whole file read, or it got shorter.
+                        }
+                    }
+                    break;
+
+                case CLOSE:
+                    Release(slotIndex);
+                    break;
+            }
+        }
+
+        Ring& ring;
+        const std::vector<File::SFilename_t>& filenames;
+        const File::ReadManyCallback& callback;
+        std::vector<Slot> slots;
+        size_t next = 0; // Index of the next file to start.
+        size_t busySlots = 0;
+        size_t succeeded = 0;
+        bool ringFailed = false; // No more submission: the files left are read by "FinishSynchronously".
+    };
+}
+
+bool Unix_ReadManyIoUring(const std::vector<File::SFilename_t>& filenames, const File::ReadManyCallback& callback,
+                          unsigned int queueDepth, size_t& succeeded) {
+    queueDepth = std::min(std::max(queueDepth, 1u), 4096u);
+    Ring ring;
+    // A single operation per file is in flight (open, then read, then close): the completion queue cannot overflow.
+    if (!ring.Setup(queueDepth)) {
+        return false;
+    }
+    Batch batch(ring, filenames, callback);
+    succeeded = batch.Run(queueDepth);
+    return true;
+}
+
+#else
+
+bool Unix_ReadManyIoUring(const std::vector<File::SFilename_t>&, const File::ReadManyCallback&, unsigned int, size_t&) {
+    return false;
+}
+
+#endif // MF_HAS_IO_URING
+
+#endif // !_WIN32
@@ -0,0 +1,32 @@
+//
+// Internal events of directory watches, as read from the system by the API helpers (see File::Watcher).
+//
+
+#ifndef MFRANCESCHI_CPPLIBRARIES_WATCHHELPER_HPP
+#define MFRANCESCHI_CPPLIBRARIES_WATCHHELPER_HPP
+
+#include <cstdint>
+#include "MF/File.hpp"
+
+/// What happened, in the words of the system.
+enum class Watch_EventKind {
+    CREATED,
+    MODIFIED,
+    DELETED,
+    MOVED_FROM, // First half of a rename, paired with a MOVED_TO by the cookie
+    MOVED_TO,
+    SELF_DELETED, // The watched directory itself was deleted
+    WATCH_REMOVED, // The watch does not exist anymore
+    OVERFLOWED // The system queue was full: events were lost
+};
+
+/// One event on a watched directory.
+struct Watch_Event {
+    int watch; // Descriptor returned when the directory was added, -1 for OVERFLOWED.
+    Watch_EventKind kind;
+    uint32_t cookie; // Same value for the two halves of a rename.
+    bool isDirectory;
+    File::SFilename_t name; // Name in the watched directory, empty for an event on the directory itself.
+};
+
+#endif //MFRANCESCHI_CPPLIBRARIES_WATCHHELPER_HPP
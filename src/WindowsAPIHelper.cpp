@@ -7,6 +7,10 @@
 #include <Windows.h>
 #include "WindowsAPIHelper.hpp"
 #include "StringSafePlaceHolder.hpp"
+#include "BufferPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory>
 
 void Windows_ShowErrorMessage(const char* functionName) {
     // Source: https://docs.microsoft.com/fr-fr/windows/win32/debug/retrieving-the-last-error-code
@@ -121,6 +125,59 @@ File::Filesize_t Windows_GetFileSize(File::Filename_t filename) {
     return static_cast<File::Filesize_t>(res.QuadPart);
 }
 
+bool Windows_GetFileIdentity(File::Filename_t filename, File::FileIdentity& identity) {
+    HANDLE file = CreateFile(filename, FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                             nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    BY_HANDLE_FILE_INFORMATION info;
+    const bool success = GetFileInformationByHandle(file, &info);
+    CloseHandle(file);
+    if (!success) return false;
+
+    identity.device = info.dwVolumeSerialNumber;
+    identity.inode = (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    // FILETIME counts 100 ns intervals.
+    identity.mtimeNs = static_cast<int64_t>((static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32)
+            | info.ftLastWriteTime.dwLowDateTime) * 100;
+    identity.size = static_cast<File::Filesize_t>((static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow);
+    return true;
+}
+
+void Windows_StatGroup(const std::vector<File::SFilename_t>& paths, size_t begin, size_t end, size_t,
+                       File::StatMask mask, bool followLinks, File::StatResult& result) {
+    const DWORD flags = FILE_FLAG_BACKUP_SEMANTICS | (followLinks ? 0 : FILE_FLAG_OPEN_REPARSE_POINT);
+    for (size_t row = begin; row < end; ++row) {
+        HANDLE file = CreateFile(paths[row].c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                 nullptr, OPEN_EXISTING, flags, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            continue;
+        }
+        BY_HANDLE_FILE_INFORMATION info;
+        const bool success = GetFileInformationByHandle(file, &info);
+        CloseHandle(file);
+        if (!success) {
+            continue;
+        }
+
+        const DWORD attributes = info.dwFileAttributes;
+        result.types[row] = !followLinks && (attributes & FILE_ATTRIBUTE_REPARSE_POINT) ? File::StatType::SYMLINK
+                : (attributes & FILE_ATTRIBUTE_DIRECTORY) ? File::StatType::DIRECTORY
+                : (attributes & FILE_ATTRIBUTE_DEVICE) ? File::StatType::OTHER : File::StatType::FILE;
+        if (mask & File::STAT_SIZE) {
+            result.sizes[row] = static_cast<File::Filesize_t>((static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow);
+        }
+        if (mask & File::STAT_MTIME) {
+            // FILETIME counts 100 ns intervals.
+            result.mtimesNs[row] = static_cast<int64_t>((static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32)
+                    | info.ftLastWriteTime.dwLowDateTime) * 100;
+        }
+        if (mask & File::STAT_INODE) {
+            result.devices[row] = info.dwVolumeSerialNumber;
+            result.inodes[row] = (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+        }
+    }
+}
+
 bool Windows_CreateDirectory(File::Filename_t directoryName) {
     return CreateDirectory(directoryName, nullptr);
 }
@@ -165,50 +222,191 @@ void Windows_GetDirectoryContents(File::Filename_t directoryName, std::vector<Fi
     }
 }
 
-const Windows_ReadFileData* Windows_OpenFile(File::Filename_t filename) {
-    auto rfd = static_cast<Windows_ReadFileData*>(HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(Windows_ReadFileData)));
-    rfd->size = Windows_GetFileSize(filename);
-    if (rfd->size == 0) {
-        HeapFree(GetProcessHeap(), 0, rfd);
-        return nullptr;
+bool Windows_ListDirectory(File::Filename_t directoryName, std::vector<Tree_Entry>& entries) {
+    WIN32_FIND_DATA wfd;
+    const File::SFilename_t pattern = File::SFilename_t(directoryName) + MAKE_FILE_NAME "*";
+    HANDLE hFind = FindFirstFileEx(pattern.c_str(), FindExInfoBasic, &wfd, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (hFind == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    do {
+        const File::SFilename_t name = wfd.cFileName;
+        if (name == MAKE_FILE_NAME "." || name == MAKE_FILE_NAME "..") {
+            continue;
+        }
+        Tree_EntryType type = Tree_EntryType::FILE;
+        if (wfd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+            type = Tree_EntryType::SYMLINK;
+        } else if (wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            type = Tree_EntryType::DIRECTORY;
+        } else if (wfd.dwFileAttributes & FILE_ATTRIBUTE_DEVICE) {
+            type = Tree_EntryType::OTHER;
+        }
+        entries.push_back({name, type});
+    } while (FindNextFile(hFind, &wfd));
+    FindClose(hFind);
+    return true;
+}
+
+bool Windows_ReadEntry(File::Filename_t name, Tree_EntryType& type, File::SFilename_t& target) {
+    const DWORD attributes = GetFileAttributes(name);
+    if (attributes == INVALID_FILE_ATTRIBUTES) {
+        return false;
     }
+    if (!(attributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+        type = (attributes & FILE_ATTRIBUTE_DIRECTORY) ? Tree_EntryType::DIRECTORY
+               : (attributes & FILE_ATTRIBUTE_DEVICE) ? Tree_EntryType::OTHER : Tree_EntryType::FILE;
+        return true;
+    }
+
+    // The system follows the whole chain of reparse points, and gives the final path.
+    type = Tree_EntryType::SYMLINK;
+    HANDLE file = CreateFile(name, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                             FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    target.assign(MAX_PATH, '\0');
+    DWORD length = GetFinalPathNameByHandle(file, &target[0], static_cast<DWORD>(target.size()), FILE_NAME_NORMALIZED);
+    if (length >= target.size()) {
+        target.assign(length, '\0');
+        length = GetFinalPathNameByHandle(file, &target[0], static_cast<DWORD>(target.size()), FILE_NAME_NORMALIZED);
+    }
+    CloseHandle(file);
+    if (!length || length >= target.size()) {
+        return false;
+    }
+    target.resize(length);
+    // "\\?\C:\..." for a drive, "\\?\UNC\server\..." for a share.
+    if (target.compare(0, 8, MAKE_FILE_NAME "\\\\?\\UNC\\") == 0) {
+        target.replace(0, 8, MAKE_FILE_NAME "\\\\");
+    } else if (target.compare(0, 4, MAKE_FILE_NAME "\\\\?\\") == 0) {
+        target.erase(0, 4);
+    }
+    return true;
+}
+
+bool Windows_OpenDirectoryAt(const File::SFilename_t& parent, File::Filename_t name, File::SFilename_t& directory) {
+    directory = parent + name;
+    const DWORD attributes = GetFileAttributes(directory.c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_DIRECTORY)
+            || (attributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+        return false;
+    }
+    directory = Tree_AsDirectory(directory.c_str());
+    return true;
+}
 
-    rfd->fileHandle = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+bool Windows_ListDirectoryAt(const File::SFilename_t& directory, std::vector<Tree_Entry>& entries) {
+    return Windows_ListDirectory(directory.c_str(), entries);
+}
+
+bool Windows_RemoveAt(const File::SFilename_t& parent, File::Filename_t name, bool directory) {
+    const File::SFilename_t path = parent + name;
+    if (directory) {
+        return RemoveDirectory(path.c_str()) != 0;
+    }
+    if (DeleteFile(path.c_str())) {
+        return true;
+    }
+    const DWORD attributes = GetFileAttributes(path.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY)
+            && RemoveDirectory(path.c_str());
+}
+
+const Windows_ReadFileData* Windows_OpenFile(File::Filename_t filename, File::ReadStrategy strategy, File::AccessPattern pattern) {
+    auto rfd = new Windows_ReadFileData;
+
+    const DWORD flags = FILE_ATTRIBUTE_NORMAL |
+            (pattern == File::AccessPattern::RANDOM ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN);
+    // Files still being written are readable too, such as the open segment of a File::Journal.
+    rfd->fileHandle = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, flags, nullptr);
     if (rfd->fileHandle == INVALID_HANDLE_VALUE)
     {
-        HeapFree(GetProcessHeap(), 0, rfd);
+        rfd->fileHandle = nullptr;
+        Windows_CloseReadFileData(rfd);
         return nullptr;
     }
 
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(rfd->fileHandle, &size) || size.QuadPart == 0) {
+        Windows_CloseReadFileData(rfd);
+        return nullptr;
+    }
+    rfd->size = static_cast<File::Filesize_t>(size.QuadPart);
+
+    if (strategy == File::ReadStrategy::AUTO) {
+        strategy = File::ChooseReadStrategy(rfd->size, pattern);
+    } else if (strategy == File::ReadStrategy::MMAP_HUGE_PAGES) {
+        strategy = File::ReadStrategy::MMAP;
+    }
+    rfd->strategy = strategy;
+
+    if (strategy == File::ReadStrategy::READ) {
+        char* buffer = BufferPool_Acquire(rfd->size);
+        rfd->contents = buffer;
+        File::Filesize_t done = 0;
+        bool success = true;
+        while (success && done < rfd->size) {
+            DWORD nbRead = 0;
+            const File::Filesize_t remaining = rfd->size - done;
+            const DWORD toRead = remaining < (1ul << 30) ? static_cast<DWORD>(remaining) : (1ul << 30);
+            success = ReadFile(rfd->fileHandle, buffer + done, toRead, &nbRead, nullptr) && nbRead;
+            done += nbRead;
+        }
+        CloseHandle(rfd->fileHandle);
+        rfd->fileHandle = nullptr;
+        if (!success) {
+            Windows_CloseReadFileData(rfd);
+            return nullptr;
+        }
+        return rfd;
+    }
+
     rfd->mappingHandle = CreateFileMapping(rfd->fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
-    if (rfd->mappingHandle == nullptr || GetLastError() == ERROR_ALREADY_EXISTS)
+    if (rfd->mappingHandle == nullptr)
     {
-        CloseHandle(rfd->fileHandle);
-        HeapFree(GetProcessHeap(), 0, rfd);
+        Windows_CloseReadFileData(rfd);
         return nullptr;
     }
 
     rfd->contents = (const char*)MapViewOfFile(rfd->mappingHandle, FILE_MAP_READ, 0, 0, 0);
     if (rfd->contents == nullptr)
     {
-        CloseHandle(rfd->mappingHandle);
-        CloseHandle(rfd->fileHandle);
-        HeapFree(GetProcessHeap(), 0, rfd);
+        Windows_CloseReadFileData(rfd);
         return nullptr;
     }
 
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+    if (strategy == File::ReadStrategy::MMAP_POPULATE) {
+        WIN32_MEMORY_RANGE_ENTRY range{const_cast<char*>(rfd->contents), static_cast<SIZE_T>(rfd->size)};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#endif
+
     return rfd;
 }
 
 void Windows_CloseReadFileData(const Windows_ReadFileData* readFileData) {
-    UnmapViewOfFile(readFileData->contents);
-    CloseHandle(readFileData->mappingHandle);
-    CloseHandle(readFileData->fileHandle);
-    HeapFree(GetProcessHeap(), 0, (void*) readFileData);
+    if (readFileData->contents) {
+        if (readFileData->strategy == File::ReadStrategy::READ) {
+            BufferPool_Release(const_cast<char*>(readFileData->contents), readFileData->size);
+        } else {
+            UnmapViewOfFile(readFileData->contents);
+        }
+    }
+    if (readFileData->mappingHandle) {
+        CloseHandle(readFileData->mappingHandle);
+    }
+    if (readFileData->fileHandle) {
+        CloseHandle(readFileData->fileHandle);
+    }
+    delete readFileData;
 }
 
 void Windows_CloseReadFileData(const File::ReadFileData* readFileData) {
-    (void)(readFileData); // to avoid "unused parameter warning
+    // Everything returned by "Windows_OpenFile" is a Windows_ReadFileData.
+    Windows_CloseReadFileData(static_cast<const Windows_ReadFileData*>(readFileData));
 }
 
 int Windows_ReadFileToBuffer(File::Filename_t filename, char* buffer, File::Filesize_t bufferSize) {
@@ -223,4 +421,421 @@ int Windows_ReadFileToBuffer(File::Filename_t filename, char* buffer, File::File
 
     return returnValue ? static_cast<int>(numberOfBytesRead) : -1;
 }
+
+bool Windows_ReadWholeFile(File::Filename_t filename, File::FileBuffer& buffer) {
+    HANDLE fileHandle = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                   FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+    const auto size = static_cast<File::Filesize_t>(fileSize.QuadPart);
+    std::unique_ptr<char[]> contents(size ? new char[size] : nullptr);
+
+    File::Filesize_t done = 0;
+    while (done < size) {
+        DWORD numberOfBytesRead = 0;
+        const File::Filesize_t remaining = size - done;
+        const DWORD toRead = remaining < (1ul << 30) ? static_cast<DWORD>(remaining) : (1ul << 30);
+        if (!ReadFile(fileHandle, contents.get() + done, toRead, &numberOfBytesRead, nullptr)) {
+            CloseHandle(fileHandle);
+            return false;
+        } else if (!numberOfBytesRead) {
+            break; // The file got shorter.
+        }
+        done += numberOfBytesRead;
+    }
+    CloseHandle(fileHandle);
+
+    buffer.contents = std::move(contents);
+    buffer.size = done;
+    return true;
+}
+
+File::Filesize_t Windows_GetMappingGranularity() {
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    return static_cast<File::Filesize_t>(systemInfo.dwAllocationGranularity);
+}
+
+Windows_WindowedFile* Windows_OpenWindowedFile(File::Filename_t filename, File::Filesize_t& fileSize) {
+    auto file = new Windows_WindowedFile;
+    file->fileHandle = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file->fileHandle == INVALID_HANDLE_VALUE) {
+        delete file;
+        return nullptr;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file->fileHandle, &size)) {
+        CloseHandle(file->fileHandle);
+        delete file;
+        return nullptr;
+    }
+    fileSize = static_cast<File::Filesize_t>(size.QuadPart);
+
+    file->mappingHandle = fileSize ? CreateFileMapping(file->fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    if (fileSize && file->mappingHandle == nullptr) {
+        CloseHandle(file->fileHandle);
+        delete file;
+        return nullptr;
+    }
+    return file;
+}
+
+const char* Windows_MapWindow(const Windows_WindowedFile* file, File::Filesize_t offset, File::Filesize_t length, bool prefetch) {
+    const auto offset64 = static_cast<unsigned long long>(offset);
+    void* window = MapViewOfFile(file->mappingHandle, FILE_MAP_READ,
+                                 static_cast<DWORD>(offset64 >> 32), static_cast<DWORD>(offset64 & 0xFFFFFFFFull), length);
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+    if (window && prefetch) {
+        WIN32_MEMORY_RANGE_ENTRY range{window, static_cast<SIZE_T>(length)};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    (void)prefetch;
+#endif
+    return static_cast<const char*>(window);
+}
+
+void Windows_UnmapWindow(const Windows_WindowedFile* file, const char* window, File::Filesize_t offset,
+                         File::Filesize_t length, bool dropPages) {
+    (void)file;
+    (void)offset;
+    (void)length;
+    (void)dropPages;
+    UnmapViewOfFile(window);
+}
+
+void Windows_CloseWindowedFile(Windows_WindowedFile* file) {
+    if (file->mappingHandle) {
+        CloseHandle(file->mappingHandle);
+    }
+    CloseHandle(file->fileHandle);
+    delete file;
+}
+
+Windows_PrefetchedFile* Windows_PrefetchFile(File::Filename_t, File::Filesize_t&) {
+    return nullptr;
+}
+
+void Windows_ReleasePrefetchedFile(Windows_PrefetchedFile*, bool) {}
+
+Windows_WriteFile* Windows_OpenWriteFile(File::Filename_t filename, bool atomic, File::Filesize_t expectedSize) {
+    static std::atomic<unsigned int> counter(0);
+    auto file = new Windows_WriteFile;
+    file->target = filename;
+    if (atomic) {
+        File::OSStream_t oss;
+        oss << filename << MAKE_FILE_NAME ".tmp." << GetCurrentProcessId() << MAKE_FILE_NAME "." << counter++;
+        file->tempName = oss.str();
+    }
+
+    file->fileHandle = CreateFile(atomic ? file->tempName.c_str() : filename, GENERIC_WRITE, 0, nullptr,
+                                  atomic ? CREATE_NEW : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file->fileHandle == INVALID_HANDLE_VALUE) {
+        delete file;
+        return nullptr;
+    }
+
+    if (expectedSize) {
+        FILE_ALLOCATION_INFO allocation;
+        allocation.AllocationSize.QuadPart = static_cast<LONGLONG>(expectedSize);
+        if (SetFileInformationByHandle(file->fileHandle, FileAllocationInfo, &allocation, sizeof(allocation))) {
+            file->preallocated = expectedSize;
+        }
+    }
+    return file;
+}
+
+bool Windows_WriteToFile(const Windows_WriteFile* file, const char* data, File::Filesize_t size) {
+    while (size) {
+        const DWORD toWrite = size < (1ul << 30) ? static_cast<DWORD>(size) : (1ul << 30);
+        DWORD numberOfBytesWritten = 0;
+        if (!WriteFile(file->fileHandle, data, toWrite, &numberOfBytesWritten, nullptr)) {
+            return false;
+        }
+        data += numberOfBytesWritten;
+        size -= numberOfBytesWritten;
+    }
+    return true;
+}
+
+bool Windows_CommitWriteFile(Windows_WriteFile* file, File::Filesize_t size, File::Durability durability) {
+    bool success = true;
+    if (file->preallocated > size) {
+        // The allocation is released when the file is closed, only the end of file must be set.
+        FILE_END_OF_FILE_INFO endOfFile;
+        endOfFile.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+        success = SetFileInformationByHandle(file->fileHandle, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile));
+    }
+    if (success && durability != File::Durability::NONE) {
+        success = FlushFileBuffers(file->fileHandle);
+    }
+    success &= CloseHandle(file->fileHandle) != 0;
+
+    if (!file->tempName.empty()) {
+        const DWORD flags = MOVEFILE_REPLACE_EXISTING
+                | (durability == File::Durability::SYNC_DIRECTORY ? MOVEFILE_WRITE_THROUGH : 0);
+        if (!success || !MoveFileEx(file->tempName.c_str(), file->target.c_str(), flags)) {
+            DeleteFile(file->tempName.c_str());
+            success = false;
+        }
+    }
+    delete file;
+    return success;
+}
+
+void Windows_AbortWriteFile(Windows_WriteFile* file) {
+    CloseHandle(file->fileHandle);
+    if (!file->tempName.empty()) {
+        DeleteFile(file->tempName.c_str());
+    }
+    delete file;
+}
+
+Windows_JournalSegment* Windows_OpenJournalSegment(File::Filename_t filename, File::Filesize_t size, bool create) {
+    auto segment = new Windows_JournalSegment;
+    // Shared with readers which allow writers, as "File::Read" does for "Journal::ForEach".
+    segment->fileHandle = CreateFile(filename, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                     create ? CREATE_NEW : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (segment->fileHandle == INVALID_HANDLE_VALUE) {
+        delete segment;
+        return nullptr;
+    }
+
+    bool success = true;
+    if (create) {
+        // The zeros are written now, rather than by the first synchronisations.
+        std::unique_ptr<char[]> zeros(new char[1ul << 20]());
+        for (File::Filesize_t offset = 0; success && offset < size; offset += 1ul << 20) {
+            const auto length = static_cast<size_t>(std::min<File::Filesize_t>(size - offset, 1ul << 20));
+            success = Windows_WriteJournalSegment(segment, offset, nullptr, 0, zeros.get(), length);
+        }
+        success = success && FlushFileBuffers(segment->fileHandle);
+    } else {
+        LARGE_INTEGER fileSize;
+        success = GetFileSizeEx(segment->fileHandle, &fileSize) != 0;
+        size = static_cast<File::Filesize_t>(fileSize.QuadPart);
+    }
+
+    if (!success) {
+        CloseHandle(segment->fileHandle);
+        delete segment;
+        if (create) {
+            DeleteFile(filename);
+        }
+        return nullptr;
+    }
+    segment->size = size;
+    return segment;
+}
+
+bool Windows_WriteJournalSegment(const Windows_JournalSegment* segment, File::Filesize_t offset, const char* header, size_t headerSize,
+                                 const char* data, size_t size) {
+    for (int part = 0; part < 2; ++part) {
+        const char* bytes = part ? data : header;
+        size_t remaining = part ? size : headerSize;
+        while (remaining) {
+            OVERLAPPED overlapped{};
+            overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFull);
+            overlapped.OffsetHigh = static_cast<DWORD>(static_cast<unsigned long long>(offset) >> 32);
+            const DWORD toWrite = remaining < (1ul << 30) ? static_cast<DWORD>(remaining) : (1ul << 30);
+            DWORD written = 0;
+            if (!WriteFile(segment->fileHandle, bytes, toWrite, &written, &overlapped)) {
+                return false;
+            }
+            bytes += written;
+            remaining -= written;
+            offset += written;
+        }
+    }
+    return true;
+}
+
+bool Windows_SyncJournalSegment(const Windows_JournalSegment* segment) {
+    return FlushFileBuffers(segment->fileHandle) != 0;
+}
+
+void Windows_CloseJournalSegment(Windows_JournalSegment* segment) {
+    CloseHandle(segment->fileHandle);
+    delete segment;
+}
+
+Windows_PatchFile* Windows_OpenPatchFile(File::Filename_t filename, File::Filesize_t& size) {
+    const HANDLE fileHandle = CreateFile(filename, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        CloseHandle(fileHandle);
+        return nullptr;
+    }
+    size = static_cast<File::Filesize_t>(fileSize.QuadPart);
+    auto file = new Windows_PatchFile;
+    file->fileHandle = fileHandle;
+    return file;
+}
+
+bool Windows_ReadPatchFile(const Windows_PatchFile* file, File::Filesize_t offset, char* buffer, size_t size) {
+    while (size) {
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFull);
+        overlapped.OffsetHigh = static_cast<DWORD>(static_cast<unsigned long long>(offset) >> 32);
+        const DWORD toRead = size < (1ul << 30) ? static_cast<DWORD>(size) : (1ul << 30);
+        DWORD done = 0;
+        if (!ReadFile(file->fileHandle, buffer, toRead, &done, &overlapped) || !done) {
+            return false;
+        }
+        buffer += done;
+        size -= done;
+        offset += done;
+    }
+    return true;
+}
+
+bool Windows_WritePatchFile(const Windows_PatchFile* file, File::Filesize_t offset, const char* data, size_t size) {
+    while (size) {
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFull);
+        overlapped.OffsetHigh = static_cast<DWORD>(static_cast<unsigned long long>(offset) >> 32);
+        const DWORD toWrite = size < (1ul << 30) ? static_cast<DWORD>(size) : (1ul << 30);
+        DWORD done = 0;
+        if (!WriteFile(file->fileHandle, data, toWrite, &done, &overlapped)) {
+            return false;
+        }
+        data += done;
+        size -= done;
+        offset += done;
+    }
+    return true;
+}
+
+bool Windows_ClosePatchFile(Windows_PatchFile* file, File::Filesize_t size, bool resize) {
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(size);
+    const bool success = !resize || (SetFilePointerEx(file->fileHandle, end, nullptr, FILE_BEGIN) && SetEndOfFile(file->fileHandle));
+    CloseHandle(file->fileHandle);
+    delete file;
+    return success;
+}
+
+/// Maps the current size of the file, if not empty.
+static bool MapRegion(Windows_MappedRegion* region) {
+    if (!region->size) {
+        return true;
+    }
+    region->mappingHandle = CreateFileMapping(region->fileHandle, nullptr, region->writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+    if (region->mappingHandle == nullptr) {
+        return false;
+    }
+    region->data = static_cast<char*>(MapViewOfFile(region->mappingHandle, region->writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+    if (region->data == nullptr) {
+        CloseHandle(region->mappingHandle);
+        region->mappingHandle = nullptr;
+        return false;
+    }
+    return true;
+}
+
+static void UnmapRegion(Windows_MappedRegion* region) {
+    if (region->data) {
+        UnmapViewOfFile(region->data);
+        region->data = nullptr;
+    }
+    if (region->mappingHandle) {
+        CloseHandle(region->mappingHandle);
+        region->mappingHandle = nullptr;
+    }
+}
+
+Windows_MappedRegion* Windows_OpenMappedRegion(File::Filename_t filename, bool writable) {
+    const HANDLE fileHandle = writable
+            ? CreateFile(filename, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr)
+            : CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        CloseHandle(fileHandle);
+        return nullptr;
+    }
+    auto region = new Windows_MappedRegion;
+    region->fileHandle = fileHandle;
+    region->size = static_cast<File::Filesize_t>(fileSize.QuadPart);
+    region->writable = writable;
+    if (!MapRegion(region)) {
+        CloseHandle(fileHandle);
+        delete region;
+        return nullptr;
+    }
+    return region;
+}
+
+bool Windows_ResizeMappedRegion(Windows_MappedRegion* region, File::Filesize_t size) {
+    // A mapped file cannot change size: it is unmapped, resized, and mapped again.
+    UnmapRegion(region);
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(size);
+    const bool resized = SetFilePointerEx(region->fileHandle, end, nullptr, FILE_BEGIN) && SetEndOfFile(region->fileHandle);
+    if (resized) {
+        region->size = size;
+    }
+    return MapRegion(region) && resized;
+}
+
+bool Windows_FlushMappedRegion(const Windows_MappedRegion* region) {
+    if (region->data && !FlushViewOfFile(region->data, 0)) {
+        return false;
+    }
+    return FlushFileBuffers(region->fileHandle) != 0;
+}
+
+void Windows_CloseMappedRegion(Windows_MappedRegion* region) {
+    UnmapRegion(region);
+    CloseHandle(region->fileHandle);
+    delete region;
+}
+
+File::CopyMethod Windows_CopyFile(File::Filename_t source, File::Filename_t destination, bool overwrite, File::Filesize_t& size) {
+    size = Windows_GetFileSize(source);
+    if (!CopyFileEx(source, destination, nullptr, nullptr, nullptr, overwrite ? 0 : COPY_FILE_FAIL_IF_EXISTS)) {
+        return File::CopyMethod::FAILED;
+    }
+    return File::CopyMethod::SYSTEM;
+}
+
+bool Windows_CopySymlink(File::Filename_t source, File::Filename_t destination) {
+    return CopyFileEx(source, destination, nullptr, nullptr, nullptr, COPY_FILE_COPY_SYMLINK);
+}
+
+Windows_Watcher* Windows_OpenWatcher() {
+    return nullptr;
+}
+
+int Windows_AddWatch(Windows_Watcher*, File::Filename_t) {
+    return -1;
+}
+
+void Windows_RemoveWatch(Windows_Watcher*, int) {}
+
+bool Windows_ReadWatchEvents(Windows_Watcher*, int, std::vector<Watch_Event>&) {
+    return false;
+}
+
+void Windows_WakeWatcher(Windows_Watcher*) {}
+
+void Windows_CloseWatcher(Windows_Watcher* watcher) {
+    delete watcher;
+}
+
 #endif
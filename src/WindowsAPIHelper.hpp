@@ -7,7 +7,13 @@
 
 #include <string>
 #include "MF/File.hpp"
+#include "MF/FileBatch.hpp"
+#include "MF/FileCopy.hpp"
 #include "MF/FileOpen.hpp"
+#include "MF/FileStat.hpp"
+#include "MF/FileWriter.hpp"
+#include "TreeHelper.hpp"
+#include "WatchHelper.hpp"
 #include "MF/Command.hpp"
 
 /**
@@ -69,6 +75,43 @@ struct Windows_ReadFileData : public File::ReadFileData {
     Windows_FileHandle mappingHandle = nullptr;
 };
 
+/// File being written (see File::Writer).
+struct Windows_WriteFile {
+    Windows_FileHandle fileHandle = nullptr;
+    File::SFilename_t target; // Name of the file to write.
+    File::SFilename_t tempName; // Name of the temporary file, empty if not atomic.
+    File::Filesize_t preallocated = 0;
+};
+
+/// Segment of a journal (see File::Journal).
+struct Windows_JournalSegment {
+    Windows_FileHandle fileHandle = nullptr;
+    File::Filesize_t size = 0;
+};
+
+/// File modified in place (see File::ApplyDeltaInPlace).
+struct Windows_PatchFile {
+    Windows_FileHandle fileHandle = nullptr;
+};
+
+/// File mapped to be read, and written in place if opened so (see File::MappedContainer).
+struct Windows_MappedRegion {
+    Windows_FileHandle fileHandle = nullptr;
+    Windows_FileHandle mappingHandle = nullptr;
+    char* data = nullptr; // Null if the file is empty.
+    File::Filesize_t size = 0;
+    bool writable = false;
+};
+
+/// File read by windows (see File::WindowedReader).
+struct Windows_WindowedFile {
+    Windows_FileHandle fileHandle = nullptr;
+    Windows_FileHandle mappingHandle = nullptr;
+};
+
+/// File read into the page cache ahead of its use (see File::Prefetcher). Never created on Windows.
+struct Windows_PrefetchedFile;
+
 /**
  * Deletes a file.
  * @param filename Name of the file to delete.
@@ -104,6 +147,21 @@ bool Windows_DirectoryExists(File::Filename_t directoryName);
  */
 File::Filesize_t Windows_GetFileSize(File::Filename_t filename);
 
+/**
+ * Gets the identity (volume, file index, last write time, size) of a file.
+ * @param filename Name of the file.
+ * @param identity Identity to fill.
+ * @return True on success, false on failure.
+ */
+bool Windows_GetFileIdentity(File::Filename_t filename, File::FileIdentity& identity);
+
+/**
+ * Fills rows [begin, end) of "result" (see File::StatMany), with one CreateFile and GetFileInformationByHandle per path:
+ * Windows has no directory-relative lookups, so "directoryLength" is not used.
+ */
+void Windows_StatGroup(const std::vector<File::SFilename_t>& paths, size_t begin, size_t end, size_t directoryLength,
+                       File::StatMask mask, bool followLinks, File::StatResult& result);
+
 /**
  * Creates a directory.
  * @param directoryName Name of the new directory.
@@ -125,11 +183,55 @@ File::SFilename_t Windows_GetCurrentWorkingDirectory();
 void Windows_GetDirectoryContents(File::Filename_t directoryName, std::vector<File::SFilename_t>& result);
 
 /**
- * Opens the given file and returns a pointer to a ReadFileData structure.
+ * Lists a directory with FindFirstFileEx. Reparse points (symbolic links, junctions) are reported as SYMLINK.
+ * @param directoryName Name of the directory, ending with a separator.
+ * @param entries Vector to fill.
+ * @return False if the directory could not be opened.
+ */
+bool Windows_ListDirectory(File::Filename_t directoryName, std::vector<Tree_Entry>& entries);
+
+/**
+ * Gives the type of an entry, and where a reparse point leads (see File::PathCache).
+ * @param name Name of the entry.
+ * @param type Type of the entry: reparse points (symbolic links, junctions) are SYMLINK.
+ * @param target Filled with the absolute final path of a SYMLINK, as opened by the system.
+ * @return False if the entry does not exist, or if a reparse point cannot be opened.
+ */
+bool Windows_ReadEntry(File::Filename_t name, Tree_EntryType& type, File::SFilename_t& target);
+
+/**
+ * Windows has no descriptor-relative calls: a directory is "opened" by building its name (see File::DeleteTree).
+ * @param parent Name of the parent directory ending with a separator, or empty for the current directory.
+ * @param name Name of the directory in its parent.
+ * @param directory Filled with the name of the directory, ending with a separator.
+ * @return False if it is not a directory (reparse points included).
+ */
+bool Windows_OpenDirectoryAt(const File::SFilename_t& parent, File::Filename_t name, File::SFilename_t& directory);
+
+/// Same as "Windows_ListDirectory", for a directory opened with "Windows_OpenDirectoryAt".
+bool Windows_ListDirectoryAt(const File::SFilename_t& directory, std::vector<Tree_Entry>& entries);
+
+/**
+ * Removes an entry of a directory. A reparse point to a directory is removed as a directory, without following it.
+ * @param parent Name of the directory holding the entry, as given by "Windows_OpenDirectoryAt".
+ * @param name Name of the entry.
+ * @param directory If true, the entry is an empty directory.
+ * @return True on success, false on failure.
+ */
+bool Windows_RemoveAt(const File::SFilename_t& parent, File::Filename_t name, bool directory);
+
+/// Nothing to release.
+inline void Windows_CloseDirectory(const File::SFilename_t&) {}
+
+/**
+ * Opens the given file and returns a pointer to a ReadFileData structure. The file may be open for writing elsewhere.
  * @param filename Name of the file to open.
- * @return A new structure, or nullptr if anything failed.
+ * @param strategy How to bring the file into memory; AUTO is resolved with "File::ChooseReadStrategy".
+ *                 MMAP_HUGE_PAGES is not supported for file mappings and falls back to MMAP.
+ * @param pattern Access pattern, given to the system when opening the file.
+ * @return A new structure, or nullptr if anything failed (including an empty file).
  */
-const Windows_ReadFileData* Windows_OpenFile(File::Filename_t filename);
+const Windows_ReadFileData* Windows_OpenFile(File::Filename_t filename, File::ReadStrategy strategy, File::AccessPattern pattern);
 
 /**
  * Releases the memory associated with the file opened there.
@@ -137,7 +239,7 @@ const Windows_ReadFileData* Windows_OpenFile(File::Filename_t filename);
  */
 void Windows_CloseReadFileData(const Windows_ReadFileData* readFileData);
 
-/// For polymorphic reasons; actually this is a dummy function.
+/// Closes something returned by "Windows_OpenFile" but known through its base class.
 void Windows_CloseReadFileData(const File::ReadFileData* readFileData);
 
 /**
@@ -149,4 +251,148 @@ void Windows_CloseReadFileData(const File::ReadFileData* readFileData);
  */
 int Windows_ReadFileToBuffer(File::Filename_t filename, char* buffer, File::Filesize_t bufferSize);
 
+/**
+ * Reads a whole file into a new buffer.
+ * @param filename Name of the file to read.
+ * @param buffer Buffer to fill, left empty on failure.
+ * @return True on success, false on failure.
+ */
+bool Windows_ReadWholeFile(File::Filename_t filename, File::FileBuffer& buffer);
+
+/// Returns the granularity of file mappings: offsets of mapped windows must be multiples of it.
+File::Filesize_t Windows_GetMappingGranularity();
+
+/**
+ * Opens a file to be mapped window by window, with the sequential scan hint.
+ * @param filename Name of the file to open.
+ * @param fileSize Filled with the size of the file.
+ * @return A new structure, or nullptr if anything failed.
+ */
+Windows_WindowedFile* Windows_OpenWindowedFile(File::Filename_t filename, File::Filesize_t& fileSize);
+
+/**
+ * Maps a window of a file opened with "Windows_OpenWindowedFile".
+ * @param file The file.
+ * @param offset Offset of the window, multiple of "Windows_GetMappingGranularity()".
+ * @param length Length of the window.
+ * @param prefetch If true, the system is asked to start reading the window now (PrefetchVirtualMemory).
+ * @return The address of the window, or nullptr on failure.
+ */
+const char* Windows_MapWindow(const Windows_WindowedFile* file, File::Filesize_t offset, File::Filesize_t length, bool prefetch);
+
+/// Unmaps a window mapped by "Windows_MapWindow". Pages cannot be dropped from the cache on Windows.
+void Windows_UnmapWindow(const Windows_WindowedFile* file, const char* window, File::Filesize_t offset,
+                         File::Filesize_t length, bool dropPages);
+
+/// Closes a file opened with "Windows_OpenWindowedFile", and frees the structure.
+void Windows_CloseWindowedFile(Windows_WindowedFile* file);
+
+/// Returns nullptr: there is no way to read a file into the cache without waiting for it on Windows.
+Windows_PrefetchedFile* Windows_PrefetchFile(File::Filename_t filename, File::Filesize_t& length);
+
+/// Never called, as no file can be prefetched.
+void Windows_ReleasePrefetchedFile(Windows_PrefetchedFile* file, bool dropPages);
+
+/**
+ * Opens a file to write.
+ * @param filename Name of the file to write.
+ * @param atomic If true, a temporary file is opened next to the target instead.
+ * @param expectedSize If not 0, space is reserved upfront (FileAllocationInfo).
+ * @return A new structure, or nullptr if anything failed.
+ */
+Windows_WriteFile* Windows_OpenWriteFile(File::Filename_t filename, bool atomic, File::Filesize_t expectedSize);
+
+/// Writes all the given bytes. Returns false on failure.
+bool Windows_WriteToFile(const Windows_WriteFile* file, const char* data, File::Filesize_t size);
+
+/**
+ * Truncates the preallocated space, flushes according to "durability", closes the file,
+ * replaces the target with it if atomic (MoveFileEx), and frees the structure.
+ * @param size Number of bytes written.
+ * @return True on success, false on failure (an atomic target is then unchanged).
+ */
+bool Windows_CommitWriteFile(Windows_WriteFile* file, File::Filesize_t size, File::Durability durability);
+
+/// Closes the file, removes the temporary file if any, and frees the structure.
+void Windows_AbortWriteFile(Windows_WriteFile* file);
+
+/**
+ * Opens a segment of a journal to be read and written.
+ * @param filename Name of the segment.
+ * @param size Size of a new segment, which is filled with zeros. Ignored for an existing segment.
+ * @param create If true, the segment must not exist yet: it is created, and it is on the device on return.
+ * @return A new structure, or nullptr if anything failed.
+ */
+Windows_JournalSegment* Windows_OpenJournalSegment(File::Filename_t filename, File::Filesize_t size, bool create);
+
+/// Writes a header then data at an offset of a segment.
+bool Windows_WriteJournalSegment(const Windows_JournalSegment* segment, File::Filesize_t offset, const char* header, size_t headerSize,
+                                 const char* data, size_t size);
+
+/// Waits until what was written to a segment is on the device (FlushFileBuffers).
+bool Windows_SyncJournalSegment(const Windows_JournalSegment* segment);
+
+/// Closes a segment opened with "Windows_OpenJournalSegment", and frees the structure.
+void Windows_CloseJournalSegment(Windows_JournalSegment* segment);
+
+/**
+ * Opens an existing file to be read and written at any offset.
+ * @param filename Name of the file.
+ * @param size Filled with the size of the file.
+ * @return A new structure, or nullptr if the file could not be opened.
+ */
+Windows_PatchFile* Windows_OpenPatchFile(File::Filename_t filename, File::Filesize_t& size);
+
+/// Reads exactly "size" bytes at an offset of the file.
+bool Windows_ReadPatchFile(const Windows_PatchFile* file, File::Filesize_t offset, char* buffer, size_t size);
+
+/// Writes data at an offset of the file.
+bool Windows_WritePatchFile(const Windows_PatchFile* file, File::Filesize_t offset, const char* data, size_t size);
+
+/// If "resize", sets the size of the file (SetEndOfFile), closes it, and frees the structure. Returns false if the size could not be set.
+bool Windows_ClosePatchFile(Windows_PatchFile* file, File::Filesize_t size, bool resize);
+
+/**
+ * Maps a whole file. A reader shares it with other readers only, a writer with nobody (sharing modes),
+ * so that a writer never changes it under a reader.
+ * @param filename Name of the file.
+ * @param writable If true, the file is created if needed and mapped to be written; otherwise it must exist.
+ * @return A new structure, or nullptr if the file could not be opened or mapped, or is in use.
+ */
+Windows_MappedRegion* Windows_OpenMappedRegion(File::Filename_t filename, bool writable);
+
+/// Sets the size of a writable file (SetEndOfFile) and maps it again. Its data may move.
+bool Windows_ResizeMappedRegion(Windows_MappedRegion* region, File::Filesize_t size);
+
+/// Waits until what was written through the mapping is on the device (FlushViewOfFile, then FlushFileBuffers).
+bool Windows_FlushMappedRegion(const Windows_MappedRegion* region);
+
+/// Unmaps and closes a region opened with "Windows_OpenMappedRegion", and frees the structure.
+void Windows_CloseMappedRegion(Windows_MappedRegion* region);
+
+/**
+ * Copies a file with CopyFileEx, which uses block cloning where the file system supports it (ReFS)
+ * and keeps sparse regions.
+ * @param overwrite If false, fails when "destination" exists.
+ * @param size Filled with the size of the file.
+ * @return SYSTEM on success, FAILED on failure.
+ */
+File::CopyMethod Windows_CopyFile(File::Filename_t source, File::Filename_t destination, bool overwrite, File::Filesize_t& size);
+
+/// Copies a symbolic link to a file as a link (COPY_FILE_COPY_SYMLINK). Replaces an existing file.
+bool Windows_CopySymlink(File::Filename_t source, File::Filename_t destination);
+
+/// Set of watched directories (see File::Watcher). Not supported yet: ReadDirectoryChangesW has no watch descriptors.
+struct Windows_Watcher {};
+
+/// Returns nullptr: directory watching is not supported on Windows yet.
+Windows_Watcher* Windows_OpenWatcher();
+
+/// Never called, as no watcher can be opened.
+int Windows_AddWatch(Windows_Watcher* watcher, File::Filename_t directoryName);
+void Windows_RemoveWatch(Windows_Watcher* watcher, int watch);
+bool Windows_ReadWatchEvents(Windows_Watcher* watcher, int timeoutMs, std::vector<Watch_Event>& events);
+void Windows_WakeWatcher(Windows_Watcher* watcher);
+void Windows_CloseWatcher(Windows_Watcher* watcher);
+
 #endif //MYWORKS_TEST0_WINDOWSAPIHELPER_HPP
@@ -0,0 +1,60 @@
+//
+// Tests of the batch reading of files.
+//
+
+#include "tests_datas.hpp"
+
+static std::vector<File::SFilename_t> TestFiles(size_t repetitions) {
+    std::vector<File::SFilename_t> filenames;
+    for (size_t i = 0; i < repetitions; ++i) {
+        filenames.push_back(File::MakeFilename(false, false, 2, TEST_FILES_DIR_PREFIX, MAKE_FILE_NAME "aom_v.scx"));
+        filenames.push_back(File::MakeFilename(false, false, 2, TEST_FILES_DIR_PREFIX, MAKE_FILE_NAME "Small_utf16le.txt"));
+        filenames.push_back(MAKE_FILE_NAME "not_existing._tut");
+        filenames.push_back(File::MakeFilename(false, true, 2, TEST_FILES_DIR_PREFIX, MAKE_FILE_NAME "EmptyFolder"));
+    }
+    return filenames;
+}
+
+static void CheckReadMany(const File::ReadManyOptions& options) {
+    const std::vector<File::SFilename_t> filenames = TestFiles(25);
+    std::vector<std::string> expected(filenames.size());
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        File::ReadToString(filenames[i].c_str(), expected[i]);
+    }
+
+    std::vector<int> calls(filenames.size(), 0);
+    const size_t succeeded = File::ReadMany(filenames, [&](size_t index, File::FileBuffer&& buffer, bool success) {
+        ASSERT_LT(index, filenames.size());
+        ++calls[index];
+        EXPECT_EQ(success, index % 4 < 2) << "File " << index;
+        if (success) {
+            EXPECT_EQ(std::string(buffer.contents.get(), buffer.size), expected[index]);
+        } else {
+            EXPECT_EQ(buffer.contents, nullptr);
+        }
+    }, options);
+
+    EXPECT_EQ(succeeded, filenames.size() / 2);
+    EXPECT_EQ(calls, std::vector<int>(filenames.size(), 1));
+}
+
+TEST(ReadMany, Default) {
+    CheckReadMany(File::ReadManyOptions());
+}
+
+TEST(ReadMany, QueueDepthOfOne) {
+    File::ReadManyOptions options;
+    options.queueDepth = 1;
+    CheckReadMany(options);
+}
+
+TEST(ReadMany, ThreadPool) {
+    File::ReadManyOptions options;
+    options.useIoUring = false;
+    options.threads = 3;
+    CheckReadMany(options);
+}
+
+TEST(ReadMany, NoFile) {
+    EXPECT_EQ(File::ReadMany({}, [](size_t, File::FileBuffer&&, bool) { FAIL(); }), 0u);
+}
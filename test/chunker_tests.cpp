@@ -0,0 +1,98 @@
+//
+// Tests of the content-defined chunking.
+//
+
+#include <set>
+#include "tests_datas.hpp"
+
+static void ExpectCovers(const std::vector<File::Chunk>& chunks, File::Filesize_t size, const File::ChunkOptions& options) {
+    File::Filesize_t offset = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        EXPECT_EQ(chunks[i].offset, offset);
+        EXPECT_LE(chunks[i].size, options.maxSize);
+        if (i + 1 < chunks.size()) {
+            EXPECT_GT(chunks[i].size, options.minSize);
+        }
+        offset += chunks[i].size;
+    }
+    EXPECT_EQ(offset, size);
+}
+
+TEST(FindChunks, Sizes) {
+    const std::string data = RandomBytes(1u << 20, 1);
+    File::ChunkOptions options;
+    options.threads = 1;
+    const std::vector<File::Chunk> chunks = File::FindChunks(data.data(), data.size(), options);
+    ExpectCovers(chunks, data.size(), options);
+    // About one chunk per "avgSize" bytes, after the skipped minimum.
+    EXPECT_GT(chunks.size(), data.size() / (options.avgSize * 2));
+    EXPECT_LT(chunks.size(), data.size() / options.avgSize);
+
+    // Same bytes, same hash.
+    const std::string twice = data.substr(0, 100000) + data.substr(0, 100000);
+    const std::vector<File::Chunk> repeated = File::FindChunks(twice.data(), twice.size(), options);
+    std::set<uint64_t> hashes;
+    for (const File::Chunk& chunk : repeated) {
+        hashes.insert(chunk.hash);
+    }
+    EXPECT_LT(hashes.size(), repeated.size() - 5);
+
+    EXPECT_TRUE(File::FindChunks(data.data(), 0, options).empty());
+    const std::vector<File::Chunk> small = File::FindChunks(data.data(), 100, options);
+    ASSERT_EQ(small.size(), 1u);
+    EXPECT_EQ(small.front().size, 100u);
+    EXPECT_NE(small.front().hash, 0u);
+    options.hashChunks = false;
+    EXPECT_EQ(File::FindChunks(data.data(), 100, options).front().hash, 0u);
+
+    // Constant bytes never give a cut point: the chunks are as big as allowed.
+    const std::string zeros(100000, '\0');
+    options.threads = 1;
+    for (const File::Chunk& chunk : File::FindChunks(zeros.data(), zeros.size(), options)) {
+        EXPECT_TRUE(chunk.size == options.maxSize || chunk.offset + chunk.size == zeros.size());
+    }
+}
+
+TEST(FindChunks, Insertion) {
+    const std::string data = RandomBytes(1u << 20, 2);
+    std::string edited = data;
+    edited.insert(edited.size() / 3, "inserted bytes");
+    edited.erase(2 * edited.size() / 3, 1000);
+    File::ChunkOptions options;
+    options.avgSize = 4096;
+    const std::vector<File::Chunk> before = File::FindChunks(data.data(), data.size(), options);
+    const std::vector<File::Chunk> after = File::FindChunks(edited.data(), edited.size(), options);
+
+    std::set<uint64_t> known;
+    for (const File::Chunk& chunk : before) {
+        known.insert(chunk.hash);
+    }
+    size_t changed = 0;
+    for (const File::Chunk& chunk : after) {
+        changed += !known.count(chunk.hash);
+    }
+    // Only the chunks around each edit differ.
+    EXPECT_GE(changed, 2u);
+    EXPECT_LE(changed, 6u);
+}
+
+TEST(FindChunks, Parallel) {
+    // Several segments, with small chunks so that they are many per segment.
+    const std::string data = RandomBytes(20u << 20, 3);
+    File::ChunkOptions options;
+    options.minSize = 256;
+    options.avgSize = 1024;
+    options.maxSize = 4096;
+    options.threads = 1;
+    const std::vector<File::Chunk> serial = File::FindChunks(data.data(), data.size(), options);
+    ExpectCovers(serial, data.size(), options);
+    options.threads = 4;
+    EXPECT_EQ(File::FindChunks(data.data(), data.size(), options), serial);
+
+    // The same, with segments starting in the middle of long chunks.
+    const std::string zeros = std::string(9u << 20, '\0') + data.substr(0, 9u << 20);
+    options.threads = 1;
+    const std::vector<File::Chunk> serialZeros = File::FindChunks(zeros.data(), zeros.size(), options);
+    options.threads = 3;
+    EXPECT_EQ(File::FindChunks(zeros.data(), zeros.size(), options), serialZeros);
+}
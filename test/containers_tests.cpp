@@ -0,0 +1,128 @@
+//
+// Tests of the containers stored in memory-mapped files.
+//
+
+#include "tests_datas.hpp"
+
+static const File::SFilename_t CONTAINERS_FOLDER = MAKE_FILE_NAME "ContainersTests.tmp" FILE_SEPARATOR;
+static const File::SFilename_t CONTAINERS_FILE = CONTAINERS_FOLDER + MAKE_FILE_NAME "container";
+
+class ContainersTest : public TemporaryFolderTest {
+protected:
+    ContainersTest() : TemporaryFolderTest(CONTAINERS_FOLDER) {}
+};
+
+struct ContainersPoint {
+    int32_t x;
+    int32_t y;
+};
+
+TEST_F(ContainersTest, Vector) {
+    {
+        File::MappedVector<ContainersPoint> points(CONTAINERS_FILE.c_str());
+        ASSERT_TRUE(points.IsOpen());
+        EXPECT_TRUE(points.Empty());
+        for (int32_t i = 0; i < 100000; ++i) {
+            ASSERT_TRUE(points.PushBack({i, -i}));
+        }
+        ASSERT_TRUE(points.PushBack(points[0])); // Moved by the growth.
+        EXPECT_EQ(points.Back().x, 0);
+        EXPECT_TRUE(points.PopBack());
+        EXPECT_GE(points.Capacity(), 100000u);
+        EXPECT_TRUE(points.Flush());
+    }
+
+    // Reopened as it was left, by several readers.
+    File::MappedVector<ContainersPoint> reader(CONTAINERS_FILE.c_str(), File::MappedMode::READ_ONLY);
+    File::MappedVector<ContainersPoint> other(CONTAINERS_FILE.c_str(), File::MappedMode::READ_ONLY);
+    ASSERT_TRUE(reader.IsOpen());
+    ASSERT_TRUE(other.IsOpen());
+    ASSERT_EQ(reader.Size(), 100000u);
+    int64_t sum = 0;
+    for (const ContainersPoint& point : reader) {
+        sum += point.x + point.y;
+    }
+    EXPECT_EQ(sum, 0);
+    EXPECT_EQ(other[99999].y, -99999);
+    EXPECT_FALSE(reader.PushBack({1, 1}));
+    EXPECT_FALSE(reader.Resize(10));
+    EXPECT_FALSE(reader.PopBack());
+    EXPECT_EQ(reader.Size(), 100000u);
+
+    // A writer waits for the readers to leave.
+    EXPECT_FALSE(File::MappedVector<ContainersPoint>(CONTAINERS_FILE.c_str()).IsOpen());
+    reader.Close();
+    other = File::MappedVector<ContainersPoint>();
+    File::MappedVector<ContainersPoint> writer(CONTAINERS_FILE.c_str());
+    ASSERT_TRUE(writer.IsOpen());
+    ASSERT_TRUE(writer.Resize(10));
+    ASSERT_TRUE(writer.ShrinkToFit());
+    EXPECT_EQ(writer.Capacity(), 10u);
+    ASSERT_TRUE(writer.Resize(12));
+    EXPECT_EQ(writer[9].x, 9);
+    EXPECT_EQ(writer[11].x, 0);
+    writer.Close();
+    EXPECT_FALSE(writer.PopBack());
+
+    // Nothing to remove from an empty container.
+    File::MappedVector<ContainersPoint> empty((CONTAINERS_FOLDER + MAKE_FILE_NAME "empty").c_str());
+    ASSERT_TRUE(empty.IsOpen());
+    EXPECT_FALSE(empty.PopBack());
+    EXPECT_EQ(empty.Size(), 0u);
+    empty.Close();
+
+    // Another kind of element, or not a container.
+    EXPECT_FALSE(File::MappedVector<int64_t>(CONTAINERS_FILE.c_str()).IsOpen());
+    EXPECT_FALSE((File::MappedHashMap<int32_t, int32_t>(CONTAINERS_FILE.c_str()).IsOpen()));
+    std::ofstream(CONTAINERS_FILE, std::ios_base::binary | std::ios_base::trunc) << "not a container";
+    EXPECT_FALSE(File::MappedVector<ContainersPoint>(CONTAINERS_FILE.c_str()).IsOpen());
+    EXPECT_FALSE(File::MappedVector<ContainersPoint>((CONTAINERS_FOLDER + MAKE_FILE_NAME "missing").c_str(),
+                                                     File::MappedMode::READ_ONLY).IsOpen());
+}
+
+TEST_F(ContainersTest, HashMap) {
+    {
+        File::MappedHashMap<uint64_t, ContainersPoint> map(CONTAINERS_FILE.c_str());
+        ASSERT_TRUE(map.IsOpen());
+        EXPECT_EQ(map.Find(1), nullptr);
+        for (uint64_t i = 0; i < 50000; ++i) {
+            ASSERT_TRUE(map.Set(i * 7919, {static_cast<int32_t>(i), 0}));
+        }
+        EXPECT_EQ(map.Size(), 50000u);
+        EXPECT_LE(map.Size(), map.Capacity() / 4 * 3);
+        ASSERT_TRUE(map.Set(7919, {-1, -1}));
+        EXPECT_EQ(map.Size(), 50000u);
+        // Erasing every other key moves the others back: all must still be found.
+        for (uint64_t i = 0; i < 50000; i += 2) {
+            ASSERT_TRUE(map.Erase(i * 7919));
+        }
+        EXPECT_FALSE(map.Erase(0));
+        EXPECT_EQ(map.Size(), 25000u);
+        EXPECT_TRUE(map.Flush());
+    }
+
+    File::MappedHashMap<uint64_t, ContainersPoint> map(CONTAINERS_FILE.c_str(), File::MappedMode::READ_ONLY);
+    ASSERT_TRUE(map.IsOpen());
+    EXPECT_EQ(map.Size(), 25000u);
+    for (uint64_t i = 0; i < 50000; ++i) {
+        const ContainersPoint* point = map.Find(i * 7919);
+        if (i % 2) {
+            ASSERT_NE(point, nullptr);
+            EXPECT_EQ(point->x, i == 1 ? -1 : static_cast<int32_t>(i));
+        } else {
+            EXPECT_EQ(point, nullptr);
+        }
+    }
+    size_t count = 0;
+    map.ForEach([&count](uint64_t key, const ContainersPoint& point) {
+        count += key % 7919 == 0 && (point.x == -1 || key / 7919 == static_cast<uint64_t>(point.x));
+    });
+    EXPECT_EQ(count, 25000u);
+    EXPECT_FALSE(map.Set(1, {0, 0}));
+    map.Close();
+
+    File::MappedHashMap<uint64_t, ContainersPoint> writer(CONTAINERS_FILE.c_str());
+    ASSERT_TRUE(writer.Clear());
+    EXPECT_TRUE(writer.Empty());
+    EXPECT_FALSE(writer.Contains(7919));
+}
@@ -0,0 +1,109 @@
+//
+// Tests of the copy of files and trees.
+//
+
+#include "tests_datas.hpp"
+#if !defined(_WIN32)
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+static const File::SFilename_t COPY_FOLDER = MAKE_FILE_NAME "CopyTests.tmp" FILE_SEPARATOR;
+
+class CopyTest : public TemporaryFolderTest {
+protected:
+    CopyTest() : TemporaryFolderTest(COPY_FOLDER) {}
+};
+
+TEST_F(CopyTest, File) {
+    const File::SFilename_t copy = COPY_FOLDER + MAKE_FILE_NAME "copy.scx";
+    EXPECT_NE(File::Copy(FILENAME_MIDDLE_SIZE.c_str(), copy.c_str()), File::CopyMethod::FAILED);
+    EXPECT_TRUE(Contents(copy) == Contents(FILENAME_MIDDLE_SIZE));
+
+    EXPECT_EQ(File::Copy(FILENAME_MIDDLE_SIZE.c_str(), copy.c_str(), false), File::CopyMethod::FAILED);
+    EXPECT_NE(File::Copy(FILENAME_MIDDLE_SIZE.c_str(), copy.c_str(), true), File::CopyMethod::FAILED);
+
+    // Never onto the source itself.
+    EXPECT_EQ(File::Copy(copy.c_str(), copy.c_str(), true), File::CopyMethod::FAILED);
+    EXPECT_TRUE(Contents(copy) == Contents(FILENAME_MIDDLE_SIZE));
+#if !defined(_WIN32)
+    const File::SFilename_t hardLink = COPY_FOLDER + "link.scx";
+    ASSERT_EQ(link(copy.c_str(), hardLink.c_str()), 0);
+    EXPECT_EQ(File::Copy(copy.c_str(), hardLink.c_str(), true), File::CopyMethod::FAILED);
+    EXPECT_TRUE(Contents(copy) == Contents(FILENAME_MIDDLE_SIZE));
+
+    // The permissions of an overwritten file are those of the source.
+    const File::SFilename_t other = COPY_FOLDER + "other.scx";
+    std::ofstream(other, std::ios_base::binary) << "other";
+    ASSERT_EQ(chmod(other.c_str(), 0600), 0);
+    ASSERT_EQ(chmod(copy.c_str(), 0640), 0);
+    EXPECT_NE(File::Copy(copy.c_str(), other.c_str(), true), File::CopyMethod::FAILED);
+    struct stat st{};
+    ASSERT_EQ(stat(other.c_str(), &st), 0);
+    EXPECT_EQ(st.st_mode & 0777, 0640u);
+#endif
+
+    EXPECT_EQ(File::Copy(MAKE_FILE_NAME "not_existing._tut", copy.c_str()), File::CopyMethod::FAILED);
+    EXPECT_EQ(File::Copy(FILENAME_MIDDLE_SIZE.c_str(), (COPY_FOLDER + MAKE_FILE_NAME "no" FILE_SEPARATOR "copy").c_str()), File::CopyMethod::FAILED);
+}
+
+TEST_F(CopyTest, SparseFile) {
+    const File::SFilename_t sparse = COPY_FOLDER + MAKE_FILE_NAME "sparse.bin";
+    const File::SFilename_t copy = COPY_FOLDER + MAKE_FILE_NAME "sparse_copy.bin";
+    {
+        std::ofstream ofs(sparse, std::ios_base::binary);
+        ofs << "start";
+        ofs.seekp(64 << 20);
+        ofs << "middle";
+        ofs.seekp(128 << 20);
+        ofs << "end";
+    }
+    ASSERT_NE(File::Copy(sparse.c_str(), copy.c_str()), File::CopyMethod::FAILED);
+    EXPECT_EQ(File::Size(copy.c_str()), File::Size(sparse.c_str()));
+    EXPECT_TRUE(Contents(copy) == Contents(sparse));
+
+#if !defined(_WIN32)
+    struct stat st{};
+    ASSERT_EQ(stat(copy.c_str(), &st), 0);
+    EXPECT_LT(st.st_blocks * 512, 16 << 20) << "Holes were filled";
+#endif
+}
+
+TEST_F(CopyTest, Tree) {
+    const File::SFilename_t source = COPY_FOLDER + MAKE_FILE_NAME "source" FILE_SEPARATOR;
+    const File::SFilename_t destination = COPY_FOLDER + MAKE_FILE_NAME "destination";
+    File::CreateFolder(source.c_str());
+    File::CreateFolder((source + MAKE_FILE_NAME "empty").c_str());
+    File::CreateFolder((source + MAKE_FILE_NAME "sub").c_str());
+    File::CreateFolder((source + MAKE_FILE_NAME "sub" FILE_SEPARATOR "subsub").c_str());
+    for (int i = 0; i < 20; ++i) {
+        std::ofstream(source + MAKE_FILE_NAME "sub" FILE_SEPARATOR "subsub" FILE_SEPARATOR + std::to_string(i)) << "file " << i;
+    }
+    File::Copy(FILENAME_MIDDLE_SIZE.c_str(), (source + MAKE_FILE_NAME "sub" FILE_SEPARATOR "big").c_str());
+    size_t links = 0;
+#if !defined(_WIN32)
+    ASSERT_EQ(symlink("sub/big", (source + "link").c_str()), 0);
+    links = 1;
+#endif
+
+    const File::CopyTreeResult result = File::CopyTree(source.c_str(), destination.c_str(), 3);
+    EXPECT_EQ(result.failures, 0u);
+    EXPECT_EQ(result.directories, 4u);
+    EXPECT_EQ(result.files, 21u);
+    EXPECT_EQ(result.links, links);
+    EXPECT_GT(result.bytes, File::Size(FILENAME_MIDDLE_SIZE.c_str()));
+
+    const File::SFilename_t copied = destination + FILE_SEPARATOR;
+    EXPECT_TRUE(File::IsDir((copied + MAKE_FILE_NAME "empty").c_str()));
+    EXPECT_EQ(Contents(copied + MAKE_FILE_NAME "sub" FILE_SEPARATOR "subsub" FILE_SEPARATOR "7"), "file 7");
+    EXPECT_TRUE(Contents(copied + MAKE_FILE_NAME "sub" FILE_SEPARATOR "big") == Contents(FILENAME_MIDDLE_SIZE));
+#if !defined(_WIN32)
+    char target[64] = {0};
+    ASSERT_GT(readlink((copied + "link").c_str(), target, sizeof(target) - 1), 0);
+    EXPECT_STREQ(target, "sub/big");
+#endif
+
+    const File::CopyTreeResult missing = File::CopyTree(MAKE_FILE_NAME "not_existing_folder", destination.c_str());
+    EXPECT_EQ(missing.failures, 1u);
+    EXPECT_EQ(missing.files, 0u);
+}
@@ -0,0 +1,87 @@
+//
+// Tests of the removal of trees.
+//
+
+#include "tests_datas.hpp"
+#if !defined(_WIN32)
+#   include <unistd.h>
+#endif
+
+static const File::SFilename_t DELETE_FOLDER = MAKE_FILE_NAME "DeleteTests.tmp" FILE_SEPARATOR;
+
+// Creates "width" subdirectories of "folder", each with "files" files, down to "depth" levels.
+static void MakeTree(const File::SFilename_t& folder, int depth, int width, int files) {
+    File::CreateFolder(folder.c_str());
+    for (int i = 0; i < files; ++i) {
+        std::ofstream(folder + MAKE_FILE_NAME "file" + std::to_string(i)) << i;
+    }
+    if (depth > 0) {
+        for (int i = 0; i < width; ++i) {
+            MakeTree(folder + MAKE_FILE_NAME "dir" + std::to_string(i) + FILE_SEPARATOR, depth - 1, width, files);
+        }
+    }
+}
+
+TEST(DeleteTree, Tree) {
+    // 1 + 3 + 9 + 27 directories, 8 files in each.
+    MakeTree(DELETE_FOLDER, 3, 3, 8);
+    std::ofstream(DELETE_FOLDER + MAKE_FILE_NAME "dir2" FILE_SEPARATOR "empty");
+    size_t files = 40 * 8 + 1;
+
+    // A link to a directory outside of the tree: removed, not followed.
+    const File::SFilename_t outside = MAKE_FILE_NAME "DeleteTests_outside.tmp";
+    File::CreateFolder(outside.c_str());
+    std::ofstream(outside + FILE_SEPARATOR + MAKE_FILE_NAME "kept") << "kept";
+#if !defined(_WIN32)
+    ASSERT_EQ(symlink("../../DeleteTests_outside.tmp", (DELETE_FOLDER + "dir0/link").c_str()), 0);
+    ++files;
+#endif
+
+    size_t calls = 0;
+    size_t lastCount = 0;
+    const File::DeleteTreeResult result = File::DeleteTree(DELETE_FOLDER.c_str(), 4,
+            [&calls, &lastCount](const File::DeleteTreeResult& progress) {
+                ++calls;
+                EXPECT_GE(progress.files + progress.directories, lastCount);
+                lastCount = progress.files + progress.directories;
+            });
+    EXPECT_EQ(result.failures, 0u);
+    EXPECT_EQ(result.directories, 40u);
+    EXPECT_EQ(result.files, files);
+    EXPECT_EQ(calls, 0u); // Fewer removals than DELETE_TREE_PROGRESS_INTERVAL.
+    EXPECT_FALSE(File::IsDir(DELETE_FOLDER.c_str()));
+
+    EXPECT_TRUE(File::Exists((outside + FILE_SEPARATOR + MAKE_FILE_NAME "kept").c_str()));
+    EXPECT_EQ(File::DeleteTree(outside.c_str(), 1).files, 1u);
+    EXPECT_FALSE(File::IsDir(outside.c_str()));
+}
+
+TEST(DeleteTree, Progress) {
+    MakeTree(DELETE_FOLDER, 1, 2, File::DELETE_TREE_PROGRESS_INTERVAL);
+
+    size_t calls = 0;
+    const File::DeleteTreeResult result = File::DeleteTree(DELETE_FOLDER.c_str(), 2,
+            [&calls](const File::DeleteTreeResult& progress) {
+                ++calls;
+                EXPECT_EQ(progress.failures, 0u);
+            });
+    EXPECT_EQ(result.failures, 0u);
+    EXPECT_EQ(result.files, 3 * File::DELETE_TREE_PROGRESS_INTERVAL);
+    EXPECT_EQ(result.directories, 3u);
+    EXPECT_EQ(calls, 3u);
+}
+
+TEST(DeleteTree, Failures) {
+    const File::DeleteTreeResult missing = File::DeleteTree(MAKE_FILE_NAME "not_existing_folder");
+    EXPECT_EQ(missing.failures, 1u);
+    EXPECT_EQ(missing.files + missing.directories, 0u);
+
+    // A file is not a tree.
+    const File::SFilename_t file = MAKE_FILE_NAME "DeleteTests_file.tmp";
+    std::ofstream(file) << "file";
+    EXPECT_EQ(File::DeleteTree(file.c_str()).failures, 1u);
+    EXPECT_TRUE(File::Exists(file.c_str()));
+    File::Delete(file.c_str());
+
+    EXPECT_EQ(File::DeleteTree(DELETE_FOLDER.c_str(), 1).failures, 1u);
+}
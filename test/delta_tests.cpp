@@ -0,0 +1,136 @@
+//
+// Tests of the deltas between versions of a file.
+//
+
+#include "tests_datas.hpp"
+
+static const File::SFilename_t DELTA_FOLDER = MAKE_FILE_NAME "DeltaTests.tmp" FILE_SEPARATOR;
+static const File::SFilename_t DELTA_OUTPUT = DELTA_FOLDER + MAKE_FILE_NAME "output";
+
+class DeltaTest : public TemporaryFolderTest {
+protected:
+    DeltaTest() : TemporaryFolderTest(DELTA_FOLDER) {}
+
+    static std::string ReadOutput() {
+        std::string contents;
+        EXPECT_TRUE(File::ReadToString(DELTA_OUTPUT.c_str(), contents));
+        return contents;
+    }
+
+    static void WriteOutput(const std::string& contents) {
+        std::ofstream(DELTA_OUTPUT, std::ios_base::binary | std::ios_base::trunc) << contents;
+    }
+};
+
+TEST_F(DeltaTest, Signature) {
+    const std::string basis = RandomBytes(10000, 1);
+    const File::DeltaSignature signature = File::ComputeSignature(basis.data(), basis.size(), 1024);
+    EXPECT_EQ(signature.size, basis.size());
+    EXPECT_EQ(signature.blockSize, 1024u);
+    EXPECT_EQ(signature.weak.size(), 10u);
+    EXPECT_EQ(signature.strong.size(), 10u);
+
+    const std::string serialized = signature.Serialize();
+    File::DeltaSignature parsed;
+    ASSERT_TRUE(parsed.Parse(serialized.data(), serialized.size()));
+    EXPECT_EQ(parsed.size, signature.size);
+    EXPECT_EQ(parsed.blockSize, signature.blockSize);
+    EXPECT_EQ(parsed.weak, signature.weak);
+    EXPECT_EQ(parsed.strong, signature.strong);
+
+    std::string corrupted = serialized;
+    corrupted[20] ^= 1;
+    EXPECT_FALSE(parsed.Parse(corrupted.data(), corrupted.size()));
+    EXPECT_TRUE(parsed.weak.empty());
+
+    // The automatic block size grows with the size of the basis.
+    EXPECT_EQ(File::ComputeSignature(basis.data(), basis.size()).blockSize, 1024u);
+    const std::string big = RandomBytes(16u << 20, 2);
+    EXPECT_EQ(File::ComputeSignature(big.data(), big.size()).blockSize, 4096u);
+}
+
+TEST_F(DeltaTest, Apply) {
+    const std::string basis = RandomBytes(1u << 20, 3);
+    std::string edited = basis;
+    edited.insert(1000, "some inserted bytes");
+    edited.erase(300000, 5000);
+    edited.replace(600000, 10, "0123456789");
+    edited += "appended";
+    const File::DeltaSignature signature = File::ComputeSignature(basis.data(), basis.size());
+
+    const std::string delta = File::ComputeDelta(signature, edited.data(), edited.size());
+    // About 3 blocks of 1 KiB around the edits.
+    EXPECT_LT(delta.size(), 4000u);
+    ASSERT_TRUE(File::ApplyDelta(basis.data(), basis.size(), delta.data(), delta.size(), DELTA_OUTPUT.c_str()));
+    EXPECT_EQ(ReadOutput(), edited);
+
+    // Unchanged, emptied, or from nothing.
+    const std::string same = File::ComputeDelta(signature, basis.data(), basis.size());
+    EXPECT_LT(same.size(), 64u);
+    ASSERT_TRUE(File::ApplyDelta(basis.data(), basis.size(), same.data(), same.size(), DELTA_OUTPUT.c_str()));
+    EXPECT_EQ(ReadOutput(), basis);
+    const std::string empty = File::ComputeDelta(signature, basis.data(), 0);
+    ASSERT_TRUE(File::ApplyDelta(basis.data(), basis.size(), empty.data(), empty.size(), DELTA_OUTPUT.c_str()));
+    EXPECT_EQ(File::Size(DELTA_OUTPUT.c_str()), 0u);
+    const File::DeltaSignature none = File::ComputeSignature(basis.data(), 0);
+    const std::string full = File::ComputeDelta(none, edited.data(), edited.size());
+    ASSERT_TRUE(File::ApplyDelta(basis.data(), 0, full.data(), full.size(), DELTA_OUTPUT.c_str()));
+    EXPECT_EQ(ReadOutput(), edited);
+
+    // A short last block is found at the end only.
+    const std::string odd = basis.substr(0, 5500);
+    const File::DeltaSignature oddSignature = File::ComputeSignature(odd.data(), odd.size(), 1024);
+    const std::string prefixed = "x" + odd;
+    const std::string oddDelta = File::ComputeDelta(oddSignature, prefixed.data(), prefixed.size());
+    EXPECT_LT(oddDelta.size(), 64u);
+    ASSERT_TRUE(File::ApplyDelta(odd.data(), odd.size(), oddDelta.data(), oddDelta.size(), DELTA_OUTPUT.c_str()));
+    EXPECT_EQ(ReadOutput(), prefixed);
+
+    // Corrupted, or for another basis.
+    std::string corrupted = delta;
+    corrupted[delta.size() / 2] ^= 1;
+    EXPECT_FALSE(File::ApplyDelta(basis.data(), basis.size(), corrupted.data(), corrupted.size(), DELTA_OUTPUT.c_str()));
+    EXPECT_FALSE(File::ApplyDelta(basis.data(), basis.size() - 1, delta.data(), delta.size(), DELTA_OUTPUT.c_str()));
+    EXPECT_EQ(ReadOutput(), prefixed);
+}
+
+TEST_F(DeltaTest, InPlace) {
+    const std::string basis = RandomBytes(1u << 20, 4);
+    const File::DeltaSignature signature = File::ComputeSignature(basis.data(), basis.size());
+    File::Filesize_t written = 1;
+
+    // Unchanged blocks are not written.
+    std::string edited = basis;
+    edited.replace(500000, 100, std::string(100, 'x'));
+    WriteOutput(basis);
+    std::string delta = File::ComputeDelta(signature, edited.data(), edited.size(), true);
+    ASSERT_TRUE(File::ApplyDeltaInPlace(DELTA_OUTPUT.c_str(), delta.data(), delta.size(), &written));
+    EXPECT_EQ(ReadOutput(), edited);
+    EXPECT_LE(written, 2048u);
+
+    // Bytes removed: the blocks after them move towards the start, and the file shrinks.
+    edited = basis;
+    edited.erase(1000, 3000);
+    WriteOutput(basis);
+    delta = File::ComputeDelta(signature, edited.data(), edited.size(), true);
+    EXPECT_LT(delta.size(), 4000u);
+    ASSERT_TRUE(File::ApplyDeltaInPlace(DELTA_OUTPUT.c_str(), delta.data(), delta.size(), &written));
+    EXPECT_EQ(ReadOutput(), edited);
+
+    // Bytes inserted: the blocks moved further cannot be copied in place, they are in the delta.
+    edited = basis.substr(0, 2000) + "inserted" + basis.substr(2000) + "appended";
+    WriteOutput(basis);
+    delta = File::ComputeDelta(signature, edited.data(), edited.size(), true);
+    ASSERT_TRUE(File::ApplyDeltaInPlace(DELTA_OUTPUT.c_str(), delta.data(), delta.size(), &written));
+    EXPECT_EQ(ReadOutput(), edited);
+
+    // Only deltas computed for it, and matching the file.
+    WriteOutput(basis);
+    delta = File::ComputeDelta(signature, edited.data(), edited.size());
+    EXPECT_FALSE(File::ApplyDeltaInPlace(DELTA_OUTPUT.c_str(), delta.data(), delta.size()));
+    WriteOutput(basis.substr(1));
+    delta = File::ComputeDelta(signature, edited.data(), edited.size(), true);
+    EXPECT_FALSE(File::ApplyDeltaInPlace(DELTA_OUTPUT.c_str(), delta.data(), delta.size()));
+    EXPECT_EQ(ReadOutput(), basis.substr(1));
+    EXPECT_FALSE(File::ApplyDeltaInPlace((DELTA_FOLDER + MAKE_FILE_NAME "missing").c_str(), delta.data(), delta.size()));
+}
@@ -0,0 +1,78 @@
+//
+// Tests of the search of duplicate files.
+//
+
+#include "tests_datas.hpp"
+#if !defined(_WIN32)
+#   include <unistd.h>
+#endif
+
+static const File::SFilename_t DUPLICATES_FOLDER = MAKE_FILE_NAME "DuplicatesTests.tmp" FILE_SEPARATOR;
+
+TEST(FindDuplicates, Stages) {
+    std::string contents;
+    ASSERT_TRUE(File::ReadToString(FILENAME_MIDDLE_SIZE.c_str(), contents));
+    File::DeleteTree(DUPLICATES_FOLDER.c_str());
+    File::CreateFolder(DUPLICATES_FOLDER.c_str());
+    File::CreateFolder((DUPLICATES_FOLDER + MAKE_FILE_NAME "sub").c_str());
+
+    const File::SFilename_t first = DUPLICATES_FOLDER + MAKE_FILE_NAME "first.scx";
+    const File::SFilename_t second = DUPLICATES_FOLDER + MAKE_FILE_NAME "sub" FILE_SEPARATOR "second.scx";
+    WriteFile(first, contents);
+    WriteFile(second, contents);
+    // Same size, but different in the last bytes: dropped by the samples.
+    std::string changed = contents;
+    changed.back() ^= 1;
+    WriteFile(DUPLICATES_FOLDER + MAKE_FILE_NAME "end.scx", changed);
+    // Same size and samples, but different in the middle: dropped by the full hash.
+    changed = contents;
+    changed[changed.size() / 2] ^= 1;
+    WriteFile(DUPLICATES_FOLDER + MAKE_FILE_NAME "middle.scx", changed);
+
+    WriteFile(DUPLICATES_FOLDER + MAKE_FILE_NAME "small1", "hello");
+    WriteFile(DUPLICATES_FOLDER + MAKE_FILE_NAME "sub" FILE_SEPARATOR "small2", "hello");
+    WriteFile(DUPLICATES_FOLDER + MAKE_FILE_NAME "small3", "hellp");
+    WriteFile(DUPLICATES_FOLDER + MAKE_FILE_NAME "unique", "unique size");
+    WriteFile(DUPLICATES_FOLDER + MAKE_FILE_NAME "empty1", "");
+    WriteFile(DUPLICATES_FOLDER + MAKE_FILE_NAME "empty2", "");
+    size_t files = 10;
+    size_t bigNames = 2;
+#if !defined(_WIN32)
+    // A hard link is listed in the group, but frees nothing.
+    ASSERT_EQ(link(first.c_str(), (DUPLICATES_FOLDER + "hardlink.scx").c_str()), 0);
+    ++files;
+    ++bigNames;
+#endif
+
+    File::DuplicatesOptions options;
+    options.threads = 3;
+    const File::DuplicatesResult result = File::FindDuplicates({DUPLICATES_FOLDER}, options);
+    EXPECT_EQ(result.failures, 0u);
+    EXPECT_EQ(result.files, files);
+    EXPECT_EQ(result.sampled, 7u);
+    EXPECT_EQ(result.fullyHashed, 3u);
+    EXPECT_EQ(result.compared, 2u);
+    EXPECT_EQ(result.reclaimableBytes, contents.size() + 5);
+    ASSERT_EQ(result.groups.size(), 2u);
+
+    const File::DuplicateGroup& big = result.groups[0];
+    EXPECT_EQ(big.size, contents.size());
+    EXPECT_EQ(big.copies, 2u);
+    ASSERT_EQ(big.files.size(), bigNames);
+    ASSERT_LIST_CONTAINS(big.files, first);
+    ASSERT_LIST_CONTAINS(big.files, second);
+
+    const File::DuplicateGroup& small = result.groups[1];
+    EXPECT_EQ(small.size, 5u);
+    EXPECT_EQ(small.copies, 2u);
+    EXPECT_EQ(small.files.size(), 2u);
+
+    // The minimum size skips the small files; a missing root is a failure.
+    options.minimumSize = 6;
+    const File::DuplicatesResult filtered = File::FindDuplicates({MAKE_FILE_NAME "not_existing_folder" FILE_SEPARATOR, first, second}, options);
+    EXPECT_EQ(filtered.failures, 1u);
+    EXPECT_EQ(filtered.groups.size(), 1u);
+    EXPECT_EQ(filtered.reclaimableBytes, contents.size());
+
+    File::DeleteTree(DUPLICATES_FOLDER.c_str());
+}
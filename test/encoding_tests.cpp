@@ -0,0 +1,184 @@
+//
+// Tests of the content-based encoding detection.
+//
+
+#include "tests_datas.hpp"
+
+using File::encoding_t;
+
+static File::EncodingDetection Detect(const std::string& contents) {
+    return File::DetectEncoding(contents.data(), contents.size());
+}
+
+static File::Filesize_t Validate(const std::string& contents) {
+    return File::ValidateUTF8(contents.data(), contents.size());
+}
+
+TEST(ValidateUTF8, ValidContents) {
+    EXPECT_EQ(Validate(""), 0);
+    EXPECT_EQ(Validate("Hello, world!"), 13);
+
+    // Long enough to go through the vectorised kernels, with sequences across block boundaries.
+    std::string mixed;
+    for (int i = 0; i < 100; ++i) {
+        mixed += "a\xC3\xA9" "bc\xE2\x82\xAC" "d\xF0\x9F\x98\x80";
+    }
+    EXPECT_EQ(Validate(mixed), mixed.size());
+}
+
+TEST(ValidateUTF8, InvalidSequences) {
+    EXPECT_EQ(Validate("ab\xC0\xAF"), 2); // Overlong
+    EXPECT_EQ(Validate("ab\xED\xA0\x80"), 2); // Surrogate
+    EXPECT_EQ(Validate("ab\xF4\x90\x80\x80"), 2); // Above U+10FFFF
+    EXPECT_EQ(Validate("ab\x80"), 2); // Lone continuation
+    EXPECT_EQ(Validate("abc\xE2\x82"), 3); // Truncated at the end
+    EXPECT_EQ(Validate(std::string(64, 'a') + "\xE2\x82"), 64);
+    EXPECT_EQ(Validate(std::string(31, 'a') + "\xE2\x82" + std::string(40, 'b')), 31);
+}
+
+TEST(ValidateUTF8, ErrorAtEveryOffset) {
+    const char* sequences[] = {"a", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80"};
+    std::string valid;
+    std::vector<size_t> boundaries;
+    for (int i = 0; i < 60; ++i) {
+        boundaries.push_back(valid.size());
+        valid += sequences[(i * 7) % 4];
+    }
+
+    for (size_t boundary : boundaries) {
+        std::string invalid = valid;
+        invalid.insert(boundary, 1, '\xFF');
+        EXPECT_EQ(Validate(invalid), boundary);
+    }
+}
+
+TEST(DetectEncoding, ByteOrderMarks) {
+    File::EncodingDetection detection = Detect(std::string("\xEF\xBB\xBF" "abc"));
+    EXPECT_EQ(detection.encoding, encoding_t::ENC_UTF8);
+    EXPECT_EQ(detection.bomLength, 3u);
+    EXPECT_TRUE(detection.IsValid(6));
+
+    detection = Detect(std::string("\xFF\xFE\x00\x00" "a\0\0\0", 8));
+    EXPECT_EQ(detection.encoding, encoding_t::ENC_UTF32LE);
+    EXPECT_EQ(detection.bomLength, 4u);
+
+    detection = Detect(std::string("\xFE\xFF\0a", 4));
+    EXPECT_EQ(detection.encoding, encoding_t::ENC_UTF16BE);
+    EXPECT_EQ(detection.bomLength, 2u);
+}
+
+TEST(DetectEncoding, WithoutByteOrderMark) {
+    File::EncodingDetection detection = Detect(std::string("h\0e\0l\0l\0o\0", 10));
+    EXPECT_EQ(detection.encoding, encoding_t::ENC_UTF16LE);
+    EXPECT_EQ(detection.bomLength, 0u);
+    EXPECT_TRUE(detection.IsValid(10));
+
+    detection = Detect(std::string("\0h\0e\0l\0l\0o", 10));
+    EXPECT_EQ(detection.encoding, encoding_t::ENC_UTF16BE);
+
+    detection = Detect(std::string("h\0\0\0i\0\0\0", 8));
+    EXPECT_EQ(detection.encoding, encoding_t::ENC_UTF32LE);
+
+    detection = Detect(std::string("\0\0\0h\0\0\0i", 8));
+    EXPECT_EQ(detection.encoding, encoding_t::ENC_UTF32BE);
+
+    // Lone high surrogate
+    detection = Detect(std::string("h\0i\0\x00\xD8" "a\0b\0", 10));
+    EXPECT_EQ(detection.encoding, encoding_t::ENC_UTF16LE);
+    EXPECT_EQ(detection.firstInvalid, 4);
+
+    detection = Detect("caf\xC3\xA9");
+    EXPECT_EQ(detection.encoding, encoding_t::ENC_UTF8);
+    EXPECT_TRUE(detection.IsValid(5));
+
+    detection = Detect("caf\xE9 au lait");
+    EXPECT_EQ(detection.encoding, encoding_t::ENC_DEFAULT);
+    EXPECT_EQ(detection.firstInvalid, 3);
+}
+
+TEST(DetectEncoding, Files) {
+    const File::SFilename_t utf16File = File::MakeFilename(false, false, 2, TEST_FILES_DIR_PREFIX, MAKE_FILE_NAME "Small_utf16le.txt");
+    File::EncodingDetection detection = File::DetectEncoding(utf16File.c_str());
+    EXPECT_EQ(detection.encoding, encoding_t::ENC_UTF16LE);
+    EXPECT_EQ(detection.bomLength, 2u);
+    EXPECT_TRUE(detection.IsValid(File::Size(utf16File.c_str())));
+
+    const File::SFilename_t binaryFile = File::MakeFilename(false, false, 2, TEST_FILES_DIR_PREFIX, MAKE_FILE_NAME "aom_v.scx");
+    detection = File::DetectEncoding(binaryFile.c_str());
+    EXPECT_EQ(detection.encoding, encoding_t::ENC_DEFAULT);
+    EXPECT_LT(detection.firstInvalid, File::Size(binaryFile.c_str()));
+
+    detection = File::DetectEncoding(MAKE_FILE_NAME "not_existing._tut");
+    EXPECT_EQ(detection.encoding, encoding_t::ENC_ERROR);
+}
+
+// "Bonjour à tous !" followed by U+1F600, in UTF-16LE and in UTF-8.
+static const std::string UTF16LE_SAMPLE("B\0o\0n\0j\0o\0u\0r\0 \0\xE0\0 \0t\0o\0u\0s\0 \0!\0\x3D\xD8\x00\xDE", 36);
+static const std::string UTF8_SAMPLE("Bonjour \xC3\xA0 tous !\xF0\x9F\x98\x80");
+
+TEST(UTF16LEToUTF8, Bulk) {
+    std::string longSource, longExpected;
+    for (int i = 0; i < 50; ++i) {
+        longSource += UTF16LE_SAMPLE;
+        longExpected += UTF8_SAMPLE;
+    }
+
+    std::string destination(File::UTF16LEToUTF8_MaxLength(longSource.size()), '\0');
+    File::TranscodeResult result = File::UTF16LEToUTF8(longSource.data(), longSource.size(), &destination[0], destination.size());
+    EXPECT_EQ(result.status, File::TranscodeStatus::OK);
+    EXPECT_EQ(result.read, longSource.size());
+    destination.resize(result.written);
+    EXPECT_EQ(destination, longExpected);
+
+    // Lone low surrogate
+    const std::string invalid("a\0\x00\xDC" "b\0", 6);
+    result = File::UTF16LEToUTF8(invalid.data(), invalid.size(), &destination[0], destination.size());
+    EXPECT_EQ(result.status, File::TranscodeStatus::INVALID);
+    EXPECT_EQ(result.read, 2);
+
+    // Too small destination
+    result = File::UTF16LEToUTF8(UTF16LE_SAMPLE.data(), UTF16LE_SAMPLE.size(), &destination[0], 9);
+    EXPECT_EQ(result.status, File::TranscodeStatus::DESTINATION_FULL);
+    EXPECT_EQ(result.written, 8);
+}
+
+TEST(UTF16LEToUTF32, Bulk) {
+    std::u32string destination(UTF16LE_SAMPLE.size() / 2, U'\0');
+    File::TranscodeResult result = File::UTF16LEToUTF32(UTF16LE_SAMPLE.data(), UTF16LE_SAMPLE.size(), &destination[0], destination.size());
+    EXPECT_EQ(result.status, File::TranscodeStatus::OK);
+    destination.resize(result.written);
+    EXPECT_EQ(destination, U"Bonjour \u00E0 tous !\U0001F600");
+}
+
+TEST(UTF16LEDecoder, AnyChunkSize) {
+    for (size_t chunkSize = 1; chunkSize <= 7; ++chunkSize) {
+        File::UTF16LEDecoder decoder;
+        std::string output;
+        for (size_t i = 0; i < UTF16LE_SAMPLE.size(); i += chunkSize) {
+            const size_t length = std::min(chunkSize, UTF16LE_SAMPLE.size() - i);
+            ASSERT_EQ(decoder.Decode(UTF16LE_SAMPLE.data() + i, length, output), File::TranscodeStatus::OK);
+        }
+        EXPECT_EQ(decoder.Finish(), File::TranscodeStatus::OK);
+        EXPECT_EQ(output, UTF8_SAMPLE) << "Chunks of " << chunkSize << " bytes";
+    }
+
+    File::UTF16LEDecoder decoder;
+    std::string output;
+    decoder.Decode(UTF16LE_SAMPLE.data(), UTF16LE_SAMPLE.size() - 1, output);
+    EXPECT_EQ(decoder.Finish(), File::TranscodeStatus::TRUNCATED);
+}
+
+TEST(UTF16LEToUTF8, File) {
+    const File::SFilename_t utf16File = File::MakeFilename(false, false, 2, TEST_FILES_DIR_PREFIX, MAKE_FILE_NAME "Small_utf16le.txt");
+    std::string decoded;
+    ASSERT_TRUE(File::ReadUTF16LEToString(utf16File.c_str(), decoded));
+    EXPECT_EQ(decoded, "Bonjour \xC3\xA0 tous !\r\n");
+
+    std::string chunked;
+    EXPECT_EQ(File::DecodeUTF16LEFile(utf16File.c_str(), [&chunked](const char* utf8, size_t length) {
+        chunked.append(utf8, length);
+    }, 6), File::TranscodeStatus::OK);
+    EXPECT_EQ(chunked, decoded);
+
+    EXPECT_FALSE(File::ReadUTF16LEToString(MAKE_FILE_NAME "not_existing._tut", decoded));
+}
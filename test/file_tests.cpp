@@ -5,23 +5,18 @@
 #include "tests_datas.hpp"
 
 #if defined(UNICODE)
-#define MIDDLE_SIZE_RAW      L"aom_v.scx"
 #define NOT_EXISTING_RAW      L"not_existing._tut"
 #define SMALL_UTF16LE_RAW   L"Small_utf16le.txt"
 #define TEMP_RAW            L"I_AM_TEMP"
 #else
-#define MIDDLE_SIZE_RAW      "aom_v.scx"
 #define NOT_EXISTING_RAW      "not_existing._tut"
 #define SMALL_UTF16LE_RAW   "Small_utf16le.txt"
 #define TEMP_RAW            "I_AM_TEMP"
 #endif
 
-#define TEST_FILES_DIR_PREFIX MAKE_FILE_NAME ".." FILE_SEPARATOR ".." FILE_SEPARATOR "test" FILE_SEPARATOR "files" FILE_SEPARATOR
-
 // First settings : file names, (Win) memory leaks check.
 #if 1
 
-const File::SFilename_t FILENAME_MIDDLE_SIZE = File::MakeFilename(false, false, 2, TEST_FILES_DIR_PREFIX, MIDDLE_SIZE_RAW);
 const File::SFilename_t FILENAME_NOT_EXISTING = File::MakeFilename(false, false, 2, TEST_FILES_DIR_PREFIX, NOT_EXISTING_RAW);
 const File::SFilename_t FILENAME_SMALL_UTF16LE = File::MakeFilename(false, false, 2, TEST_FILES_DIR_PREFIX, SMALL_UTF16LE_RAW);
 const File::SFilename_t FILENAME_TEMP = File::MakeFilename(false, false, 2, TEST_FILES_DIR_PREFIX, TEMP_RAW);
@@ -263,6 +258,34 @@ TEST(Read, ManyReads) {
 	}
 }
 
+TEST(Read, Strategies) {
+    using File::ReadStrategy;
+    std::string expected;
+    ASSERT_TRUE(File::ReadToString(fid_middle_size.name.c_str(), expected));
+
+    for (ReadStrategy strategy : {ReadStrategy::READ, ReadStrategy::MMAP, ReadStrategy::MMAP_POPULATE, ReadStrategy::MMAP_HUGE_PAGES}) {
+        const File::ReadFileData* filedata = File::Read(fid_middle_size.name.c_str(), strategy);
+        ASSERT_NE(filedata, nullptr);
+        EXPECT_EQ(filedata->size, expected.size());
+        EXPECT_EQ(std::string(filedata->contents, filedata->size), expected);
+        EXPECT_NE(filedata->strategy, ReadStrategy::AUTO);
+        File::Read_Close(filedata);
+    }
+}
+
+TEST(Read, ChooseStrategy) {
+    using File::ReadStrategy;
+    using File::AccessPattern;
+    EXPECT_EQ(File::ChooseReadStrategy(fid_smallfile_utf16le.size, AccessPattern::SEQUENTIAL), ReadStrategy::READ);
+    EXPECT_EQ(File::ChooseReadStrategy(File::READ_STRATEGY_MAX_SIZE + 1, AccessPattern::SEQUENTIAL), ReadStrategy::MMAP_POPULATE);
+    EXPECT_EQ(File::ChooseReadStrategy(File::READ_STRATEGY_MAX_SIZE + 1, AccessPattern::RANDOM), ReadStrategy::MMAP);
+
+    const File::ReadFileData* filedata = File::Read(fid_smallfile_utf16le.name.c_str());
+    ASSERT_NE(filedata, nullptr);
+    EXPECT_EQ(filedata->strategy, ReadStrategy::READ);
+    File::Read_Close(filedata);
+}
+
 TEST(Read, StringRead) {
     file_info_data& file_used = fid_smallfile_utf16le;
     std::string callResult;
@@ -284,3 +307,47 @@ TEST(FilesInDirectory, UsualTest) {
     }
 }
 #endif
+
+// Windowed reading
+#if 1
+TEST(WindowedReader, SameAsRead) {
+    std::string expected;
+    ASSERT_TRUE(File::ReadToString(fid_middle_size.name.c_str(), expected));
+
+    File::WindowedReader reader(fid_middle_size.name.c_str(), 5000);
+    ASSERT_TRUE(reader.IsOpen());
+    EXPECT_EQ(reader.FileSize(), fid_middle_size.size);
+    EXPECT_GE(reader.WindowSize(), 5000u);
+
+    std::string contents;
+    size_t windows = 0;
+    for (bool ok = reader.IsOpen(); ok; ok = reader.Next()) {
+        EXPECT_EQ(reader.Offset(), contents.size());
+        contents.append(reader.Data(), reader.Length());
+        ++windows;
+    }
+    EXPECT_EQ(windows, (fid_middle_size.size + reader.WindowSize() - 1) / reader.WindowSize());
+    EXPECT_TRUE(contents == expected);
+    EXPECT_EQ(reader.Data(), nullptr);
+}
+
+TEST(WindowedReader, Seek) {
+    File::WindowedReader reader(fid_middle_size.name.c_str(), 1);
+    const File::Filesize_t position = fid_middle_size.size - 1;
+    ASSERT_TRUE(reader.Seek(position));
+    ASSERT_LE(reader.Offset(), position);
+    EXPECT_EQ(reader.Data()[position - reader.Offset()], fid_middle_size.lastByte);
+    EXPECT_FALSE(reader.Next());
+
+    ASSERT_TRUE(reader.Seek(0));
+    EXPECT_EQ(reader.Data()[0], fid_middle_size.firstByte);
+    EXPECT_FALSE(reader.Seek(fid_middle_size.size));
+}
+
+TEST(WindowedReader, NotExisting) {
+    File::WindowedReader reader(fid_not_existing.name.c_str());
+    EXPECT_FALSE(reader.IsOpen());
+    EXPECT_FALSE(reader.Next());
+    EXPECT_FALSE(reader.Seek(0));
+}
+#endif
@@ -0,0 +1,95 @@
+//
+// Tests of the glob patterns.
+//
+
+#include "tests_datas.hpp"
+
+static const File::SFilename_t GLOB_FOLDER = MAKE_FILE_NAME "GlobTests.tmp" FILE_SEPARATOR;
+
+class GlobTest : public TemporaryFolderTest {
+protected:
+    GlobTest() : TemporaryFolderTest(GLOB_FOLDER) {}
+
+    void SetUp() override {
+        TemporaryFolderTest::SetUp();
+        for (const char* folder : {"src", "src/main", "src/main/deep", "src/test", "build", "build/src"}) {
+            File::CreateFolder((GLOB_FOLDER + Native(folder)).c_str());
+        }
+        for (const char* file : {"readme.md", "src/a.cpp", "src/a.hpp", "src/main/b.cpp", "src/main/deep/c.cpp",
+                                 "src/main/deep/c.scx", "src/test/t1.cpp", "src/test/t2.cpp", "build/src/a.o"}) {
+            std::ofstream(GLOB_FOLDER + Native(file), std::ios_base::binary) << file;
+        }
+    }
+
+    /// Path with the separators of the system.
+    static File::SFilename_t Native(const char* path) {
+        File::SFilename_t native;
+        for (const char* c = path; *c; ++c) {
+            native += *c == '/' ? FILE_SEPARATOR[0] : static_cast<File::SFilename_t::value_type>(*c);
+        }
+        return native;
+    }
+
+    static std::vector<File::SFilename_t> Natives(std::initializer_list<const char*> paths) {
+        std::vector<File::SFilename_t> natives;
+        for (const char* path : paths) {
+            natives.push_back(Native(path));
+        }
+        return natives;
+    }
+};
+
+TEST_F(GlobTest, Matches) {
+    const File::GlobPattern sources(MAKE_FILE_NAME "src/**/*.cpp");
+    ASSERT_TRUE(sources.IsValid());
+    EXPECT_TRUE(sources.Matches(MAKE_FILE_NAME "src/a.cpp"));
+    EXPECT_TRUE(sources.Matches(MAKE_FILE_NAME "src/x/y/z.cpp"));
+    EXPECT_FALSE(sources.Matches(MAKE_FILE_NAME "src/a.hpp"));
+    EXPECT_FALSE(sources.Matches(MAKE_FILE_NAME "build/src/a.cpp"));
+    EXPECT_FALSE(sources.Matches(MAKE_FILE_NAME "src"));
+
+    const File::GlobPattern general(MAKE_FILE_NAME "t?/[a-c]*[!0-9].[ch]pp");
+    EXPECT_TRUE(general.Matches(MAKE_FILE_NAME "t1/bar.cpp"));
+    EXPECT_TRUE(general.Matches(MAKE_FILE_NAME "tx/cx.hpp/"));
+    EXPECT_FALSE(general.Matches(MAKE_FILE_NAME "t1/bar1.cpp"));
+    EXPECT_FALSE(general.Matches(MAKE_FILE_NAME "t12/bar.cpp"));
+    EXPECT_FALSE(general.Matches(MAKE_FILE_NAME "t1/dar.cpp"));
+    EXPECT_FALSE(general.Matches(MAKE_FILE_NAME "t1/bar.opp"));
+
+    EXPECT_TRUE(File::GlobPattern(MAKE_FILE_NAME "*").Matches(MAKE_FILE_NAME ".hidden"));
+    EXPECT_TRUE(File::GlobPattern(MAKE_FILE_NAME "a*b*c").Matches(MAKE_FILE_NAME "abxbc"));
+    EXPECT_FALSE(File::GlobPattern(MAKE_FILE_NAME "a*b*c").Matches(MAKE_FILE_NAME "abxbcd"));
+    EXPECT_FALSE(File::GlobPattern(MAKE_FILE_NAME "ab*ba").Matches(MAKE_FILE_NAME "aba"));
+    EXPECT_TRUE(File::GlobPattern(MAKE_FILE_NAME "[]x]").Matches(MAKE_FILE_NAME "]"));
+    EXPECT_TRUE(File::GlobPattern(MAKE_FILE_NAME "**/**").Matches(MAKE_FILE_NAME "a/b"));
+    EXPECT_TRUE(File::GlobPattern(MAKE_FILE_NAME "./a//b").Matches(MAKE_FILE_NAME "a/b"));
+    EXPECT_TRUE(File::GlobPattern(MAKE_FILE_NAME "src/*/").Matches(MAKE_FILE_NAME "src/main/"));
+    EXPECT_FALSE(File::GlobPattern(MAKE_FILE_NAME "src/*/").Matches(MAKE_FILE_NAME "src/a.cpp"));
+    EXPECT_FALSE(File::GlobPattern(MAKE_FILE_NAME "[ab").IsValid());
+    EXPECT_FALSE(File::GlobPattern(MAKE_FILE_NAME "[ab").Matches(MAKE_FILE_NAME "a"));
+
+    // States of a walk: what may follow a directory.
+    File::GlobPattern::States states = sources.Step(sources.Start(), MAKE_FILE_NAME "build");
+    EXPECT_FALSE(sources.CanDescend(states));
+    std::vector<File::SFilename_t> names;
+    EXPECT_TRUE(sources.ExactNames(sources.Start(), names));
+    EXPECT_EQ(names, std::vector<File::SFilename_t>{MAKE_FILE_NAME "src"});
+    states = sources.Step(sources.Start(), MAKE_FILE_NAME "src");
+    EXPECT_TRUE(sources.CanDescend(states));
+    EXPECT_FALSE(sources.ExactNames(states, names));
+}
+
+TEST_F(GlobTest, Tree) {
+    EXPECT_EQ(File::Glob(GLOB_FOLDER.c_str(), MAKE_FILE_NAME "**/*.cpp"),
+              Natives({"src/a.cpp", "src/main/b.cpp", "src/main/deep/c.cpp", "src/test/t1.cpp", "src/test/t2.cpp"}));
+    EXPECT_EQ(File::Glob(GLOB_FOLDER.c_str(), MAKE_FILE_NAME "src/main/**/c.*", 1),
+              Natives({"src/main/deep/c.cpp", "src/main/deep/c.scx"}));
+    EXPECT_EQ(File::Glob(GLOB_FOLDER.c_str(), MAKE_FILE_NAME "*/src"), Natives({"build/src/"}));
+    EXPECT_EQ(File::Glob(GLOB_FOLDER.c_str(), MAKE_FILE_NAME "src/*/"), Natives({"src/main/", "src/test/"}));
+    EXPECT_EQ(File::Glob(GLOB_FOLDER.c_str(), MAKE_FILE_NAME "src/test/t[2-9].cpp"), Natives({"src/test/t2.cpp"}));
+    EXPECT_EQ(File::Glob(GLOB_FOLDER.c_str(), MAKE_FILE_NAME "build/**"), Natives({"build/", "build/src/", "build/src/a.o"}));
+    EXPECT_EQ(File::Glob(GLOB_FOLDER.c_str(), MAKE_FILE_NAME "src/main/deep/c.scx"), Natives({"src/main/deep/c.scx"}));
+    EXPECT_TRUE(File::Glob(GLOB_FOLDER.c_str(), MAKE_FILE_NAME "src/missing/*.cpp").empty());
+    EXPECT_TRUE(File::Glob(GLOB_FOLDER.c_str(), MAKE_FILE_NAME "src/../readme.md").empty());
+    EXPECT_TRUE(File::Glob((GLOB_FOLDER + MAKE_FILE_NAME "missing").c_str(), MAKE_FILE_NAME "**").empty());
+}
@@ -0,0 +1,145 @@
+//
+// Tests of the decompression of DEFLATE and zlib streams.
+//
+
+#include "tests_datas.hpp"
+
+// The test file is "l33t", the size of the contents on 4 bytes (little-endian), then a zlib stream.
+static constexpr File::Filesize_t SCX_HEADER_SIZE = 8;
+
+static std::string InflateString(const std::string& compressed, File::InflateFormat format = File::InflateFormat::ZLIB) {
+    File::Inflater inflater(compressed.data(), compressed.size(), format);
+    std::string output;
+    EXPECT_TRUE(inflater.ReadAll([&output](const char* data, size_t size) {
+        output.append(data, size);
+        return true;
+    }));
+    EXPECT_TRUE(inflater.IsDone());
+    EXPECT_EQ(inflater.TotalIn(), compressed.size());
+    EXPECT_EQ(inflater.TotalOut(), output.size());
+    return output;
+}
+
+static uint32_t Adler32(const std::string& data) {
+    uint32_t a = 1, b = 0;
+    for (char c : data) {
+        a = (a + static_cast<unsigned char>(c)) % 65521;
+        b = (b + a) % 65521;
+    }
+    return b << 16 | a;
+}
+
+TEST(Inflate, Blocks) {
+    // Made by zlib: a stored block, a block with fixed codes, and raw DEFLATE data.
+    EXPECT_EQ(InflateString(std::string("\x78\x01\x01\x14\x00\xeb\xff\x48\x65\x6c\x6c\x6f\x2c\x20\x73\x74\x6f\x72\x65\x64"
+                                        "\x20\x62\x6c\x6f\x63\x6b\x21\x4b\x8c\x07\x1e", 31)), "Hello, stored block!");
+    EXPECT_EQ(InflateString(std::string("\x78\x01\x4b\x4c\x4a\x4e\x44\x45\x3a\x0a\x69\x99\x15\xa9\x29\x0a\xc9\xf9\x29\xa9"
+                                        "\xc5\x00\xb8\x45\x0b\x6f", 26)), "abcabcabcabcabcabc, fixed codes");
+    EXPECT_EQ(InflateString(std::string("\x2b\x4a\x2c\x57\x48\x49\x4d\xcb\x49\x2c\x49\x55\x28\x42\xb0\x01", 16),
+                            File::InflateFormat::RAW), "raw deflate raw deflate");
+}
+
+TEST(Inflate, Errors) {
+    const std::string stored("\x78\x01\x01\x14\x00\xeb\xff\x48\x65\x6c\x6c\x6f\x2c\x20\x73\x74\x6f\x72\x65\x64"
+                             "\x20\x62\x6c\x6f\x63\x6b\x21\x4b\x8c\x07\x1e", 31);
+    std::string output;
+    for (size_t size = 0; size < stored.size(); ++size) {
+        File::Inflater truncated(stored.data(), size);
+        EXPECT_FALSE(truncated.ReadAll([](const char*, size_t) { return true; })) << size;
+        EXPECT_TRUE(truncated.Failed()) << size;
+    }
+
+    std::string corrupted = stored;
+    corrupted[10] = 'J'; // The checksum does not match anymore.
+    File::Inflater wrongChecksum(corrupted.data(), corrupted.size());
+    EXPECT_EQ(wrongChecksum.Read(&output.assign(100, ' ')[0], 100), 20u);
+    EXPECT_TRUE(wrongChecksum.Failed());
+
+    corrupted = stored;
+    corrupted[0] = '\x79'; // Not DEFLATE.
+    File::Inflater wrongHeader(corrupted.data(), corrupted.size());
+    EXPECT_EQ(wrongHeader.Read(&output[0], 100), 0u);
+    EXPECT_TRUE(wrongHeader.Failed());
+
+    const std::string reservedBlockType("\x78\x01\x07\x00", 4);
+    File::Inflater reserved(reservedBlockType.data(), reservedBlockType.size());
+    EXPECT_EQ(reserved.Read(&output[0], 100), 0u);
+    EXPECT_TRUE(reserved.Failed());
+
+    const std::string tooFar("\x4b\x04\x42\x00", 4); // "a", then a match 2 bytes back.
+    File::Inflater distance(tooFar.data(), tooFar.size(), File::InflateFormat::RAW);
+    distance.Read(&output[0], 100);
+    EXPECT_TRUE(distance.Failed());
+}
+
+TEST(Inflate, StoredBlocksAcrossBuffers) {
+    // Several stored blocks, bigger than the buffer together, given in pieces of odd sizes.
+    std::string contents;
+    for (size_t i = 0; i < 3 * File::Inflater::BUFFER_SIZE; ++i) {
+        contents += static_cast<char>(i * 7 % 251);
+    }
+    std::string compressed("\x78\x01", 2);
+    for (size_t offset = 0; offset < contents.size(); offset += 65535) {
+        const size_t size = std::min<size_t>(65535, contents.size() - offset);
+        compressed += static_cast<char>(offset + size == contents.size());
+        compressed += static_cast<char>(size & 0xFF);
+        compressed += static_cast<char>(size >> 8);
+        compressed += static_cast<char>(~size & 0xFF);
+        compressed += static_cast<char>(~size >> 8 & 0xFF);
+        compressed.append(contents, offset, size);
+    }
+    const uint32_t adler = Adler32(contents);
+    for (int shift : {24, 16, 8, 0}) {
+        compressed += static_cast<char>(adler >> shift & 0xFF);
+    }
+    compressed += "trailing bytes";
+
+    size_t position = 0;
+    File::Inflater inflater([&compressed, &position](const char*& data, size_t& size) {
+        data = compressed.data() + position;
+        size = std::min<size_t>(1 + position % 40000, compressed.size() - position);
+        position += size;
+        return size != 0;
+    });
+    std::string output(contents.size() + 10, '\0');
+    EXPECT_EQ(inflater.Read(&output[0], output.size()), contents.size());
+    output.resize(contents.size());
+    EXPECT_TRUE(output == contents);
+    EXPECT_TRUE(inflater.IsDone());
+    EXPECT_EQ(inflater.TotalIn(), compressed.size() - 14);
+}
+
+TEST(Inflate, File) {
+    const File::ReadFileData* content = File::Read(TEST_FILES_DIR_PREFIX MAKE_FILE_NAME "aom_v.scx");
+    ASSERT_NE(content, nullptr);
+    uint32_t expectedSize = 0;
+    for (int i = 3; i >= 0; --i) {
+        expectedSize = expectedSize << 8 | static_cast<unsigned char>(content->contents[4 + i]);
+    }
+
+    std::string whole;
+    ASSERT_TRUE(File::Inflate(content, whole, SCX_HEADER_SIZE));
+    EXPECT_EQ(whole.size(), expectedSize);
+
+    // Same contents with the input given byte by byte, and read by small pieces.
+    const char* next = content->contents + SCX_HEADER_SIZE;
+    const char* const end = content->contents + content->size;
+    File::Inflater inflater([&next, end](const char*& data, size_t& size) {
+        data = next;
+        size = next < end ? 1 : 0;
+        next += size;
+        return size != 0;
+    });
+    std::string pieces;
+    char buffer[1000];
+    for (size_t read = inflater.Read(buffer, 999); read; read = inflater.Read(buffer, 1 + read % 999)) {
+        pieces.append(buffer, read);
+    }
+    EXPECT_TRUE(inflater.IsDone());
+    EXPECT_EQ(inflater.TotalIn(), content->size - SCX_HEADER_SIZE);
+    EXPECT_TRUE(pieces == whole);
+
+    std::string none;
+    EXPECT_FALSE(File::Inflate(content, none, 0)); // "l33t" is not a zlib header.
+    File::Read_Close(content);
+}
@@ -0,0 +1,184 @@
+//
+// Tests of the durable append-only journal.
+//
+
+#include <thread>
+#include "tests_datas.hpp"
+
+static const File::SFilename_t JOURNAL_FOLDER = MAKE_FILE_NAME "JournalTests.tmp" FILE_SEPARATOR;
+
+class JournalTest : public TemporaryFolderTest {
+protected:
+    JournalTest() : TemporaryFolderTest(JOURNAL_FOLDER) {}
+
+    static std::vector<std::string> ReadAll(const File::Journal& journal) {
+        std::vector<std::string> records;
+        EXPECT_TRUE(journal.ForEach([&records](const char* data, size_t size) {
+            records.emplace_back(data, size);
+            return true;
+        }));
+        return records;
+    }
+
+    static File::SFilename_t Segment(const char* number) {
+        return JOURNAL_FOLDER + File::SFilename_t(number, number + 16) + MAKE_FILE_NAME ".journal";
+    }
+
+    static std::string Record(size_t i) {
+        return std::string(i % 37, static_cast<char>('a' + i % 26)) + std::to_string(i);
+    }
+};
+
+TEST_F(JournalTest, AppendAndReopen) {
+    std::vector<std::string> expected;
+    {
+        File::Journal journal(JOURNAL_FOLDER.c_str());
+        ASSERT_TRUE(journal.IsOpen());
+        EXPECT_EQ(journal.RecordCount(), 0u);
+        ASSERT_TRUE(journal.Append(std::string()));
+        expected.emplace_back();
+        for (size_t i = 0; i < 100; ++i) {
+            ASSERT_TRUE(journal.Append(Record(i)));
+            expected.push_back(Record(i));
+        }
+        EXPECT_EQ(journal.RecordCount(), 101u);
+        EXPECT_EQ(ReadAll(journal), expected);
+
+        size_t seen = 0;
+        journal.ForEach([&seen](const char*, size_t) { return ++seen < 10; });
+        EXPECT_EQ(seen, 10u);
+    }
+
+    File::JournalOptions options;
+    options.durability = File::Durability::NONE;
+    {
+        File::Journal journal(JOURNAL_FOLDER.c_str(), options);
+        ASSERT_TRUE(journal.IsOpen());
+        EXPECT_EQ(journal.RecordCount(), 101u);
+        EXPECT_EQ(ReadAll(journal), expected);
+        ASSERT_TRUE(journal.Append("after reopening"));
+        expected.emplace_back("after reopening");
+        EXPECT_TRUE(journal.Sync());
+    }
+    File::Journal journal(JOURNAL_FOLDER.c_str());
+    EXPECT_EQ(ReadAll(journal), expected);
+}
+
+TEST_F(JournalTest, Segments) {
+    File::JournalOptions options;
+    options.segmentSize = 4096;
+    std::vector<std::string> expected;
+    {
+        File::Journal journal(JOURNAL_FOLDER.c_str(), options);
+        ASSERT_TRUE(journal.IsOpen());
+        EXPECT_EQ(journal.MaxRecordSize(), 4096u - 16);
+        EXPECT_FALSE(journal.Append(std::string(4096 - 15, 'x')));
+        ASSERT_TRUE(journal.Append(std::string(4096 - 16, 'x')));
+        expected.emplace_back(4096 - 16, 'x');
+        for (size_t i = 0; i < 20; ++i) {
+            expected.push_back(std::string(1000, 'y') + Record(i));
+            ASSERT_TRUE(journal.Append(expected.back()));
+        }
+        EXPECT_TRUE(journal.IsOpen());
+    }
+    EXPECT_TRUE(File::Exists(Segment("0000000000000007").c_str()));
+    EXPECT_FALSE(File::Exists(Segment("0000000000000008").c_str()));
+
+    // A segment created just before a crash, which is created again, and a file which is not a segment.
+    std::ofstream(Segment("0000000000000008"), std::ios_base::binary) << std::string(4096, '\0');
+    std::ofstream(JOURNAL_FOLDER + MAKE_FILE_NAME "notes.txt") << "not a segment";
+    File::Journal journal(JOURNAL_FOLDER.c_str(), options);
+    ASSERT_TRUE(journal.IsOpen());
+    EXPECT_EQ(journal.RecordCount(), expected.size());
+    EXPECT_EQ(ReadAll(journal), expected);
+    EXPECT_TRUE(journal.Append("next"));
+    expected.emplace_back("next");
+    EXPECT_EQ(ReadAll(journal), expected);
+    EXPECT_FALSE(File::Exists(Segment("0000000000000009").c_str()));
+}
+
+TEST_F(JournalTest, OddSegmentSize) {
+    // Rounded down to a multiple of 8, so that the largest record fits in a segment.
+    File::JournalOptions options;
+    options.segmentSize = 4097 + 8;
+    File::Journal journal(JOURNAL_FOLDER.c_str(), options);
+    ASSERT_TRUE(journal.IsOpen());
+    EXPECT_EQ(journal.MaxRecordSize(), 4104u - 16);
+    EXPECT_FALSE(journal.Append(std::string(journal.MaxRecordSize() + 1, 'x')));
+    const std::vector<std::string> expected = {std::string(journal.MaxRecordSize(), 'x'), std::string(journal.MaxRecordSize(), 'y')};
+    ASSERT_TRUE(journal.Append(expected[0]));
+    ASSERT_TRUE(journal.Append(expected[1]));
+    EXPECT_EQ(ReadAll(journal), expected);
+    EXPECT_EQ(File::Size(Segment("0000000000000002").c_str()), 4104u);
+    EXPECT_FALSE(File::Exists(Segment("0000000000000003").c_str()));
+}
+
+TEST_F(JournalTest, Recovery) {
+    {
+        File::Journal journal(JOURNAL_FOLDER.c_str());
+        for (size_t i = 0; i < 10; ++i) {
+            ASSERT_TRUE(journal.Append(Record(i)));
+        }
+    }
+    // A crash during the last append: the end of the record is lost, and something was written after it.
+    const File::SFilename_t segment = Segment("0000000000000001");
+    const std::string before = Record(8);
+    {
+        const File::ReadFileData* content = File::Read(segment.c_str());
+        ASSERT_NE(content, nullptr);
+        const std::string contents(content->contents, content->size);
+        File::Read_Close(content);
+        const size_t last = contents.find(Record(9));
+        ASSERT_NE(last, std::string::npos);
+        std::fstream file(segment, std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+        file.seekp(static_cast<std::streamoff>(last + 3));
+        file << "torn" << std::string(100, '\0') << "garbage";
+    }
+
+    {
+        File::Journal journal(JOURNAL_FOLDER.c_str());
+        ASSERT_TRUE(journal.IsOpen());
+        EXPECT_EQ(journal.RecordCount(), 9u);
+        EXPECT_EQ(ReadAll(journal).back(), Record(8));
+        ASSERT_TRUE(journal.Append("x"));
+    }
+    File::Journal journal(JOURNAL_FOLDER.c_str());
+    const std::vector<std::string> records = ReadAll(journal);
+    ASSERT_EQ(records.size(), 10u);
+    EXPECT_EQ(records[8], Record(8));
+    EXPECT_EQ(records[9], "x");
+}
+
+#if Threads_FOUND
+TEST_F(JournalTest, ConcurrentAppends) {
+    File::JournalOptions options;
+    options.segmentSize = 64ul << 10;
+    {
+        File::Journal journal(JOURNAL_FOLDER.c_str(), options);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < 4; ++t) {
+            threads.emplace_back([&journal, t]() {
+                for (size_t i = 0; i < 300; ++i) {
+                    EXPECT_TRUE(journal.Append(std::to_string(t) + ":" + Record(i)));
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(journal.RecordCount(), 1200u);
+    }
+
+    // The records of each thread are in the order of their appends.
+    File::Journal journal(JOURNAL_FOLDER.c_str(), options);
+    size_t next[4] = {};
+    for (const std::string& record : ReadAll(journal)) {
+        const size_t t = static_cast<size_t>(record[0] - '0');
+        ASSERT_LT(t, 4u);
+        EXPECT_EQ(record.substr(2), Record(next[t]++));
+    }
+    for (size_t count : next) {
+        EXPECT_EQ(count, 300u);
+    }
+}
+#endif
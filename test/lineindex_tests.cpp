@@ -0,0 +1,115 @@
+//
+// Tests of the index of the lines of a file.
+//
+
+#include "tests_datas.hpp"
+
+static const File::SFilename_t INDEX_FOLDER = MAKE_FILE_NAME "LineIndexTests.tmp" FILE_SEPARATOR;
+
+// Checks that the index gives the same lines as "LineRange".
+static void ExpectSameLines(const std::string& contents, unsigned int threads = 1) {
+    File::LineIndex index;
+    index.Build(contents.data(), contents.size(), threads);
+    size_t line = 0;
+    for (File::LineView view : File::LineRange(contents.data(), contents.size())) {
+        ASSERT_LT(line, index.LineCount());
+        const File::LineView indexed = index.Line(contents.data(), line);
+        ASSERT_EQ(indexed.data, view.data) << "Line " << line;
+        ASSERT_EQ(indexed.size, view.size) << "Line " << line;
+        ++line;
+    }
+    EXPECT_EQ(index.LineCount(), line);
+}
+
+TEST(LineIndex, SameLinesAsLineRange) {
+    ExpectSameLines("");
+    ExpectSameLines("a");
+    ExpectSameLines("a\n");
+    ExpectSameLines("\n");
+    ExpectSameLines("\n\n\r\n");
+    ExpectSameLines("first\r\nsecond\nthird");
+
+    // Several blocks, with lines of very different lengths so that the blocks get different widths.
+    std::string contents;
+    for (int i = 0; i < 1000; ++i) {
+        contents += std::string(i % 7 == 0 ? i * 97 : i % 13, 'x');
+        contents += i % 5 ? "\n" : "\r\n";
+    }
+    ExpectSameLines(contents);
+    contents += "no end of line";
+    ExpectSameLines(contents, 3);
+}
+
+TEST(LineIndex, ManyChunks) {
+    // More than one chunk per thread, and newlines right on chunk boundaries.
+    std::string contents(9ul << 20, 'y');
+    for (size_t i = 0; i < contents.size(); i += 1 + i % 251) {
+        contents[i] = '\n';
+    }
+    contents[(4ul << 20) - 1] = '\n';
+    contents[4ul << 20] = '\n';
+    ExpectSameLines(contents, 3);
+
+    File::LineIndex index;
+    index.Build(contents.data(), contents.size(), 2);
+    EXPECT_LT(index.MemoryUsage(), index.LineCount() * 3); // Instead of 8 bytes per line.
+}
+
+TEST(LineIndex, Sidecar) {
+    File::DeleteTree(INDEX_FOLDER.c_str());
+    File::CreateFolder(INDEX_FOLDER.c_str());
+    const File::SFilename_t filename = INDEX_FOLDER + MAKE_FILE_NAME "log.txt";
+    const File::SFilename_t sidecar = File::LineIndexFilename(filename.c_str());
+    {
+        std::ofstream ofs(filename, std::ios_base::binary);
+        for (int i = 0; i < 500; ++i) {
+            ofs << "line " << i << "\n";
+        }
+    }
+
+    File::LineIndex index;
+    ASSERT_TRUE(index.Open(filename.c_str()));
+    EXPECT_EQ(index.LineCount(), 500u);
+    EXPECT_TRUE(File::Exists(sidecar.c_str()));
+
+    // Second time: loaded from the sidecar.
+    File::FileIdentity identity;
+    ASSERT_TRUE(File::Identity(filename.c_str(), identity));
+    File::LineIndex loaded;
+    ASSERT_TRUE(loaded.Load(sidecar.c_str(), identity));
+    EXPECT_EQ(loaded.LineCount(), 500u);
+    File::MappedFile file(filename.c_str(), File::AccessPattern::RANDOM);
+    ASSERT_TRUE(file.IsOpen());
+    for (size_t line : {0, 1, 63, 64, 65, 321, 499}) {
+        EXPECT_EQ(loaded.Offset(line), index.Offset(line));
+        EXPECT_EQ(loaded.Line(file.Get(), line), "line " + std::to_string(line));
+    }
+
+    // Another version of the file does not match the sidecar.
+    File::FileIdentity other = identity;
+    ++other.mtimeNs;
+    EXPECT_FALSE(loaded.Load(sidecar.c_str(), other));
+    other = identity;
+    --other.size;
+    EXPECT_FALSE(loaded.Load(sidecar.c_str(), other));
+    EXPECT_EQ(loaded.LineCount(), 500u);
+
+    // Appending lines changes the file, so the index is built again.
+    std::ofstream(filename, std::ios_base::binary | std::ios_base::app) << "one more\n";
+    File::LineIndex reopened;
+    ASSERT_TRUE(reopened.Open(filename.c_str()));
+    EXPECT_EQ(reopened.LineCount(), 501u);
+    file = File::MappedFile(filename.c_str(), File::AccessPattern::RANDOM);
+    EXPECT_EQ(reopened.Line(file.Get(), 500), "one more");
+
+    // A corrupted sidecar is rejected.
+    std::string corrupted;
+    ASSERT_TRUE(File::ReadToString(sidecar.c_str(), corrupted));
+    corrupted[corrupted.size() - 3] ^= 0x40;
+    std::ofstream(sidecar, std::ios_base::binary | std::ios_base::trunc) << corrupted;
+    ASSERT_TRUE(File::Identity(filename.c_str(), identity));
+    EXPECT_FALSE(loaded.Load(sidecar.c_str(), identity));
+
+    EXPECT_FALSE(index.Open(MAKE_FILE_NAME "not_existing._tut"));
+    File::DeleteTree(INDEX_FOLDER.c_str());
+}
@@ -0,0 +1,58 @@
+//
+// Tests of the zero-copy line iteration.
+//
+
+#include "tests_datas.hpp"
+
+static std::vector<std::string> AllLines(const std::string& contents) {
+    std::vector<std::string> lines;
+    for (const File::LineView& line : File::LineRange(contents.data(), contents.size())) {
+        lines.push_back(line.ToString());
+    }
+    return lines;
+}
+
+TEST(LineRange, EndsOfLine) {
+    using Lines = std::vector<std::string>;
+    EXPECT_EQ(AllLines(""), Lines());
+    EXPECT_EQ(AllLines("one"), Lines({"one"}));
+    EXPECT_EQ(AllLines("one\n"), Lines({"one"}));
+    EXPECT_EQ(AllLines("one\r\ntwo\nthree"), Lines({"one", "two", "three"}));
+    EXPECT_EQ(AllLines("\n\r\n\n"), Lines({"", "", ""}));
+    EXPECT_EQ(AllLines("a\rb\r\n"), Lines({"a\rb"}));
+}
+
+TEST(LineRange, SameAsGetline) {
+    std::string contents;
+    for (int i = 0; i < 1000; ++i) {
+        contents += std::string(i % 97, 'x') + "\n";
+    }
+
+    std::istringstream iss(contents);
+    std::string expected;
+    size_t count = 0;
+    for (File::LineView line : File::LineRange(contents.data(), contents.size())) {
+        ASSERT_TRUE(std::getline(iss, expected));
+        EXPECT_EQ(line, expected);
+        ++count;
+    }
+    EXPECT_FALSE(std::getline(iss, expected));
+    EXPECT_EQ(count, 1000u);
+}
+
+TEST(LineRange, ReadFileData) {
+    const File::SFilename_t utf16File = File::MakeFilename(false, false, 2, TEST_FILES_DIR_PREFIX, MAKE_FILE_NAME "Small_utf16le.txt");
+    auto fileData = File::Read(utf16File.c_str());
+    ASSERT_NE(fileData, nullptr);
+    File::LineRange lines(fileData);
+    auto it = lines.begin();
+    ASSERT_TRUE(it != lines.end());
+    EXPECT_EQ(it->data, fileData->contents);
+    EXPECT_EQ(it->size, 36u); // Read as bytes, the UTF-16 "\r\0\n\0" gives a line break before the last '\0'.
+    ASSERT_TRUE(++it != lines.end());
+    EXPECT_EQ(it->size, 1u);
+    EXPECT_TRUE(++it == lines.end());
+    File::Read_Close(fileData);
+
+    EXPECT_TRUE(File::LineRange(nullptr).begin() == File::LineRange(nullptr).end());
+}
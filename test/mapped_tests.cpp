@@ -0,0 +1,103 @@
+//
+// Tests of the shared mapping cache.
+//
+
+#include "tests_datas.hpp"
+
+static const File::SFilename_t SMALL_FILE = File::MakeFilename(false, false, 2, TEST_FILES_DIR_PREFIX, MAKE_FILE_NAME "Small_utf16le.txt");
+
+TEST(Identity, Files) {
+    File::FileIdentity first, second;
+    ASSERT_TRUE(File::Identity(FILENAME_MIDDLE_SIZE.c_str(), first));
+    ASSERT_TRUE(File::Identity(FILENAME_MIDDLE_SIZE.c_str(), second));
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(first.size, File::Size(FILENAME_MIDDLE_SIZE.c_str()));
+
+    ASSERT_TRUE(File::Identity(SMALL_FILE.c_str(), second));
+    EXPECT_NE(first, second);
+    EXPECT_FALSE(File::Identity(MAKE_FILE_NAME "not_existing._tut", second));
+}
+
+TEST(MappedFile, SharedMapping) {
+    File::MappedFile::ClearCache();
+    std::string expected;
+    ASSERT_TRUE(File::ReadToString(FILENAME_MIDDLE_SIZE.c_str(), expected));
+
+    File::MappedFile first(FILENAME_MIDDLE_SIZE.c_str());
+    ASSERT_TRUE(first.IsOpen());
+    EXPECT_EQ(std::string(first.Data(), first.Size()), expected);
+    EXPECT_EQ(File::MappedFile::CacheSize(), 1u);
+
+    File::MappedFile second(FILENAME_MIDDLE_SIZE.c_str());
+    EXPECT_EQ(second.Data(), first.Data());
+    EXPECT_EQ(second.GetIdentity(), first.GetIdentity());
+
+    // Once every handle is gone, the cache still holds the mapping.
+    const char* data = first.Data();
+    first.Close();
+    second.Close();
+    EXPECT_FALSE(first.IsOpen());
+    File::MappedFile third(FILENAME_MIDDLE_SIZE.c_str());
+    EXPECT_EQ(third.Data(), data);
+
+    File::MappedFile moved(std::move(third));
+    EXPECT_EQ(moved.Data(), data);
+    EXPECT_FALSE(third.IsOpen());
+    File::MappedFile::ClearCache();
+    EXPECT_EQ(File::MappedFile::CacheSize(), 0u);
+    EXPECT_EQ(std::string(moved.Data(), moved.Size()), expected);
+}
+
+TEST(MappedFile, Capacity) {
+    File::MappedFile::ClearCache();
+    File::MappedFile::SetCacheCapacity(1);
+    {
+        // Files in use are never dropped.
+        File::MappedFile middle(FILENAME_MIDDLE_SIZE.c_str());
+        File::MappedFile small(SMALL_FILE.c_str());
+        EXPECT_TRUE(middle && small);
+        EXPECT_EQ(File::MappedFile::CacheSize(), 2u);
+    }
+    // Both are unused now: only the most recent one is kept.
+    File::MappedFile::SetCacheCapacity(1);
+    EXPECT_EQ(File::MappedFile::CacheSize(), 1u);
+    const char* data = File::MappedFile(SMALL_FILE.c_str()).Data();
+    EXPECT_EQ(File::MappedFile(SMALL_FILE.c_str()).Data(), data);
+
+    File::MappedFile::SetCacheCapacity(0);
+    EXPECT_EQ(File::MappedFile::CacheSize(), 0u);
+    File::MappedFile first(SMALL_FILE.c_str());
+    File::MappedFile second(SMALL_FILE.c_str());
+    EXPECT_NE(first.Data(), second.Data());
+    EXPECT_EQ(File::MappedFile::CacheSize(), 0u);
+    File::MappedFile::SetCacheCapacity(File::MappedFile::DEFAULT_CACHE_CAPACITY);
+}
+
+TEST(MappedFile, ModifiedFile) {
+    const File::SFilename_t filename = MAKE_FILE_NAME "MappedFile_Modified.tmp";
+    File::MappedFile::ClearCache();
+    std::ofstream(filename) << "first version";
+    File::MappedFile first(filename.c_str());
+    ASSERT_TRUE(first.IsOpen());
+
+    std::ofstream(filename) << "second version, longer";
+    File::MappedFile second(filename.c_str());
+    ASSERT_TRUE(second.IsOpen());
+    EXPECT_EQ(std::string(second.Data(), second.Size()), "second version, longer");
+    EXPECT_NE(first.GetIdentity(), second.GetIdentity());
+    // The cache forgot the first version, which its handle still holds.
+    EXPECT_EQ(File::MappedFile::CacheSize(), 1u);
+    EXPECT_EQ(std::string(first.Data(), first.Size()), "first version");
+
+    first.Close();
+    second.Close();
+    File::MappedFile::ClearCache();
+    File::Delete(filename.c_str());
+}
+
+TEST(MappedFile, NotExisting) {
+    File::MappedFile file(MAKE_FILE_NAME "not_existing._tut");
+    EXPECT_FALSE(file.IsOpen());
+    EXPECT_EQ(file.Data(), nullptr);
+    EXPECT_EQ(file.Size(), 0u);
+}
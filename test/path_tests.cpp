@@ -0,0 +1,148 @@
+//
+// Tests of the normalisation and canonicalisation of paths.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include "tests_datas.hpp"
+#if !defined(_WIN32)
+#   include <climits>
+#   include <cstdlib>
+#   include <unistd.h>
+#endif
+
+static const File::SFilename_t PATH_FOLDER = MAKE_FILE_NAME "PathTests.tmp" FILE_SEPARATOR;
+
+class PathTest : public TemporaryFolderTest {
+protected:
+    PathTest() : TemporaryFolderTest(PATH_FOLDER) {}
+
+    void SetUp() override {
+        TemporaryFolderTest::SetUp();
+        for (const char* folder : {"a", "a/b", "c"}) {
+            File::CreateFolder((PATH_FOLDER + Native(folder)).c_str());
+        }
+        std::ofstream(PATH_FOLDER + Native("a/file"), std::ios_base::binary) << "file";
+    }
+
+    /// Path with the separators of the system.
+    static File::SFilename_t Native(const char* path) {
+        File::SFilename_t native;
+        for (const char* c = path; *c; ++c) {
+            native += *c == '/' ? FILE_SEPARATOR[0] : static_cast<File::SFilename_t::value_type>(*c);
+        }
+        return native;
+    }
+
+    /// Canonical path of the test folder, ending with a separator.
+    static File::SFilename_t Folder() {
+        File::PathCache cache;
+        File::SFilename_t folder;
+        EXPECT_TRUE(cache.Canonicalize(PATH_FOLDER, folder));
+        return folder;
+    }
+};
+
+TEST_F(PathTest, Normalize) {
+    EXPECT_EQ(File::NormalizePath(Native("a//./b/../c")), Native("a/c"));
+    EXPECT_EQ(File::NormalizePath(Native("./a/")), Native("a/"));
+    EXPECT_EQ(File::NormalizePath(Native("a/..")), Native("."));
+    EXPECT_EQ(File::NormalizePath(Native("a/../")), Native("./"));
+    EXPECT_EQ(File::NormalizePath(Native("../../a/../b")), Native("../../b"));
+    EXPECT_EQ(File::NormalizePath(Native("a/b/../../..")), Native(".."));
+    EXPECT_EQ(File::NormalizePath(File::SFilename_t()), File::SFilename_t());
+    EXPECT_FALSE(File::IsAbsolutePath(Native("a/b")));
+#if defined(_WIN32)
+    EXPECT_EQ(File::NormalizePath(MAKE_FILE_NAME "C:/a/../../b"), MAKE_FILE_NAME "C:\\b");
+    EXPECT_EQ(File::NormalizePath(MAKE_FILE_NAME "\\\\server\\share\\..\\a"), MAKE_FILE_NAME "\\\\server\\share\\a");
+    EXPECT_TRUE(File::IsAbsolutePath(MAKE_FILE_NAME "C:\\a"));
+    EXPECT_FALSE(File::IsAbsolutePath(MAKE_FILE_NAME "C:a"));
+#else
+    EXPECT_EQ(File::NormalizePath("/../a/./b//"), "/a/b/");
+    EXPECT_EQ(File::NormalizePath("//"), "/");
+    EXPECT_TRUE(File::IsAbsolutePath("/a"));
+#endif
+}
+
+TEST_F(PathTest, Canonicalize) {
+    const File::SFilename_t folder = Folder();
+    ASSERT_TRUE(File::IsAbsolutePath(folder));
+#if !defined(_WIN32)
+    char* real = realpath(PATH_FOLDER.c_str(), nullptr);
+    ASSERT_NE(real, nullptr);
+    EXPECT_EQ(folder, std::string(real) + "/");
+    free(real);
+#endif
+
+    File::PathCache cache;
+    File::SFilename_t canonical;
+    ASSERT_TRUE(cache.Canonicalize(PATH_FOLDER + Native("a/./b/../file"), canonical));
+    EXPECT_EQ(canonical, folder + Native("a/file"));
+    ASSERT_TRUE(cache.Canonicalize(PATH_FOLDER + Native("a/b/.."), canonical));
+    EXPECT_EQ(canonical, folder + Native("a/"));
+    ASSERT_TRUE(cache.Canonicalize(folder + Native("c/missing"), canonical));
+    EXPECT_EQ(canonical, folder + Native("c/missing"));
+    EXPECT_FALSE(cache.Canonicalize(PATH_FOLDER + Native("missing/file"), canonical));
+    EXPECT_FALSE(cache.Canonicalize(PATH_FOLDER + Native("a/file/"), canonical));
+    EXPECT_FALSE(cache.Canonicalize(File::SFilename_t(), canonical));
+
+    // The files of a known directory cost nothing.
+    if (cache.IsCaching()) {
+        const uint64_t lookups = cache.LookupCount();
+        for (int i = 0; i < 100; ++i) {
+            ASSERT_TRUE(cache.Canonicalize(PATH_FOLDER + Native("a/b/file_") + File::SFilename_t(1, 'a' + i % 26), canonical));
+        }
+        ASSERT_TRUE(cache.Canonicalize(PATH_FOLDER + Native("a/b/../file"), canonical));
+        EXPECT_EQ(cache.LookupCount(), lookups);
+    }
+}
+
+#if !defined(_WIN32)
+TEST_F(PathTest, Links) {
+    const File::SFilename_t folder = Folder();
+    ASSERT_EQ(symlink("a/b", (PATH_FOLDER + "link").c_str()), 0);
+    ASSERT_EQ(symlink(folder.c_str(), (PATH_FOLDER + "c/absolute").c_str()), 0);
+    ASSERT_EQ(symlink("loop2", (PATH_FOLDER + "loop1").c_str()), 0);
+    ASSERT_EQ(symlink("loop1", (PATH_FOLDER + "loop2").c_str()), 0);
+
+    File::PathCache cache;
+    File::SFilename_t canonical;
+    ASSERT_TRUE(cache.Canonicalize(PATH_FOLDER + "link/../file", canonical));
+    EXPECT_EQ(canonical, folder + "a/file");
+    ASSERT_TRUE(cache.Canonicalize(PATH_FOLDER + "c/absolute/link/x", canonical));
+    EXPECT_EQ(canonical, folder + "a/b/x");
+    // The last name is not resolved.
+    ASSERT_TRUE(cache.Canonicalize(PATH_FOLDER + "link", canonical));
+    EXPECT_EQ(canonical, folder + "link");
+    ASSERT_TRUE(cache.Canonicalize(PATH_FOLDER + "link/", canonical));
+    EXPECT_EQ(canonical, folder + "a/b/");
+    EXPECT_FALSE(cache.Canonicalize(PATH_FOLDER + "loop1/x", canonical));
+}
+
+TEST_F(PathTest, Changes) {
+    const File::SFilename_t folder = Folder();
+    ASSERT_EQ(symlink("a", (PATH_FOLDER + "link").c_str()), 0);
+    File::PathCache cache;
+    if (!cache.IsCaching()) {
+        GTEST_SKIP() << "No directory watching on this system";
+    }
+    File::SFilename_t canonical;
+    ASSERT_TRUE(cache.Canonicalize(PATH_FOLDER + "link/b/x", canonical));
+    EXPECT_EQ(canonical, folder + "a/b/x");
+    ASSERT_TRUE(cache.Canonicalize(PATH_FOLDER + "a/b/x", canonical));
+
+    // The link now leads elsewhere, and "a/b" is not a directory anymore.
+    ASSERT_EQ(unlink((PATH_FOLDER + "link").c_str()), 0);
+    ASSERT_EQ(symlink("c", (PATH_FOLDER + "link").c_str()), 0);
+    ASSERT_EQ(std::rename((PATH_FOLDER + "a/b").c_str(), (PATH_FOLDER + "c/b").c_str()), 0);
+    std::ofstream(PATH_FOLDER + "a/b", std::ios_base::binary) << "file";
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (cache.Canonicalize(PATH_FOLDER + "a/b/x", canonical) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_FALSE(cache.Canonicalize(PATH_FOLDER + "a/b/x", canonical));
+    ASSERT_TRUE(cache.Canonicalize(PATH_FOLDER + "link/b/x", canonical));
+    EXPECT_EQ(canonical, folder + "c/b/x");
+}
+#endif
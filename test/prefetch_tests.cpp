@@ -0,0 +1,82 @@
+//
+// Tests of the prefetching of the files of a batch.
+//
+
+#include <chrono>
+#include <thread>
+#include "tests_datas.hpp"
+
+static const File::SFilename_t PREFETCH_FOLDER = MAKE_FILE_NAME "PrefetchTests.tmp" FILE_SEPARATOR;
+
+class PrefetchTest : public TemporaryFolderTest {
+protected:
+    PrefetchTest() : TemporaryFolderTest(PREFETCH_FOLDER) {}
+
+    void SetUp() override {
+        TemporaryFolderTest::SetUp();
+        for (int i = 0; i < 10; ++i) {
+            filenames.push_back(PREFETCH_FOLDER + MAKE_FILE_NAME "file" + File::SFilename_t(1, static_cast<char>('0' + i)));
+            std::ofstream(filenames.back(), std::ios_base::binary) << std::string(1000, static_cast<char>('a' + i));
+        }
+    }
+
+    /// Waits until "expected" files are prefetched, at most a few seconds, then a little more to see if others are.
+    static size_t WaitForCount(const File::Prefetcher& prefetcher, size_t expected) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (prefetcher.PrefetchedCount() < expected && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return prefetcher.PrefetchedCount();
+    }
+
+    std::vector<File::SFilename_t> filenames;
+};
+
+#if !defined(_WIN32)
+
+TEST_F(PrefetchTest, WindowOfFiles) {
+    File::PrefetchOptions options;
+    options.windowFiles = 3;
+    File::Prefetcher prefetcher(filenames, options);
+    EXPECT_EQ(prefetcher.FileCount(), 10u);
+    EXPECT_EQ(WaitForCount(prefetcher, 3), 3u);
+
+    prefetcher.Consume(1);
+    EXPECT_EQ(WaitForCount(prefetcher, 4), 4u);
+    prefetcher.Consume(5); // File 4 is skipped: 3 was already prefetched, 5 to 7 are now.
+    EXPECT_EQ(WaitForCount(prefetcher, 7), 7u);
+    prefetcher.Consume(2); // Going back does nothing.
+    EXPECT_EQ(WaitForCount(prefetcher, 7), 7u);
+    prefetcher.Consume(9);
+    EXPECT_EQ(WaitForCount(prefetcher, 8), 8u); // File 8 is skipped: 7 was already prefetched, 9 is now.
+    prefetcher.Consume(prefetcher.FileCount());
+    EXPECT_EQ(WaitForCount(prefetcher, 8), 8u);
+}
+
+TEST_F(PrefetchTest, WindowOfBytes) {
+    File::PrefetchOptions options;
+    options.windowBytes = 2500; // Two files and a half.
+    options.dropBehind = false;
+    filenames.push_back(PREFETCH_FOLDER + MAKE_FILE_NAME "missing");
+    File::Prefetcher prefetcher(filenames, options);
+    EXPECT_EQ(WaitForCount(prefetcher, 3), 3u);
+
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        prefetcher.Consume(i);
+        // The window holds the three files from "i"; the last one is missing.
+        const size_t expected = std::min<size_t>(i + 3, 10);
+        EXPECT_EQ(WaitForCount(prefetcher, expected), expected) << i;
+        const File::ReadFileData* content = File::Read(filenames[i].c_str());
+        if (i == 10) {
+            EXPECT_EQ(content, nullptr);
+        } else {
+            ASSERT_NE(content, nullptr);
+            EXPECT_EQ(std::string(content->contents, content->size), std::string(1000, filenames[i].back() - '0' + 'a'));
+            File::Read_Close(content);
+        }
+    }
+    prefetcher.Consume(filenames.size() + 10);
+}
+
+#endif
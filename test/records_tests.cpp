@@ -0,0 +1,135 @@
+//
+// Tests of the typed views over files of binary records.
+//
+
+#include <cstdio>
+#include "tests_datas.hpp"
+
+static constexpr File::Filename_t RECORDS_FILE = MAKE_FILE_NAME "RecordsTests.tmp";
+
+struct Sample {
+    uint32_t id;
+    int16_t x;
+    int16_t y;
+    double value;
+};
+
+namespace File {
+    template <>
+    struct RecordSwapper<Sample> {
+        static void Swap(Sample& sample) {
+            RecordSwapper<uint32_t>::Swap(sample.id);
+            RecordSwapper<int16_t>::Swap(sample.x);
+            RecordSwapper<int16_t>::Swap(sample.y);
+            RecordSwapper<double>::Swap(sample.value);
+        }
+    };
+}
+
+/// Same bytes as "sample" written by a machine with the other byte order.
+static Sample Swapped(Sample sample) {
+    File::RecordSwapper<Sample>::Swap(sample);
+    return sample;
+}
+
+static constexpr File::ByteOrder OTHER_BYTE_ORDER =
+        File::HOST_BYTE_ORDER == File::ByteOrder::LITTLE ? File::ByteOrder::BIG : File::ByteOrder::LITTLE;
+
+class RecordsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        for (uint32_t i = 0; i < 1000; ++i) {
+            samples.push_back({i * 3, static_cast<int16_t>(i), static_cast<int16_t>(-static_cast<int>(i)), i / 4.0});
+        }
+    }
+
+    void TearDown() override {
+        File::Delete(RECORDS_FILE);
+    }
+
+    void WriteSamples(bool swapped, const std::string& header = std::string()) {
+        std::ofstream ofs(RECORDS_FILE, std::ios_base::binary | std::ios_base::trunc);
+        ofs << header;
+        for (const Sample& sample : samples) {
+            const Sample written = swapped ? Swapped(sample) : sample;
+            ofs.write(reinterpret_cast<const char*>(&written), sizeof(written));
+        }
+    }
+
+    static bool Equal(const Sample& a, const Sample& b) {
+        return a.id == b.id && a.x == b.x && a.y == b.y && a.value == b.value;
+    }
+
+    std::vector<Sample> samples;
+};
+
+TEST_F(RecordsTest, Native) {
+    WriteSamples(false);
+    const File::ReadFileData* content = File::Read(RECORDS_FILE, File::ReadStrategy::MMAP, File::AccessPattern::RANDOM);
+    ASSERT_NE(content, nullptr);
+    const File::RecordView<Sample> view(content);
+    ASSERT_TRUE(view.IsValid());
+    ASSERT_EQ(view.Size(), samples.size());
+    EXPECT_EQ(static_cast<const void*>(view.Data()), static_cast<const void*>(content->contents));
+    EXPECT_TRUE(Equal(view[999], samples[999]));
+
+    size_t i = 0;
+    for (const Sample& sample : view) {
+        EXPECT_TRUE(Equal(sample, samples[i++]));
+    }
+    EXPECT_EQ(i, samples.size());
+    const auto found = std::lower_bound(view.begin(), view.end(), 1500u,
+                                        [](const Sample& sample, uint32_t id) { return sample.id < id; });
+    EXPECT_EQ(found - view.begin(), 500);
+
+    // Same file with the byte order given explicitly: nothing is swapped.
+    EXPECT_FALSE((File::RecordView<Sample, File::HOST_BYTE_ORDER>::SWAPPED));
+    EXPECT_TRUE(Equal(File::RecordView<Sample, File::HOST_BYTE_ORDER>(content)[7], samples[7]));
+    File::Read_Close(content);
+}
+
+TEST_F(RecordsTest, Swapped) {
+    WriteSamples(true, "HEAD");
+    const File::ReadFileData* content = File::Read(RECORDS_FILE);
+    ASSERT_NE(content, nullptr);
+    EXPECT_FALSE(File::RecordView<Sample>(content, 4).IsValid()); // Not aligned.
+
+    // Swapped records are copied, so they do not need to be aligned.
+    const File::RecordView<Sample, OTHER_BYTE_ORDER> view(content, 4);
+    ASSERT_TRUE(view.IsValid());
+    ASSERT_EQ(view.Size(), samples.size());
+    EXPECT_TRUE(Equal(view[3], samples[3]));
+    EXPECT_TRUE(Equal(*(view.end() - 1), samples.back()));
+    EXPECT_TRUE(Equal(view.begin()[10], samples[10]));
+    size_t i = 0;
+    for (const Sample sample : view) {
+        EXPECT_TRUE(Equal(sample, samples[i++]));
+    }
+    EXPECT_EQ(i, samples.size());
+    const auto found = std::lower_bound(view.begin(), view.end(), 1500u,
+                                        [](const Sample& sample, uint32_t id) { return sample.id < id; });
+    EXPECT_EQ(found - view.begin(), 500);
+
+    // Numbers alone.
+    const char bigEndian[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+    const File::RecordView<uint32_t, File::ByteOrder::BIG> numbers(bigEndian, sizeof(bigEndian));
+    ASSERT_EQ(numbers.Size(), 2u);
+    EXPECT_EQ(numbers[0], 0x01020304u);
+    EXPECT_EQ(numbers[1], 0x05060708u);
+    EXPECT_EQ((File::RecordView<uint16_t, File::ByteOrder::LITTLE>(bigEndian, 2)[0]), 0x0201u);
+    File::Read_Close(content);
+}
+
+TEST_F(RecordsTest, Invalid) {
+    WriteSamples(false, "X");
+    const File::ReadFileData* content = File::Read(RECORDS_FILE);
+    ASSERT_NE(content, nullptr);
+    const File::RecordView<Sample> partial(content); // One byte too many.
+    EXPECT_FALSE(partial.IsValid());
+    EXPECT_EQ(partial.Size(), 0u);
+    EXPECT_EQ(partial.begin(), partial.end());
+    EXPECT_FALSE(File::RecordView<Sample>(content, content->size + 1).IsValid());
+    EXPECT_TRUE(File::RecordView<char>(content, content->size).IsValid()); // No record.
+    EXPECT_FALSE(File::RecordView<Sample>(nullptr).IsValid());
+    File::Read_Close(content);
+}
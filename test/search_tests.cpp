@@ -0,0 +1,104 @@
+//
+// Tests of the search of substrings.
+//
+
+#include "tests_datas.hpp"
+
+// Every occurrence of the patterns found with "std::string::find", in the order of "Searcher::Find".
+static std::vector<File::SearchMatch> FindNaively(const std::string& contents, const std::vector<std::string>& patterns) {
+    std::vector<File::SearchMatch> matches;
+    for (size_t offset = 0; offset < contents.size(); ++offset) {
+        for (size_t pattern = 0; pattern < patterns.size(); ++pattern) {
+            if (!patterns[pattern].empty() && contents.compare(offset, patterns[pattern].size(), patterns[pattern]) == 0) {
+                matches.push_back({offset, pattern});
+            }
+        }
+    }
+    return matches;
+}
+
+static void ExpectSameMatches(const std::string& contents, const std::vector<std::string>& patterns, unsigned int threads = 1) {
+    const std::vector<File::SearchMatch> expected = FindNaively(contents, patterns);
+    const std::vector<File::SearchMatch> found = File::Searcher(patterns).Find(contents.data(), contents.size(), threads);
+    ASSERT_EQ(found.size(), expected.size());
+    for (size_t i = 0; i < found.size(); ++i) {
+        ASSERT_EQ(found[i], expected[i]) << "Match " << i << " at " << found[i].offset;
+    }
+}
+
+TEST(Search, OnePattern) {
+    ExpectSameMatches("", {"a"});
+    ExpectSameMatches("abc", {""});
+    ExpectSameMatches("ab", {"abc"});
+    ExpectSameMatches("aaa", {"aa"});
+    ExpectSameMatches("abcabc", {"abc"});
+
+    // Long enough for the SIMD loops, with occurrences and near misses at every position of a block.
+    std::string contents;
+    for (int i = 0; i < 2000; ++i) {
+        contents += i % 3 ? "needle" : i % 5 ? "neeedle" : "nee";
+        contents += std::string(i % 37, 'e');
+    }
+    ExpectSameMatches(contents, {"n"});
+    ExpectSameMatches(contents, {"ne"});
+    ExpectSameMatches(contents, {"needle"});
+    ExpectSameMatches(contents, {"needleneedle"});
+    ExpectSameMatches(contents, {"eee"});
+    ExpectSameMatches(contents, {"needle"}, 3);
+}
+
+TEST(Search, ManyPatterns) {
+    ExpectSameMatches("", {"a", "b"});
+    ExpectSameMatches("ushers", {"he", "she", "his", "hers"});
+    ExpectSameMatches("aaaa", {"a", "aa", "aaa", "", "aa"}); // Nested, empty and duplicate patterns.
+    ExpectSameMatches("xyz", {"z", "yz", "xyzz"}); // Occurrences up to the last byte.
+
+    std::string contents;
+    for (int i = 0; i < 5000; ++i) {
+        contents += static_cast<char>('a' + (i * 7919) % 5);
+        contents += static_cast<char>(i % 256); // Bytes which are in no pattern.
+    }
+    ExpectSameMatches(contents, {"ab", "bca", "c", "dea", "eeee", "a\x01", "\xff"});
+
+    // All the 256 bytes in the patterns.
+    std::vector<std::string> patterns;
+    for (int byte = 0; byte < 256; byte += 2) {
+        patterns.push_back(std::string(1, static_cast<char>(byte)) + static_cast<char>(byte + 1));
+    }
+    ExpectSameMatches(contents, patterns);
+}
+
+TEST(Search, ManyChunks) {
+    // Occurrences across the boundaries of the chunks searched by different threads.
+    std::string contents(9ul << 20, '.');
+    for (size_t boundary : {4ul << 20, 8ul << 20}) {
+        contents.replace(boundary - 3, 6, "needle");
+        contents.replace(boundary - 10, 5, "hay01");
+        contents.replace(boundary + 3, 5, "hay02");
+    }
+    contents.replace(contents.size() - 6, 6, "needle");
+
+    const std::vector<File::SearchMatch> found = File::Searcher("needle").Find(contents.data(), contents.size(), 3);
+    ASSERT_EQ(found.size(), 3u);
+    EXPECT_EQ(found[0].offset, (4ul << 20) - 3);
+    EXPECT_EQ(found[1].offset, (8ul << 20) - 3);
+    EXPECT_EQ(found[2].offset, contents.size() - 6);
+    ExpectSameMatches(contents, {"needle", "hay", "le", "dle.", "y0"}, 3);
+}
+
+TEST(Search, File) {
+    const File::ReadFileData* content = File::Read(TEST_FILES_DIR_PREFIX MAKE_FILE_NAME "aom_v.scx");
+    ASSERT_NE(content, nullptr);
+    const std::string contents(content->contents, content->size);
+    const std::vector<File::Filesize_t> offsets = File::Search(content, "l33t", 2);
+    std::vector<File::Filesize_t> expected;
+    for (size_t offset = contents.find("l33t"); offset != std::string::npos; offset = contents.find("l33t", offset + 1)) {
+        expected.push_back(offset);
+    }
+    EXPECT_EQ(offsets, expected);
+    EXPECT_FALSE(offsets.empty());
+    const std::vector<File::SearchMatch> matches = File::Search(content, std::vector<std::string>({"l33t", "33", "\x78\x9c"}));
+    EXPECT_EQ(matches, FindNaively(contents, {"l33t", "33", "\x78\x9c"}));
+    EXPECT_TRUE(File::Search(nullptr, "l33t").empty());
+    File::Read_Close(content);
+}
@@ -0,0 +1,152 @@
+//
+// Tests of the snapshots of directory trees.
+//
+
+#include <cstdio>
+#include "tests_datas.hpp"
+
+static const File::SFilename_t SNAPSHOT_FOLDER = MAKE_FILE_NAME "SnapshotTests.tmp" FILE_SEPARATOR;
+static const File::SFilename_t SNAPSHOT_TREE = SNAPSHOT_FOLDER + MAKE_FILE_NAME "tree" FILE_SEPARATOR;
+static const File::SFilename_t SNAPSHOT_FILE = SNAPSHOT_FOLDER + MAKE_FILE_NAME "state.snapshot";
+
+class SnapshotTest : public TemporaryFolderTest {
+protected:
+    SnapshotTest() : TemporaryFolderTest(SNAPSHOT_FOLDER) {}
+
+    void SetUp() override {
+        TemporaryFolderTest::SetUp();
+        File::CreateFolder(SNAPSHOT_TREE.c_str());
+        File::CreateFolder((SNAPSHOT_TREE + MAKE_FILE_NAME "sub").c_str());
+        WriteFile(SNAPSHOT_TREE + MAKE_FILE_NAME "a.txt", "first");
+        WriteFile(SNAPSHOT_TREE + MAKE_FILE_NAME "sub" FILE_SEPARATOR "b.txt", "second");
+        WriteFile(SNAPSHOT_TREE + MAKE_FILE_NAME "sub" FILE_SEPARATOR "c.txt", "third");
+    }
+
+    /// Changes the inode of a file without changing its contents.
+    static void Replace(const File::SFilename_t& name) {
+        std::string contents;
+        ASSERT_TRUE(File::ReadToString((SNAPSHOT_TREE + name).c_str(), contents));
+        WriteFile(SNAPSHOT_TREE + MAKE_FILE_NAME "replacement", contents);
+        File::Delete((SNAPSHOT_TREE + name).c_str());
+#if defined(_WIN32)
+        ASSERT_EQ(_wrename((SNAPSHOT_TREE + MAKE_FILE_NAME "replacement").c_str(), (SNAPSHOT_TREE + name).c_str()), 0);
+#else
+        ASSERT_EQ(std::rename((SNAPSHOT_TREE + MAKE_FILE_NAME "replacement").c_str(), (SNAPSHOT_TREE + name).c_str()), 0);
+#endif
+    }
+
+    static std::vector<std::pair<File::SnapshotChangeType, File::SFilename_t>> Changes(
+            const File::TreeSnapshot& before, const File::TreeSnapshot& after) {
+        std::vector<std::pair<File::SnapshotChangeType, File::SFilename_t>> changes;
+        for (const File::SnapshotChange& change : File::DiffSnapshots(before, after)) {
+            changes.emplace_back(change.type, change.Path());
+        }
+        return changes;
+    }
+};
+
+TEST_F(SnapshotTest, Entries) {
+    const File::TreeSnapshot snapshot = File::SnapshotTree(SNAPSHOT_TREE.c_str());
+    EXPECT_EQ(snapshot.failures, 0u);
+    EXPECT_EQ(snapshot.hashedFiles, 0u);
+    ASSERT_EQ(snapshot.entries.size(), 4u);
+    EXPECT_EQ(snapshot.entries[0].path, MAKE_FILE_NAME "a.txt");
+    EXPECT_EQ(snapshot.entries[1].path, MAKE_FILE_NAME "sub");
+    EXPECT_EQ(snapshot.entries[2].path, MAKE_FILE_NAME "sub" FILE_SEPARATOR "b.txt");
+    EXPECT_EQ(snapshot.entries[3].path, MAKE_FILE_NAME "sub" FILE_SEPARATOR "c.txt");
+    EXPECT_EQ(snapshot.entries[0].type, File::StatType::FILE);
+    EXPECT_EQ(snapshot.entries[0].size, 5u);
+    EXPECT_FALSE(snapshot.entries[0].hashed);
+    EXPECT_NE(snapshot.entries[0].inode, snapshot.entries[2].inode);
+    EXPECT_NE(snapshot.entries[0].mtimeNs, 0);
+    EXPECT_EQ(snapshot.entries[1].type, File::StatType::DIRECTORY);
+
+    ASSERT_NE(snapshot.Find(MAKE_FILE_NAME "sub" FILE_SEPARATOR "c.txt"), nullptr);
+    EXPECT_EQ(snapshot.Find(MAKE_FILE_NAME "sub" FILE_SEPARATOR "c.txt")->size, 5u);
+    EXPECT_EQ(snapshot.Find(MAKE_FILE_NAME "missing"), nullptr);
+    EXPECT_TRUE(File::DiffSnapshots(snapshot, snapshot).empty());
+
+    EXPECT_TRUE(File::SnapshotTree((SNAPSHOT_FOLDER + MAKE_FILE_NAME "missing").c_str()).entries.empty());
+}
+
+TEST_F(SnapshotTest, SaveAndLoad) {
+    File::SnapshotOptions options;
+    options.hashContents = true;
+    const File::TreeSnapshot snapshot = File::SnapshotTree(SNAPSHOT_TREE.c_str(), options);
+    ASSERT_TRUE(File::SaveSnapshot(snapshot, SNAPSHOT_FILE.c_str()));
+
+    File::TreeSnapshot loaded;
+    ASSERT_TRUE(File::LoadSnapshot(SNAPSHOT_FILE.c_str(), loaded));
+    ASSERT_EQ(loaded.entries.size(), snapshot.entries.size());
+    for (size_t i = 0; i < loaded.entries.size(); ++i) {
+        EXPECT_EQ(loaded.entries[i].path, snapshot.entries[i].path);
+        EXPECT_EQ(loaded.entries[i].type, snapshot.entries[i].type);
+        EXPECT_EQ(loaded.entries[i].inode, snapshot.entries[i].inode);
+        EXPECT_EQ(loaded.entries[i].mtimeNs, snapshot.entries[i].mtimeNs);
+        EXPECT_EQ(loaded.entries[i].size, snapshot.entries[i].size);
+        EXPECT_EQ(loaded.entries[i].hashed, snapshot.entries[i].hashed);
+        EXPECT_EQ(loaded.entries[i].hash, snapshot.entries[i].hash);
+    }
+    EXPECT_TRUE(loaded.entries[0].hashed);
+    EXPECT_FALSE(loaded.entries[1].hashed);
+
+    // A corrupted file is rejected.
+    std::string contents;
+    ASSERT_TRUE(File::ReadToString(SNAPSHOT_FILE.c_str(), contents));
+    contents[contents.size() / 2] ^= 1;
+    std::ofstream(SNAPSHOT_FILE, std::ios_base::binary | std::ios_base::trunc) << contents;
+    EXPECT_FALSE(File::LoadSnapshot(SNAPSHOT_FILE.c_str(), loaded));
+    EXPECT_TRUE(loaded.entries.empty());
+    EXPECT_FALSE(File::LoadSnapshot((SNAPSHOT_FOLDER + MAKE_FILE_NAME "missing").c_str(), loaded));
+
+    // An empty tree.
+    File::CreateFolder((SNAPSHOT_FOLDER + MAKE_FILE_NAME "empty").c_str());
+    ASSERT_TRUE(File::SaveSnapshot(File::SnapshotTree((SNAPSHOT_FOLDER + MAKE_FILE_NAME "empty").c_str()), SNAPSHOT_FILE.c_str()));
+    EXPECT_TRUE(File::LoadSnapshot(SNAPSHOT_FILE.c_str(), loaded));
+    EXPECT_TRUE(loaded.entries.empty());
+}
+
+TEST_F(SnapshotTest, Incremental) {
+    using Type = File::SnapshotChangeType;
+    File::SnapshotOptions options;
+    options.hashContents = true;
+    options.threads = 2;
+    const File::TreeSnapshot first = File::SnapshotTree(SNAPSHOT_TREE.c_str(), options);
+    EXPECT_EQ(first.hashedFiles, 3u);
+
+    WriteFile(SNAPSHOT_TREE + MAKE_FILE_NAME "a.txt", "first, longer");
+    Replace(MAKE_FILE_NAME "sub" FILE_SEPARATOR "b.txt");
+    File::Delete((SNAPSHOT_TREE + MAKE_FILE_NAME "sub" FILE_SEPARATOR "c.txt").c_str());
+    File::CreateFolder((SNAPSHOT_TREE + MAKE_FILE_NAME "new").c_str());
+    WriteFile(SNAPSHOT_TREE + MAKE_FILE_NAME "new" FILE_SEPARATOR "d.txt", "fourth");
+
+    // Only the new and modified files are read.
+    const File::TreeSnapshot second = File::SnapshotTree(SNAPSHOT_TREE.c_str(), options, &first);
+    EXPECT_EQ(second.hashedFiles, 3u);
+    const std::vector<std::pair<Type, File::SFilename_t>> expected = {
+        {Type::MODIFIED, MAKE_FILE_NAME "a.txt"},
+        {Type::ADDED, MAKE_FILE_NAME "new"},
+        {Type::ADDED, MAKE_FILE_NAME "new" FILE_SEPARATOR "d.txt"},
+        {Type::TOUCHED, MAKE_FILE_NAME "sub" FILE_SEPARATOR "b.txt"},
+        {Type::REMOVED, MAKE_FILE_NAME "sub" FILE_SEPARATOR "c.txt"}};
+    EXPECT_EQ(Changes(first, second), expected);
+
+    // Nothing changed: nothing is read.
+    const File::TreeSnapshot third = File::SnapshotTree(SNAPSHOT_TREE.c_str(), options, &second);
+    EXPECT_EQ(third.hashedFiles, 0u);
+    EXPECT_TRUE(Changes(second, third).empty());
+    EXPECT_EQ(third.Find(MAKE_FILE_NAME "a.txt")->hash, second.Find(MAKE_FILE_NAME "a.txt")->hash);
+
+    // Without hashes, a new inode is a modification; a file replaced by a directory is removed then added.
+    File::Delete((SNAPSHOT_TREE + MAKE_FILE_NAME "a.txt").c_str());
+    File::CreateFolder((SNAPSHOT_TREE + MAKE_FILE_NAME "a.txt").c_str());
+    const File::TreeSnapshot unhashedBefore = File::SnapshotTree(SNAPSHOT_TREE.c_str());
+    Replace(MAKE_FILE_NAME "new" FILE_SEPARATOR "d.txt");
+    const std::vector<std::pair<Type, File::SFilename_t>> expectedUnhashed = {
+        {Type::MODIFIED, MAKE_FILE_NAME "new" FILE_SEPARATOR "d.txt"}};
+    EXPECT_EQ(Changes(unhashedBefore, File::SnapshotTree(SNAPSHOT_TREE.c_str())), expectedUnhashed);
+    const std::vector<std::pair<Type, File::SFilename_t>> expectedReplaced = {
+        {Type::REMOVED, MAKE_FILE_NAME "a.txt"},
+        {Type::ADDED, MAKE_FILE_NAME "a.txt"}};
+    EXPECT_EQ(Changes(third, unhashedBefore), expectedReplaced);
+}
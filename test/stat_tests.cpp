@@ -0,0 +1,83 @@
+//
+// Tests of the metadata of many files at once.
+//
+
+#include "tests_datas.hpp"
+#if !defined(_WIN32)
+#   include <unistd.h>
+#endif
+
+static const File::SFilename_t SMALL_FILE = File::MakeFilename(false, false, 2, TEST_FILES_DIR_PREFIX, MAKE_FILE_NAME "Small_utf16le.txt");
+static const File::SFilename_t EMPTY_FOLDER = File::MakeFilename(false, false, 2, TEST_FILES_DIR_PREFIX, MAKE_FILE_NAME "EmptyFolder");
+
+TEST(StatMany, Fields) {
+    const std::vector<File::SFilename_t> paths = {
+            FILENAME_MIDDLE_SIZE, SMALL_FILE, EMPTY_FOLDER, EMPTY_FOLDER + FILE_SEPARATOR, TEST_FILES_DIR_PREFIX,
+            MAKE_FILE_NAME "not_existing._tut", EMPTY_FOLDER + FILE_SEPARATOR + MAKE_FILE_NAME "not_existing._tut",
+            MAKE_FILE_NAME "not_existing_folder" FILE_SEPARATOR "file", MAKE_FILE_NAME ""
+    };
+    const File::StatResult result = File::StatMany(paths);
+    ASSERT_EQ(result.Size(), paths.size());
+    ASSERT_EQ(result.sizes.size(), paths.size());
+    ASSERT_EQ(result.inodes.size(), paths.size());
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        EXPECT_EQ(result.Exists(i), File::Exists(paths[i].c_str())) << i;
+        EXPECT_EQ(result.IsDir(i), File::IsDir(paths[i].c_str())) << i;
+    }
+    EXPECT_EQ(result.types[0], File::StatType::FILE);
+    EXPECT_EQ(result.types[2], File::StatType::DIRECTORY);
+    EXPECT_EQ(result.types[5], File::StatType::NONE);
+
+    for (size_t i = 0; i < 2; ++i) {
+        File::FileIdentity identity;
+        ASSERT_TRUE(File::Identity(paths[i].c_str(), identity));
+        EXPECT_EQ(result.sizes[i], identity.size);
+        EXPECT_EQ(result.mtimesNs[i], identity.mtimeNs);
+        EXPECT_EQ(result.devices[i], identity.device);
+        EXPECT_EQ(result.inodes[i], identity.inode);
+    }
+    EXPECT_EQ(result.sizes[0], 287815u);
+    EXPECT_EQ(result.sizes[1], 38u);
+    EXPECT_EQ(result.sizes[5], 0u);
+    EXPECT_EQ(result.inodes[2], result.inodes[3]);
+
+    // Only the asked columns are filled.
+    const File::StatResult sizes = File::StatMany(paths, File::STAT_SIZE);
+    EXPECT_EQ(sizes.sizes, result.sizes);
+    EXPECT_TRUE(sizes.mtimesNs.empty());
+    EXPECT_TRUE(sizes.inodes.empty());
+    EXPECT_TRUE(File::StatMany(paths, File::STAT_TYPE).sizes.empty());
+}
+
+TEST(StatMany, Threads) {
+    // More paths than one job, from several directories, in no particular order.
+    std::vector<File::SFilename_t> paths;
+    for (int i = 0; i < 5000; ++i) {
+        paths.push_back(i % 3 ? FILENAME_MIDDLE_SIZE : i % 2 ? SMALL_FILE : MAKE_FILE_NAME "not_existing._tut");
+    }
+    const File::StatResult result = File::StatMany(paths, File::STAT_SIZE, 3);
+    for (int i = 0; i < 5000; ++i) {
+        ASSERT_EQ(result.sizes[i], i % 3 ? 287815u : i % 2 ? 38u : 0u) << i;
+        ASSERT_EQ(result.Exists(i), i % 3 || i % 2) << i;
+    }
+}
+
+#if !defined(_WIN32)
+TEST(StatMany, Links) {
+    const std::string link = "StatTests_link.tmp";
+    unlink(link.c_str());
+    ASSERT_EQ(symlink(FILENAME_MIDDLE_SIZE.c_str(), link.c_str()), 0);
+
+    const File::StatResult followed = File::StatMany({link}, File::STAT_SIZE);
+    EXPECT_EQ(followed.types[0], File::StatType::FILE);
+    EXPECT_EQ(followed.sizes[0], 287815u);
+    const File::StatResult notFollowed = File::StatMany({link}, File::STAT_SIZE, 1, false);
+    EXPECT_EQ(notFollowed.types[0], File::StatType::SYMLINK);
+    EXPECT_EQ(notFollowed.sizes[0], FILENAME_MIDDLE_SIZE.size());
+
+    const File::StatResult mode = File::StatMany({FILENAME_MIDDLE_SIZE}, File::STAT_MODE);
+    EXPECT_NE(mode.modes[0] & 0400, 0u);
+    unlink(link.c_str());
+}
+#endif
@@ -8,6 +8,10 @@
 #include "gtest/gtest.h"
 #include <MFranceschi_CppLibrary.hpp>
 #include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
 
 // Turn on Memory Leaks detection (Win32 only)
 #if defined(_MSC_VER) && defined(I_Want_Mem_Leaks)
@@ -16,6 +20,51 @@
 #   include <crtdbg.h>
 #endif
 
+#define TEST_FILES_DIR_PREFIX MAKE_FILE_NAME ".." FILE_SEPARATOR ".." FILE_SEPARATOR "test" FILE_SEPARATOR "files" FILE_SEPARATOR
+
+/// "aom_v.scx", the file of middle size among the test files.
+static const File::SFilename_t FILENAME_MIDDLE_SIZE = File::MakeFilename(false, false, 2, TEST_FILES_DIR_PREFIX, MAKE_FILE_NAME "aom_v.scx");
+
 #define ASSERT_LIST_CONTAINS(container, item) ASSERT_TRUE(std::find(container.cbegin(), container.cend(), item) != container.cend())
 
+/// Contents of a file, empty if it cannot be read.
+inline std::string Contents(const File::SFilename_t& filename) {
+    std::string contents;
+    File::ReadToString(filename.c_str(), contents);
+    return contents;
+}
+
+/// Creates or replaces a file.
+inline void WriteFile(const File::SFilename_t& filename, const std::string& contents) {
+    std::ofstream(filename, std::ios_base::binary | std::ios_base::trunc) << contents;
+}
+
+/// Fixture of the tests working in a folder of their own, created empty before each test and deleted after it.
+class TemporaryFolderTest : public ::testing::Test {
+protected:
+    /// @param folder Name of the folder, ending with a FILE_SEPARATOR.
+    explicit TemporaryFolderTest(File::SFilename_t folder) : folder(std::move(folder)) {}
+
+    void SetUp() override {
+        File::DeleteTree(folder.c_str());
+        File::CreateFolder(folder.c_str());
+    }
+
+    void TearDown() override {
+        File::DeleteTree(folder.c_str());
+    }
+
+    const File::SFilename_t folder;
+};
+
+/// Bytes which look random, the same on every run.
+inline std::string RandomBytes(size_t size, uint64_t seed) {
+    std::string bytes(size, '\0');
+    for (char& byte : bytes) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        byte = static_cast<char>(seed >> 56);
+    }
+    return bytes;
+}
+
 #endif //MYWORKS_TEST0_TESTS_DATAS_HPP
@@ -0,0 +1,165 @@
+//
+// Tests of the notification of changes in directories.
+//
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include "tests_datas.hpp"
+
+static const File::SFilename_t WATCHER_FOLDER = MAKE_FILE_NAME "WatcherTests.tmp" FILE_SEPARATOR;
+
+class WatcherTest : public TemporaryFolderTest {
+protected:
+    WatcherTest() : TemporaryFolderTest(WATCHER_FOLDER) {}
+
+    void SetUp() override {
+        TemporaryFolderTest::SetUp();
+        options.coalesceMs = 200;
+    }
+
+    File::WatcherCallback Collector() {
+        return [this](const std::vector<File::Change>& changes) {
+            std::lock_guard<std::mutex> lock(mutex);
+            batches.push_back(changes);
+            delivered.notify_all();
+        };
+    }
+
+    /// Waits for the next batch, at most a few seconds.
+    std::vector<File::Change> NextBatch() {
+        std::unique_lock<std::mutex> lock(mutex);
+        delivered.wait_for(lock, std::chrono::seconds(5), [this]() { return batches.size() > taken; });
+        return batches.size() > taken ? batches[taken++] : std::vector<File::Change>();
+    }
+
+    static void Write(const File::SFilename_t& filename, const char* contents) {
+        std::ofstream(filename, std::ios_base::binary | std::ios_base::app) << contents;
+    }
+
+    File::WatcherOptions options;
+    std::mutex mutex;
+    std::condition_variable delivered;
+    std::vector<std::vector<File::Change>> batches;
+    size_t taken = 0;
+};
+
+TEST_F(WatcherTest, Coalescing) {
+    const File::SFilename_t existing = WATCHER_FOLDER + MAKE_FILE_NAME "existing";
+    const File::SFilename_t renamed = WATCHER_FOLDER + MAKE_FILE_NAME "renamed";
+    Write(existing, "old");
+
+    File::Watcher watcher(Collector(), options);
+    if (!watcher.IsValid()) {
+        GTEST_SKIP() << "No directory watching on this system";
+    }
+    ASSERT_TRUE(watcher.Add(WATCHER_FOLDER.c_str()));
+    EXPECT_EQ(watcher.WatchCount(), 1u);
+
+    // Created, written, then renamed: one creation under the final name.
+    const File::SFilename_t created = WATCHER_FOLDER + MAKE_FILE_NAME "created";
+    const File::SFilename_t moved = WATCHER_FOLDER + MAKE_FILE_NAME "moved";
+    Write(created, "new");
+    Write(created, "more");
+    ASSERT_EQ(std::rename(created.c_str(), moved.c_str()), 0);
+    // Created then deleted: nothing.
+    Write(WATCHER_FOLDER + MAKE_FILE_NAME "temporary", "temporary");
+    File::Delete((WATCHER_FOLDER + MAKE_FILE_NAME "temporary").c_str());
+
+    std::vector<File::Change> changes = NextBatch();
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_EQ(changes[0].type, File::ChangeType::CREATED);
+    EXPECT_EQ(changes[0].name, moved);
+    EXPECT_FALSE(changes[0].isDirectory);
+
+    // Modified several times, and an existing file renamed.
+    Write(existing, "1");
+    Write(existing, "2");
+    ASSERT_EQ(std::rename(moved.c_str(), renamed.c_str()), 0);
+    changes = NextBatch();
+    ASSERT_EQ(changes.size(), 2u);
+    EXPECT_EQ(changes[0].type, File::ChangeType::MODIFIED);
+    EXPECT_EQ(changes[0].name, existing);
+    EXPECT_EQ(changes[1].type, File::ChangeType::MOVED);
+    EXPECT_EQ(changes[1].name, renamed);
+    EXPECT_EQ(changes[1].oldName, moved);
+
+    File::Delete(renamed.c_str());
+    changes = NextBatch();
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_EQ(changes[0].type, File::ChangeType::DELETED);
+    EXPECT_EQ(changes[0].name, renamed);
+
+    // Once removed, nothing is reported anymore.
+    watcher.Remove(WATCHER_FOLDER.c_str());
+    EXPECT_EQ(watcher.WatchCount(), 0u);
+    Write(existing, "3");
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT_FALSE(delivered.wait_for(lock, std::chrono::milliseconds(2 * options.coalesceMs),
+                                    [this]() { return batches.size() > taken; }));
+}
+
+TEST_F(WatcherTest, Recursive) {
+    File::CreateFolder((WATCHER_FOLDER + MAKE_FILE_NAME "sub").c_str());
+
+    File::Watcher watcher(Collector(), options);
+    if (!watcher.IsValid()) {
+        GTEST_SKIP() << "No directory watching on this system";
+    }
+    ASSERT_TRUE(watcher.Add(WATCHER_FOLDER.c_str(), true));
+    EXPECT_EQ(watcher.WatchCount(), 2u);
+
+    // A new directory is watched as soon as it is seen; what it already holds is reported too.
+    const File::SFilename_t folder = WATCHER_FOLDER + MAKE_FILE_NAME "new";
+    File::CreateFolder(folder.c_str());
+    Write(folder + FILE_SEPARATOR + MAKE_FILE_NAME "inside", "inside");
+    Write(WATCHER_FOLDER + MAKE_FILE_NAME "sub" FILE_SEPARATOR "deep", "deep");
+
+    std::vector<File::Change> changes = NextBatch();
+    ASSERT_EQ(changes.size(), 3u);
+    EXPECT_EQ(changes[0].type, File::ChangeType::CREATED);
+    EXPECT_EQ(changes[0].name, folder);
+    EXPECT_TRUE(changes[0].isDirectory);
+    EXPECT_EQ(changes[1].type, File::ChangeType::CREATED);
+    EXPECT_EQ(changes[1].name, folder + FILE_SEPARATOR + MAKE_FILE_NAME "inside");
+    EXPECT_EQ(changes[2].type, File::ChangeType::CREATED);
+    EXPECT_EQ(watcher.WatchCount(), 3u);
+
+    // Watches follow renamed directories.
+    const File::SFilename_t renamed = WATCHER_FOLDER + MAKE_FILE_NAME "renamed";
+    ASSERT_EQ(std::rename(folder.c_str(), renamed.c_str()), 0);
+    changes = NextBatch();
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_EQ(changes[0].type, File::ChangeType::MOVED);
+    EXPECT_TRUE(changes[0].isDirectory);
+    Write(renamed + FILE_SEPARATOR + MAKE_FILE_NAME "inside", "more");
+    changes = NextBatch();
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_EQ(changes[0].type, File::ChangeType::MODIFIED);
+    EXPECT_EQ(changes[0].name, renamed + FILE_SEPARATOR + MAKE_FILE_NAME "inside");
+
+    EXPECT_EQ(File::DeleteTree(renamed.c_str()).failures, 0u);
+    changes = NextBatch();
+    ASSERT_EQ(changes.size(), 2u);
+    EXPECT_EQ(changes[0].type, File::ChangeType::DELETED);
+    EXPECT_EQ(changes[1].type, File::ChangeType::DELETED);
+    EXPECT_EQ(changes[1].name, renamed);
+    EXPECT_EQ(watcher.WatchCount(), 2u);
+
+    // A directory moved in from an unwatched place is new, and so is what it holds.
+    const File::SFilename_t outside = MAKE_FILE_NAME "WatcherTests_outside.tmp";
+    File::DeleteTree(outside.c_str());
+    File::CreateFolder(outside.c_str());
+    Write(outside + FILE_SEPARATOR + MAKE_FILE_NAME "held", "held");
+    const File::SFilename_t movedIn = WATCHER_FOLDER + MAKE_FILE_NAME "moved_in";
+    ASSERT_EQ(std::rename(outside.c_str(), movedIn.c_str()), 0);
+    changes = NextBatch();
+    ASSERT_EQ(changes.size(), 2u);
+    EXPECT_EQ(changes[0].type, File::ChangeType::CREATED);
+    EXPECT_EQ(changes[0].name, movedIn);
+    EXPECT_TRUE(changes[0].isDirectory);
+    EXPECT_EQ(changes[1].type, File::ChangeType::CREATED);
+    EXPECT_EQ(changes[1].name, movedIn + FILE_SEPARATOR + MAKE_FILE_NAME "held");
+    EXPECT_EQ(watcher.WatchCount(), 3u);
+}
@@ -0,0 +1,98 @@
+//
+// Tests of the buffered and atomic file writer.
+//
+
+#include "tests_datas.hpp"
+
+static const File::SFilename_t WRITER_FOLDER = MAKE_FILE_NAME "WriterTests.tmp" FILE_SEPARATOR;
+
+class WriterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        File::CreateFolder(WRITER_FOLDER.c_str());
+        target = WRITER_FOLDER + MAKE_FILE_NAME "target.bin";
+    }
+
+    void TearDown() override {
+        for (const File::SFilename_t& name : File::FilesInDirectory(WRITER_FOLDER.c_str())) {
+            File::Delete((WRITER_FOLDER + name).c_str());
+        }
+        File::Delete(WRITER_FOLDER.c_str(), false);
+    }
+
+    File::SFilename_t target;
+};
+
+TEST_F(WriterTest, SmallAndBigWrites) {
+    File::WriterOptions options;
+    options.bufferSize = 5000; // Rounded up to 8 KiB
+    File::Writer writer(target.c_str(), options);
+    ASSERT_TRUE(writer.IsOpen());
+
+    std::string expected;
+    for (size_t size : {10, 3, 8190, 1, 20000, 4096, 7, 100000}) {
+        const std::string part(size, static_cast<char>('a' + expected.size() % 26));
+        ASSERT_TRUE(writer.Write(part));
+        expected += part;
+    }
+    EXPECT_EQ(writer.Size(), expected.size());
+    ASSERT_TRUE(writer.Commit());
+    EXPECT_FALSE(writer.IsOpen());
+    EXPECT_FALSE(writer.Write("x", 1));
+    EXPECT_TRUE(Contents(target) == expected);
+}
+
+TEST_F(WriterTest, AtomicReplacement) {
+    std::ofstream(target) << "old contents";
+    {
+        File::Writer writer(target.c_str());
+        ASSERT_TRUE(writer.Write("new contents"));
+        ASSERT_TRUE(writer.Flush());
+        EXPECT_EQ(Contents(target), "old contents");
+        // Not committed: aborted by the destructor.
+    }
+    EXPECT_EQ(Contents(target), "old contents");
+
+    File::Writer writer(target.c_str());
+    writer.Write("new contents");
+    ASSERT_TRUE(writer.Commit());
+    EXPECT_EQ(Contents(target), "new contents");
+
+    // No temporary file left behind.
+    EXPECT_EQ(File::FilesInDirectory(WRITER_FOLDER.c_str()).size(), 1u);
+}
+
+TEST_F(WriterTest, DurabilityAndPreallocation) {
+    for (File::Durability durability : {File::Durability::NONE, File::Durability::SYNC_DATA, File::Durability::SYNC_DIRECTORY}) {
+        File::WriterOptions options;
+        options.durability = durability;
+        options.expectedSize = 1ul << 20;
+        File::Writer writer(target.c_str(), options);
+        writer.Write("short");
+        ASSERT_TRUE(writer.Commit());
+        EXPECT_EQ(File::Size(target.c_str()), 5u);
+    }
+}
+
+TEST_F(WriterTest, NotAtomic) {
+    File::WriterOptions options;
+    options.atomic = false;
+    {
+        File::Writer writer(target.c_str(), options);
+        writer.Write("first");
+        // Committed by the destructor.
+    }
+    EXPECT_EQ(Contents(target), "first");
+
+    File::Writer writer(target.c_str(), options);
+    writer.Write("second");
+    writer.Abort();
+    EXPECT_EQ(Contents(target), ""); // Truncated when opened.
+}
+
+TEST_F(WriterTest, UnexistingFolder) {
+    File::Writer writer(MAKE_FILE_NAME "not_existing_folder" FILE_SEPARATOR "file.txt");
+    EXPECT_FALSE(writer.IsOpen());
+    EXPECT_FALSE(writer.Write("x", 1));
+    EXPECT_FALSE(writer.Commit());
+}